@@ -0,0 +1,63 @@
+#include "tcp/posix/AssetArchive.h"
+
+#include <cstdlib>
+#include <iostream>
+
+using c11http::tcp::posix::AssetArchive;
+
+namespace {
+   void usage(const char* program) {
+      std::cerr << "usage: " << program << " [options] <directory> <archive>" << std::endl
+                << "  --gzip-level <n>       zlib compression level, 1-9 (9)" << std::endl
+                << "  --brotli-quality <n>   brotli quality, 0-11 (11)" << std::endl
+                << "  --min-savings <f>      fraction an encoding must save to be stored (0.05)" << std::endl;
+   }
+}
+
+/**
+ * Pack a directory of static assets into an archive for tcp::Server::serveAssetArchive, e.g. as a build step:
+ *    AssetPack www/ www.assets
+ */
+int main(int argc, char** argv) {
+   AssetArchive::PackOptions options;
+   std::string directory;
+   std::string archive;
+
+   for(int i = 1; i < argc; ++i) {
+      const std::string arg(argv[i]);
+      const bool hasValue = i + 1 < argc;
+      if("--gzip-level" == arg && hasValue) {
+         options.gzipLevel = std::atoi(argv[++i]);
+      }
+      else if("--brotli-quality" == arg && hasValue) {
+         options.brotliQuality = std::atoi(argv[++i]);
+      }
+      else if("--min-savings" == arg && hasValue) {
+         options.minimumSavings = std::atof(argv[++i]);
+      }
+      else if(0 != arg.compare(0, 2, "--") && directory.empty()) {
+         directory = arg;
+      }
+      else if(0 != arg.compare(0, 2, "--") && archive.empty()) {
+         archive = arg;
+      }
+      else {
+         usage(argv[0]);
+         return 1;
+      }
+   }
+   if(directory.empty() || archive.empty()) {
+      usage(argv[0]);
+      return 1;
+   }
+
+   try {
+      const size_t assets = AssetArchive::pack(directory, archive, options);
+      std::cout << "packed " << assets << " assets into " << archive << std::endl;
+   }
+   catch(std::runtime_error& ex) {
+      std::cerr << ex.what() << std::endl;
+      return 1;
+   }
+   return 0;
+}
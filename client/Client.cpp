@@ -4,8 +4,8 @@
 #include "tcp/windows/Client.h"
 #include "tcp/windows/Callback.h"
 #else
-#include "tcp/posix/Client.h"
-#include "tcp/posix/Callback.h"
+#include "client/posix/Client.h"
+#include "client/posix/Callback.h"
 #endif
 
 namespace c11http {
@@ -14,7 +14,7 @@ namespace c11http {
 #ifdef WINDOWS
 		class Client::PlatformCallback : public windows::Callback
 #else
-		class Client::PlatformCallback : public posix::Callback
+		class Client::PlatformCallback : public client::posix::Callback
 #endif
 		{
 		public:
@@ -67,7 +67,7 @@ namespace c11http {
 #ifdef WINDOWS
 				mClient = new windows::Client(callback, hostname, port, onConnectMessage);
 #else
-				mClient = new posix::Client(callback, hostname, port, onConnectMessage);
+				mClient = new client::posix::Client(callback, hostname, port, onConnectMessage);
 #endif
 			}
 
@@ -90,7 +90,7 @@ namespace c11http {
 #ifdef WINDOWS
 			windows::Client* mClient;
 #else
-			posix::Client* mClient;
+			client::posix::Client* mClient;
 #endif
 		};
 
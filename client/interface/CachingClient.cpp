@@ -0,0 +1,268 @@
+#include "client/interface/CachingClient.h"
+
+#include "objects/HttpRequest.h"
+#include "objects/HttpResponse.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+namespace c11http {
+namespace client {
+
+namespace {
+
+std::string trim(const std::string& value) {
+   const size_t begin = value.find_first_not_of(" \t");
+   if(std::string::npos == begin) return std::string();
+   return value.substr(begin, value.find_last_not_of(" \t") - begin + 1);
+}
+
+std::string lower(std::string value) {
+   std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+   return value;
+}
+
+/**
+ * Split a comma separated header value into its trimmed, non empty elements.
+ */
+std::vector<std::string> splitList(const std::string& value) {
+   std::vector<std::string> elements;
+   size_t begin = 0;
+   while(begin <= value.size()) {
+      size_t end = value.find(',', begin);
+      if(std::string::npos == end) end = value.size();
+      const std::string element = trim(value.substr(begin, end - begin));
+      if(!element.empty()) elements.push_back(element);
+      begin = end + 1;
+   }
+   return elements;
+}
+
+/**
+ * The Cache-Control directives the cache acts on.
+ */
+struct CacheControl {
+   CacheControl(const std::string& value) : noStore(false), noCache(false), isPrivate(false), isPublic(false),
+         maxAge(-1), sMaxAge(-1) {
+      const std::vector<std::string> directives = splitList(value);
+      for(size_t i = 0; i < directives.size(); ++i) {
+         const size_t equals = directives[i].find('=');
+         const std::string name = lower(trim(directives[i].substr(0, equals)));
+         std::string argument = (std::string::npos == equals) ? "" : trim(directives[i].substr(equals + 1));
+         if(argument.size() >= 2 && '"' == argument[0]) argument = argument.substr(1, argument.size() - 2);
+
+         if("no-store" == name) noStore = true;
+         else if("no-cache" == name) noCache = true;
+         else if("private" == name) isPrivate = true;
+         else if("public" == name) isPublic = true;
+         else if("max-age" == name) maxAge = parseSeconds(argument);
+         else if("s-maxage" == name) sMaxAge = parseSeconds(argument);
+      }
+   }
+
+   static long parseSeconds(const std::string& argument) {
+      if(argument.empty() || !isdigit(static_cast<unsigned char>(argument[0]))) return -1;
+      return strtol(argument.c_str(), 0, 10);
+   }
+
+   bool noStore;
+   bool noCache;
+   bool isPrivate;
+   bool isPublic;
+   long maxAge; //-1 if absent
+   long sMaxAge;
+};
+
+bool isCacheableStatus(const unsigned int status) {
+   return 200 == status || 203 == status || 300 == status || 301 == status || 404 == status || 410 == status;
+}
+
+/**
+ * Fill in how long entry stays fresh, and what it varies on, from its response to req. Returns false if the
+ * response may not be stored, or would never be reusable.
+ */
+bool describe(const objects::HttpRequest& req, ResponseCache::Entry& entry) {
+   const objects::HttpResponse& resp = entry.response;
+   const CacheControl control(resp.getHeader("cache-control"));
+   if(control.noStore || control.isPrivate) return false;
+   //responses to authorized requests are only shared when the server says so
+   if(req.hasHeader("authorization") && !control.isPublic && control.sMaxAge < 0) return false;
+
+   entry.vary.clear();
+   const std::vector<std::string> vary = splitList(resp.getHeader("vary"));
+   for(size_t i = 0; i < vary.size(); ++i) {
+      if("*" == vary[i]) return false;
+      const std::string name = lower(vary[i]);
+      entry.vary.push_back(std::make_pair(name, req.getHeader(name)));
+   }
+
+   const long lifetime = (control.sMaxAge >= 0) ? control.sMaxAge : control.maxAge;
+   const long age = resp.hasHeader("age") ? std::max(0L, CacheControl::parseSeconds(resp.getHeader("age"))) : 0;
+   const long remaining = std::max(0L, lifetime - age);
+   entry.expires = entry.storedAt + std::chrono::seconds(remaining);
+   entry.alwaysRevalidate = control.noCache;
+
+   const bool hasValidator = resp.hasHeader("etag") || resp.hasHeader("last-modified");
+   return remaining > 0 || hasValidator;
+}
+
+bool varyMatches(const objects::HttpRequest& req, const ResponseCache::Entry& entry) {
+   for(size_t i = 0; i < entry.vary.size(); ++i) {
+      if(req.getHeader(entry.vary[i].first) != entry.vary[i].second) return false;
+   }
+   return true;
+}
+
+}
+
+CachingClient::Stats::Stats() : hits(0), misses(0), revalidations(0), stores(0) {
+
+}
+
+CachingClient::CachingClient(IClient* client, ResponseCache* cache, const std::string& origin)
+   : IClient(IClient::ClientResponseCallback()), mClient(client), mCache(cache), mOrigin(origin) {
+
+}
+
+CachingClient::~CachingClient() {
+
+}
+
+IClient* CachingClient::getClient() const {
+   return mClient;
+}
+
+const CachingClient::Stats& CachingClient::getStats() const {
+   return mStats;
+}
+
+std::string CachingClient::keyFor(const objects::HttpRequest& req) const {
+   std::string key(objects::HttpRequest::methodToString(req.getRequestMethod()));
+   key.append(" ");
+   key.append(mOrigin);
+   key.append(req.getTarget());
+   return key;
+}
+
+CachingClient::Action CachingClient::prepare(const objects::HttpRequest& req, std::string& key,
+      std::shared_ptr<const ResponseCache::Entry>& entry, objects::HttpRequest& sent) {
+   sent = req;
+   if(objects::HttpRequest::GET != req.getRequestMethod()) {
+      //a request that may change the resource makes what is cached for it out of date
+      objects::HttpRequest get(objects::HttpRequest::GET, req.getTarget(), "");
+      mCache->erase(keyFor(get));
+      return SEND;
+   }
+
+   const CacheControl control(req.getHeader("cache-control"));
+   if(control.noStore) return SEND;
+   key = keyFor(req);
+
+   //the caller asked for an end to end reload, or is validating a copy of its own, the response is still stored
+   if(control.noCache || lower(req.getHeader("pragma")) == "no-cache" || req.hasHeader("if-none-match") ||
+         req.hasHeader("if-modified-since")) {
+      ++mStats.misses;
+      return SEND;
+   }
+
+   entry = mCache->lookup(key);
+   if(entry && !varyMatches(req, *entry)) entry.reset();
+   if(!entry) {
+      ++mStats.misses;
+      return SEND;
+   }
+
+   if(entry->isFresh(ResponseCache::Clock::now())) {
+      ++mStats.hits;
+      return ANSWER;
+   }
+
+   const objects::HttpResponse& cached = entry->response;
+   if(!cached.hasHeader("etag") && !cached.hasHeader("last-modified")) {
+      entry.reset();
+      ++mStats.misses;
+      return SEND;
+   }
+   if(cached.hasHeader("etag")) sent.setHeader("If-None-Match", cached.getHeader("etag"));
+   if(cached.hasHeader("last-modified")) sent.setHeader("If-Modified-Since", cached.getHeader("last-modified"));
+   return REVALIDATE;
+}
+
+objects::HttpResponse CachingClient::complete(const objects::HttpRequest& req, const std::string& key,
+      const std::shared_ptr<const ResponseCache::Entry>& entry, const objects::HttpResponse& resp) {
+   if(key.empty()) return resp;
+
+   std::shared_ptr<ResponseCache::Entry> updated(new ResponseCache::Entry());
+   updated->storedAt = ResponseCache::Clock::now();
+
+   if(entry && 304 == resp.getStatus()) {
+      //still valid, the 304's headers replace those stored while the body is kept
+      updated->response = entry->response;
+      const objects::HttpResponse::Headers& headers = resp.getHeaders();
+      for(objects::HttpResponse::Headers::const_iterator iter = headers.begin(); iter != headers.end(); ++iter) {
+         if("content-length" != iter->first && "transfer-encoding" != iter->first) {
+            updated->response.setHeader(iter->first, iter->second);
+         }
+      }
+      ++mStats.revalidations;
+      if(describe(req, *updated)) mCache->store(key, updated);
+      else mCache->erase(key);
+      return updated->response;
+   }
+
+   if(!isCacheableStatus(resp.getStatus())) return resp;
+
+   updated->response = resp;
+   if(describe(req, *updated)) {
+      mCache->store(key, updated);
+      ++mStats.stores;
+   }
+   else if(entry) {
+      mCache->erase(key);
+   }
+   return resp;
+}
+
+void CachingClient::sendRequestAsync(const objects::HttpRequest& req, const IClient::ClientResponseCallback& onResponse,
+      const IClient::ClientFailureCallback& onFailure) {
+   std::string key;
+   std::shared_ptr<const ResponseCache::Entry> entry;
+   objects::HttpRequest sent;
+   if(ANSWER == prepare(req, key, entry, sent)) {
+      onResponse(entry->response);
+      return;
+   }
+
+   mClient->sendRequestAsync(sent, [this, req, key, entry, onResponse](const objects::HttpResponse& resp) {
+      onResponse(complete(req, key, entry, resp));
+   }, onFailure);
+}
+
+objects::HttpResponse CachingClient::sendRequestToServer(const objects::HttpRequest& req) {
+   std::string key;
+   std::shared_ptr<const ResponseCache::Entry> entry;
+   objects::HttpRequest sent;
+   if(ANSWER == prepare(req, key, entry, sent)) return entry->response;
+
+   return complete(req, key, entry, mClient->sendRequestToServer(sent));
+}
+
+void CachingClient::connectToServer(const std::string& ip, const unsigned int port) {
+   mClient->connectToServer(ip, port);
+}
+
+void CachingClient::disconnect() {
+   mClient->disconnect();
+}
+
+void CachingClient::performServerConnection(const std::string& ip, const unsigned int port) {
+
+}
+
+void CachingClient::writeRequest(const std::string& bytes) {
+
+}
+
+}
+}
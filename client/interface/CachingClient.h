@@ -0,0 +1,103 @@
+#pragma once
+
+#include "client/interface/Platform.h"
+#include "client/interface/IClient.h"
+#include "client/interface/ResponseCache.h"
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <string>
+
+namespace c11http {
+
+namespace objects {
+class HttpRequest;
+class HttpResponse;
+}
+
+namespace client {
+
+/**
+ * Answers GET requests from a ResponseCache where the cached response is still fresh, and sends the rest through
+ * a client. Freshness follows the response's Cache-Control as a shared cache would, s-maxage taking precedence
+ * over max-age, less any Age it already had. Stale responses carrying an ETag or Last-Modified are revalidated
+ * with If-None-Match or If-Modified-Since, a 304 refreshing the cached response rather than transferring it again.
+ * Responses marked no-store or private, and requests carrying no-cache, no-store or their own conditions, bypass
+ * the cache. Expires is not consulted, responses without max-age are only reused after revalidation.
+ *
+ * Several CachingClients, e.g. one per pooled connection, may share a cache. The origin given on construction
+ * becomes part of every key, so clients of different servers can share one too. Being an IClient itself, it may
+ * wrap, or be wrapped by, another client such as a HedgingClient.
+ */
+class CLIENT_INTERFACE_API CachingClient : public IClient {
+public:
+   struct Stats {
+      Stats();
+      std::atomic<size_t> hits; //answered from the cache without a request
+      std::atomic<size_t> misses; //sent to the server, nothing usable cached
+      std::atomic<size_t> revalidations; //stale responses confirmed by a 304
+      std::atomic<size_t> stores; //responses stored
+   };
+
+   /**
+    * Neither client nor cache are owned, and must outlive this object.
+    */
+   CachingClient(IClient* client, ResponseCache* cache, const std::string& origin = "");
+   ~CachingClient();
+
+   using IClient::sendRequestAsync;
+   /**
+    * Send a request, answering it from the cache if possible, in which case onResponse is called before this
+    * returns. Otherwise as IClient::sendRequestAsync.
+    */
+   virtual void sendRequestAsync(const objects::HttpRequest& req, const IClient::ClientResponseCallback& onResponse,
+         const IClient::ClientFailureCallback& onFailure = IClient::ClientFailureCallback());
+   /**
+    * Send a request and wait for its response, answering it from the cache if possible.
+    */
+   virtual objects::HttpResponse sendRequestToServer(const objects::HttpRequest& req);
+   /**
+    * Connect, or disconnect, the wrapped client.
+    */
+   virtual void connectToServer(const std::string& ip, const unsigned int port);
+   virtual void disconnect();
+
+   IClient* getClient() const;
+   const Stats& getStats() const;
+
+protected:
+   /**
+    * Requests are written by the wrapped client, never by this one.
+    */
+   virtual void performServerConnection(const std::string& ip, const unsigned int port);
+   virtual void writeRequest(const std::string& bytes);
+
+private:
+   /**
+    * What to do with a request: answer it from the entry, send it as is, or send it with the conditions
+    * revalidating the entry.
+    */
+   enum Action {
+      ANSWER,
+      SEND,
+      REVALIDATE
+   };
+   Action prepare(const objects::HttpRequest& req, std::string& key, std::shared_ptr<const ResponseCache::Entry>& entry,
+         objects::HttpRequest& sent);
+   /**
+    * The server answered a request sent for key, returning the response to hand to the caller. Stores the
+    * response if it may be cached, or refreshes entry if it was revalidated.
+    */
+   objects::HttpResponse complete(const objects::HttpRequest& req, const std::string& key,
+         const std::shared_ptr<const ResponseCache::Entry>& entry, const objects::HttpResponse& resp);
+   std::string keyFor(const objects::HttpRequest& req) const;
+
+   IClient* mClient;
+   ResponseCache* mCache;
+   const std::string mOrigin;
+   Stats mStats;
+};
+
+}
+}
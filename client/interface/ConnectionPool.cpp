@@ -0,0 +1,162 @@
+#include "client/interface/ConnectionPool.h"
+#include "client/interface/IClient.h"
+
+#include <sstream>
+#include <vector>
+
+namespace c11http {
+namespace client {
+
+ConnectionPool::Limits::Limits() : maxIdlePerHost(8), maxActivePerHost(64), idleTimeoutMilliseconds(30000),
+   evictionIntervalMilliseconds(1000) {
+
+}
+
+ConnectionPool::Host::Host() : active(0) {
+
+}
+
+ConnectionPool::ConnectionPool(const ClientFactory& factory, const Limits& limits, const HealthCheck& healthCheck) :
+   mFactory(factory), mHealthCheck(healthCheck), mLimits(limits), mTimers(0), mEvictionTimer(0) {
+
+}
+
+ConnectionPool::~ConnectionPool() {
+   if(0 != mTimers) mTimers->cancel(mEvictionTimer);
+   for(std::map<std::string, Host>::iterator host = mHosts.begin(); host != mHosts.end(); ++host) {
+      for(std::list<IdleConnection>::iterator iter = host->second.idle.begin(); iter != host->second.idle.end(); ++iter) {
+         closeConnection(iter->client);
+      }
+   }
+}
+
+IClient* ConnectionPool::acquire(const std::string& host, const unsigned int port) throw (std::runtime_error) {
+   const std::string key = keyFor(host, port);
+   {
+      std::lock_guard<std::mutex> lock(mMutex);
+      Host& entry = mHosts[key];
+      if(entry.active >= mLimits.maxActivePerHost) {
+         throw(std::runtime_error("Too many active connections to " + key));
+      }
+      ++entry.active;
+      if(!entry.idle.empty()) {
+         IClient* client = entry.idle.front().client;
+         entry.idle.pop_front();
+         mActive[client] = key;
+         return client;
+      }
+   }
+
+   //connect outside the lock, other hosts should not wait on this one
+   IClient* client = 0;
+   try {
+      client = mFactory(host, port);
+   }
+   catch(std::runtime_error&) {
+      std::lock_guard<std::mutex> lock(mMutex);
+      --mHosts[key].active;
+      throw;
+   }
+
+   std::lock_guard<std::mutex> lock(mMutex);
+   mActive[client] = key;
+   return client;
+}
+
+void ConnectionPool::release(IClient* client) {
+   const std::string key = deactivate(client);
+   if(mHealthCheck && !mHealthCheck(client)) {
+      closeConnection(client);
+      return;
+   }
+
+   {
+      std::lock_guard<std::mutex> lock(mMutex);
+      Host& entry = mHosts[key];
+      if(entry.idle.size() < mLimits.maxIdlePerHost) {
+         IdleConnection idle;
+         idle.client = client;
+         idle.since = Clock::now();
+         entry.idle.push_front(idle);
+         return;
+      }
+   }
+   closeConnection(client);
+}
+
+void ConnectionPool::discard(IClient* client) {
+   deactivate(client);
+   closeConnection(client);
+}
+
+size_t ConnectionPool::evictIdle() {
+   std::vector<IClient*> expired;
+   {
+      std::lock_guard<std::mutex> lock(mMutex);
+      const Clock::time_point cutoff = Clock::now() - std::chrono::milliseconds(mLimits.idleTimeoutMilliseconds);
+      for(std::map<std::string, Host>::iterator host = mHosts.begin(); host != mHosts.end(); ++host) {
+         //least recently released connections are at the back
+         std::list<IdleConnection>& idle = host->second.idle;
+         while(!idle.empty() && idle.back().since <= cutoff) {
+            expired.push_back(idle.back().client);
+            idle.pop_back();
+         }
+      }
+   }
+
+   for(std::vector<IClient*>::iterator iter = expired.begin(); iter != expired.end(); ++iter) {
+      closeConnection(*iter);
+   }
+   return expired.size();
+}
+
+void ConnectionPool::scheduleEviction(workers::TimerWheel& timers) {
+   if(0 != mTimers) mTimers->cancel(mEvictionTimer);
+   mTimers = &timers;
+   mEvictionTimer = mTimers->schedule(mLimits.evictionIntervalMilliseconds, [this]() {
+      onEvictionTimer();
+   });
+}
+
+void ConnectionPool::onEvictionTimer() {
+   evictIdle();
+   mEvictionTimer = mTimers->schedule(mLimits.evictionIntervalMilliseconds, [this]() {
+      onEvictionTimer();
+   });
+}
+
+size_t ConnectionPool::idleCount(const std::string& host, const unsigned int port) {
+   std::lock_guard<std::mutex> lock(mMutex);
+   std::map<std::string, Host>::iterator iter = mHosts.find(keyFor(host, port));
+   return (iter == mHosts.end()) ? 0 : iter->second.idle.size();
+}
+
+size_t ConnectionPool::activeCount(const std::string& host, const unsigned int port) {
+   std::lock_guard<std::mutex> lock(mMutex);
+   std::map<std::string, Host>::iterator iter = mHosts.find(keyFor(host, port));
+   return (iter == mHosts.end()) ? 0 : iter->second.active;
+}
+
+std::string ConnectionPool::keyFor(const std::string& host, const unsigned int port) {
+   std::stringstream sstr;
+   sstr << host << ":" << port;
+   return sstr.str();
+}
+
+std::string ConnectionPool::deactivate(IClient* client) throw (std::runtime_error) {
+   std::lock_guard<std::mutex> lock(mMutex);
+   std::map<IClient*, std::string>::iterator iter = mActive.find(client);
+   if(iter == mActive.end()) throw(std::runtime_error("Connection was not acquired from this pool"));
+   const std::string key = iter->second;
+   mActive.erase(iter);
+   --mHosts[key].active;
+   return key;
+}
+
+void ConnectionPool::closeConnection(IClient* client) {
+   client->disconnect();
+   delete client;
+}
+
+}
+}
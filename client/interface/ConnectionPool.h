@@ -0,0 +1,108 @@
+#pragma once
+
+#include "client/interface/Platform.h"
+
+#include "workers/TimerWheel.h"
+
+#include <chrono>
+#include <functional>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace c11http {
+namespace client {
+
+class IClient;
+
+/**
+ * Keep-alive pool of client connections, keyed by host:port. Connections are handed out with acquire and given
+ * back with release, so that repeated requests to the same server reuse an established connection rather than
+ * paying for the connect and identifier handshake each time. Thread safe.
+ */
+class CLIENT_INTERFACE_API ConnectionPool {
+public:
+   /**
+    * Create a new connection to host:port. Throws if the connection cannot be made.
+    */
+   typedef std::function<IClient*(const std::string& host, const unsigned int port)> ClientFactory;
+   /**
+    * Returns false if a connection given back to the pool is no longer usable.
+    */
+   typedef std::function<bool(IClient*)> HealthCheck;
+
+   struct Limits {
+      Limits();
+      size_t maxIdlePerHost; //idle connections kept per host, extra connections are closed on release
+      size_t maxActivePerHost; //connections handed out at once per host
+      unsigned int idleTimeoutMilliseconds; //idle connections unused this long are closed
+      unsigned int evictionIntervalMilliseconds; //how often idle connections are checked
+   };
+
+   ConnectionPool(const ClientFactory& factory, const Limits& limits = Limits(),
+         const HealthCheck& healthCheck = HealthCheck());
+   /**
+    * Closes every idle connection. Connections still handed out are owned by their users from then on.
+    */
+   ~ConnectionPool();
+
+   /**
+    * Take a connection to host:port, reusing the most recently released idle connection if there is one.
+    * Throws if maxActivePerHost connections to the host are already handed out.
+    */
+   IClient* acquire(const std::string& host, const unsigned int port) throw (std::runtime_error);
+   /**
+    * Give a connection back for reuse. Connections failing the health check, or beyond maxIdlePerHost,
+    * are closed instead.
+    */
+   void release(IClient* client);
+   /**
+    * Close a connection that failed, instead of giving it back.
+    */
+   void discard(IClient* client);
+   /**
+    * Close idle connections that have not been used for idleTimeoutMilliseconds, returning how many were closed.
+    */
+   size_t evictIdle();
+   /**
+    * Run evictIdle every evictionIntervalMilliseconds from timers. The wheel must outlive this pool, and
+    * be advanced by the event loop that owns it.
+    */
+   void scheduleEviction(workers::TimerWheel& timers);
+
+   size_t idleCount(const std::string& host, const unsigned int port);
+   size_t activeCount(const std::string& host, const unsigned int port);
+
+private:
+   typedef std::chrono::steady_clock Clock;
+   struct IdleConnection {
+      IClient* client;
+      Clock::time_point since;
+   };
+   struct Host {
+      Host();
+      std::list<IdleConnection> idle; //most recently released at the front
+      size_t active;
+   };
+
+   static std::string keyFor(const std::string& host, const unsigned int port);
+   /**
+    * Remove client from the active connections, returning the key of its host.
+    */
+   std::string deactivate(IClient* client) throw (std::runtime_error);
+   void closeConnection(IClient* client);
+   void onEvictionTimer();
+
+   ClientFactory mFactory;
+   HealthCheck mHealthCheck;
+   const Limits mLimits;
+   std::map<std::string, Host> mHosts;
+   std::map<IClient*, std::string> mActive; //host key of each connection handed out
+   std::mutex mMutex;
+   workers::TimerWheel* mTimers;
+   workers::TimerWheel::TimerId mEvictionTimer;
+};
+
+}
+}
@@ -0,0 +1,175 @@
+#include "client/interface/HedgingClient.h"
+
+#include "objects/HttpRequest.h"
+#include "objects/HttpResponse.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace c11http {
+namespace client {
+
+/**
+ * A request and its attempts. The first attempt to answer completes it, later answers are dropped.
+ */
+struct HedgingClient::Flight {
+   Flight(const objects::HttpRequest& request) : req(request), primary(0), done(false), hedged(false),
+         outstanding(0) {
+
+   }
+   const objects::HttpRequest req;
+   IClient::ClientResponseCallback onResponse;
+   IClient::ClientFailureCallback onFailure;
+   size_t primary; //endpoint of the original attempt
+   std::mutex mutex;
+   bool done;
+   bool hedged;
+   int outstanding; //attempts sent and not yet answered or failed
+};
+
+HedgingClient::Policy::Policy() : percentile(95.0), initialDelayMilliseconds(50), minDelayMilliseconds(1),
+      window(1000), budgetPercent(5.0), budgetBurst(10.0) {
+
+}
+
+HedgingClient::HedgingClient(const std::vector<IClient*>& endpoints, const Scheduler& scheduler,
+      const Policy& policy) : IClient(IClient::ClientResponseCallback()), mEndpoints(endpoints), mScheduler(scheduler), mPolicy(policy), mNextEndpoint(0),
+      mRequests(0), mHedges(0), mHedgeWins(0), mHedgeDelayMilliseconds(policy.initialDelayMilliseconds),
+      mBudget(policy.budgetBurst) {
+
+}
+
+HedgingClient::~HedgingClient() {
+
+}
+
+size_t HedgingClient::getRequests() const {
+   return mRequests;
+}
+
+size_t HedgingClient::getHedges() const {
+   return mHedges;
+}
+
+size_t HedgingClient::getHedgeWins() const {
+   return mHedgeWins;
+}
+
+double HedgingClient::getHedgeRate() const {
+   const size_t requests = mRequests;
+   return 0 == requests ? 0.0 : static_cast<double>(mHedges) / requests;
+}
+
+unsigned int HedgingClient::getHedgeDelayMilliseconds() {
+   std::lock_guard<std::mutex> lock(mMutex);
+   return mHedgeDelayMilliseconds;
+}
+
+void HedgingClient::sendRequestAsync(const objects::HttpRequest& req, const IClient::ClientResponseCallback& onResponse,
+      const IClient::ClientFailureCallback& onFailure) {
+   std::shared_ptr<Flight> flight(new Flight(req));
+   flight->onResponse = onResponse;
+   flight->onFailure = onFailure;
+   flight->primary = mNextEndpoint++ % mEndpoints.size();
+   ++mRequests;
+
+   {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mBudget = std::min(mPolicy.budgetBurst, mBudget + mPolicy.budgetPercent / 100.0);
+   }
+
+   const bool hedgeable = objects::HttpRequest::GET == req.getRequestMethod() && mEndpoints.size() > 1;
+   sendAttempt(flight, flight->primary, false);
+   if(hedgeable) {
+      mScheduler(getHedgeDelayMilliseconds(), [this, flight]() {
+         hedge(flight);
+      });
+   }
+}
+
+objects::HttpResponse HedgingClient::sendRequestToServer(const objects::HttpRequest& req) {
+   return sendRequestAsync(req).get();
+}
+
+void HedgingClient::connectToServer(const std::string& ip, const unsigned int port) {
+   throw(std::runtime_error("HedgingClient endpoints are connected individually"));
+}
+
+void HedgingClient::disconnect() {
+   for(size_t i = 0; i < mEndpoints.size(); ++i) {
+      mEndpoints[i]->disconnect();
+   }
+}
+
+void HedgingClient::performServerConnection(const std::string& ip, const unsigned int port) {
+
+}
+
+void HedgingClient::writeRequest(const std::string& bytes) {
+
+}
+
+void HedgingClient::sendAttempt(const std::shared_ptr<Flight>& flight, const size_t endpoint, const bool hedge) {
+   {
+      std::lock_guard<std::mutex> lock(flight->mutex);
+      ++flight->outstanding;
+   }
+
+   const Clock::time_point sent = Clock::now();
+   mEndpoints[endpoint]->sendRequestAsync(flight->req, [this, flight, hedge, sent](const objects::HttpResponse& resp) {
+      recordLatency(Clock::now() - sent);
+      {
+         std::lock_guard<std::mutex> lock(flight->mutex);
+         --flight->outstanding;
+         if(flight->done) return;
+         flight->done = true;
+      }
+      if(hedge) ++mHedgeWins;
+      if(flight->onResponse) flight->onResponse(resp);
+   }, [this, flight](const std::string& reason) {
+      {
+         std::lock_guard<std::mutex> lock(flight->mutex);
+         --flight->outstanding;
+         //the other attempt may still answer, failure is only reported once none can
+         if(flight->done || flight->outstanding > 0) return;
+         flight->done = true;
+      }
+      if(flight->onFailure) flight->onFailure(reason);
+   });
+}
+
+void HedgingClient::hedge(const std::shared_ptr<Flight>& flight) {
+   {
+      std::lock_guard<std::mutex> lock(flight->mutex);
+      if(flight->done || flight->hedged) return;
+      flight->hedged = true;
+   }
+   if(!takeHedge()) return;
+
+   ++mHedges;
+   sendAttempt(flight, (flight->primary + 1) % mEndpoints.size(), true);
+}
+
+bool HedgingClient::takeHedge() {
+   std::lock_guard<std::mutex> lock(mMutex);
+   if(mBudget < 1.0) return false;
+   mBudget -= 1.0;
+   return true;
+}
+
+void HedgingClient::recordLatency(const Clock::duration& latency) {
+   const long long micros = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+
+   std::lock_guard<std::mutex> lock(mMutex);
+   mLatencies.record(static_cast<unsigned long long>(std::max(1LL, micros)));
+   if(mLatencies.getTotalCount() < mPolicy.window) return;
+
+   //windows are replaced rather than accumulated, so the delay follows the backend as it speeds up or slows down
+   const unsigned long long delay = mLatencies.valueAtPercentile(mPolicy.percentile) / 1000;
+   mHedgeDelayMilliseconds = static_cast<unsigned int>(std::max<unsigned long long>(mPolicy.minDelayMilliseconds,
+         delay));
+   mLatencies.reset();
+}
+
+}
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "client/interface/Platform.h"
+#include "client/interface/IClient.h"
+
+#include "workers/HdrHistogram.h"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace c11http {
+
+namespace objects {
+class HttpRequest;
+class HttpResponse;
+}
+
+namespace client {
+
+/**
+ * Sends requests across a set of equivalent endpoints, e.g. one connection to each server of a backend, to cut
+ * tail latency. A GET that has not been answered within a percentile of recently observed latencies is sent again
+ * to the next endpoint, and whichever response arrives first is used. How many requests are hedged is capped by
+ * a budget, so a slow backend is not sent twice its load. Other methods are sent once, as they may not be safe
+ * to repeat.
+ *
+ * A request already written to a pipelined connection cannot be withdrawn without closing the connection, so
+ * the losing attempt is abandoned rather than cancelled, its response dropped when it arrives.
+ *
+ * Being an IClient itself, it may be wrapped by another client, e.g. a CachingClient sending only its misses on.
+ */
+class CLIENT_INTERFACE_API HedgingClient : public IClient {
+public:
+   /**
+    * Run a task after milliseconds, e.g. ClientEngine::runAfter.
+    */
+   typedef std::function<void(const unsigned int milliseconds, const std::function<void()>& task)> Scheduler;
+
+   struct Policy {
+      Policy();
+      double percentile; //hedge requests slower than this percentile of recent latency
+      unsigned int initialDelayMilliseconds; //hedge delay until a window of latencies has been seen
+      unsigned int minDelayMilliseconds;
+      size_t window; //latencies per window, the delay is recomputed as each fills
+      double budgetPercent; //hedges allowed per hundred requests
+      double budgetBurst; //hedges that may be saved up
+   };
+
+   /**
+    * There must be at least one endpoint. Neither the endpoints nor what the scheduler runs on are owned, and
+    * they must outlive this object, which must in turn outlive the requests it sends.
+    */
+   HedgingClient(const std::vector<IClient*>& endpoints, const Scheduler& scheduler, const Policy& policy = Policy());
+   ~HedgingClient();
+
+   using IClient::sendRequestAsync;
+   virtual void sendRequestAsync(const objects::HttpRequest& req, const IClient::ClientResponseCallback& onResponse,
+         const IClient::ClientFailureCallback& onFailure = IClient::ClientFailureCallback());
+   /**
+    * Send a request and wait for whichever attempt answers it first. Must not be called from the thread the
+    * endpoints answer on.
+    */
+   virtual objects::HttpResponse sendRequestToServer(const objects::HttpRequest& req);
+   /**
+    * Endpoints are connected each to its own server, so this throws.
+    */
+   virtual void connectToServer(const std::string& ip, const unsigned int port);
+   /**
+    * Disconnect every endpoint.
+    */
+   virtual void disconnect();
+
+   size_t getRequests() const;
+   size_t getHedges() const;
+   /**
+    * Hedged requests answered by the hedge rather than the original.
+    */
+   size_t getHedgeWins() const;
+   /**
+    * Fraction of requests that were hedged.
+    */
+   double getHedgeRate() const;
+   unsigned int getHedgeDelayMilliseconds();
+
+protected:
+   /**
+    * Requests are written by the endpoints, never by this client.
+    */
+   virtual void performServerConnection(const std::string& ip, const unsigned int port);
+   virtual void writeRequest(const std::string& bytes);
+
+private:
+   typedef std::chrono::steady_clock Clock;
+   struct Flight;
+
+   void sendAttempt(const std::shared_ptr<Flight>& flight, const size_t endpoint, const bool hedge);
+   void hedge(const std::shared_ptr<Flight>& flight);
+   /**
+    * Take a hedge from the budget, returning false if it is spent.
+    */
+   bool takeHedge();
+   void recordLatency(const Clock::duration& latency);
+
+   const std::vector<IClient*> mEndpoints;
+   Scheduler mScheduler;
+   const Policy mPolicy;
+   std::atomic<size_t> mNextEndpoint;
+   std::atomic<size_t> mRequests;
+   std::atomic<size_t> mHedges;
+   std::atomic<size_t> mHedgeWins;
+
+   std::mutex mMutex; //guards the latency window, delay and budget
+   workers::HdrHistogram mLatencies; //microseconds, of the current window
+   unsigned int mHedgeDelayMilliseconds;
+   double mBudget;
+};
+
+}
+}
@@ -1,15 +1,158 @@
 #include "client/interface/IClient.h"
 
+#include "objects/HttpRequest.h"
+#include "objects/HttpResponse.h"
+
+#include <memory>
+
 namespace c11http {
 namespace client {
 
-IClient::IClient(const IClient::ClientResponseCallback& callback) : mCallback(callback) {
+IClient::IClient(const IClient::ClientResponseCallback& callback) : mCallback(callback), mMaxInFlight(0),
+   mCoalesceGets(false), mCoalesced(0) {
+
+}
+
+IClient::~IClient() {
+
+}
+
+void IClient::sendRequestAsync(const objects::HttpRequest& req, const ClientResponseCallback& onResponse,
+      const ClientFailureCallback& onFailure) {
+   PendingRequest pending;
+   req.serialize(pending.bytes);
+   pending.onResponse = onResponse;
+   pending.onFailure = onFailure;
 
+   std::unique_lock<std::mutex> lock(mMutex);
+   if(isClosed()) {
+      lock.unlock();
+      if(onFailure) onFailure("Not connected to server");
+      return;
+   }
+   if(mCoalesceGets && objects::HttpRequest::GET == req.getRequestMethod()) {
+      std::map<std::string, std::shared_ptr<Waiters> >::iterator found = mCoalescing.find(pending.bytes);
+      if(mCoalescing.end() != found) {
+         found->second->push_back(std::make_pair(onResponse, onFailure));
+         ++mCoalesced;
+         return;
+      }
+
+      //the request sent answers everyone who joins it until its response arrives
+      std::shared_ptr<Waiters> waiters(new Waiters());
+      waiters->push_back(std::make_pair(onResponse, onFailure));
+      mCoalescing[pending.bytes] = waiters;
+      const std::string key(pending.bytes);
+      pending.onResponse = [this, key, waiters](const objects::HttpResponse& resp) {
+         std::shared_ptr<Waiters> answered = takeWaiters(key, waiters);
+         for(Waiters::iterator iter = answered->begin(); iter != answered->end(); ++iter) {
+            if(iter->first) iter->first(resp);
+         }
+      };
+      pending.onFailure = [this, key, waiters](const std::string& reason) {
+         std::shared_ptr<Waiters> failed = takeWaiters(key, waiters);
+         for(Waiters::iterator iter = failed->begin(); iter != failed->end(); ++iter) {
+            if(iter->second) iter->second(reason);
+         }
+      };
+   }
+   mHeld.push_back(pending);
+   writeHeldRequests();
+}
+
+std::future<objects::HttpResponse> IClient::sendRequestAsync(const objects::HttpRequest& req) {
+   std::shared_ptr<std::promise<objects::HttpResponse> > promise(new std::promise<objects::HttpResponse>());
+   sendRequestAsync(req, [promise](const objects::HttpResponse& resp) {
+      promise->set_value(resp);
+   }, [promise](const std::string& reason) {
+      promise->set_exception(std::make_exception_ptr(std::runtime_error(reason)));
+   });
+   return promise->get_future();
+}
+
+void IClient::setMaxInFlight(const size_t maxInFlight) {
+   std::lock_guard<std::mutex> lock(mMutex);
+   mMaxInFlight = maxInFlight;
+   writeHeldRequests();
+}
+
+void IClient::setCoalesceGets(const bool coalesce) {
+   std::lock_guard<std::mutex> lock(mMutex);
+   mCoalesceGets = coalesce;
+}
+
+size_t IClient::getCoalesced() {
+   std::lock_guard<std::mutex> lock(mMutex);
+   return mCoalesced;
+}
+
+std::shared_ptr<IClient::Waiters> IClient::takeWaiters(const std::string& key,
+      const std::shared_ptr<Waiters>& waiters) {
+   std::shared_ptr<Waiters> taken(new Waiters());
+   std::lock_guard<std::mutex> lock(mMutex);
+   std::map<std::string, std::shared_ptr<Waiters> >::iterator found = mCoalescing.find(key);
+   if(mCoalescing.end() != found && found->second == waiters) mCoalescing.erase(found);
+   taken->swap(*waiters);
+   return taken;
+}
+
+size_t IClient::getInFlight() {
+   std::lock_guard<std::mutex> lock(mMutex);
+   return mInFlight.size();
+}
+
+bool IClient::hasRequestsInFlight() {
+   std::lock_guard<std::mutex> lock(mMutex);
+   return !mInFlight.empty();
+}
+
+bool IClient::isClosed() const {
+   return false;
 }
 
 void IClient::receiveResponseFromServer(const objects::HttpResponse& resp) {
-   mCallback(resp);
+   ClientResponseCallback onResponse;
+   {
+      std::lock_guard<std::mutex> lock(mMutex);
+      if(!mInFlight.empty()) {
+         //responses arrive in request order, so this answers the oldest request
+         onResponse = mInFlight.front().onResponse;
+         mInFlight.pop_front();
+         writeHeldRequests();
+      }
+      else {
+         onResponse = mCallback;
+      }
+   }
+   if(onResponse) onResponse(resp);
+}
+
+void IClient::failRequests(const std::string& reason) {
+   std::deque<PendingRequest> failed;
+   {
+      std::lock_guard<std::mutex> lock(mMutex);
+      failed.swap(mInFlight);
+      failed.insert(failed.end(), mHeld.begin(), mHeld.end());
+      mHeld.clear();
+   }
+   for(std::deque<PendingRequest>::iterator iter = failed.begin(); iter != failed.end(); ++iter) {
+      if(iter->onFailure) iter->onFailure(reason);
+   }
 }
 
+void IClient::writeHeldRequests() {
+   while(!mHeld.empty() && (0 == mMaxInFlight || mInFlight.size() < mMaxInFlight)) {
+      mInFlight.push_back(PendingRequest());
+      PendingRequest& pending = mInFlight.back();
+      pending.bytes.swap(mHeld.front().bytes);
+      pending.onResponse = mHeld.front().onResponse;
+      pending.onFailure = mHeld.front().onFailure;
+      mHeld.pop_front();
+
+      writeRequest(pending.bytes);
+      pending.bytes.clear();
+   }
+}
+
+}
 }
-}
\ No newline at end of file
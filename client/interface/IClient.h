@@ -2,7 +2,15 @@
 
 #include "client/interface/Platform.h"
 
+#include <deque>
 #include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace c11http {
 
@@ -16,21 +24,99 @@ namespace client {
 class CLIENT_INTERFACE_API IClient {
 public:
    typedef std::function<void(const objects::HttpResponse&)> ClientResponseCallback;
+   /**
+    * A request could not be completed, e.g. the connection was closed before its response arrived.
+    */
+   typedef std::function<void(const std::string&)> ClientFailureCallback;
 
    IClient(const ClientResponseCallback& callback);
+   virtual ~IClient();
 
    virtual objects::HttpResponse sendRequestToServer(const objects::HttpRequest& req) = 0;
    virtual void connectToServer(const std::string& ip, const unsigned int port) = 0;
    virtual void disconnect() = 0;
 
+   /**
+    * Send a request without waiting for its response. Requests are pipelined on the connection and their
+    * responses matched to them in the order they were sent. Once maxInFlight requests are awaiting responses,
+    * further requests are held until a response arrives. Safe to call from any thread; the callbacks are
+    * called from the thread receiving responses. Clients wrapping another, e.g. CachingClient, override it to send
+    * through the client they wrap.
+    */
+   virtual void sendRequestAsync(const objects::HttpRequest& req, const ClientResponseCallback& onResponse,
+         const ClientFailureCallback& onFailure = ClientFailureCallback());
+   /**
+    * Send a request without waiting for its response, as above. The future holds a std::runtime_error if the
+    * request could not be completed.
+    */
+   std::future<objects::HttpResponse> sendRequestAsync(const objects::HttpRequest& req);
+   /**
+    * Maximum number of requests written to the connection without a response, 0 for no limit.
+    */
+   void setMaxInFlight(const size_t maxInFlight);
+   size_t getInFlight();
+   /**
+    * Coalesce identical GET requests: while a GET is held or in flight, an identical one (same target and
+    * headers) is not sent again, but answered with the same response, or failed with it. Off by default.
+    */
+   void setCoalesceGets(const bool coalesce);
+   /**
+    * Number of requests answered by joining an identical request rather than being sent.
+    */
+   size_t getCoalesced();
+
+   /**
+    * A response has been received from the server. Completes the oldest in flight request, or is passed
+    * to the callback given on construction if no request is in flight.
+    */
    void receiveResponseFromServer(const objects::HttpResponse& resp);
-   void connectToServer(const std::string& ip, const unsigned int port);
 protected:
    virtual void performServerConnection(const std::string& ip, const unsigned int port) = 0;
+   /**
+    * Write a serialized request to the server. Called in the order responses are expected, and must not
+    * block or call back into this object.
+    */
+   virtual void writeRequest(const std::string& bytes) = 0;
+   /**
+    * Fail every in flight and held request, e.g. when the connection is lost.
+    */
+   void failRequests(const std::string& reason);
+   bool hasRequestsInFlight();
+   /**
+    * The connection is closed, so a request sent now would never be answered nor failed, and is failed at once
+    * instead. Checked with the request lock held, so a transport marking itself closed before calling failRequests
+    * fails every request. Never closed by default.
+    */
+   virtual bool isClosed() const;
 
 private:
+   struct PendingRequest {
+      std::string bytes; //serialized request, empty once written
+      ClientResponseCallback onResponse;
+      ClientFailureCallback onFailure;
+   };
+   /**
+    * Callers waiting on a coalesced GET, the first being the caller that sent it.
+    */
+   typedef std::vector<std::pair<ClientResponseCallback, ClientFailureCallback> > Waiters;
+   /**
+    * The coalesced GET serialized as key was answered or failed, detach its waiters from the table.
+    */
+   std::shared_ptr<Waiters> takeWaiters(const std::string& key, const std::shared_ptr<Waiters>& waiters);
+   /**
+    * Write held requests while there is room in flight. Must be called with mMutex held.
+    */
+   void writeHeldRequests();
+
    ClientResponseCallback mCallback;
+   std::deque<PendingRequest> mInFlight;
+   std::deque<PendingRequest> mHeld; //waiting for room in flight
+   size_t mMaxInFlight;
+   bool mCoalesceGets;
+   std::map<std::string, std::shared_ptr<Waiters> > mCoalescing; //waiters of each held or in flight GET
+   size_t mCoalesced;
+   std::mutex mMutex;
 };
 
 }
-}
\ No newline at end of file
+}
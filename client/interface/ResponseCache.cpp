@@ -0,0 +1,117 @@
+#include "client/interface/ResponseCache.h"
+
+#include <functional>
+
+namespace c11http {
+namespace client {
+
+ResponseCache::Entry::Entry() : alwaysRevalidate(false) {
+
+}
+
+bool ResponseCache::Entry::isFresh(const Clock::time_point& now) const {
+   return !alwaysRevalidate && now < expires;
+}
+
+size_t ResponseCache::Entry::size() const {
+   size_t total = sizeof(Entry) + response.getBody().size();
+   const objects::HttpResponse::Headers& headers = response.getHeaders();
+   for(objects::HttpResponse::Headers::const_iterator iter = headers.begin(); iter != headers.end(); ++iter) {
+      total += iter->first.size() + iter->second.size();
+   }
+   for(size_t i = 0; i < vary.size(); ++i) total += vary[i].first.size() + vary[i].second.size();
+   return total;
+}
+
+ResponseCache::Shard::Shard() : bytes(0) {
+
+}
+
+ResponseCache::ResponseCache(const size_t maxBytes, const size_t shards)
+   : mMaxBytesPerShard(maxBytes / (0 == shards ? 1 : shards)) {
+   for(size_t i = 0; i < (0 == shards ? 1 : shards); ++i) mShards.push_back(new Shard());
+}
+
+ResponseCache::~ResponseCache() {
+   for(size_t i = 0; i < mShards.size(); ++i) delete mShards[i];
+}
+
+ResponseCache::Shard& ResponseCache::shardFor(const std::string& key) {
+   return *mShards[std::hash<std::string>()(key) % mShards.size()];
+}
+
+std::shared_ptr<const ResponseCache::Entry> ResponseCache::lookup(const std::string& key) {
+   Shard& shard = shardFor(key);
+   std::lock_guard<std::mutex> lock(shard.mutex);
+   std::unordered_map<std::string, Lru::iterator>::iterator found = shard.index.find(key);
+   if(shard.index.end() == found) return std::shared_ptr<const Entry>();
+
+   shard.lru.splice(shard.lru.begin(), shard.lru, found->second);
+   return found->second->second;
+}
+
+void ResponseCache::store(const std::string& key, const std::shared_ptr<const Entry>& entry) {
+   const size_t size = key.size() + entry->size();
+   Shard& shard = shardFor(key);
+   std::lock_guard<std::mutex> lock(shard.mutex);
+
+   std::unordered_map<std::string, Lru::iterator>::iterator found = shard.index.find(key);
+   if(shard.index.end() != found) {
+      shard.bytes -= key.size() + found->second->second->size();
+      shard.lru.erase(found->second);
+      shard.index.erase(found);
+   }
+   if(size > mMaxBytesPerShard) return;
+
+   while(shard.bytes + size > mMaxBytesPerShard && !shard.lru.empty()) {
+      const std::pair<std::string, std::shared_ptr<const Entry> >& oldest = shard.lru.back();
+      shard.bytes -= oldest.first.size() + oldest.second->size();
+      shard.index.erase(oldest.first);
+      shard.lru.pop_back();
+   }
+
+   shard.lru.push_front(std::make_pair(key, entry));
+   shard.index[key] = shard.lru.begin();
+   shard.bytes += size;
+}
+
+void ResponseCache::erase(const std::string& key) {
+   Shard& shard = shardFor(key);
+   std::lock_guard<std::mutex> lock(shard.mutex);
+   std::unordered_map<std::string, Lru::iterator>::iterator found = shard.index.find(key);
+   if(shard.index.end() == found) return;
+
+   shard.bytes -= key.size() + found->second->second->size();
+   shard.lru.erase(found->second);
+   shard.index.erase(found);
+}
+
+void ResponseCache::clear() {
+   for(size_t i = 0; i < mShards.size(); ++i) {
+      std::lock_guard<std::mutex> lock(mShards[i]->mutex);
+      mShards[i]->lru.clear();
+      mShards[i]->index.clear();
+      mShards[i]->bytes = 0;
+   }
+}
+
+size_t ResponseCache::getEntries() const {
+   size_t total = 0;
+   for(size_t i = 0; i < mShards.size(); ++i) {
+      std::lock_guard<std::mutex> lock(mShards[i]->mutex);
+      total += mShards[i]->index.size();
+   }
+   return total;
+}
+
+size_t ResponseCache::getBytes() const {
+   size_t total = 0;
+   for(size_t i = 0; i < mShards.size(); ++i) {
+      std::lock_guard<std::mutex> lock(mShards[i]->mutex);
+      total += mShards[i]->bytes;
+   }
+   return total;
+}
+
+}
+}
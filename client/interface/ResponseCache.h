@@ -0,0 +1,83 @@
+#pragma once
+
+#include "client/interface/Platform.h"
+
+#include "objects/HttpResponse.h"
+
+#include <chrono>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace c11http {
+namespace client {
+
+/**
+ * In-memory store of HTTP responses, bounded by the bytes they hold. Entries are spread over independently locked
+ * shards by key, each evicting its least recently used entries, so threads looking up different keys rarely
+ * contend. Entries are immutable once stored and handed out as shared pointers, so a hit copies nothing.
+ */
+class CLIENT_INTERFACE_API ResponseCache {
+public:
+   typedef std::chrono::steady_clock Clock;
+
+   struct Entry {
+      Entry();
+      objects::HttpResponse response;
+      Clock::time_point storedAt;
+      Clock::time_point expires; //fresh until
+      bool alwaysRevalidate; //no-cache: may be stored, but must be revalidated before every use
+      /**
+       * Request headers named by the response's Vary, with the values they had. A request with other values
+       * does not match the entry.
+       */
+      std::vector<std::pair<std::string, std::string> > vary;
+
+      bool isFresh(const Clock::time_point& now) const;
+      /**
+       * Approximate memory held by the entry, counted against the cache's budget.
+       */
+      size_t size() const;
+   };
+
+   ResponseCache(const size_t maxBytes = 64 * 1024 * 1024, const size_t shards = 16);
+   ~ResponseCache();
+
+   /**
+    * Returns the entry stored for key, or null, marking it as recently used.
+    */
+   std::shared_ptr<const Entry> lookup(const std::string& key);
+   /**
+    * Store entry for key, replacing any entry already there and evicting least recently used entries of the shard
+    * until it fits. Entries bigger than a shard's share of maxBytes are not stored.
+    */
+   void store(const std::string& key, const std::shared_ptr<const Entry>& entry);
+   void erase(const std::string& key);
+   void clear();
+
+   size_t getEntries() const;
+   size_t getBytes() const;
+
+private:
+   typedef std::list<std::pair<std::string, std::shared_ptr<const Entry> > > Lru;
+
+   struct Shard {
+      Shard();
+      mutable std::mutex mutex;
+      Lru lru; //most recently used first
+      std::unordered_map<std::string, Lru::iterator> index;
+      size_t bytes;
+   };
+
+   Shard& shardFor(const std::string& key);
+
+   const size_t mMaxBytesPerShard;
+   std::vector<Shard*> mShards;
+};
+
+}
+}
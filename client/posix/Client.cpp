@@ -1,5 +1,5 @@
 #ifndef WINDOWS
-#include "tcp/posix/Client.h"
+#include "client/posix/Client.h"
 
 #include <arpa/inet.h>
 #include <unistd.h>
@@ -8,32 +8,66 @@
 #include <errno.h>
 #include <sstream>
 #include <poll.h>
+#include <algorithm>
 
-#include "tcp/posix/Socket.h"
-#include "tcp/posix/Callback.h"
+#include "client/posix/Socket.h"
+#include "client/posix/Callback.h"
+#include "client/posix/Tls.h"
+
+#include "objects/HttpRequest.h"
+#include "objects/HttpResponse.h"
 
 namespace c11http {
-namespace tcp {
+namespace client {
 namespace posix {
 
+namespace {
+//size of the acknowledgement the server sends on accepting a connection
+const unsigned int ACK_SIZE = 3;
+//ends the identifier, so the server can tell it from queued data sent straight after it
+const char IDENTIFIER_END = '\n';
+}
+
+Client::Timeouts::Timeouts() :
+		connectMilliseconds(3000), handshakeMilliseconds(3000),
+		requestMilliseconds(30000) {
+}
+
 Client::Client(Callback* _callback, const std::string& hostname,
-		const unsigned int port, const std::string& _identifier)
-				throw (std::runtime_error) :
-		mCallback(_callback), mConnected(false), mIdentifier(_identifier) {
+		const unsigned int port, const std::string& _identifier,
+		const IClient::ClientResponseCallback& responseCallback,
+		const Timeouts& timeouts, const std::shared_ptr<TlsContext>& tls)
+		throw (std::runtime_error) :
+		IClient(responseCallback), mCallback(_callback), mState(CLOSED),
+		mIdentifier(_identifier), mTimeouts(timeouts), mAckReceived(0),
+		mSocket(-1), mTlsContext(tls), mTlsWantsWrite(false) {
+	FD_ZERO(&mMasterWrite);
+	prepareWakeupPipe();
+	performServerConnection(hostname, port);
+}
 
+void Client::performServerConnection(const std::string& hostname,
+		const unsigned int port) {
 	Socket connectSocket;
 	mSocket = connectSocket.getSocket();
+	connectSocket.makeNonBlocking();
 
 	/**
 	 * Convert our address information into a usable format
 	 */
 	struct sockaddr_in server;
+	memset(&server, 0, sizeof(server));
+	server.sin_family = AF_INET;
+	server.sin_port = htons(port);
+
 	int result = inet_pton(AF_INET, hostname.c_str(), &server.sin_addr.s_addr);
 
 	/**
 	 * Check for errors and report them
 	 */
 	if (0 >= result) {
+		connectSocket.closeSocket();
+		mSocket = -1;
 		if (0 == result) {
 			std::stringstream sstr;
 			sstr << "not in presentation format";
@@ -46,43 +80,54 @@ Client::Client(Callback* _callback, const std::string& hostname,
 	}
 
 	/**
-	 * Set port and type
-	 */
-	memset(&server, 0, sizeof(server));
-	server.sin_family = AF_INET;
-	server.sin_port = htons(port);
-
-	/**
-	 * Connect to our server, on the previously defined socket (file descriptor)
+	 * Start connecting to our server, waitForEvents finishes the connection once the socket is writable
 	 */
 	result = connect(mSocket, (struct sockaddr*) &server, sizeof(server));
 
-	if (-1 == result) {
+	if (-1 == result && EINPROGRESS != errno) {
 		//throw error
 		std::stringstream sstr;
 		sstr << "failed to connect to host server " << strerror(errno);
+		connectSocket.closeSocket();
+		mSocket = -1;
 		throw(std::runtime_error(sstr.str()));
 	}
 
-	//receive acknowledge from server
-	char ackBuff[4];
-	::recv(mSocket, ackBuff, sizeof(ackBuff), 0);
-	//send over our connection information
-	::send(mSocket, _identifier.c_str(), _identifier.size(), 0);
-
-	mConnected = true;
-
-	/**
-	 * Now that we're connected, we can do asynchronous i/o, so need a non-blocking socket
-	 */
-	connectSocket.makeNonBlocking();
+	std::stringstream peer;
+	peer << hostname << ":" << port;
+	mPeer = peer.str();
+
+	mAckReceived = 0;
+	mResponseParser.reset();
+	if (0 == result) {
+		mState = HANDSHAKE;
+		mStageDeadline = Clock::now()
+				+ std::chrono::milliseconds(mTimeouts.handshakeMilliseconds);
+		if (mTlsContext) {
+			try {
+				startTls();
+			} catch (std::runtime_error&) {
+				closeConnection();
+				throw;
+			}
+		}
+	} else {
+		mState = CONNECTING;
+		mStageDeadline = Clock::now()
+				+ std::chrono::milliseconds(mTimeouts.connectMilliseconds);
+	}
+}
 
-	prepareWakeupPipe();
+void Client::connectToServer(const std::string& hostname,
+		const unsigned int port) {
+	disconnect();
+	performServerConnection(hostname, port);
 }
 
 Client::~Client() {
-	if (mConnected)
-		disconnect();
+	disconnect();
+	::close(mWakeupPipe[0]);
+	::close(mWakeupPipe[1]);
 }
 
 Callback* Client::getCallback() const {
@@ -90,7 +135,7 @@ Callback* Client::getCallback() const {
 }
 
 const bool Client::isConnected() const {
-	return mConnected;
+	return OPEN == mState;
 }
 
 const int Client::getSocket() const {
@@ -106,116 +151,415 @@ void Client::prepareWakeupPipe() throw (std::runtime_error) {
 		sstr << "Failed to create wakeup pipe " << strerror(errno);
 		throw(std::runtime_error(sstr.str()));
 	}
-
-	mFdMax = std::max(mWakeupPipe[0], mSocket);
 }
 
 void Client::waitForEvents() throw (std::runtime_error) {
 	/**
 	 * Prepare our file descriptor sets for select
 	 */
-	fd_set masterRead, readFds, writeFds;
-	FD_ZERO(&masterRead);
-	FD_ZERO(&mMasterWrite);
-	FD_SET(mWakeupPipe[0], &masterRead);
-	FD_SET(mSocket, &masterRead);
-
-	while (mConnected) {
-		//copy from the master into a temporary
-		readFds = masterRead;
-		writeFds = mMasterWrite;
+	fd_set readFds, writeFds;
+
+	while (CLOSED != mState) {
+		const int socket = mSocket;
+		const std::shared_ptr<TlsStream> tls = std::atomic_load(&mTls);
+		FD_ZERO(&readFds);
+		FD_SET(mWakeupPipe[0], &readFds);
+		FD_SET(socket, &readFds);
+
+		const Clock::time_point now = Clock::now();
+		if (CONNECTING == mState
+				|| (TLS_HANDSHAKE == mState && mTlsWantsWrite)) {
+			//connect has finished once the socket is writable
+			FD_ZERO(&writeFds);
+			FD_SET(socket, &writeFds);
+		} else if (OPEN == mState) {
+			std::lock_guard<std::mutex> lock(mOutgoingMutex);
+			writeFds = mMasterWrite;
+		} else {
+			FD_ZERO(&writeFds);
+		}
 
 		/**
-		 * Wait until a file descriptor is ready, this blocks
+		 * Wait until a file descriptor is ready or a deadline passes, this blocks
 		 */
-		if (-1 == select(mFdMax + 1, &readFds, &writeFds, 0, 0)) {
+		struct timeval timeout;
+		if (-1
+				== select(std::max(mWakeupPipe[0], socket) + 1, &readFds,
+						&writeFds, 0, nextTimeout(now, timeout))) {
+			if (EINTR == errno)
+				continue;
 			std::stringstream sstr;
 			sstr << "Select error " << strerror(errno);
 			throw(std::runtime_error(sstr.str()));
 		}
 
-		if (!mConnected)
+		if (CLOSED == mState)
 			break;
 
 		/**
-		 * Check all client connection sockets to see if there is information to read
+		 * See if we were attempting to wake up the client, for send/disconnect
 		 */
-		if (FD_ISSET(mSocket, &readFds)) //read from socket
+		if (FD_ISSET(mWakeupPipe[0], &readFds)) //performing wakeup
 				{
-			/**
-			 * Socket is ready, block until all data is read
-			 */
-			int nbytes = ::recv(mSocket, &mBuffer, sizeof(mBuffer),
-					MSG_WAITALL);
+			//clear the wakeup pipe
+			::read(mWakeupPipe[0], mBuffer, sizeof(mBuffer));
+		}
 
-			if (-1 == nbytes) {
-				std::stringstream sstr;
-				sstr << "Failed to recv from socket: " << strerror(errno);
-				throw(std::runtime_error(sstr.str()));
-			}
+		if (!checkDeadlines(Clock::now()))
+			break;
 
-			if (0 == nbytes) {
-				//server closed connection
-				mConnected = false;
-			} else {
-				Callback* receiveCB = getCallback();
+		if (CONNECTING == mState) {
+			if (FD_ISSET(socket, &writeFds) || FD_ISSET(socket, &readFds))
+				handleConnect();
+			continue;
+		}
 
-				if (0 != receiveCB)
-					receiveCB->receiveComplete(mIdentifier, mBuffer, nbytes);
-			}
+		if (TLS_HANDSHAKE == mState) {
+			if (FD_ISSET(socket, &writeFds) || FD_ISSET(socket, &readFds))
+				handleTlsHandshake(tls.get());
+			continue;
+		}
+
+		if (HANDSHAKE == mState) {
+			if (FD_ISSET(socket, &readFds))
+				handleHandshake(tls.get());
+			continue;
 		}
 
 		/**
-		 * See if we were attempting to wake up the client, for send/disconnect
+		 * Check all client connection sockets to see if there is information to read
 		 */
-		if (FD_ISSET(mWakeupPipe[0], &readFds)) //performing wakeup
+		if (FD_ISSET(socket, &readFds)) //read from socket
 				{
-			//clear the wakeup pipe
-			::recv(mWakeupPipe[0], &mBuffer, sizeof(mBuffer), MSG_WAITALL);
+			bool closed = false;
+			/**
+			 * Socket is ready, block until all data is read. Over TLS, the rest of a record already read
+			 * is not shown by select, so it is read now
+			 */
+			do {
+				std::string error;
+				int nbytes = receive(tls.get(), mBuffer, sizeof(mBuffer),
+						MSG_WAITALL, error);
+
+				if (-1 == nbytes) {
+					if (EAGAIN != errno && EWOULDBLOCK != errno) {
+						fail("Failed to recv from socket: " + error);
+						closed = true;
+					}
+					break;
+				} else if (0 == nbytes) {
+					handleServerClose();
+					closed = true;
+					break;
+				} else {
+					handleReceive(mBuffer, nbytes);
+				}
+			} while (0 != tls.get() && OPEN == mState && tls->hasBuffered());
+
+			if (closed)
+				break;
 		}
 
 		/**
 		 * Data is ready to be sent, and the client sockets are ready to receive data
 		 */
-		if (FD_ISSET(mSocket, &writeFds)) //send data to server
+		if (OPEN == mState && FD_ISSET(socket, &writeFds)) //send data to server
 				{
 			std::vector<char> bytesToSend;
-			bytesToSend.swap(mOutgoingBytes);
+			{
+				std::lock_guard<std::mutex> lock(mOutgoingMutex);
+				bytesToSend.swap(mOutgoingBytes);
+				/**
+				 * Everything queued is being written, clear the socket from the write list
+				 */
+				FD_CLR(socket, &mMasterWrite);
+			}
 
 			const int expected = bytesToSend.size();
-			bool sendSuccessful = true;
+			int sent = 0;
+			std::string error;
+			int nbytes = 0;
+			while (sent < expected && -1 != nbytes) {
+				nbytes = transmit(tls.get(), &(bytesToSend[sent]),
+						expected - sent, error);
+				if (-1 != nbytes)
+					sent += nbytes;
+			}
 
-			if (expected
-					!= ::send(mSocket, &(bytesToSend.front()), expected, 0)) {
-				sendSuccessful = false;
+			if (-1 == nbytes && EAGAIN != errno && EWOULDBLOCK != errno) {
+				fail("Failed to send to server: " + error);
+				break;
+			}
+			if (sent < expected) {
+				/**
+				 * The socket is full, what is left goes out ahead of anything queued since. A TLS write
+				 * waiting on the socket is retried with these same bytes
+				 */
+				std::lock_guard<std::mutex> lock(mOutgoingMutex);
+				mOutgoingBytes.insert(mOutgoingBytes.begin(),
+						bytesToSend.begin() + sent, bytesToSend.end());
+				FD_SET(socket, &mMasterWrite);
 			}
 
 			Callback* sendCB = getCallback();
 
 			if (0 != sendCB)
-				sendCB->sendComplete(mIdentifier, expected);
+				sendCB->sendComplete(mIdentifier, sent);
+		}
+	}
 
-			/**
-			 * Write is complete, clear the socket from the write list
-			 */
-			FD_CLR(mSocket, &mMasterWrite);
+}
+
+void Client::handleConnect() {
+	int error = 0;
+	socklen_t length = sizeof(error);
+	if (-1 == getsockopt(mSocket, SOL_SOCKET, SO_ERROR, &error, &length))
+		error = errno;
+
+	if (0 != error) {
+		std::stringstream sstr;
+		sstr << "failed to connect to host server " << strerror(error);
+		fail(sstr.str());
+		return;
+	}
+
+	//wait for the server's acknowledgement
+	mState = HANDSHAKE;
+	mStageDeadline = Clock::now()
+			+ std::chrono::milliseconds(mTimeouts.handshakeMilliseconds);
+
+	if (mTlsContext) {
+		try {
+			startTls();
+		} catch (std::runtime_error& ex) {
+			fail(ex.what());
+		}
+	}
+}
+
+void Client::startTls() {
+	//the server acknowledges the connection once it is secured, the handshake starts once the socket is writable
+	std::atomic_store(&mTls,
+			std::make_shared<TlsStream>(*mTlsContext, mSocket, mPeer));
+	mTlsWantsWrite = true;
+	mState = TLS_HANDSHAKE;
+}
+
+void Client::handleTlsHandshake(TlsStream* tls) {
+	const TlsStream::Status status = tls->handshake();
+	mTlsWantsWrite = TlsStream::TLS_WANT_WRITE == status;
+	if (TlsStream::TLS_WANT_READ == status
+			|| TlsStream::TLS_WANT_WRITE == status)
+		return;
+
+	if (TlsStream::TLS_OK != status) {
+		fail("TLS handshake failed: " + tls->getError());
+		return;
+	}
+
+	//the acknowledgement may have arrived with the end of the handshake
+	mState = HANDSHAKE;
+	handleHandshake(tls);
+}
+
+int Client::receive(TlsStream* tls, char* buffer, const size_t length,
+		const int flags, std::string& error) {
+	if (0 == tls) {
+		const int nbytes = ::recv(mSocket, buffer, length, flags);
+		if (-1 == nbytes)
+			error = strerror(errno);
+		return nbytes;
+	}
+
+	size_t count = 0;
+	switch (tls->read(buffer, length, count)) {
+	case TlsStream::TLS_OK:
+		return count;
+	case TlsStream::TLS_CLOSED:
+		return 0;
+	case TlsStream::TLS_WANT_READ:
+	case TlsStream::TLS_WANT_WRITE:
+		errno = EAGAIN;
+		return -1;
+	default:
+		error = tls->getError();
+		errno = EPROTO;
+		return -1;
+	}
+}
+
+int Client::transmit(TlsStream* tls, const char* data, const size_t length,
+		std::string& error) {
+	if (0 == tls) {
+		const int nbytes = ::send(mSocket, data, length, 0);
+		if (-1 == nbytes)
+			error = strerror(errno);
+		return nbytes;
+	}
+
+	size_t count = 0;
+	switch (tls->write(data, length, count)) {
+	case TlsStream::TLS_OK:
+		return count;
+	case TlsStream::TLS_WANT_READ:
+	case TlsStream::TLS_WANT_WRITE:
+		errno = EAGAIN;
+		return -1;
+	case TlsStream::TLS_CLOSED:
+		error = "Connection closed by server";
+		errno = EPIPE;
+		return -1;
+	default:
+		error = tls->getError();
+		errno = EPROTO;
+		return -1;
+	}
+}
+
+void Client::handleHandshake(TlsStream* tls) {
+	//receive acknowledge from server, leaving anything after it for the open connection
+	std::string error;
+	int nbytes = receive(tls, mBuffer, ACK_SIZE - mAckReceived, 0, error);
+
+	if (-1 == nbytes) {
+		if (EAGAIN != errno && EWOULDBLOCK != errno) {
+			fail("Failed to recv from socket: " + error);
 		}
+		return;
+	}
+
+	if (0 == nbytes) {
+		fail("Connection closed by server");
+		return;
+	}
+
+	mAckReceived += nbytes;
+	if (mAckReceived < ACK_SIZE)
+		return;
+
+	//send over our connection information
+	const std::string identifier(mIdentifier + IDENTIFIER_END);
+	if ((int) identifier.size()
+			!= transmit(tls, identifier.c_str(), identifier.size(), error)) {
+		fail("Failed to send identifier " + error);
+		return;
+	}
+
+	mState = OPEN;
+
+	if (0 != getCallback())
+		getCallback()->connected(mIdentifier);
+}
+
+bool Client::checkDeadlines(const Clock::time_point& now) {
+	if ((CONNECTING == mState && 0 != mTimeouts.connectMilliseconds
+			&& now >= mStageDeadline)) {
+		fail("Timed out connecting to server");
+		return false;
+	}
+
+	if (((TLS_HANDSHAKE == mState || HANDSHAKE == mState)
+			&& 0 != mTimeouts.handshakeMilliseconds && now >= mStageDeadline)) {
+		fail("Timed out waiting for server acknowledgement");
+		return false;
+	}
+
+	bool requestExpired = false;
+	{
+		std::lock_guard<std::mutex> lock(mOutgoingMutex);
+		requestExpired = !mRequestDeadlines.empty()
+				&& now >= mRequestDeadlines.front();
+	}
+	if (requestExpired) {
+		/**
+		 * Responses arrive in request order, so once the oldest request has expired the
+		 * connection can not be used for the requests behind it either
+		 */
+		fail("Timed out waiting for response");
+		return false;
+	}
+
+	return true;
+}
+
+struct timeval* Client::nextTimeout(const Clock::time_point& now,
+		struct timeval& timeout) {
+	bool hasDeadline = false;
+	Clock::time_point deadline;
+
+	if ((CONNECTING == mState && 0 != mTimeouts.connectMilliseconds)
+			|| ((TLS_HANDSHAKE == mState || HANDSHAKE == mState)
+					&& 0 != mTimeouts.handshakeMilliseconds)) {
+		hasDeadline = true;
+		deadline = mStageDeadline;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mOutgoingMutex);
+		if (!mRequestDeadlines.empty()
+				&& Clock::time_point::max() != mRequestDeadlines.front()
+				&& (!hasDeadline || mRequestDeadlines.front() < deadline)) {
+			deadline = mRequestDeadlines.front();
+			hasDeadline = true;
+		}
+	}
+
+	if (!hasDeadline)
+		return 0;
+
+	const long long microseconds = (deadline > now) ?
+			std::chrono::duration_cast<std::chrono::microseconds>(
+					deadline - now).count() : 0;
+	timeout.tv_sec = microseconds / 1000000;
+	timeout.tv_usec = microseconds % 1000000;
+	return &timeout;
+}
+
+void Client::fail(const std::string& reason) {
+	Callback* failCB = getCallback();
+
+	if (0 != failCB)
+		failCB->sendFailed(mIdentifier, reason);
+
+	closeConnection();
+	failRequests(reason);
+
+	if (0 != failCB)
+		failCB->disconnected(mIdentifier);
+}
+
+void Client::closeConnection() {
+	mState = CLOSED;
+	if (-1 != mSocket) {
+		Socket sckt(mSocket);
+		sckt.closeSocket();
+		mSocket = -1;
 	}
+	std::atomic_store(&mTls, std::shared_ptr<TlsStream>());
+	mTlsWantsWrite = false;
+	mResponseParser.reset();
 
+	std::lock_guard<std::mutex> lock(mOutgoingMutex);
+	mOutgoingBytes.clear();
+	mRequestDeadlines.clear();
+	FD_ZERO(&mMasterWrite);
 }
 
 void Client::sendDataToServer(const char* data, const unsigned int count)
 		throw (std::runtime_error) {
 	if (count > 0) {
+		std::lock_guard<std::mutex> lock(mOutgoingMutex);
 		mOutgoingBytes.reserve(mOutgoingBytes.size() + count);
-		mOutgoingBytes.insert(mOutgoingBytes.begin(), data, data + count);
+		mOutgoingBytes.insert(mOutgoingBytes.end(), data, data + count);
 		/**
 		 * Need to add our socket to the write list now that it has data ready. If
 		 * we added it earlier with no data available, it would constantly be shown
 		 * as ready by the select call. It is ready since it has no data, and can
-		 * write immediately.
+		 * write immediately. Data queued while connecting waits until the connection
+		 * is open.
 		 */
-		FD_SET(mSocket, &mMasterWrite);
+		if (-1 != mSocket)
+			FD_SET(mSocket, &mMasterWrite);
 		/**
 		 * Use our wakeup pipe since the current set of write file descriptors (write_fds)
 		 * does not contain the socket we want to write to. Self pipe wakes us up and
@@ -225,6 +569,93 @@ void Client::sendDataToServer(const char* data, const unsigned int count)
 	}
 }
 
+void Client::handleReceive(const char* data, const unsigned int count) {
+	Callback* receiveCB = getCallback();
+
+	if (0 != receiveCB)
+		receiveCB->receiveComplete(mIdentifier, data, count);
+
+	/**
+	 * Only data arriving while requests await responses is parsed as HTTP, anything
+	 * else is left to the callback alone
+	 */
+	if (hasRequestsInFlight()) {
+		std::vector<objects::HttpResponse> responses;
+		std::string error;
+		try {
+			mResponseParser.parse(data, count, responses);
+		} catch (std::runtime_error& ex) {
+			error = ex.what();
+		}
+
+		//responses parsed before any error still answer the oldest requests
+		deliverResponses(responses);
+		if (!error.empty()) {
+			mResponseParser.reset();
+			{
+				std::lock_guard<std::mutex> lock(mOutgoingMutex);
+				mRequestDeadlines.clear();
+			}
+			failRequests(error);
+		}
+	}
+}
+
+void Client::handleServerClose() {
+	std::vector<objects::HttpResponse> responses;
+	std::string reason("Connection closed by server");
+
+	//the close completes a response whose body runs until the connection ends
+	if (hasRequestsInFlight()) {
+		try {
+			mResponseParser.finish(responses);
+		} catch (std::runtime_error& ex) {
+			reason = ex.what();
+		}
+	}
+	deliverResponses(responses);
+
+	closeConnection();
+	failRequests(reason);
+	if (0 != getCallback())
+		getCallback()->disconnected(mIdentifier);
+}
+
+void Client::deliverResponses(
+		const std::vector<objects::HttpResponse>& responses) {
+	for (std::vector<objects::HttpResponse>::const_iterator iter =
+			responses.begin(); iter != responses.end(); ++iter) {
+		{
+			std::lock_guard<std::mutex> lock(mOutgoingMutex);
+			if (!mRequestDeadlines.empty())
+				mRequestDeadlines.pop_front();
+		}
+		receiveResponseFromServer(*iter);
+	}
+}
+
+void Client::writeRequest(const std::string& bytes) {
+	{
+		std::lock_guard<std::mutex> lock(mOutgoingMutex);
+		mRequestDeadlines.push_back(
+				0 == mTimeouts.requestMilliseconds ?
+						Clock::time_point::max() :
+						Clock::now()
+								+ std::chrono::milliseconds(
+										mTimeouts.requestMilliseconds));
+	}
+	sendDataToServer(bytes.data(), bytes.size());
+}
+
+bool Client::isClosed() const {
+	return CLOSED == mState;
+}
+
+objects::HttpResponse Client::sendRequestToServer(
+		const objects::HttpRequest& req) {
+	return sendRequestAsync(req).get();
+}
+
 /**
  * Self pipe technique for wake up from select
  */
@@ -237,23 +668,11 @@ void Client::performWakeup() {
 	::write(mWakeupPipe[1], &wakeup, 1);
 }
 
-void Client::disconnect() throw (std::runtime_error) {
-	if (mConnected) {
-		mConnected = false;
-		struct pollfd fd;
-		fd.fd = mSocket;
-		fd.events = POLLOUT;
-
-		if (-1 == poll(&fd, 1, -1)) {
-			std::stringstream sstr;
-			sstr << "Error polling for socket write " << strerror(errno);
-			throw(std::runtime_error(sstr.str()));
-		}
-
-		::send(mSocket, mBuffer, 0, 0);
-		Socket sckt(mSocket);
-		sckt.closeSocket();
+void Client::disconnect() {
+	if (CLOSED != mState) {
+		closeConnection();
 		performWakeup();
+		failRequests("Disconnected from server");
 	}
 }
 
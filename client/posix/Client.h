@@ -1,5 +1,10 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 #include "client/interface/IClient.h"
@@ -7,11 +12,15 @@
 #include "client/posix/Platform.h"
 #include "client/posix/posix.h"
 
+#include "objects/HttpResponseParser.h"
+
 namespace c11http {
 namespace client {
 namespace posix {
 
 class Callback;
+class TlsContext;
+class TlsStream;
 
 /**
  * Posix implementation of a client, which is a connection to some server. This class is implemented asynchronously
@@ -21,52 +30,157 @@ class CLIENT_POSIX_API Client : public IClient
 {
 public:
     /**
-     * Connection a specific server listening at hostname:port. Users are notified of events via the specified
-     * callback, and the identifier is sent to the server on connection.
+     * Deadlines for each stage of a connection, 0 for none. When one passes, the callback is told with sendFailed
+     * and disconnected, and outstanding requests are failed.
      */
-    Client(Callback* callback, const std::string& hostname, const unsigned int port, const std::string& identifier);;
+    struct Timeouts
+    {
+        Timeouts();
+        unsigned int connectMilliseconds; //from starting the connect until the server accepts it
+        unsigned int handshakeMilliseconds; //from being accepted until the server's acknowledgement arrives
+        unsigned int requestMilliseconds; //from writing a request until its response arrives
+    };
+
+    /**
+     * Connection a specific server listening at hostname:port. The connect does not block: it is completed by
+     * waitForEvents, which tells the callback once connected, and data sent before then is queued. The identifier
+     * is sent to the server on connection. Responses to requests sent through IClient are matched to their
+     * requests; any other response is given to responseCallback. With tls, the connection is secured before the
+     * server acknowledges it, resuming the last session tls holds for the server if it can; the handshake counts
+     * towards the handshake timeout.
+     */
+    Client(Callback* callback, const std::string& hostname, const unsigned int port, const std::string& identifier,
+            const IClient::ClientResponseCallback& responseCallback = IClient::ClientResponseCallback(),
+            const Timeouts& timeouts = Timeouts(),
+            const std::shared_ptr<TlsContext>& tls = std::shared_ptr<TlsContext>())
+            throw (std::runtime_error);
     ~Client();
 
     /**
-     * Block the current thread, waiting for events. This will unblock when data is ready to be sent/recv'd or
-     * a disconnection request is received.
+     * Block the current thread, waiting for events. This will unblock when data is ready to be sent/recv'd,
+     * a deadline passes or a disconnection request is received, returning once the connection is closed.
+     */
+    void waitForEvents() throw (std::runtime_error);
+    /**
+     * Send data to the connected server. Safe to call from any thread.
+     */
+    void sendDataToServer(const char* data, const unsigned int count) throw (std::runtime_error);
+    /**
+     * Close any current connection and start connecting to the server listening at hostname:port. waitForEvents
+     * must be called again to complete the connection.
      */
     virtual void connectToServer(const std::string& hostname, const unsigned int port);
     /**
-     * Send data to the connected server.
+     * Send a request and block until its response arrives. Another thread must be running waitForEvents.
      */
     virtual objects::HttpResponse sendRequestToServer(const objects::HttpRequest& req);
     /**
-     * Disconnect from the server, closing the connection.
+     * Disconnect from the server, closing the connection. Requests awaiting responses are failed.
      */
     virtual void disconnect();
+
+    Callback* getCallback() const;
+    const bool isConnected() const;
+    const int getSocket() const;
+    const char* getBuffer() const;
+
+protected:
+    /**
+     * Start a non-blocking connect to hostname:port. Throws if the connect fails immediately.
+     */
+    virtual void performServerConnection(const std::string& hostname, const unsigned int port);
+    virtual void writeRequest(const std::string& bytes);
+    /**
+     * Closed once the connection fails or is disconnected, until the next connect.
+     */
+    virtual bool isClosed() const;
+
 private:
+    typedef std::chrono::steady_clock Clock;
+
+    enum State
+    {
+        CLOSED, CONNECTING, TLS_HANDSHAKE, HANDSHAKE, OPEN
+    };
+
+    /**
+     * Non-blocking connect has finished, check whether it succeeded.
+     */
+    void handleConnect();
     /**
-     * Perform the wait action.
+     * Start securing the connection, once connected.
      */
-    void performWait() throw (std::runtime_error);
+    void startTls();
+    /**
+     * Continue the TLS handshake, moving on to the acknowledgement once it completes.
+     */
+    void handleTlsHandshake(TlsStream* tls);
+    /**
+     * Read the server's acknowledgement, then send our identifier.
+     */
+    void handleHandshake(TlsStream* tls);
+    /**
+     * recv, or over tls a read of decrypted bytes. Returns the count read, 0 once the server has closed, or -1,
+     * with errno EAGAIN if the socket would block and otherwise error set.
+     */
+    int receive(TlsStream* tls, char* buffer, const size_t length, const int flags, std::string& error);
+    /**
+     * send, or over tls a write of encrypted bytes, returning as receive does.
+     */
+    int transmit(TlsStream* tls, const char* data, const size_t length, std::string& error);
+    /**
+     * Fail the connection if the current stage, or the oldest request, has passed its deadline.
+     */
+    bool checkDeadlines(const Clock::time_point& now);
+    /**
+     * Time select may wait before a deadline needs checking, or 0 to wait indefinitely.
+     */
+    struct timeval* nextTimeout(const Clock::time_point& now, struct timeval& timeout);
+    /**
+     * Report the failure to the callback, close the connection and fail outstanding requests.
+     */
+    void fail(const std::string& reason);
+    void closeConnection();
     /**
      * Create a wakeup pipe, that uses a self-pipe to unblock this object.
      */
     void prepareWakeupPipe() throw (std::runtime_error);
     /**
-     * Receive data from the server, into a buffer. Socket must be ready for reading, as indicated by a select/poll
+     * Data has been received from the server, report it and complete any responses it finishes.
+     */
+    void handleReceive(const char* data, const unsigned int count);
+    /**
+     * The server closed the connection, completing any response delimited by the close.
+     */
+    void handleServerClose();
+    /**
+     * Complete the oldest requests with responses parsed from the connection.
      */
-    int receiveDataFromServer();
+    void deliverResponses(const std::vector<objects::HttpResponse>& responses);
     /**
      * Unblock this client, using a self-pipe.
      */
     void performWakeup();
 
+    Callback* mCallback;
     int mWakeupPipe[2];
-    int mFdMax;
-    bool mConnected;
+    std::atomic<State> mState;
     std::string mIdentifier;
+    Timeouts mTimeouts;
+    Clock::time_point mStageDeadline; //deadline for connecting or the handshake
+    unsigned int mAckReceived;
     fd_set mMasterWrite;
     int mSocket;
-    char mBuffer[MAX_BUFFER_SIZE];
+    char mBuffer[CLIENT_RECEIVE_BUFFER_SIZE];
 
     std::vector<char> mOutgoingBytes;
+    std::deque<Clock::time_point> mRequestDeadlines; //one per request awaiting a response, oldest first
+    std::mutex mOutgoingMutex; //guards mOutgoingBytes, mMasterWrite and mRequestDeadlines
+    objects::HttpResponseParser mResponseParser;
+    std::shared_ptr<TlsContext> mTlsContext;
+    std::shared_ptr<TlsStream> mTls; //swapped atomically, as disconnect may close the connection from any thread
+    std::string mPeer; //"address:port", whose sessions the TLS context resumes
+    bool mTlsWantsWrite; //the handshake waits for the socket to be writable
 };
 
 }
@@ -0,0 +1,577 @@
+#if !defined(WINDOWS) && defined(__linux__)
+#include "client/posix/ClientEngine.h"
+
+#include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+#include <sstream>
+
+#include "client/posix/Socket.h"
+
+#include "objects/HttpRequest.h"
+#include "objects/HttpResponse.h"
+
+#define MAX_ENGINE_EVENTS 256
+#define MAX_FREE_BUFFERS 64
+#define MAX_POOLED_BUFFER_CAPACITY (1024 * 1024)
+
+namespace c11http {
+namespace client {
+namespace posix {
+
+namespace {
+const ClientEngine::ConnectionId WAKEUP_ID = 0;
+//size of the acknowledgement the server sends on accepting a connection
+const unsigned int ACK_SIZE = 3;
+//ends the identifier, so the server can tell it from requests sent straight after it
+const char IDENTIFIER_END = '\n';
+
+std::string describeError(const std::string& what, const int error) {
+	std::stringstream sstr;
+	sstr << what << " " << strerror(error);
+	return sstr.str();
+}
+}
+
+ClientEngine::ClientEngine(const unsigned int tickMilliseconds)
+		throw (std::runtime_error) :
+		mShutdown(false), mTimers(tickMilliseconds), mNextId(WAKEUP_ID + 1) {
+	mEpoll = epoll_create1(EPOLL_CLOEXEC);
+	if (-1 == mEpoll) {
+		throw(std::runtime_error(describeError("Failed to create epoll", errno)));
+	}
+
+	mWakeupFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (-1 == mWakeupFd) {
+		::close(mEpoll);
+		throw(std::runtime_error(describeError("Failed to create wakeup", errno)));
+	}
+
+	struct epoll_event event;
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.u64 = WAKEUP_ID;
+	epoll_ctl(mEpoll, EPOLL_CTL_ADD, mWakeupFd, &event);
+}
+
+ClientEngine::~ClientEngine() {
+	std::vector<Connection*> remaining;
+	{
+		std::lock_guard<std::recursive_mutex> lock(mConnectionsMutex);
+		for (std::map<ConnectionId, Connection*>::iterator iter =
+				mConnections.begin(); iter != mConnections.end(); ++iter) {
+			remaining.push_back(iter->second);
+		}
+	}
+	for (std::vector<Connection*>::iterator iter = remaining.begin();
+			iter != remaining.end(); ++iter) {
+		delete *iter;
+	}
+
+	for (std::vector<std::vector<char>*>::iterator iter =
+			mFreeBuffers.begin(); iter != mFreeBuffers.end(); ++iter) {
+		delete *iter;
+	}
+
+	::close(mWakeupFd);
+	::close(mEpoll);
+}
+
+ClientEngine::Connection* ClientEngine::connect(const std::string& hostname,
+		const unsigned int port, const std::string& identifier,
+		const IClient::ClientResponseCallback& responseCallback) {
+	Connection* connection;
+	{
+		std::lock_guard<std::recursive_mutex> lock(mConnectionsMutex);
+		const ConnectionId id = mNextId++;
+		connection = new Connection(this, id, identifier, responseCallback);
+		mConnections[id] = connection;
+	}
+
+	postToConnection(connection->mId,
+			[hostname, port](Connection* toConnect) {
+				toConnect->performServerConnection(hostname, port);
+			});
+	return connection;
+}
+
+void ClientEngine::run() throw (std::runtime_error) {
+	mLoopThread = std::this_thread::get_id();
+	struct epoll_event events[MAX_ENGINE_EVENTS];
+
+	while (!mShutdown) {
+		int timeout = mTimers.nextTimeout(workers::TimerWheel::Clock::now());
+		{
+			std::lock_guard<std::mutex> lock(mTasksMutex);
+			if (!mPostedTasks.empty())
+				timeout = 0;
+		}
+
+		/**
+		 * Wait until a connection is ready, a task is posted or the next timer is due
+		 */
+		int count = epoll_wait(mEpoll, events, MAX_ENGINE_EVENTS, timeout);
+
+		if (-1 == count) {
+			if (EINTR == errno)
+				continue;
+			mLoopThread = std::thread::id();
+			throw(std::runtime_error(describeError("epoll error", errno)));
+		}
+
+		for (int i = 0; i < count; ++i) {
+			if (WAKEUP_ID == events[i].data.u64) {
+				//clear the wakeup
+				uint64_t value;
+				::read(mWakeupFd, &value, sizeof(value));
+				continue;
+			}
+
+			std::lock_guard<std::recursive_mutex> lock(mConnectionsMutex);
+			Connection* connection = findConnection(events[i].data.u64);
+			if (0 != connection)
+				connection->handleEvents(events[i].events);
+		}
+
+		mTimers.advance(workers::TimerWheel::Clock::now());
+		/**
+		 * Posted tasks run last, so writes queued while handling events go out in one send per connection
+		 */
+		runPostedTasks();
+	}
+
+	mLoopThread = std::thread::id();
+}
+
+void ClientEngine::shutdown() {
+	mShutdown = true;
+	performWakeup();
+}
+
+void ClientEngine::post(const std::function<void()>& task) {
+	bool wasEmpty;
+	{
+		std::lock_guard<std::mutex> lock(mTasksMutex);
+		wasEmpty = mPostedTasks.empty();
+		mPostedTasks.push_back(task);
+	}
+
+	//the engine thread checks for tasks before waiting, so only other threads need to wake it
+	if (wasEmpty && !isEventLoopThread())
+		performWakeup();
+}
+
+void ClientEngine::runAfter(const unsigned int milliseconds,
+		const std::function<void()>& task) {
+	if (isEventLoopThread()) {
+		mTimers.schedule(milliseconds, task);
+	} else {
+		post([this, milliseconds, task]() {
+			mTimers.schedule(milliseconds, task);
+		});
+	}
+}
+
+bool ClientEngine::isEventLoopThread() const {
+	return std::this_thread::get_id() == mLoopThread;
+}
+
+workers::TimerWheel& ClientEngine::getTimers() {
+	return mTimers;
+}
+
+size_t ClientEngine::getConnectionCount() {
+	std::lock_guard<std::recursive_mutex> lock(mConnectionsMutex);
+	return mConnections.size();
+}
+
+void ClientEngine::postToConnection(const ConnectionId id,
+		const std::function<void(Connection*)>& task) {
+	post([this, id, task]() {
+		std::lock_guard<std::recursive_mutex> lock(mConnectionsMutex);
+		Connection* connection = findConnection(id);
+		if (0 != connection)
+			task(connection);
+	});
+}
+
+ClientEngine::Connection* ClientEngine::findConnection(const ConnectionId id) {
+	std::lock_guard<std::recursive_mutex> lock(mConnectionsMutex);
+	std::map<ConnectionId, Connection*>::iterator iter = mConnections.find(id);
+	return mConnections.end() == iter ? 0 : iter->second;
+}
+
+void ClientEngine::removeConnection(const ConnectionId id) {
+	std::lock_guard<std::recursive_mutex> lock(mConnectionsMutex);
+	mConnections.erase(id);
+}
+
+std::vector<char>* ClientEngine::acquireBuffer() {
+	std::lock_guard<std::mutex> lock(mBuffersMutex);
+	if (mFreeBuffers.empty())
+		return new std::vector<char>();
+
+	std::vector<char>* buffer = mFreeBuffers.back();
+	mFreeBuffers.pop_back();
+	return buffer;
+}
+
+void ClientEngine::releaseBuffer(std::vector<char>* buffer) {
+	buffer->clear();
+	{
+		std::lock_guard<std::mutex> lock(mBuffersMutex);
+		if (mFreeBuffers.size() < MAX_FREE_BUFFERS
+				&& buffer->capacity() <= MAX_POOLED_BUFFER_CAPACITY) {
+			mFreeBuffers.push_back(buffer);
+			return;
+		}
+	}
+	delete buffer;
+}
+
+void ClientEngine::runPostedTasks() {
+	std::vector<std::function<void()> > tasks;
+	{
+		std::lock_guard<std::mutex> lock(mTasksMutex);
+		tasks.swap(mPostedTasks);
+	}
+
+	for (std::vector<std::function<void()> >::iterator iter = tasks.begin();
+			iter != tasks.end(); ++iter) {
+		(*iter)();
+	}
+}
+
+void ClientEngine::performWakeup() {
+	uint64_t value = 1;
+	::write(mWakeupFd, &value, sizeof(value));
+}
+
+ClientEngine::Connection::Connection(ClientEngine* engine,
+		const ConnectionId id, const std::string& identifier,
+		const IClient::ClientResponseCallback& responseCallback) :
+		IClient(responseCallback), mEngine(engine), mId(id),
+		mIdentifier(identifier), mState(CLOSED), mConnected(false),
+		mClosed(false), mSocket(-1), mAckReceived(0), mWatchingWrite(false), mOutgoing(0),
+		mOutgoingOffset(0), mFlushScheduled(false) {
+}
+
+ClientEngine::Connection::~Connection() {
+	/**
+	 * Holding the engine's lock means the engine thread is not handling this connection,
+	 * and will not find it once it is removed
+	 */
+	std::lock_guard<std::recursive_mutex> lock(mEngine->mConnectionsMutex);
+	mEngine->removeConnection(mId);
+	close("Connection deleted");
+}
+
+objects::HttpResponse ClientEngine::Connection::sendRequestToServer(
+		const objects::HttpRequest& req) {
+	if (mEngine->isEventLoopThread()) {
+		throw(std::runtime_error(
+				"sendRequestToServer would block the engine thread, use sendRequestAsync"));
+	}
+	return sendRequestAsync(req).get();
+}
+
+void ClientEngine::Connection::connectToServer(const std::string& hostname,
+		const unsigned int port) {
+	mEngine->postToConnection(mId,
+			[hostname, port](Connection* connection) {
+				ClientEngine* engine = connection->mEngine;
+				const ConnectionId id = connection->mId;
+				connection->close("Reconnecting");
+				//failure callbacks may have deleted the connection
+				connection = engine->findConnection(id);
+				if (0 != connection)
+					connection->performServerConnection(hostname, port);
+			});
+}
+
+void ClientEngine::Connection::disconnect() {
+	mConnected = false;
+	mEngine->postToConnection(mId, [](Connection* connection) {
+		connection->close("Disconnected from server");
+	});
+}
+
+const bool ClientEngine::Connection::isConnected() const {
+	return mConnected;
+}
+
+const std::string& ClientEngine::Connection::getIdentifier() const {
+	return mIdentifier;
+}
+
+bool ClientEngine::Connection::isClosed() const {
+	return mClosed;
+}
+
+void ClientEngine::Connection::performServerConnection(
+		const std::string& hostname, const unsigned int port) {
+	mClosed = false;
+	try {
+		Socket connectSocket;
+		mSocket = connectSocket.getSocket();
+		connectSocket.makeNonBlocking();
+	} catch (std::runtime_error& ex) {
+		close(ex.what());
+		return;
+	}
+
+	/**
+	 * Convert our address information into a usable format
+	 */
+	struct sockaddr_in server;
+	memset(&server, 0, sizeof(server));
+	server.sin_family = AF_INET;
+	server.sin_port = htons(port);
+
+	int result = inet_pton(AF_INET, hostname.c_str(), &server.sin_addr);
+	if (0 >= result) {
+		close(0 == result ? std::string("not in presentation format") :
+				describeError("inet_pton Error", errno));
+		return;
+	}
+
+	mAckReceived = 0;
+	mResponseParser.reset();
+
+	/**
+	 * Connect without blocking, the engine is told once the connect has finished
+	 */
+	result = ::connect(mSocket, (struct sockaddr*) &server, sizeof(server));
+	if (0 == result) {
+		mState = HANDSHAKE;
+	} else if (EINPROGRESS == errno) {
+		mState = CONNECTING;
+	} else {
+		close(describeError("failed to connect to host server", errno));
+		return;
+	}
+
+	struct epoll_event event;
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN | (CONNECTING == mState ? (uint32_t) EPOLLOUT : 0);
+	event.data.u64 = mId;
+	mWatchingWrite = CONNECTING == mState;
+
+	if (-1 == epoll_ctl(mEngine->mEpoll, EPOLL_CTL_ADD, mSocket, &event)) {
+		close(describeError("Failed to watch socket", errno));
+	}
+}
+
+void ClientEngine::Connection::writeRequest(const std::string& bytes) {
+	std::lock_guard<std::mutex> lock(mOutgoingMutex);
+	if (0 == mOutgoing)
+		mOutgoing = mEngine->acquireBuffer();
+	mOutgoing->insert(mOutgoing->end(), bytes.begin(), bytes.end());
+
+	if (!mFlushScheduled) {
+		mFlushScheduled = true;
+		mEngine->postToConnection(mId, [](Connection* connection) {
+			connection->flush();
+		});
+	}
+}
+
+void ClientEngine::Connection::handleEvents(const unsigned int events) {
+	ClientEngine* engine = mEngine;
+	const ConnectionId id = mId;
+
+	switch (mState) {
+	case CONNECTING:
+		if (events & (EPOLLOUT | EPOLLERR | EPOLLHUP))
+			handleConnect();
+		break;
+	case HANDSHAKE:
+		if (events & (EPOLLIN | EPOLLERR | EPOLLHUP))
+			handleHandshake();
+		break;
+	case OPEN:
+		if (events & EPOLLOUT) {
+			flush();
+			//a failed send closes the connection, whose callbacks may have deleted it
+			if (engine->findConnection(id) != this || OPEN != mState)
+				break;
+		}
+		if (events & (EPOLLIN | EPOLLERR | EPOLLHUP))
+			handleReceive();
+		break;
+	case CLOSED:
+		break;
+	}
+}
+
+void ClientEngine::Connection::handleConnect() {
+	int error = 0;
+	socklen_t length = sizeof(error);
+	if (-1 == getsockopt(mSocket, SOL_SOCKET, SO_ERROR, &error, &length))
+		error = errno;
+
+	if (0 != error) {
+		close(describeError("failed to connect to host server", error));
+		return;
+	}
+
+	//wait for the server's acknowledgement
+	mState = HANDSHAKE;
+	watch(false);
+}
+
+void ClientEngine::Connection::handleHandshake() {
+	/**
+	 * Read only the acknowledgement, anything after it is left for handleReceive
+	 */
+	int nbytes = ::recv(mSocket, mEngine->mBuffer, ACK_SIZE - mAckReceived, 0);
+
+	if (-1 == nbytes) {
+		if (EAGAIN != errno && EWOULDBLOCK != errno && EINTR != errno)
+			close(describeError("Failed to recv from socket:", errno));
+		return;
+	}
+
+	if (0 == nbytes) {
+		close("Connection closed by server");
+		return;
+	}
+
+	mAckReceived += nbytes;
+	if (mAckReceived < ACK_SIZE)
+		return;
+
+	//send over our connection information
+	const std::string identifier(mIdentifier + IDENTIFIER_END);
+	if ((int) identifier.size()
+			!= ::send(mSocket, identifier.c_str(), identifier.size(),
+					MSG_NOSIGNAL)) {
+		close(describeError("Failed to send identifier:", errno));
+		return;
+	}
+
+	//open, and send anything requested while connecting
+	mState = OPEN;
+	mConnected = true;
+	flush();
+}
+
+void ClientEngine::Connection::handleReceive() {
+	ClientEngine* engine = mEngine;
+	const ConnectionId id = mId;
+
+	int nbytes = ::recv(mSocket, engine->mBuffer, sizeof(engine->mBuffer), 0);
+
+	if (-1 == nbytes) {
+		if (EAGAIN != errno && EWOULDBLOCK != errno && EINTR != errno)
+			close(describeError("Failed to recv from socket:", errno));
+		return;
+	}
+
+	std::vector<objects::HttpResponse> responses;
+	std::string error;
+	try {
+		if (0 == nbytes) {
+			//server closed connection, which completes a body delimited by the close
+			mResponseParser.finish(responses);
+			error = "Connection closed by server";
+		} else {
+			mResponseParser.parse(engine->mBuffer, nbytes, responses);
+		}
+	} catch (std::runtime_error& ex) {
+		error = ex.what();
+	}
+
+	for (std::vector<objects::HttpResponse>::iterator iter = responses.begin();
+			iter != responses.end(); ++iter) {
+		receiveResponseFromServer(*iter);
+		//response callbacks may delete the connection
+		if (engine->findConnection(id) != this)
+			return;
+	}
+
+	if (!error.empty())
+		close(error);
+}
+
+void ClientEngine::Connection::flush() {
+	std::unique_lock<std::mutex> lock(mOutgoingMutex);
+	mFlushScheduled = false;
+
+	if (OPEN != mState || 0 == mOutgoing)
+		return;
+
+	while (mOutgoingOffset < mOutgoing->size()) {
+		ssize_t nbytes = ::send(mSocket, &(*mOutgoing)[mOutgoingOffset],
+				mOutgoing->size() - mOutgoingOffset, MSG_NOSIGNAL);
+
+		if (nbytes > 0) {
+			mOutgoingOffset += nbytes;
+		} else if (-1 == nbytes && EINTR == errno) {
+			continue;
+		} else if (-1 == nbytes && (EAGAIN == errno || EWOULDBLOCK == errno)) {
+			//socket is full, continue once it is writable
+			if (!mWatchingWrite)
+				watch(true);
+			return;
+		} else {
+			std::string reason(describeError("Failed to send to socket:", errno));
+			lock.unlock();
+			close(reason);
+			return;
+		}
+	}
+
+	//everything queued has been sent, give the buffer back
+	mEngine->releaseBuffer(mOutgoing);
+	mOutgoing = 0;
+	mOutgoingOffset = 0;
+
+	if (mWatchingWrite)
+		watch(false);
+}
+
+void ClientEngine::Connection::watch(const bool writable) {
+	struct epoll_event event;
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN | (writable ? (uint32_t) EPOLLOUT : 0);
+	event.data.u64 = mId;
+	epoll_ctl(mEngine->mEpoll, EPOLL_CTL_MOD, mSocket, &event);
+	mWatchingWrite = writable;
+}
+
+void ClientEngine::Connection::close(const std::string& reason) {
+	if (-1 != mSocket) {
+		epoll_ctl(mEngine->mEpoll, EPOLL_CTL_DEL, mSocket, 0);
+		Socket sckt(mSocket);
+		sckt.closeSocket();
+		mSocket = -1;
+	}
+
+	mState = CLOSED;
+	mConnected = false;
+	mClosed = true;
+	mWatchingWrite = false;
+	mResponseParser.reset();
+
+	{
+		std::lock_guard<std::mutex> lock(mOutgoingMutex);
+		if (0 != mOutgoing) {
+			mEngine->releaseBuffer(mOutgoing);
+			mOutgoing = 0;
+			mOutgoingOffset = 0;
+		}
+	}
+
+	failRequests(reason);
+}
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "client/interface/IClient.h"
+
+#include "client/posix/Platform.h"
+#include "client/posix/posix.h"
+
+#include "objects/HttpResponseParser.h"
+
+#include "workers/TimerWheel.h"
+
+#define ENGINE_BUFFER_SIZE 65536
+
+namespace c11http {
+namespace client {
+namespace posix {
+
+/**
+ * Single threaded client engine. The one thread calling run drives every connection created through the engine,
+ * multiplexed with epoll (Linux only), so a process holding thousands of upstream connections does not need a
+ * thread per connection. Connections share the engine's timer wheel, its receive buffer and a pool of send
+ * buffers, and each is an IClient.
+ */
+class CLIENT_POSIX_API ClientEngine
+{
+public:
+    typedef unsigned long long ConnectionId;
+
+    /**
+     * Connection to one server, driven by the engine. Requests may be sent from any thread; responses and
+     * failures are reported on the engine thread. Deleting a connection closes it and removes it from the engine.
+     */
+    class CLIENT_POSIX_API Connection : public IClient
+    {
+    public:
+        ~Connection();
+
+        /**
+         * Send a request and block until its response arrives. Throws if called from the engine thread, which
+         * would never see the response.
+         */
+        virtual objects::HttpResponse sendRequestToServer(const objects::HttpRequest& req);
+        /**
+         * Close any current connection and connect to the server listening at hostname:port.
+         */
+        virtual void connectToServer(const std::string& hostname, const unsigned int port);
+        /**
+         * Close the connection. Requests awaiting responses are failed.
+         */
+        virtual void disconnect();
+
+        const bool isConnected() const;
+        const std::string& getIdentifier() const;
+
+    protected:
+        /**
+         * Start a non-blocking connect to hostname:port. Called on the engine thread.
+         */
+        virtual void performServerConnection(const std::string& hostname, const unsigned int port);
+        /**
+         * Queue request bytes, which are written at the end of the engine's current iteration so that
+         * pipelined requests go out in as few sends as possible.
+         */
+        virtual void writeRequest(const std::string& bytes);
+        /**
+         * Closed once the connection fails or is disconnected, until the next connect.
+         */
+        virtual bool isClosed() const;
+
+    private:
+        friend class ClientEngine;
+
+        enum State
+        {
+            CLOSED, CONNECTING, HANDSHAKE, OPEN
+        };
+
+        Connection(ClientEngine* engine, const ConnectionId id, const std::string& identifier,
+                const IClient::ClientResponseCallback& responseCallback);
+
+        /**
+         * Socket is ready, as reported by epoll.
+         */
+        void handleEvents(const unsigned int events);
+        /**
+         * Non-blocking connect has finished, check whether it succeeded.
+         */
+        void handleConnect();
+        /**
+         * Read the server's acknowledgement, then send our identifier, opening the connection.
+         */
+        void handleHandshake();
+        /**
+         * Read from the socket and complete any responses received.
+         */
+        void handleReceive();
+        /**
+         * Write as much queued data as the socket will take.
+         */
+        void flush();
+        /**
+         * Close the socket and fail outstanding requests. Callers must return straight after, since failure
+         * callbacks may delete this connection.
+         */
+        void close(const std::string& reason);
+        void watch(const bool writable);
+
+        ClientEngine* mEngine;
+        const ConnectionId mId;
+        std::string mIdentifier;
+        State mState; //only used on the engine thread
+        std::atomic<bool> mConnected;
+        std::atomic<bool> mClosed; //set before outstanding requests are failed, unlike mState read from any thread
+        int mSocket;
+        unsigned int mAckReceived;
+        bool mWatchingWrite;
+
+        std::vector<char>* mOutgoing; //borrowed from the engine while there is data to send
+        size_t mOutgoingOffset;
+        bool mFlushScheduled;
+        std::mutex mOutgoingMutex; //guards mOutgoing, mOutgoingOffset and mFlushScheduled
+
+        objects::HttpResponseParser mResponseParser;
+    };
+
+    ClientEngine(const unsigned int tickMilliseconds = 10) throw (std::runtime_error);
+    /**
+     * Deletes every connection still open. run must have returned.
+     */
+    ~ClientEngine();
+
+    /**
+     * Create a connection to the server listening at hostname:port, which is established on the engine thread.
+     * Requests sent before then are queued. The engine owns the connection until it is deleted. Safe to call
+     * from any thread.
+     */
+    Connection* connect(const std::string& hostname, const unsigned int port, const std::string& identifier,
+            const IClient::ClientResponseCallback& responseCallback = IClient::ClientResponseCallback());
+
+    /**
+     * Block the current thread, which becomes the engine thread, until shutdown is called.
+     */
+    void run() throw (std::runtime_error);
+    void shutdown();
+
+    /**
+     * Run a task on the engine thread. Safe to call from any thread.
+     */
+    void post(const std::function<void()>& task);
+    /**
+     * Run a task on the engine thread after milliseconds. Safe to call from any thread.
+     */
+    void runAfter(const unsigned int milliseconds, const std::function<void()>& task);
+    bool isEventLoopThread() const;
+    /**
+     * Timer wheel driven by the engine, e.g. for ConnectionPool eviction. Only usable on the engine thread.
+     */
+    workers::TimerWheel& getTimers();
+    size_t getConnectionCount();
+
+private:
+    friend class Connection;
+
+    /**
+     * Run a task against a connection on the engine thread, if the connection still exists by then.
+     */
+    void postToConnection(const ConnectionId id, const std::function<void(Connection*)>& task);
+    Connection* findConnection(const ConnectionId id);
+    void removeConnection(const ConnectionId id);
+    std::vector<char>* acquireBuffer();
+    void releaseBuffer(std::vector<char>* buffer);
+    void runPostedTasks();
+    void performWakeup();
+
+    int mEpoll;
+    int mWakeupFd;
+    std::atomic<bool> mShutdown;
+    std::thread::id mLoopThread;
+    workers::TimerWheel mTimers;
+
+    std::map<ConnectionId, Connection*> mConnections;
+    ConnectionId mNextId;
+    /**
+     * Held by the engine thread while a connection is handled, so connections deleted on other threads are never
+     * deleted mid-event. Recursive since callbacks on the engine thread may delete connections too.
+     */
+    std::recursive_mutex mConnectionsMutex;
+
+    std::vector<std::function<void()> > mPostedTasks;
+    std::mutex mTasksMutex;
+
+    std::vector<std::vector<char>*> mFreeBuffers;
+    std::mutex mBuffersMutex;
+
+    char mBuffer[ENGINE_BUFFER_SIZE]; //receive buffer shared by every connection
+};
+
+}
+}
+}
@@ -1,6 +1,6 @@
 #ifndef WINDOWS
 
-#include "tcp/posix/Socket.h"
+#include "client/posix/Socket.h"
 
 #include <sys/socket.h>
 #include <netinet/in.h>
@@ -8,9 +8,10 @@
 #include <fcntl.h>
 #include <sstream>
 #include <string.h>
+#include <unistd.h>
 
 namespace c11http {
-namespace tcp {
+namespace client {
 namespace posix {
 
 Socket::Socket() throw (std::runtime_error) {
@@ -1,17 +1,17 @@
 #pragma once
 
-#include "tcp/posix/Platform.h"
-#include "tcp/posix/posix.h"
+#include "client/posix/Platform.h"
+#include "client/posix/posix.h"
 
 namespace c11http {
-namespace tcp {
+namespace client {
 namespace posix {
 
 /**
  * Wrapper around the underlying posix file descriptor, which maintains
  * a network connection to some other device.
  */
-class TCP_POSIX_API Socket
+class CLIENT_POSIX_API Socket
 {
 public:
     /**
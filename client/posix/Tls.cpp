@@ -0,0 +1,212 @@
+#ifndef WINDOWS
+#include "client/posix/Tls.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+
+namespace c11http {
+namespace client {
+namespace posix {
+
+namespace {
+/**
+ * what, followed by the reason OpenSSL gives for the error it last queued.
+ */
+std::string describe(const std::string& what) {
+	char reason[256];
+	const unsigned long error = ERR_get_error();
+	ERR_clear_error();
+	if (0 == error)
+		return what;
+	ERR_error_string_n(error, reason, sizeof(reason));
+	return what + ": " + reason;
+}
+}
+
+TlsContext::Options::Options() :
+		verifyPeer(true) {
+}
+
+TlsContext::TlsContext(const Options& options) throw (std::runtime_error) :
+		mContext(SSL_CTX_new(TLS_client_method())), mServerName(
+				options.serverName), mHandshakes(0), mResumed(0) {
+	if (0 == mContext)
+		throw(std::runtime_error(describe("Failed to create TLS context")));
+
+	SSL_CTX_set_min_proto_version(mContext, TLS1_2_VERSION);
+	SSL_CTX_set_options(mContext, SSL_OP_IGNORE_UNEXPECTED_EOF);
+	//writes are retried from the outgoing bytes, which move as requests are queued
+	SSL_CTX_set_mode(mContext,
+			SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+
+	SSL_CTX_set_verify(mContext,
+			options.verifyPeer ? SSL_VERIFY_PEER : SSL_VERIFY_NONE, 0);
+	const int loaded =
+			options.trustedCertificates.empty() ?
+					SSL_CTX_set_default_verify_paths(mContext) :
+					SSL_CTX_load_verify_locations(mContext,
+							options.trustedCertificates.c_str(), 0);
+	if (1 != loaded) {
+		const std::string reason(
+				describe(
+						"Failed to load trusted certificates "
+								+ options.trustedCertificates));
+		SSL_CTX_free(mContext);
+		throw(std::runtime_error(reason));
+	}
+
+	/**
+	 * Sessions are kept here by server rather than in OpenSSL's cache, which does not look them up for
+	 * clients. TLS 1.3 issues them after the handshake, so they are stored as they arrive.
+	 */
+	SSL_CTX_set_session_cache_mode(mContext,
+			SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+	SSL_CTX_sess_set_new_cb(mContext, &TlsContext::newSession);
+}
+
+TlsContext::~TlsContext() {
+	for (std::map<std::string, SSL_SESSION*>::iterator iter =
+			mSessions.begin(); iter != mSessions.end(); ++iter) {
+		SSL_SESSION_free(iter->second);
+	}
+	SSL_CTX_free(mContext);
+}
+
+size_t TlsContext::getHandshakes() const {
+	return mHandshakes;
+}
+
+size_t TlsContext::getResumed() const {
+	return mResumed;
+}
+
+size_t TlsContext::getCachedSessions() const {
+	std::lock_guard<std::mutex> lock(mSessionsMutex);
+	return mSessions.size();
+}
+
+void TlsContext::storeSession(const std::string& peer, SSL_SESSION* session) {
+	std::lock_guard<std::mutex> lock(mSessionsMutex);
+	SSL_SESSION*& stored = mSessions[peer];
+	if (0 != stored)
+		SSL_SESSION_free(stored);
+	stored = session;
+}
+
+int TlsContext::newSession(SSL* ssl, SSL_SESSION* session) {
+	TlsStream* stream = static_cast<TlsStream*>(SSL_get_app_data(ssl));
+	if (0 == stream || !SSL_SESSION_is_resumable(session))
+		return 0;
+	//returning 1 keeps the reference OpenSSL passed in
+	stream->mContext.storeSession(stream->mPeer, session);
+	return 1;
+}
+
+TlsStream::TlsStream(TlsContext& context, const int socket,
+		const std::string& peer) throw (std::runtime_error) :
+		mContext(context), mSession(SSL_new(context.mContext)), mPeer(peer) {
+	if (0 == mSession)
+		throw(std::runtime_error(describe("Failed to create TLS session")));
+
+	SSL_set_app_data(mSession, this);
+	if (1 != SSL_set_fd(mSession, socket)
+			|| (!context.mServerName.empty()
+					&& (1
+							!= SSL_set_tlsext_host_name(mSession,
+									context.mServerName.c_str())
+							|| 1
+									!= SSL_set1_host(mSession,
+											context.mServerName.c_str())))) {
+		const std::string reason(describe("Failed to prepare TLS session"));
+		SSL_free(mSession);
+		throw(std::runtime_error(reason));
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(context.mSessionsMutex);
+		std::map<std::string, SSL_SESSION*>::iterator iter =
+				context.mSessions.find(peer);
+		if (iter != context.mSessions.end())
+			SSL_set_session(mSession, iter->second);
+	}
+	SSL_set_connect_state(mSession);
+}
+
+TlsStream::~TlsStream() {
+	/**
+	 * The socket is closed by now, possibly from another thread. OpenSSL would take a session freed without
+	 * a shutdown as broken and refuse to resume it; a failed session was already marked so as it failed
+	 */
+	SSL_set_quiet_shutdown(mSession, 1);
+	SSL_shutdown(mSession);
+	ERR_clear_error();
+	SSL_free(mSession);
+}
+
+TlsStream::Status TlsStream::handshake() {
+	ERR_clear_error();
+	const int result = SSL_do_handshake(mSession);
+	if (1 != result)
+		return status(result);
+
+	++mContext.mHandshakes;
+	if (SSL_session_reused(mSession))
+		++mContext.mResumed;
+	return TLS_OK;
+}
+
+TlsStream::Status TlsStream::read(char* buffer, const size_t length,
+		size_t& count) {
+	ERR_clear_error();
+	const int result = SSL_read_ex(mSession, buffer, length, &count);
+	if (1 == result)
+		return TLS_OK;
+	count = 0;
+	return status(result);
+}
+
+TlsStream::Status TlsStream::write(const char* data, const size_t length,
+		size_t& count) {
+	ERR_clear_error();
+	const int result = SSL_write_ex(mSession, data, length, &count);
+	if (1 == result)
+		return TLS_OK;
+	count = 0;
+	return status(result);
+}
+
+bool TlsStream::hasBuffered() const {
+	return SSL_pending(mSession) > 0;
+}
+
+std::string TlsStream::getError() const {
+	return mError;
+}
+
+TlsStream::Status TlsStream::status(const int result) {
+	const int savedErrno = errno;
+	switch (SSL_get_error(mSession, result)) {
+	case SSL_ERROR_WANT_READ:
+		return TLS_WANT_READ;
+	case SSL_ERROR_WANT_WRITE:
+		return TLS_WANT_WRITE;
+	case SSL_ERROR_ZERO_RETURN:
+		return TLS_CLOSED;
+	case SSL_ERROR_SYSCALL:
+		mError = describe(
+				0 == savedErrno ? "connection reset" : strerror(savedErrno));
+		return TLS_FAILED;
+	default:
+		mError = describe("TLS error");
+		return TLS_FAILED;
+	}
+}
+
+}
+}
+}
+
+#endif
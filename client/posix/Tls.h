@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "client/posix/Platform.h"
+#include "client/posix/posix.h"
+
+struct ssl_st;
+struct ssl_ctx_st;
+struct ssl_session_st;
+
+namespace c11http {
+namespace client {
+namespace posix {
+
+/**
+ * TLS settings shared by client connections, and the latest session each server issued, so that reconnecting to
+ * it resumes that session with an abbreviated handshake instead of a full one. Safe to share between threads.
+ */
+class CLIENT_POSIX_API TlsContext
+{
+public:
+    struct Options
+    {
+        Options();
+        std::string trustedCertificates; //PEM file of certificates to trust, empty for the system's
+        std::string serverName; //sent to the server and checked against its certificate, empty to check the chain only
+        bool verifyPeer; //false accepts any certificate, for testing only
+    };
+
+    explicit TlsContext(const Options& options = Options()) throw (std::runtime_error);
+    ~TlsContext();
+
+    size_t getHandshakes() const;
+    size_t getResumed() const; //handshakes that resumed an earlier session
+    size_t getCachedSessions() const;
+
+private:
+    friend class TlsStream;
+
+    TlsContext(const TlsContext&);
+    TlsContext& operator=(const TlsContext&);
+
+    /**
+     * Keep session as the one to resume with peer, replacing any earlier one.
+     */
+    void storeSession(const std::string& peer, ssl_session_st* session);
+    static int newSession(ssl_st* ssl, ssl_session_st* session);
+
+    ssl_ctx_st* mContext;
+    const std::string mServerName;
+    mutable std::mutex mSessionsMutex;
+    std::map<std::string, ssl_session_st*> mSessions; //by "address:port"
+    std::atomic<size_t> mHandshakes;
+    std::atomic<size_t> mResumed;
+};
+
+/**
+ * The TLS session of one connection to a server, reading and writing its non-blocking socket. A call the socket
+ * can not complete yet says whether it waits for the socket to be readable or writable, and is retried once it is;
+ * a write is retried with the same bytes, though they may have moved.
+ */
+class CLIENT_POSIX_API TlsStream
+{
+public:
+    enum Status
+    {
+        TLS_OK, TLS_WANT_READ, TLS_WANT_WRITE, TLS_CLOSED, TLS_FAILED
+    };
+
+    /**
+     * Start a session with the server at peer, "address:port", over the connected socket, resuming the session
+     * last issued by peer if there is one.
+     */
+    TlsStream(TlsContext& context, const int socket, const std::string& peer) throw (std::runtime_error);
+    ~TlsStream();
+
+    /**
+     * Continue the client side of the handshake.
+     */
+    Status handshake();
+    Status read(char* buffer, const size_t length, size_t& count);
+    Status write(const char* data, const size_t length, size_t& count);
+    /**
+     * True if decrypted bytes are waiting, which select does not show as the socket being readable.
+     */
+    bool hasBuffered() const;
+    std::string getError() const;
+
+private:
+    friend class TlsContext;
+
+    TlsStream(const TlsStream&);
+    TlsStream& operator=(const TlsStream&);
+
+    Status status(const int result);
+
+    TlsContext& mContext;
+    ssl_st* mSession;
+    const std::string mPeer;
+    std::string mError;
+};
+
+}
+}
+}
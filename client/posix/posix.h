@@ -1,6 +1,9 @@
 #pragma once
 
 #define MAX_BUFFER_SIZE 1024
+//bytes read from the server at once, large enough for most responses to arrive in one read
+#define CLIENT_RECEIVE_BUFFER_SIZE 16384
 
 #include <stdexcept>
 #include <sys/socket.h>
+#include <sys/select.h>
@@ -0,0 +1,259 @@
+#include "loadgen/LoadGenerator.h"
+
+#include "client/posix/ClientEngine.h"
+#include "objects/HttpRequest.h"
+#include "objects/HttpResponse.h"
+#include "tcp/Server.h"
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace c11http {
+namespace loadgen {
+
+namespace {
+   typedef std::chrono::steady_clock Clock;
+
+   //how often each thread checks for requests that are due
+   const unsigned int PACING_MILLISECONDS = 1;
+   const unsigned int CONNECT_TIMEOUT_MILLISECONDS = 2000;
+   const unsigned int DRAIN_TIMEOUT_MILLISECONDS = 2000;
+
+   const double PERCENTILES[] = { 50.0, 75.0, 90.0, 99.0, 99.9, 99.99 };
+
+   unsigned long long microsecondsBetween(const Clock::time_point& from, const Clock::time_point& to) {
+      return to > from ? std::chrono::duration_cast<std::chrono::microseconds>(to - from).count() : 0;
+   }
+
+   struct ScheduledConnection {
+      client::posix::ClientEngine::Connection* connection;
+      Clock::time_point nextSend;
+   };
+
+   /**
+    * Everything driven by one thread. Histograms are only touched on the engine thread, counters are also read
+    * by the thread running the generator.
+    */
+   struct LoadThread {
+      LoadThread() : sent(0), completed(0), failed(0), statusErrors(0), stopped(false), engine(PACING_MILLISECONDS) {
+
+      }
+
+      std::vector<ScheduledConnection> connections;
+      objects::HttpRequest request;
+      Clock::duration interval;
+      workers::HdrHistogram latency;
+      workers::HdrHistogram uncorrectedLatency;
+      std::atomic<unsigned long long> sent;
+      std::atomic<unsigned long long> completed;
+      std::atomic<unsigned long long> failed;
+      std::atomic<unsigned long long> statusErrors;
+      std::atomic<bool> stopped;
+      //declared last so it is destroyed first, failing outstanding requests while the counters still exist
+      client::posix::ClientEngine engine;
+
+      /**
+       * Issue every request that is due, then check again after the pacing interval.
+       */
+      void pace() {
+         if(stopped) return;
+
+         const Clock::time_point now = Clock::now();
+         for(std::vector<ScheduledConnection>::iterator iter = connections.begin(); iter != connections.end(); ++iter) {
+            while(iter->nextSend <= now) {
+               send(iter->connection, iter->nextSend, now);
+               iter->nextSend += interval;
+            }
+         }
+         engine.runAfter(PACING_MILLISECONDS, [this]() { pace(); });
+      }
+
+      void send(client::posix::ClientEngine::Connection* connection, const Clock::time_point& scheduled,
+            const Clock::time_point& issued) {
+         ++sent;
+         connection->sendRequestAsync(request, [this, scheduled, issued](const objects::HttpResponse& resp) {
+            const Clock::time_point now = Clock::now();
+            latency.record(microsecondsBetween(scheduled, now));
+            uncorrectedLatency.record(microsecondsBetween(issued, now));
+            if(resp.getStatus() >= 400) ++statusErrors;
+            ++completed;
+         }, [this](const std::string&) {
+            ++failed;
+         });
+      }
+
+      unsigned long long outstanding() const {
+         return sent - completed - failed;
+      }
+   };
+
+   void printLatency(std::ostream& out, const std::string& name, const workers::HdrHistogram& histogram) {
+      out << name << " (us): mean " << std::fixed << std::setprecision(1) << histogram.getMean()
+          << ", max " << histogram.getMax() << std::endl;
+      for(size_t i = 0; i < sizeof(PERCENTILES) / sizeof(PERCENTILES[0]); ++i) {
+         out << std::setw(10) << std::setprecision(3) << PERCENTILES[i] << "% " << histogram.valueAtPercentile(PERCENTILES[i])
+             << std::endl;
+      }
+   }
+
+   void printLatencyJson(std::ostream& out, const workers::HdrHistogram& histogram) {
+      out << "{\"count\": " << histogram.getTotalCount()
+          << ", \"mean\": " << std::fixed << std::setprecision(1) << histogram.getMean()
+          << ", \"min\": " << histogram.getMin()
+          << ", \"max\": " << histogram.getMax()
+          << ", \"p50\": " << histogram.valueAtPercentile(50.0)
+          << ", \"p90\": " << histogram.valueAtPercentile(90.0)
+          << ", \"p99\": " << histogram.valueAtPercentile(99.0)
+          << ", \"p99_9\": " << histogram.valueAtPercentile(99.9)
+          << ", \"p99_99\": " << histogram.valueAtPercentile(99.99) << "}";
+   }
+}
+
+LoadGenerator::Options::Options() : host("127.0.0.1"), port(8080), target("/"), connections(16), threads(2), rate(1000),
+   durationSeconds(10), pipeline(1), serve(false) {
+
+}
+
+LoadGenerator::Report::Report() : sent(0), completed(0), failed(0), statusErrors(0), connectErrors(0),
+   durationSeconds(0) {
+
+}
+
+double LoadGenerator::Report::throughput() const {
+   return durationSeconds > 0 ? completed / durationSeconds : 0;
+}
+
+void LoadGenerator::Report::print(std::ostream& out) const {
+   printLatency(out, "Latency", latency);
+   printLatency(out, "Uncorrected latency", uncorrectedLatency);
+   out << sent << " requests sent, " << completed << " responses in " << std::setprecision(2) << durationSeconds << "s"
+       << std::endl;
+   out << "Errors: " << failed << " failed, " << statusErrors << " status >= 400, " << connectErrors << " connect"
+       << std::endl;
+   out << "Requests/sec: " << std::setprecision(2) << throughput() << std::endl;
+}
+
+void LoadGenerator::Report::printJson(std::ostream& out) const {
+   out << "{\"sent\": " << sent
+       << ", \"completed\": " << completed
+       << ", \"errors\": {\"failed\": " << failed << ", \"status\": " << statusErrors
+       << ", \"connect\": " << connectErrors << "}"
+       << ", \"duration_seconds\": " << std::fixed << std::setprecision(3) << durationSeconds
+       << ", \"throughput\": " << std::setprecision(2) << throughput()
+       << ", \"latency_us\": ";
+   printLatencyJson(out, latency);
+   out << ", \"uncorrected_latency_us\": ";
+   printLatencyJson(out, uncorrectedLatency);
+   out << "}" << std::endl;
+}
+
+LoadGenerator::LoadGenerator(const Options& options) : mOptions(options) {
+   if(0 == mOptions.connections) mOptions.connections = 1;
+   if(0 == mOptions.threads) mOptions.threads = 1;
+   if(mOptions.threads > mOptions.connections) mOptions.threads = mOptions.connections;
+}
+
+LoadGenerator::Report LoadGenerator::run() throw (std::runtime_error) {
+   if(mOptions.rate <= 0) throw(std::runtime_error("rate must be positive"));
+
+   std::unique_ptr<tcp::Server> server;
+   std::unique_ptr<std::thread> serverThread;
+   if(mOptions.serve) {
+      server.reset(new tcp::Server(mOptions.port));
+      server->registerHandler([](const objects::HttpRequest&) {
+         return objects::HttpResponse(200, "ok");
+      }, tcp::Server::DISPATCH_INLINE);
+      serverThread.reset(new std::thread(&tcp::Server::waitForEvents, server.get()));
+   }
+
+   /**
+    * Each connection sends one request per interval, with connections staggered evenly across it
+    */
+   const Clock::duration interval = std::chrono::duration_cast<Clock::duration>(
+         std::chrono::duration<double>(mOptions.connections / mOptions.rate));
+   const Clock::duration stagger = interval / mOptions.connections;
+
+   std::vector<std::unique_ptr<LoadThread> > threads;
+   std::vector<std::thread> runners;
+   for(unsigned int i = 0; i < mOptions.threads; ++i) {
+      threads.push_back(std::unique_ptr<LoadThread>(new LoadThread()));
+      threads.back()->request = objects::HttpRequest(objects::HttpRequest::GET, mOptions.target, "");
+      threads.back()->interval = interval;
+      runners.push_back(std::thread(&client::posix::ClientEngine::run, &threads.back()->engine));
+   }
+
+   for(unsigned int i = 0; i < mOptions.connections; ++i) {
+      LoadThread& thread = *threads[i % mOptions.threads];
+      std::stringstream identifier;
+      identifier << "loadgen-" << i;
+      ScheduledConnection scheduled;
+      scheduled.connection = thread.engine.connect(mOptions.host, mOptions.port, identifier.str());
+      scheduled.connection->setMaxInFlight(mOptions.pipeline);
+      thread.connections.push_back(scheduled);
+   }
+
+   //connection setup is not part of the measurement
+   Report report;
+   const Clock::time_point connectDeadline = Clock::now() + std::chrono::milliseconds(CONNECT_TIMEOUT_MILLISECONDS);
+   for(size_t i = 0; i < threads.size(); ++i) {
+      for(size_t j = 0; j < threads[i]->connections.size(); ++j) {
+         while(!threads[i]->connections[j].connection->isConnected() && Clock::now() < connectDeadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+         }
+         if(!threads[i]->connections[j].connection->isConnected()) ++report.connectErrors;
+      }
+   }
+
+   const Clock::time_point start = Clock::now();
+   for(size_t i = 0; i < threads.size(); ++i) {
+      LoadThread* thread = threads[i].get();
+      for(size_t j = 0; j < thread->connections.size(); ++j) {
+         thread->connections[j].nextSend = start + stagger * (j * threads.size() + i);
+      }
+      thread->engine.post([thread]() { thread->pace(); });
+   }
+
+   std::this_thread::sleep_for(std::chrono::duration<double>(mOptions.durationSeconds));
+   for(size_t i = 0; i < threads.size(); ++i) threads[i]->stopped = true;
+   report.durationSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+   //give requests already sent a chance to complete
+   const Clock::time_point drainDeadline = Clock::now() + std::chrono::milliseconds(DRAIN_TIMEOUT_MILLISECONDS);
+   for(size_t i = 0; i < threads.size(); ++i) {
+      while(threads[i]->outstanding() > 0 && Clock::now() < drainDeadline) {
+         std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+   }
+
+   for(size_t i = 0; i < threads.size(); ++i) {
+      threads[i]->engine.shutdown();
+      runners[i].join();
+   }
+
+   for(size_t i = 0; i < threads.size(); ++i) {
+      LoadThread& thread = *threads[i];
+      report.sent += thread.sent;
+      report.completed += thread.completed;
+      report.statusErrors += thread.statusErrors;
+      report.latency.add(thread.latency);
+      report.uncorrectedLatency.add(thread.uncorrectedLatency);
+   }
+   //requests still outstanding are failed as the engines are destroyed
+   threads.clear();
+   report.failed = report.sent - report.completed;
+
+   if(server) {
+      server->shutdown();
+      serverThread->join();
+   }
+
+   return report;
+}
+
+}
+}
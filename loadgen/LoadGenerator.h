@@ -0,0 +1,60 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+
+#include "workers/HdrHistogram.h"
+
+namespace c11http {
+namespace loadgen {
+
+/**
+ * Open loop HTTP load generator. Requests are issued at a constant rate on a schedule fixed in advance, whether or
+ * not earlier responses have arrived, and latency is measured from when each request should have been sent. A
+ * stalled server therefore shows up in the latency of every request scheduled during the stall, rather than being
+ * hidden by the generator waiting on it (coordinated omission).
+ */
+class LoadGenerator {
+public:
+   struct Options {
+      Options();
+      std::string host;
+      unsigned int port;
+      std::string target; //request target sent with every GET
+      unsigned int connections; //spread evenly over the threads
+      unsigned int threads; //each thread drives its connections from one ClientEngine
+      double rate; //requests per second, across all connections
+      double durationSeconds;
+      unsigned int pipeline; //requests written to a connection without a response, 0 for no limit
+      bool serve; //answer the requests with a tcp::Server on host:port in this process
+   };
+
+   struct Report {
+      Report();
+      unsigned long long sent;
+      unsigned long long completed; //responses received
+      unsigned long long failed; //requests that never got a response, e.g. refused or closed connections
+      unsigned long long statusErrors; //responses with a status of 400 or above
+      unsigned long long connectErrors; //connections not established before the run started
+      double durationSeconds;
+      workers::HdrHistogram latency; //microseconds from the scheduled send time
+      workers::HdrHistogram uncorrectedLatency; //microseconds from when the request was issued
+
+      double throughput() const;
+      void print(std::ostream& out) const;
+      void printJson(std::ostream& out) const;
+   };
+
+   LoadGenerator(const Options& options);
+
+   /**
+    * Generate load for the configured duration, blocking until every thread has finished.
+    */
+   Report run() throw (std::runtime_error);
+
+private:
+   Options mOptions;
+};
+
+}
+}
@@ -0,0 +1,93 @@
+#include "loadgen/LoadGenerator.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+using namespace c11http::loadgen;
+
+namespace {
+   void usage(const char* program) {
+      std::cerr << "usage: " << program << " [options]" << std::endl
+                << "  --host <address>       server address (127.0.0.1)" << std::endl
+                << "  --port <port>          server port (8080)" << std::endl
+                << "  --target <path>        request target (/)" << std::endl
+                << "  --connections <n>      connections to open (16)" << std::endl
+                << "  --threads <n>          threads driving the connections (2)" << std::endl
+                << "  --rate <n>             requests per second across all connections (1000)" << std::endl
+                << "  --duration <seconds>   length of the run (10)" << std::endl
+                << "  --pipeline <n>         requests in flight per connection, 0 for no limit (1)" << std::endl
+                << "  --serve                answer requests with a tcp::Server on the port in this process" << std::endl
+                << "  --json <file>          write the report as JSON, - for stdout" << std::endl;
+   }
+}
+
+/**
+ * Open loop load generator, e.g. against a local server:
+ *    LoadGenerator --serve --port 8080 --connections 1000 --threads 4 --rate 50000 --duration 30 --json -
+ */
+int main(int argc, char** argv) {
+   LoadGenerator::Options options;
+   std::string jsonPath;
+
+   for(int i = 1; i < argc; ++i) {
+      const std::string arg(argv[i]);
+      const bool hasValue = i + 1 < argc;
+      if("--serve" == arg) {
+         options.serve = true;
+      }
+      else if("--host" == arg && hasValue) {
+         options.host = argv[++i];
+      }
+      else if("--port" == arg && hasValue) {
+         options.port = std::atoi(argv[++i]);
+      }
+      else if("--target" == arg && hasValue) {
+         options.target = argv[++i];
+      }
+      else if("--connections" == arg && hasValue) {
+         options.connections = std::atoi(argv[++i]);
+      }
+      else if("--threads" == arg && hasValue) {
+         options.threads = std::atoi(argv[++i]);
+      }
+      else if("--rate" == arg && hasValue) {
+         options.rate = std::atof(argv[++i]);
+      }
+      else if("--duration" == arg && hasValue) {
+         options.durationSeconds = std::atof(argv[++i]);
+      }
+      else if("--pipeline" == arg && hasValue) {
+         options.pipeline = std::atoi(argv[++i]);
+      }
+      else if("--json" == arg && hasValue) {
+         jsonPath = argv[++i];
+      }
+      else {
+         usage(argv[0]);
+         return 1;
+      }
+   }
+
+   try {
+      LoadGenerator generator(options);
+      LoadGenerator::Report report = generator.run();
+
+      if("-" == jsonPath) {
+         report.printJson(std::cout);
+      }
+      else {
+         report.print(std::cout);
+         if(!jsonPath.empty()) {
+            std::ofstream json(jsonPath.c_str());
+            report.printJson(json);
+         }
+      }
+   }
+   catch(std::runtime_error& ex) {
+      std::cerr << ex.what() << std::endl;
+      return 1;
+   }
+   return 0;
+}
@@ -0,0 +1,420 @@
+#include "objects/Hpack.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+
+namespace c11http {
+   namespace objects {
+
+      namespace {
+         const size_t ENTRY_OVERHEAD = 32;
+
+         const char* const STATIC_TABLE[][2] = {
+            {":authority", ""}, {":method", "GET"}, {":method", "POST"}, {":path", "/"}, {":path", "/index.html"},
+            {":scheme", "http"}, {":scheme", "https"}, {":status", "200"}, {":status", "204"}, {":status", "206"},
+            {":status", "304"}, {":status", "400"}, {":status", "404"}, {":status", "500"}, {"accept-charset", ""},
+            {"accept-encoding", "gzip, deflate"}, {"accept-language", ""}, {"accept-ranges", ""}, {"accept", ""},
+            {"access-control-allow-origin", ""}, {"age", ""}, {"allow", ""}, {"authorization", ""},
+            {"cache-control", ""}, {"content-disposition", ""}, {"content-encoding", ""}, {"content-language", ""},
+            {"content-length", ""}, {"content-location", ""}, {"content-range", ""}, {"content-type", ""},
+            {"cookie", ""}, {"date", ""}, {"etag", ""}, {"expect", ""}, {"expires", ""}, {"from", ""}, {"host", ""},
+            {"if-match", ""}, {"if-modified-since", ""}, {"if-none-match", ""}, {"if-range", ""},
+            {"if-unmodified-since", ""}, {"last-modified", ""}, {"link", ""}, {"location", ""},
+            {"max-forwards", ""}, {"proxy-authenticate", ""}, {"proxy-authorization", ""}, {"range", ""},
+            {"referer", ""}, {"refresh", ""}, {"retry-after", ""}, {"server", ""}, {"set-cookie", ""},
+            {"strict-transport-security", ""}, {"transfer-encoding", ""}, {"user-agent", ""}, {"vary", ""},
+            {"via", ""}, {"www-authenticate", ""}
+         };
+         const size_t STATIC_COUNT = sizeof(STATIC_TABLE) / sizeof(STATIC_TABLE[0]);
+
+         struct HuffmanCode {
+            uint32_t code;
+            uint8_t length;
+         };
+
+         /**
+          * RFC 7541 appendix B, by symbol. EOS, 30 ones, is only ever seen as padding.
+          */
+         const HuffmanCode HUFFMAN_CODES[256] = {
+            {0x1ff8, 13}, {0x7fffd8, 23}, {0xfffffe2, 28}, {0xfffffe3, 28}, {0xfffffe4, 28}, {0xfffffe5, 28},
+            {0xfffffe6, 28}, {0xfffffe7, 28}, {0xfffffe8, 28}, {0xffffea, 24}, {0x3ffffffc, 30}, {0xfffffe9, 28},
+            {0xfffffea, 28}, {0x3ffffffd, 30}, {0xfffffeb, 28}, {0xfffffec, 28}, {0xfffffed, 28}, {0xfffffee, 28},
+            {0xfffffef, 28}, {0xffffff0, 28}, {0xffffff1, 28}, {0xffffff2, 28}, {0x3ffffffe, 30}, {0xffffff3, 28},
+            {0xffffff4, 28}, {0xffffff5, 28}, {0xffffff6, 28}, {0xffffff7, 28}, {0xffffff8, 28}, {0xffffff9, 28},
+            {0xffffffa, 28}, {0xffffffb, 28}, {0x14, 6}, {0x3f8, 10}, {0x3f9, 10}, {0xffa, 12},
+            {0x1ff9, 13}, {0x15, 6}, {0xf8, 8}, {0x7fa, 11}, {0x3fa, 10}, {0x3fb, 10},
+            {0xf9, 8}, {0x7fb, 11}, {0xfa, 8}, {0x16, 6}, {0x17, 6}, {0x18, 6},
+            {0x0, 5}, {0x1, 5}, {0x2, 5}, {0x19, 6}, {0x1a, 6}, {0x1b, 6},
+            {0x1c, 6}, {0x1d, 6}, {0x1e, 6}, {0x1f, 6}, {0x5c, 7}, {0xfb, 8},
+            {0x7ffc, 15}, {0x20, 6}, {0xffb, 12}, {0x3fc, 10}, {0x1ffa, 13}, {0x21, 6},
+            {0x5d, 7}, {0x5e, 7}, {0x5f, 7}, {0x60, 7}, {0x61, 7}, {0x62, 7},
+            {0x63, 7}, {0x64, 7}, {0x65, 7}, {0x66, 7}, {0x67, 7}, {0x68, 7},
+            {0x69, 7}, {0x6a, 7}, {0x6b, 7}, {0x6c, 7}, {0x6d, 7}, {0x6e, 7},
+            {0x6f, 7}, {0x70, 7}, {0x71, 7}, {0x72, 7}, {0xfc, 8}, {0x73, 7},
+            {0xfd, 8}, {0x1ffb, 13}, {0x7fff0, 19}, {0x1ffc, 13}, {0x3ffc, 14}, {0x22, 6},
+            {0x7ffd, 15}, {0x3, 5}, {0x23, 6}, {0x4, 5}, {0x24, 6}, {0x5, 5},
+            {0x25, 6}, {0x26, 6}, {0x27, 6}, {0x6, 5}, {0x74, 7}, {0x75, 7},
+            {0x28, 6}, {0x29, 6}, {0x2a, 6}, {0x7, 5}, {0x2b, 6}, {0x76, 7},
+            {0x2c, 6}, {0x8, 5}, {0x9, 5}, {0x2d, 6}, {0x77, 7}, {0x78, 7},
+            {0x79, 7}, {0x7a, 7}, {0x7b, 7}, {0x7ffe, 15}, {0x7fc, 11}, {0x3ffd, 14},
+            {0x1ffd, 13}, {0xffffffc, 28}, {0xfffe6, 20}, {0x3fffd2, 22}, {0xfffe7, 20}, {0xfffe8, 20},
+            {0x3fffd3, 22}, {0x3fffd4, 22}, {0x3fffd5, 22}, {0x7fffd9, 23}, {0x3fffd6, 22}, {0x7fffda, 23},
+            {0x7fffdb, 23}, {0x7fffdc, 23}, {0x7fffdd, 23}, {0x7fffde, 23}, {0xffffeb, 24}, {0x7fffdf, 23},
+            {0xffffec, 24}, {0xffffed, 24}, {0x3fffd7, 22}, {0x7fffe0, 23}, {0xffffee, 24}, {0x7fffe1, 23},
+            {0x7fffe2, 23}, {0x7fffe3, 23}, {0x7fffe4, 23}, {0x1fffdc, 21}, {0x3fffd8, 22}, {0x7fffe5, 23},
+            {0x3fffd9, 22}, {0x7fffe6, 23}, {0x7fffe7, 23}, {0xffffef, 24}, {0x3fffda, 22}, {0x1fffdd, 21},
+            {0xfffe9, 20}, {0x3fffdb, 22}, {0x3fffdc, 22}, {0x7fffe8, 23}, {0x7fffe9, 23}, {0x1fffde, 21},
+            {0x7fffea, 23}, {0x3fffdd, 22}, {0x3fffde, 22}, {0xfffff0, 24}, {0x1fffdf, 21}, {0x3fffdf, 22},
+            {0x7fffeb, 23}, {0x7fffec, 23}, {0x1fffe0, 21}, {0x1fffe1, 21}, {0x3fffe0, 22}, {0x1fffe2, 21},
+            {0x7fffed, 23}, {0x3fffe1, 22}, {0x7fffee, 23}, {0x7fffef, 23}, {0xfffea, 20}, {0x3fffe2, 22},
+            {0x3fffe3, 22}, {0x3fffe4, 22}, {0x7ffff0, 23}, {0x3fffe5, 22}, {0x3fffe6, 22}, {0x7ffff1, 23},
+            {0x3ffffe0, 26}, {0x3ffffe1, 26}, {0xfffeb, 20}, {0x7fff1, 19}, {0x3fffe7, 22}, {0x7ffff2, 23},
+            {0x3fffe8, 22}, {0x1ffffec, 25}, {0x3ffffe2, 26}, {0x3ffffe3, 26}, {0x3ffffe4, 26}, {0x7ffffde, 27},
+            {0x7ffffdf, 27}, {0x3ffffe5, 26}, {0xfffff1, 24}, {0x1ffffed, 25}, {0x7fff2, 19}, {0x1fffe3, 21},
+            {0x3ffffe6, 26}, {0x7ffffe0, 27}, {0x7ffffe1, 27}, {0x3ffffe7, 26}, {0x7ffffe2, 27}, {0xfffff2, 24},
+            {0x1fffe4, 21}, {0x1fffe5, 21}, {0x3ffffe8, 26}, {0x3ffffe9, 26}, {0xffffffd, 28}, {0x7ffffe3, 27},
+            {0x7ffffe4, 27}, {0x7ffffe5, 27}, {0xfffec, 20}, {0xfffff3, 24}, {0xfffed, 20}, {0x1fffe6, 21},
+            {0x3fffe9, 22}, {0x1fffe7, 21}, {0x1fffe8, 21}, {0x7ffff3, 23}, {0x3fffea, 22}, {0x3fffeb, 22},
+            {0x1ffffee, 25}, {0x1ffffef, 25}, {0xfffff4, 24}, {0xfffff5, 24}, {0x3ffffea, 26}, {0x7ffff4, 23},
+            {0x3ffffeb, 26}, {0x7ffffe6, 27}, {0x3ffffec, 26}, {0x3ffffed, 26}, {0x7ffffe7, 27}, {0x7ffffe8, 27},
+            {0x7ffffe9, 27}, {0x7ffffea, 27}, {0x7ffffeb, 27}, {0xffffffe, 28}, {0x7ffffec, 27}, {0x7ffffed, 27},
+            {0x7ffffee, 27}, {0x7ffffef, 27}, {0x7fffff0, 27}, {0x3ffffee, 26},
+         };
+
+         /**
+          * The codes as a binary tree, walked a bit at a time while decoding. Leaves hold their symbol.
+          */
+         class HuffmanTree {
+         public:
+            HuffmanTree() : mNodes(1) {
+               for(unsigned int symbol = 0; symbol < 256; ++symbol) {
+                  size_t node = 0;
+                  for(int bit = HUFFMAN_CODES[symbol].length - 1; bit >= 0; --bit) {
+                     const unsigned int branch = (HUFFMAN_CODES[symbol].code >> bit) & 1;
+                     if(0 == mNodes[node].children[branch]) {
+                        mNodes[node].children[branch] = static_cast<uint16_t>(mNodes.size());
+                        mNodes.push_back(Node());
+                     }
+                     node = mNodes[node].children[branch];
+                  }
+                  mNodes[node].symbol = static_cast<int16_t>(symbol);
+               }
+            }
+
+            void decode(const unsigned char* data, const size_t length, std::string& out) const
+                  throw (std::runtime_error) {
+               size_t node = 0;
+               unsigned int depth = 0; //bits since the last symbol, all ones if they are padding
+               bool ones = true;
+               for(size_t i = 0; i < length; ++i) {
+                  for(int bit = 7; bit >= 0; --bit) {
+                     const unsigned int branch = (data[i] >> bit) & 1;
+                     node = mNodes[node].children[branch];
+                     ++depth;
+                     ones = ones && 1 == branch;
+                     if(0 == node) throw(std::runtime_error("Invalid Huffman code"));
+                     if(mNodes[node].symbol >= 0) {
+                        out.push_back(static_cast<char>(mNodes[node].symbol));
+                        node = 0;
+                        depth = 0;
+                        ones = true;
+                     }
+                  }
+               }
+               if(depth > 7 || !ones) throw(std::runtime_error("Invalid Huffman padding"));
+            }
+
+         private:
+            struct Node {
+               Node() : symbol(-1) {
+                  children[0] = children[1] = 0;
+               }
+               uint16_t children[2];
+               int16_t symbol;
+            };
+
+            std::vector<Node> mNodes;
+         };
+
+         const HuffmanTree& huffmanTree() {
+            static const HuffmanTree tree;
+            return tree;
+         }
+
+         size_t huffmanLength(const std::string& value) {
+            size_t bits = 0;
+            for(size_t i = 0; i < value.size(); ++i) bits += HUFFMAN_CODES[static_cast<unsigned char>(value[i])].length;
+            return (bits + 7) / 8;
+         }
+
+         /**
+          * The static table's fields, and the indices of each name and of each name and value, first occurrence.
+          */
+         struct StaticIndex {
+            StaticIndex() {
+               for(size_t i = 0; i < STATIC_COUNT; ++i) entries.push_back(std::make_pair(STATIC_TABLE[i][0], STATIC_TABLE[i][1]));
+               for(size_t i = STATIC_COUNT; i > 0; --i) {
+                  names[STATIC_TABLE[i - 1][0]] = i;
+                  if(STATIC_TABLE[i - 1][1][0] != '\0') fields[std::string(STATIC_TABLE[i - 1][0]) + '\0' + STATIC_TABLE[i - 1][1]] = i;
+               }
+            }
+            std::vector<std::pair<std::string, std::string> > entries;
+            std::unordered_map<std::string, size_t> names;
+            std::unordered_map<std::string, size_t> fields;
+         };
+
+         const StaticIndex& staticIndex() {
+            static const StaticIndex index;
+            return index;
+         }
+
+         const std::pair<std::string, std::string>& staticField(const size_t index) {
+            return staticIndex().entries[index - 1];
+         }
+
+         /**
+          * Fields whose values differ with nearly every response, or should not be kept where a later request on
+          * the connection could probe for them, are never added to the dynamic table.
+          */
+         bool indexable(const std::string& name) {
+            return name != ":path" && name != "content-length" && name != "date" && name != "etag"
+                  && name != "last-modified" && name != "age" && name != "expires" && name != "content-range";
+         }
+
+         bool sensitive(const std::string& name) {
+            return name == "authorization" || name == "proxy-authorization" || name == "cookie" || name == "set-cookie";
+         }
+
+         size_t decodeInteger(const unsigned char*& iter, const unsigned char* end, const unsigned int prefixBits)
+               throw (std::runtime_error) {
+            if(iter == end) throw(std::runtime_error("Truncated HPACK integer"));
+            const size_t mask = (1u << prefixBits) - 1;
+            size_t value = *iter++ & mask;
+            if(value < mask) return value;
+            for(unsigned int shift = 0; ; shift += 7) {
+               if(iter == end) throw(std::runtime_error("Truncated HPACK integer"));
+               if(shift > 28) throw(std::runtime_error("HPACK integer too large"));
+               const unsigned char byte = *iter++;
+               value += static_cast<size_t>(byte & 0x7f) << shift;
+               if(0 == (byte & 0x80)) return value;
+            }
+         }
+
+         std::string decodeString(const unsigned char*& iter, const unsigned char* end) throw (std::runtime_error) {
+            if(iter == end) throw(std::runtime_error("Truncated HPACK string"));
+            const bool huffman = 0 != (*iter & 0x80);
+            const size_t length = decodeInteger(iter, end, 7);
+            if(length > static_cast<size_t>(end - iter)) throw(std::runtime_error("Truncated HPACK string"));
+            std::string value;
+            if(huffman) {
+               value.reserve(length * 8 / 5);
+               huffmanTree().decode(iter, length, value);
+            }
+            else {
+               value.assign(reinterpret_cast<const char*>(iter), length);
+            }
+            iter += length;
+            return value;
+         }
+      }
+
+      HpackTable::HpackTable(const size_t capacity) :
+         mCapacity(capacity), mSize(0) {
+
+      }
+
+      void HpackTable::add(const std::string& name, const std::string& value) {
+         const size_t size = name.size() + value.size() + ENTRY_OVERHEAD;
+         //a field larger than the table empties it and is not added
+         mSize += size;
+         mFields.push_front(std::make_pair(name, value));
+         evict();
+      }
+
+      void HpackTable::setCapacity(const size_t capacity) {
+         mCapacity = capacity;
+         evict();
+      }
+
+      size_t HpackTable::getCapacity() const {
+         return mCapacity;
+      }
+
+      size_t HpackTable::getSize() const {
+         return mSize;
+      }
+
+      size_t HpackTable::getCount() const {
+         return mFields.size();
+      }
+
+      const std::pair<std::string, std::string>& HpackTable::get(const size_t index) const {
+         return mFields[index - 1];
+      }
+
+      void HpackTable::evict() {
+         while(mSize > mCapacity && !mFields.empty()) {
+            mSize -= mFields.back().first.size() + mFields.back().second.size() + ENTRY_OVERHEAD;
+            mFields.pop_back();
+         }
+      }
+
+      HpackDecoder::HpackDecoder(const size_t maxTableSize, const size_t maxHeaderListSize) :
+         mTable(maxTableSize), mMaxTableSize(maxTableSize), mMaxHeaderListSize(maxHeaderListSize) {
+
+      }
+
+      void HpackDecoder::decode(const char* data, const size_t length, HeaderList& headers)
+            throw (std::runtime_error) {
+         const unsigned char* iter = reinterpret_cast<const unsigned char*>(data);
+         const unsigned char* const end = iter + length;
+         size_t listSize = 0;
+         bool fieldSeen = false;
+
+         while(iter < end) {
+            const unsigned char first = *iter;
+            if(first & 0x80) {
+               const std::pair<std::string, std::string>& indexed = field(decodeInteger(iter, end, 7));
+               headers.push_back(indexed);
+            }
+            else if(0x20 == (first & 0xe0)) {
+               //size updates come before any field of the block
+               if(fieldSeen) throw(std::runtime_error("HPACK table size update after a field"));
+               const size_t size = decodeInteger(iter, end, 5);
+               if(size > mMaxTableSize) throw(std::runtime_error("HPACK table size update too large"));
+               mTable.setCapacity(size);
+               continue;
+            }
+            else {
+               const bool incremental = 0 != (first & 0x40);
+               const size_t index = decodeInteger(iter, end, incremental ? 6 : 4);
+               std::string name(0 == index ? decodeString(iter, end) : field(index).first);
+               std::string value(decodeString(iter, end));
+               if(incremental) mTable.add(name, value);
+               headers.push_back(std::make_pair(std::move(name), std::move(value)));
+            }
+
+            fieldSeen = true;
+            listSize += headers.back().first.size() + headers.back().second.size() + ENTRY_OVERHEAD;
+            if(listSize > mMaxHeaderListSize) throw(std::runtime_error("HPACK header list too large"));
+         }
+      }
+
+      const std::pair<std::string, std::string>& HpackDecoder::field(const size_t index) const
+            throw (std::runtime_error) {
+         if(0 == index || index > STATIC_COUNT + mTable.getCount()) {
+            throw(std::runtime_error("Invalid HPACK index"));
+         }
+         if(index > STATIC_COUNT) return mTable.get(index - STATIC_COUNT);
+         return staticField(index);
+      }
+
+      HpackEncoder::HpackEncoder(const size_t tableSize) :
+         mTable(tableSize), mPreferredSize(tableSize), mSmallestSize(tableSize), mSizeChanged(false) {
+
+      }
+
+      void HpackEncoder::encode(const HeaderList& headers, std::string& out) {
+         if(mSizeChanged) {
+            if(mSmallestSize < mTable.getCapacity()) encodeInteger(mSmallestSize, 5, 0x20, out);
+            encodeInteger(mTable.getCapacity(), 5, 0x20, out);
+            mSmallestSize = mTable.getCapacity();
+            mSizeChanged = false;
+         }
+
+         const StaticIndex& statics = staticIndex();
+         for(HeaderList::const_iterator header = headers.begin(); header != headers.end(); ++header) {
+            const std::string& name = header->first;
+            const std::string& value = header->second;
+            size_t nameIndex = 0;
+
+            std::unordered_map<std::string, size_t>::const_iterator found = statics.fields.find(name + '\0' + value);
+            if(found != statics.fields.end()) {
+               encodeInteger(found->second, 7, 0x80, out);
+               continue;
+            }
+            found = statics.names.find(name);
+            if(found != statics.names.end()) nameIndex = found->second;
+
+            const bool neverIndexed = sensitive(name);
+            size_t fieldIndex = 0;
+            for(size_t i = 1; !neverIndexed && i <= mTable.getCount(); ++i) {
+               const std::pair<std::string, std::string>& entry = mTable.get(i);
+               if(entry.first != name) continue;
+               if(entry.second == value) {
+                  fieldIndex = STATIC_COUNT + i;
+                  break;
+               }
+               if(0 == nameIndex) nameIndex = STATIC_COUNT + i;
+            }
+            if(0 != fieldIndex) {
+               encodeInteger(fieldIndex, 7, 0x80, out);
+               continue;
+            }
+
+            if(neverIndexed) {
+               encodeInteger(nameIndex, 4, 0x10, out);
+            }
+            else if(indexable(name) && mTable.getCapacity() > 0) {
+               encodeInteger(nameIndex, 6, 0x40, out);
+            }
+            else {
+               encodeInteger(nameIndex, 4, 0x00, out);
+            }
+            if(0 == nameIndex) encodeString(name, out);
+            encodeString(value, out);
+            if(!neverIndexed && indexable(name) && mTable.getCapacity() > 0) mTable.add(name, value);
+         }
+      }
+
+      void HpackEncoder::setMaxTableSize(const size_t size) {
+         const size_t capacity = std::min(size, mPreferredSize);
+         if(capacity == mTable.getCapacity()) return;
+         mTable.setCapacity(capacity);
+         mSmallestSize = std::min(mSmallestSize, capacity);
+         mSizeChanged = true;
+      }
+
+      void HpackEncoder::encodeInteger(const size_t value, const unsigned int prefixBits, const unsigned char flags,
+            std::string& out) {
+         const size_t mask = (1u << prefixBits) - 1;
+         if(value < mask) {
+            out.push_back(static_cast<char>(flags | value));
+            return;
+         }
+         out.push_back(static_cast<char>(flags | mask));
+         size_t remaining = value - mask;
+         while(remaining >= 0x80) {
+            out.push_back(static_cast<char>(0x80 | (remaining & 0x7f)));
+            remaining >>= 7;
+         }
+         out.push_back(static_cast<char>(remaining));
+      }
+
+      void HpackEncoder::encodeString(const std::string& value, std::string& out) {
+         const size_t encodedLength = huffmanLength(value);
+         if(encodedLength >= value.size()) {
+            encodeInteger(value.size(), 7, 0x00, out);
+            out.append(value);
+            return;
+         }
+
+         encodeInteger(encodedLength, 7, 0x80, out);
+         uint64_t bits = 0;
+         unsigned int count = 0;
+         for(size_t i = 0; i < value.size(); ++i) {
+            const HuffmanCode& code = HUFFMAN_CODES[static_cast<unsigned char>(value[i])];
+            bits = (bits << code.length) | code.code;
+            count += code.length;
+            while(count >= 8) {
+               count -= 8;
+               out.push_back(static_cast<char>(bits >> count));
+            }
+         }
+         //padded with the most significant bits of EOS
+         if(count > 0) out.push_back(static_cast<char>((bits << (8 - count)) | (0xff >> count)));
+      }
+
+   }
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "objects/Platform.h"
+
+#include <deque>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace c11http {
+namespace objects {
+
+/**
+ * Header fields in the order they are sent, names lower cased. Pseudo header fields, e.g. ":path", come first.
+ */
+typedef std::vector<std::pair<std::string, std::string> > HeaderList;
+
+/**
+ * The dynamic table shared by an HPACK encoder and decoder: fields most recently added first, evicted oldest first
+ * once their size, each name and value plus 32 bytes, passes the table's capacity.
+ */
+class OBJECTS_API HpackTable {
+public:
+   explicit HpackTable(const size_t capacity);
+
+   void add(const std::string& name, const std::string& value);
+   void setCapacity(const size_t capacity);
+   size_t getCapacity() const;
+   size_t getSize() const;
+   size_t getCount() const;
+   /**
+    * Field at index, 1 for the field most recently added.
+    */
+   const std::pair<std::string, std::string>& get(const size_t index) const;
+
+private:
+   void evict();
+
+   std::deque<std::pair<std::string, std::string> > mFields;
+   size_t mCapacity;
+   size_t mSize;
+};
+
+/**
+ * Decodes HPACK (RFC 7541) header blocks received on one connection, keeping its dynamic table in step with the
+ * peer's encoder. Every block must be decoded in the order received, even for requests that are then refused.
+ */
+class OBJECTS_API HpackDecoder {
+public:
+   /**
+    * maxTableSize is the dynamic table size advertised to the peer, and maxHeaderListSize bounds the fields of one
+    * block, counted as the table counts them.
+    */
+   HpackDecoder(const size_t maxTableSize = 4096, const size_t maxHeaderListSize = 64 * 1024);
+
+   /**
+    * Decode a complete header block, appending its fields to headers. Throws if the block is malformed or too
+    * large, after which the table no longer matches the peer's and the connection must be closed.
+    */
+   void decode(const char* data, const size_t length, HeaderList& headers) throw (std::runtime_error);
+
+private:
+   const std::pair<std::string, std::string>& field(const size_t index) const throw (std::runtime_error);
+
+   HpackTable mTable;
+   const size_t mMaxTableSize;
+   const size_t mMaxHeaderListSize;
+};
+
+/**
+ * Encodes header blocks sent on one connection. Fields already in the static or dynamic table are sent as an
+ * index, others as literals, Huffman coded where that is shorter. Fields likely to repeat on later responses are
+ * added to the dynamic table; those that change with every response, or are sensitive, are not.
+ */
+class OBJECTS_API HpackEncoder {
+public:
+   explicit HpackEncoder(const size_t tableSize = 4096);
+
+   /**
+    * Append the block for headers to out.
+    */
+   void encode(const HeaderList& headers, std::string& out);
+   /**
+    * The peer's SETTINGS_HEADER_TABLE_SIZE. The table shrinks to fit, and the next block tells the peer so.
+    */
+   void setMaxTableSize(const size_t size);
+
+   static void encodeInteger(const size_t value, const unsigned int prefixBits, const unsigned char flags,
+         std::string& out);
+   /**
+    * Append value as a string literal, Huffman coded if that is shorter.
+    */
+   static void encodeString(const std::string& value, std::string& out);
+
+private:
+   HpackTable mTable;
+   const size_t mPreferredSize;
+   size_t mSmallestSize; //smallest size the table reached since the last block, signalled before the current one
+   bool mSizeChanged;
+};
+
+}
+}
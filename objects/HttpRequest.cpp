@@ -1,9 +1,24 @@
 #include "objects/HttpRequest.h"
 
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+
 namespace c11http {
    namespace objects {
 
-      HttpRequest::HttpRequest(Method reqMethod, const std::string& body) : mReqMethod(reqMethod), mBody(body) {
+      namespace {
+         std::string lowerCase(const std::string& value) {
+            std::string result(value);
+            std::transform(result.begin(), result.end(), result.begin(), ::tolower);
+            return result;
+         }
+      }
+
+      HttpRequest::HttpRequest(Method reqMethod, const std::string& body) : mReqMethod(reqMethod), mTarget("/"), mBody(body) {
+
+      }
+      HttpRequest::HttpRequest(Method reqMethod, const std::string& target, const std::string& body) : mReqMethod(reqMethod), mTarget(target), mBody(body) {
 
       }
       HttpRequest::~HttpRequest() {
@@ -13,9 +28,65 @@ namespace c11http {
       HttpRequest::Method HttpRequest::getRequestMethod() const {
          return mReqMethod;
       }
+      const std::string& HttpRequest::getTarget() const {
+         return mTarget;
+      }
       const std::string& HttpRequest::getBody() const {
          return mBody;
       }
+      const std::string& HttpRequest::getHeader(const std::string& name) const {
+         static const std::string empty;
+         Headers::const_iterator iter = mHeaders.find(lowerCase(name));
+         return (iter == mHeaders.end()) ? empty : iter->second;
+      }
+      bool HttpRequest::hasHeader(const std::string& name) const {
+         return mHeaders.find(lowerCase(name)) != mHeaders.end();
+      }
+      const HttpRequest::Headers& HttpRequest::getHeaders() const {
+         return mHeaders;
+      }
+
+      void HttpRequest::setTarget(const std::string& target) {
+         mTarget = target;
+      }
+      void HttpRequest::setHeader(const std::string& name, const std::string& value) {
+         mHeaders[lowerCase(name)] = value;
+      }
+      void HttpRequest::setBody(const std::string& body) {
+         mBody = body;
+      }
+
+      void HttpRequest::serialize(std::string& out) const {
+         std::stringstream sstr;
+         sstr << methodToString(mReqMethod) << " " << mTarget << " HTTP/1.1\r\n";
+         for(Headers::const_iterator iter = mHeaders.begin(); iter != mHeaders.end(); ++iter) {
+            if(iter->first == "content-length") continue;
+            sstr << iter->first << ": " << iter->second << "\r\n";
+         }
+         if(!mBody.empty() || POST == mReqMethod || PUT == mReqMethod) {
+            sstr << "content-length: " << mBody.size() << "\r\n";
+         }
+         sstr << "\r\n";
+         out.append(sstr.str());
+         out.append(mBody);
+      }
+
+      HttpRequest::Method HttpRequest::methodFromString(const std::string& method) throw (std::runtime_error) {
+         if(method == "GET") return GET;
+         if(method == "POST") return POST;
+         if(method == "PUT") return PUT;
+         if(method == "DELETE") return DELETE;
+         throw(std::runtime_error("Unsupported request method: " + method));
+      }
+      const char* HttpRequest::methodToString(const Method method) {
+         switch(method) {
+         case GET: return "GET";
+         case POST: return "POST";
+         case PUT: return "PUT";
+         case DELETE: return "DELETE";
+         }
+         return "GET";
+      }
 
    }
-}
\ No newline at end of file
+}
@@ -2,6 +2,9 @@
 
 #include "objects/Platform.h"
 
+#include <map>
+#include <string>
+
 namespace c11http {
 namespace objects {
 
@@ -13,16 +16,45 @@ public :
       PUT,
       DELETE
    };
+   typedef std::map<std::string, std::string> Headers;
+
    HttpRequest(Method reqMethod = GET, const std::string& body = "");
+   HttpRequest(Method reqMethod, const std::string& target, const std::string& body);
    ~HttpRequest();
 
    Method getRequestMethod() const;
+   const std::string& getTarget() const;
    const std::string& getBody() const;
+   /**
+    * Header names are case insensitive, and are stored lower cased. Returns an empty string if the
+    * header is not present.
+    */
+   const std::string& getHeader(const std::string& name) const;
+   bool hasHeader(const std::string& name) const;
+   const Headers& getHeaders() const;
+
+   void setTarget(const std::string& target);
+   void setHeader(const std::string& name, const std::string& value);
+   void setBody(const std::string& body);
+
+   /**
+    * Append the HTTP/1.1 wire representation of this request (request line, headers and body) to out.
+    * A Content-Length header is generated from the body when the request has one.
+    */
+   void serialize(std::string& out) const;
+
+   /**
+    * Convert a method token (e.g. "GET") to a Method, throwing if the method is not supported.
+    */
+   static Method methodFromString(const std::string& method) throw (std::runtime_error);
+   static const char* methodToString(const Method method);
 
 private:
    Method mReqMethod;
+   std::string mTarget;
+   Headers mHeaders;
    std::string mBody;
 };
 
 }
-}
\ No newline at end of file
+}
@@ -0,0 +1,132 @@
+#include "objects/HttpRequestParser.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace c11http {
+   namespace objects {
+
+      namespace {
+         const char* findLineEnd(const char* begin, const char* end) {
+            for(const char* iter = begin; iter + 1 < end; ++iter) {
+               if(iter[0] == '\r' && iter[1] == '\n') return iter;
+            }
+            return end;
+         }
+
+         std::string trim(const char* begin, const char* end) {
+            while(begin < end && (*begin == ' ' || *begin == '\t')) ++begin;
+            while(end > begin && (end[-1] == ' ' || end[-1] == '\t')) --end;
+            return std::string(begin, end);
+         }
+      }
+
+      HttpRequestParser::HttpRequestParser(const size_t maxHeadBytes, const size_t maxBodyBytes) :
+         mMaxHeadBytes(maxHeadBytes), mMaxBodyBytes(maxBodyBytes), mState(READING_HEAD), mBodyRemaining(0) {
+
+      }
+      HttpRequestParser::~HttpRequestParser() {
+
+      }
+
+      void HttpRequestParser::reset() {
+         mState = READING_HEAD;
+         mPending.clear();
+         mBodyRemaining = 0;
+         mCurrent = HttpRequest();
+         mBody.clear();
+      }
+
+      void HttpRequestParser::parse(const char* data, const unsigned int count, std::vector<HttpRequest>& requests)
+            throw (std::runtime_error) {
+         mPending.append(data, count);
+         size_t consumed = 0;
+
+         while(consumed < mPending.size()) {
+            const char* begin = mPending.data() + consumed;
+            const size_t available = mPending.size() - consumed;
+
+            if(READING_HEAD == mState) {
+               //the head is complete once an empty line is seen
+               const char* headEnd = 0;
+               for(const char* iter = begin; iter + 3 < begin + available; ++iter) {
+                  if(0 == memcmp(iter, "\r\n\r\n", 4)) {
+                     headEnd = iter;
+                     break;
+                  }
+               }
+               if(0 == headEnd) {
+                  if(available > mMaxHeadBytes) throw(std::runtime_error("Request head too large"));
+                  break;
+               }
+               mBodyRemaining = parseHead(begin, headEnd + 2);
+               consumed += (headEnd + 4) - begin;
+               mState = READING_BODY;
+            }
+            else {
+               const size_t take = std::min(available, mBodyRemaining);
+               mBody.append(begin, take);
+               consumed += take;
+               mBodyRemaining -= take;
+            }
+
+            //a request without a body is complete as soon as its head is
+            if(READING_BODY == mState && 0 == mBodyRemaining) {
+               mCurrent.setBody(mBody);
+               requests.push_back(mCurrent);
+               mCurrent = HttpRequest();
+               mBody.clear();
+               mState = READING_HEAD;
+               //what follows an upgrade may be another protocol, left for takePending
+               if(requests.back().hasHeader("upgrade")) break;
+            }
+         }
+         mPending.erase(0, consumed);
+      }
+
+      std::string HttpRequestParser::takePending() {
+         std::string pending;
+         pending.swap(mPending);
+         return pending;
+      }
+
+      size_t HttpRequestParser::parseHead(const char* begin, const char* end) throw (std::runtime_error) {
+         //request line: METHOD SP request-target SP HTTP-version
+         const char* lineEnd = findLineEnd(begin, end);
+         const char* methodEnd = std::find(begin, lineEnd, ' ');
+         if(methodEnd == lineEnd) throw(std::runtime_error("Malformed request line"));
+         const char* targetEnd = std::find(methodEnd + 1, lineEnd, ' ');
+         if(targetEnd == lineEnd || targetEnd == methodEnd + 1) throw(std::runtime_error("Malformed request line"));
+         if(0 != std::string(targetEnd + 1, lineEnd).compare(0, 5, "HTTP/")) {
+            throw(std::runtime_error("Malformed request line"));
+         }
+
+         mCurrent = HttpRequest(HttpRequest::methodFromString(std::string(begin, methodEnd)),
+               std::string(methodEnd + 1, targetEnd), "");
+
+         //header fields: name ":" OWS value OWS
+         for(const char* line = lineEnd + 2; line < end; ) {
+            const char* nextEnd = findLineEnd(line, end);
+            const char* colon = std::find(line, nextEnd, ':');
+            if(colon == nextEnd || colon == line) throw(std::runtime_error("Malformed header field"));
+            mCurrent.setHeader(std::string(line, colon), trim(colon + 1, nextEnd));
+            line = nextEnd + 2;
+         }
+
+         if(mCurrent.hasHeader("transfer-encoding")) {
+            throw(std::runtime_error("Transfer-Encoding on requests is not supported"));
+         }
+         size_t bodyLength = 0;
+         if(mCurrent.hasHeader("content-length")) {
+            const std::string& length = mCurrent.getHeader("content-length");
+            char* lengthEnd = 0;
+            bodyLength = strtoul(length.c_str(), &lengthEnd, 10);
+            if(length.empty() || *lengthEnd != '\0') throw(std::runtime_error("Invalid Content-Length"));
+         }
+         if(bodyLength > mMaxBodyBytes) throw(std::runtime_error("Request body too large"));
+         return bodyLength;
+      }
+
+   }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "objects/Platform.h"
+#include "objects/HttpRequest.h"
+
+#include <string>
+#include <vector>
+
+namespace c11http {
+namespace objects {
+
+/**
+ * Incremental HTTP/1.1 request parser. Bytes are fed to the parser as they are received from a connection, in
+ * whatever sized pieces the socket provides, and complete requests are produced once their head and body have
+ * arrived. One parser is kept per connection, so pipelined requests are produced in order.
+ */
+class OBJECTS_API HttpRequestParser {
+public:
+   HttpRequestParser(const size_t maxHeadBytes = 8192, const size_t maxBodyBytes = 1024 * 1024);
+   ~HttpRequestParser();
+
+   /**
+    * Parse count bytes of data, appending each request they complete to requests. Throws if the data is not
+    * a valid request, at which point the connection should be closed.
+    */
+   void parse(const char* data, const unsigned int count, std::vector<HttpRequest>& requests)
+         throw (std::runtime_error);
+   /**
+    * Take the bytes received but not yet parsed. Parsing stops after a request with an Upgrade header, so that
+    * if the upgrade is accepted, what followed it can be handed to the new protocol.
+    */
+   std::string takePending();
+   /**
+    * Discard any partially parsed request.
+    */
+   void reset();
+
+private:
+   enum State {
+      READING_HEAD,
+      READING_BODY
+   };
+   /**
+    * Parse the request line and headers in [begin, end) into mCurrent, returning the body length.
+    */
+   size_t parseHead(const char* begin, const char* end) throw (std::runtime_error);
+
+   const size_t mMaxHeadBytes;
+   const size_t mMaxBodyBytes;
+   State mState;
+   std::string mPending; //bytes received but not yet consumed
+   size_t mBodyRemaining;
+   HttpRequest mCurrent;
+   std::string mBody; //body of mCurrent received so far
+};
+
+}
+}
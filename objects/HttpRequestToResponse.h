@@ -12,5 +12,15 @@ class OBJECTS_API HttpResponse;
 
 typedef std::function<c11http::objects::HttpResponse(c11http::objects::HttpRequest)> HttpRequestToResponse;
 
+/**
+ * Completes an asynchronous request. May be called from any thread, exactly once per request.
+ */
+typedef std::function<void(const c11http::objects::HttpResponse&)> HttpResponder;
+/**
+ * Asynchronous handler. Starts the work for a request and returns without blocking, calling the responder
+ * once the response is available.
+ */
+typedef std::function<void(const c11http::objects::HttpRequest&, const HttpResponder&)> AsyncHttpRequestToResponse;
+
 }
 }
\ No newline at end of file
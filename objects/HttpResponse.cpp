@@ -1,18 +1,95 @@
 #include "objects/HttpResponse.h"
 
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+
 namespace c11http {
    namespace objects {
 
-      HttpResponse::HttpResponse(const std::string& body) : mBody(body) {
+      namespace {
+         std::string lowerCase(const std::string& value) {
+            std::string result(value);
+            std::transform(result.begin(), result.end(), result.begin(), ::tolower);
+            return result;
+         }
+      }
+
+      HttpResponse::HttpResponse(const std::string& body) : mStatus(200), mBody(body) {
+
+      }
+      HttpResponse::HttpResponse(const unsigned int status, const std::string& body) : mStatus(status), mBody(body) {
 
       }
       HttpResponse::~HttpResponse() {
 
       }
 
+      unsigned int HttpResponse::getStatus() const {
+         return mStatus;
+      }
       const std::string& HttpResponse::getBody() const {
          return mBody;
       }
+      const std::string& HttpResponse::getHeader(const std::string& name) const {
+         static const std::string empty;
+         Headers::const_iterator iter = mHeaders.find(lowerCase(name));
+         return (iter == mHeaders.end()) ? empty : iter->second;
+      }
+      bool HttpResponse::hasHeader(const std::string& name) const {
+         return mHeaders.find(lowerCase(name)) != mHeaders.end();
+      }
+      const HttpResponse::Headers& HttpResponse::getHeaders() const {
+         return mHeaders;
+      }
+
+      void HttpResponse::setStatus(const unsigned int status) {
+         mStatus = status;
+      }
+      void HttpResponse::setHeader(const std::string& name, const std::string& value) {
+         mHeaders[lowerCase(name)] = value;
+      }
+      void HttpResponse::setBody(const std::string& body) {
+         mBody = body;
+      }
+
+      void HttpResponse::serialize(std::string& out) const {
+         std::stringstream sstr;
+         sstr << "HTTP/1.1 " << mStatus << " " << reasonPhrase(mStatus) << "\r\n";
+         for(Headers::const_iterator iter = mHeaders.begin(); iter != mHeaders.end(); ++iter) {
+            if(iter->first == "content-length") continue;
+            sstr << iter->first << ": " << iter->second << "\r\n";
+         }
+         //1xx, 204 and 304 responses never carry a body
+         if(mStatus >= 200 && mStatus != 204 && mStatus != 304) {
+            sstr << "content-length: " << mBody.size() << "\r\n";
+         }
+         sstr << "\r\n";
+         out.append(sstr.str());
+         out.append(mBody);
+      }
+
+      const char* HttpResponse::reasonPhrase(const unsigned int status) {
+         switch(status) {
+         case 100: return "Continue";
+         case 101: return "Switching Protocols";
+         case 200: return "OK";
+         case 201: return "Created";
+         case 204: return "No Content";
+         case 206: return "Partial Content";
+         case 301: return "Moved Permanently";
+         case 302: return "Found";
+         case 304: return "Not Modified";
+         case 400: return "Bad Request";
+         case 403: return "Forbidden";
+         case 404: return "Not Found";
+         case 405: return "Method Not Allowed";
+         case 413: return "Payload Too Large";
+         case 500: return "Internal Server Error";
+         case 503: return "Service Unavailable";
+         }
+         return "Unknown";
+      }
 
    }
-}
\ No newline at end of file
+}
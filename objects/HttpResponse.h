@@ -2,18 +2,47 @@
 
 #include "objects/Platform.h"
 
+#include <map>
+#include <string>
+
 namespace c11http {
 namespace objects {
 
 class OBJECTS_API HttpResponse {
 public:
+   typedef std::map<std::string, std::string> Headers;
+
    HttpResponse(const std::string& body = "");
+   HttpResponse(const unsigned int status, const std::string& body);
    ~HttpResponse();
 
+   unsigned int getStatus() const;
    const std::string& getBody() const;
+   /**
+    * Header names are case insensitive, and are stored lower cased. Returns an empty string if the
+    * header is not present.
+    */
+   const std::string& getHeader(const std::string& name) const;
+   bool hasHeader(const std::string& name) const;
+   const Headers& getHeaders() const;
+
+   void setStatus(const unsigned int status);
+   void setHeader(const std::string& name, const std::string& value);
+   void setBody(const std::string& body);
+
+   /**
+    * Append the HTTP/1.1 wire representation of this response (status line, headers and body) to out.
+    * A Content-Length header is always generated from the body.
+    */
+   void serialize(std::string& out) const;
+
+   static const char* reasonPhrase(const unsigned int status);
+
 private:
+   unsigned int mStatus;
+   Headers mHeaders;
    std::string mBody;
 };
 
 }
-}
\ No newline at end of file
+}
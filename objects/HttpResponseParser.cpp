@@ -0,0 +1,302 @@
+#include "objects/HttpResponseParser.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+namespace c11http {
+   namespace objects {
+
+      namespace {
+         const char HEAD_END[] = "\r\n\r\n";
+         const unsigned int HEAD_END_SIZE = 4;
+
+         const char* findLineEnd(const char* begin, const char* end) {
+            for(const char* iter = begin; iter + 1 < end; ++iter) {
+               if(iter[0] == '\r' && iter[1] == '\n') return iter;
+            }
+            return end;
+         }
+
+         std::string trim(const char* begin, const char* end) {
+            while(begin < end && (*begin == ' ' || *begin == '\t')) ++begin;
+            while(end > begin && (end[-1] == ' ' || end[-1] == '\t')) --end;
+            return std::string(begin, end);
+         }
+
+         /**
+          * Whether chunked is the final transfer coding applied, which is the only way it frames the body.
+          */
+         bool isChunked(const std::string& transferEncoding) {
+            std::string lower(transferEncoding);
+            std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+            const size_t lastComma = lower.rfind(',');
+            return trim(lower.data() + (std::string::npos == lastComma ? 0 : lastComma + 1),
+                  lower.data() + lower.size()) == "chunked";
+         }
+
+         /**
+          * Gathers streamed responses, bodies included, for the vector overloads.
+          */
+         class GatheringConsumer : public HttpResponseParser::Consumer {
+         public:
+            GatheringConsumer(const HttpResponse& current, std::string& body, std::vector<HttpResponse>& responses)
+               : mCurrent(current), mBody(body), mResponses(responses) {
+
+            }
+            virtual void head(const HttpResponse& response) {
+               mBody.clear();
+               if(response.hasHeader("content-length")) {
+                  mBody.reserve(strtoul(response.getHeader("content-length").c_str(), 0, 10));
+               }
+            }
+            virtual void body(const char* data, const size_t count) {
+               mBody.append(data, count);
+            }
+            virtual void complete() {
+               mResponses.push_back(mCurrent);
+               mResponses.back().setBody(mBody);
+               mBody.clear();
+            }
+         private:
+            const HttpResponse& mCurrent;
+            std::string& mBody;
+            std::vector<HttpResponse>& mResponses;
+         };
+      }
+
+      HttpResponseParser::HttpResponseParser(const size_t maxHeadBytes, const size_t maxBodyBytes) :
+         mMaxHeadBytes(maxHeadBytes), mMaxBodyBytes(maxBodyBytes), mState(READING_HEAD), mHeadEndMatched(0),
+         mRemaining(0), mBodyBytes(0) {
+
+      }
+      HttpResponseParser::~HttpResponseParser() {
+
+      }
+
+      void HttpResponseParser::reset() {
+         mState = READING_HEAD;
+         mPending.clear();
+         mHeadEndMatched = 0;
+         mRemaining = 0;
+         mBodyBytes = 0;
+         mCurrent = HttpResponse();
+         mBody.clear();
+      }
+
+      void HttpResponseParser::parse(const char* data, const unsigned int count, std::vector<HttpResponse>& responses)
+            throw (std::runtime_error) {
+         GatheringConsumer consumer(mCurrent, mBody, responses);
+         parse(data, count, consumer);
+      }
+
+      void HttpResponseParser::finish(std::vector<HttpResponse>& responses) throw (std::runtime_error) {
+         GatheringConsumer consumer(mCurrent, mBody, responses);
+         finish(consumer);
+      }
+
+      void HttpResponseParser::parse(const char* data, const unsigned int count, Consumer& consumer)
+            throw (std::runtime_error) {
+         size_t offset = 0;
+
+         while(offset < count) {
+            const char* begin = data + offset;
+            const size_t available = count - offset;
+
+            switch(mState) {
+            case READING_HEAD: {
+               //the head is complete once an empty line is seen, only the head itself is buffered
+               size_t scanned = 0;
+               while(scanned < available && mHeadEndMatched < HEAD_END_SIZE) {
+                  if(0 == mHeadEndMatched) {
+                     const char* cr = static_cast<const char*>(memchr(begin + scanned, '\r', available - scanned));
+                     if(0 == cr) {
+                        scanned = available;
+                        break;
+                     }
+                     scanned = cr - begin;
+                  }
+                  if(begin[scanned] == HEAD_END[mHeadEndMatched]) ++mHeadEndMatched;
+                  else mHeadEndMatched = ('\r' == begin[scanned]) ? 1 : 0;
+                  ++scanned;
+               }
+               mPending.append(begin, scanned);
+               offset += scanned;
+
+               if(mHeadEndMatched < HEAD_END_SIZE) {
+                  if(mPending.size() > mMaxHeadBytes) throw(std::runtime_error("Response head too large"));
+                  break;
+               }
+
+               mHeadEndMatched = 0;
+               parseHead();
+               mPending.clear();
+               //interim responses other than 101 precede the real response, so are not reported
+               if(mCurrent.getStatus() < 200 && 101 != mCurrent.getStatus()) break;
+
+               consumer.head(mCurrent);
+               if(READING_HEAD == mState) completeResponse(consumer);
+               break;
+            }
+            case READING_BODY:
+            case READING_CHUNK_DATA: {
+               const size_t take = std::min(available, mRemaining);
+               passBody(begin, take, consumer);
+               offset += take;
+               mRemaining -= take;
+               if(0 == mRemaining) {
+                  if(READING_BODY == mState) completeResponse(consumer);
+                  else mState = READING_CHUNK_END;
+               }
+               break;
+            }
+            case READING_CHUNK_SIZE: {
+               bool complete = false;
+               offset += readLine(begin, available, complete);
+               if(!complete) break;
+
+               //chunk-size [ chunk-ext ], the extensions are ignored
+               char* sizeEnd = 0;
+               const unsigned long long size = strtoull(mPending.c_str(), &sizeEnd, 16);
+               if(sizeEnd == mPending.c_str() || !isxdigit(static_cast<unsigned char>(mPending[0]))) {
+                  throw(std::runtime_error("Invalid chunk size"));
+               }
+               if(size > mMaxBodyBytes) throw(std::runtime_error("Response body too large"));
+               mPending.clear();
+
+               if(0 == size) {
+                  mState = READING_TRAILERS;
+               }
+               else {
+                  mRemaining = static_cast<size_t>(size);
+                  mState = READING_CHUNK_DATA;
+               }
+               break;
+            }
+            case READING_CHUNK_END: {
+               bool complete = false;
+               offset += readLine(begin, available, complete);
+               if(!complete) break;
+               if(!mPending.empty()) throw(std::runtime_error("Chunk data longer than its size"));
+               mState = READING_CHUNK_SIZE;
+               break;
+            }
+            case READING_TRAILERS: {
+               //trailer fields are read past, an empty line ends the body
+               bool complete = false;
+               offset += readLine(begin, available, complete);
+               if(!complete) break;
+               const bool lastLine = mPending.empty();
+               mPending.clear();
+               if(lastLine) completeResponse(consumer);
+               break;
+            }
+            case READING_UNTIL_CLOSE:
+               passBody(begin, available, consumer);
+               offset = count;
+               break;
+            }
+         }
+      }
+
+      void HttpResponseParser::finish(Consumer& consumer) throw (std::runtime_error) {
+         if(READING_UNTIL_CLOSE == mState) {
+            completeResponse(consumer);
+         }
+         else if(READING_HEAD != mState || !mPending.empty()) {
+            reset();
+            throw(std::runtime_error("Connection closed before the response was complete"));
+         }
+         reset();
+      }
+
+      size_t HttpResponseParser::readLine(const char* data, const size_t count, bool& complete)
+            throw (std::runtime_error) {
+         const char* lineFeed = static_cast<const char*>(memchr(data, '\n', count));
+         const size_t consumed = (0 == lineFeed) ? count : (lineFeed - data) + 1;
+         mPending.append(data, consumed);
+         if(mPending.size() > mMaxHeadBytes) throw(std::runtime_error("Response line too long"));
+
+         complete = (0 != lineFeed);
+         if(complete) {
+            mPending.erase(mPending.size() - 1);
+            if(!mPending.empty() && '\r' == mPending[mPending.size() - 1]) mPending.erase(mPending.size() - 1);
+         }
+         return consumed;
+      }
+
+      void HttpResponseParser::passBody(const char* data, const size_t count, Consumer& consumer)
+            throw (std::runtime_error) {
+         mBodyBytes += count;
+         if(mBodyBytes > mMaxBodyBytes) throw(std::runtime_error("Response body too large"));
+         if(count > 0) consumer.body(data, count);
+      }
+
+      void HttpResponseParser::completeResponse(Consumer& consumer) {
+         mState = READING_HEAD;
+         mBodyBytes = 0;
+         mRemaining = 0;
+         consumer.complete();
+      }
+
+      void HttpResponseParser::parseHead() throw (std::runtime_error) {
+         const char* begin = mPending.data();
+         //drop the empty line ending the head, leaving every header line ended by CRLF
+         const char* end = begin + mPending.size() - 2;
+
+         //status line: HTTP-version SP status-code SP reason-phrase
+         const char* lineEnd = findLineEnd(begin, end);
+         if(lineEnd - begin < 12 || 0 != memcmp(begin, "HTTP/", 5) || begin[8] != ' ') {
+            throw(std::runtime_error("Malformed status line"));
+         }
+         char* statusEnd = 0;
+         const unsigned long status = strtoul(begin + 9, &statusEnd, 10);
+         if(statusEnd != begin + 12 || status < 100 || status > 999) {
+            throw(std::runtime_error("Malformed status line"));
+         }
+         mCurrent = HttpResponse(static_cast<unsigned int>(status), "");
+
+         //header fields: name ":" OWS value OWS
+         for(const char* line = lineEnd + 2; line < end; ) {
+            const char* nextEnd = findLineEnd(line, end);
+            const char* colon = std::find(line, nextEnd, ':');
+            if(colon == nextEnd || colon == line) throw(std::runtime_error("Malformed header field"));
+            mCurrent.setHeader(std::string(line, colon), trim(colon + 1, nextEnd));
+            line = nextEnd + 2;
+         }
+
+         mState = READING_HEAD;
+         mRemaining = 0;
+         mBodyBytes = 0;
+
+         //1xx, 204 and 304 responses never carry a body
+         if(status < 200 || 204 == status || 304 == status) return;
+
+         //transfer coding takes precedence over Content-Length, and anything but chunked runs until close
+         if(mCurrent.hasHeader("transfer-encoding")) {
+            mState = isChunked(mCurrent.getHeader("transfer-encoding")) ? READING_CHUNK_SIZE : READING_UNTIL_CLOSE;
+            return;
+         }
+
+         if(!mCurrent.hasHeader("content-length")) {
+            mState = READING_UNTIL_CLOSE;
+            return;
+         }
+
+         const std::string& length = mCurrent.getHeader("content-length");
+         char* lengthEnd = 0;
+         const unsigned long long bodyLength = strtoull(length.c_str(), &lengthEnd, 10);
+         if(length.empty() || *lengthEnd != '\0' || !isdigit(static_cast<unsigned char>(length[0]))) {
+            throw(std::runtime_error("Invalid Content-Length"));
+         }
+         if(bodyLength > mMaxBodyBytes) throw(std::runtime_error("Response body too large"));
+
+         if(bodyLength > 0) {
+            mRemaining = static_cast<size_t>(bodyLength);
+            mState = READING_BODY;
+         }
+      }
+
+   }
+}
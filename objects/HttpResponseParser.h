@@ -0,0 +1,101 @@
+#pragma once
+
+#include "objects/Platform.h"
+#include "objects/HttpResponse.h"
+
+#include <string>
+#include <vector>
+
+namespace c11http {
+namespace objects {
+
+/**
+ * Incremental HTTP/1.1 response parser, the client side counterpart of HttpRequestParser. Bytes are fed as they
+ * are received from a connection, in pieces of any size, and responses are produced in the order they were sent,
+ * so pipelined responses can be matched to their requests. Bodies may be framed by Content-Length, chunked
+ * transfer coding, or the server closing the connection. Interim 1xx responses, other than 101, are skipped.
+ */
+class OBJECTS_API HttpResponseParser {
+public:
+   /**
+    * Receives responses as they are parsed, with the body streamed in fragments rather than gathered first.
+    * Fragments point into the data given to parse and are only valid during the call.
+    */
+   class OBJECTS_API Consumer {
+   public:
+      virtual ~Consumer() {
+
+      }
+      /**
+       * Status line and headers of the next response have been parsed.
+       */
+      virtual void head(const HttpResponse& response) = 0;
+      /**
+       * Next fragment of the current response's body, after any chunked coding has been removed.
+       */
+      virtual void body(const char* data, const size_t count) = 0;
+      /**
+       * The current response's body is complete.
+       */
+      virtual void complete() = 0;
+   };
+
+   HttpResponseParser(const size_t maxHeadBytes = 8192, const size_t maxBodyBytes = 16 * 1024 * 1024);
+   ~HttpResponseParser();
+
+   /**
+    * Parse count bytes of data, streaming what they contain to consumer. Throws if the data is not a valid
+    * response, at which point the connection should be closed.
+    */
+   void parse(const char* data, const unsigned int count, Consumer& consumer) throw (std::runtime_error);
+   /**
+    * Parse count bytes of data, appending each response they complete, body included, to responses.
+    */
+   void parse(const char* data, const unsigned int count, std::vector<HttpResponse>& responses)
+         throw (std::runtime_error);
+   /**
+    * The connection has been closed, which completes a body delimited by the close. Throws if a response was
+    * cut short.
+    */
+   void finish(Consumer& consumer) throw (std::runtime_error);
+   void finish(std::vector<HttpResponse>& responses) throw (std::runtime_error);
+   /**
+    * Discard any partially parsed response.
+    */
+   void reset();
+
+private:
+   enum State {
+      READING_HEAD,
+      READING_BODY, //Content-Length body
+      READING_CHUNK_SIZE,
+      READING_CHUNK_DATA,
+      READING_CHUNK_END, //CRLF following chunk data
+      READING_TRAILERS,
+      READING_UNTIL_CLOSE
+   };
+   /**
+    * Parse the status line and headers in mPending into mCurrent, choosing how the body is framed.
+    */
+   void parseHead() throw (std::runtime_error);
+   /**
+    * Append data up to and including the next line feed to mPending. Returns the bytes consumed, with complete
+    * set once the line is, less its line ending.
+    */
+   size_t readLine(const char* data, const size_t count, bool& complete) throw (std::runtime_error);
+   void passBody(const char* data, const size_t count, Consumer& consumer) throw (std::runtime_error);
+   void completeResponse(Consumer& consumer);
+
+   const size_t mMaxHeadBytes;
+   const size_t mMaxBodyBytes;
+   State mState;
+   std::string mPending; //head or line received but not yet parsed
+   unsigned int mHeadEndMatched; //bytes of the CRLF CRLF ending a head seen so far
+   size_t mRemaining; //bytes left in the body or chunk
+   size_t mBodyBytes; //bytes of the current body so far
+   HttpResponse mCurrent;
+   std::string mBody; //body gathered for the vector overloads
+};
+
+}
+}
@@ -0,0 +1,328 @@
+#include "objects/Router.h"
+
+#include <algorithm>
+#include <stdint.h>
+#include <vector>
+
+#include "objects/HttpResponse.h"
+
+namespace c11http {
+   namespace objects {
+
+      namespace {
+         const size_t METHODS = HttpRequest::DELETE + 1;
+         const int32_t NONE = -1;
+
+         /**
+          * A node as laid out for matching. Labels and names are ranges of the table's label buffer.
+          */
+         struct FlatNode {
+            uint32_t labelOffset;
+            uint32_t labelLength;
+            uint32_t nameOffset; //parameter and wildcard nodes
+            uint32_t nameLength;
+            uint32_t firstChild; //static children are adjacent
+            uint32_t childCount;
+            int32_t param;
+            int32_t wildcard;
+            int32_t handlers[METHODS];
+         };
+      }
+
+      /**
+       * A node as routes are added. A static node matches its label, a parameter node one segment and a
+       * wildcard node the rest of the path.
+       */
+      struct Router::Node {
+         std::string label;
+         std::string name;
+         std::vector<std::unique_ptr<Node> > children; //static, no two sharing a first byte
+         std::unique_ptr<Node> param;
+         std::unique_ptr<Node> wildcard;
+         RouteHandler handlers[METHODS];
+      };
+
+      struct Router::Table {
+         std::vector<FlatNode> nodes; //root first
+         std::string firstBytes; //first byte of each node's label, scanned to pick a static child
+         std::string labels;
+         std::vector<RouteHandler> handlers;
+         HttpRequestToResponse notFound;
+      };
+
+      namespace {
+         /**
+          * Descend from node through text, splitting an edge where text leaves it, and return the node text
+          * ends at.
+          */
+         template<typename NodeType>
+         NodeType* insertStatic(NodeType* node, const std::string& text) {
+            size_t position = 0;
+            while(position < text.size()) {
+               NodeType* next = 0;
+               for(size_t i = 0; i < node->children.size() && 0 == next; ++i) {
+                  if(node->children[i]->label[0] == text[position]) next = node->children[i].get();
+               }
+               if(0 == next) {
+                  std::unique_ptr<NodeType> child(new NodeType());
+                  child->label = text.substr(position);
+                  node->children.push_back(std::move(child));
+                  return node->children.back().get();
+               }
+
+               size_t common = 0;
+               while(common < next->label.size() && position + common < text.size() &&
+                  next->label[common] == text[position + common]) {
+                  ++common;
+               }
+               if(common < next->label.size()) {
+                  //text leaves the edge part way, so the shared part becomes a node of its own
+                  std::unique_ptr<NodeType> split(new NodeType());
+                  split->label = next->label.substr(0, common);
+                  for(size_t i = 0; i < node->children.size(); ++i) {
+                     if(node->children[i].get() == next) {
+                        next->label.erase(0, common);
+                        split->children.push_back(std::move(node->children[i]));
+                        node->children[i] = std::move(split);
+                        next = node->children[i].get();
+                        break;
+                     }
+                  }
+               }
+               node = next;
+               position += common;
+            }
+            return node;
+         }
+
+         std::string malformed(const std::string& pattern, const std::string& reason) {
+            return "Malformed route " + pattern + ": " + reason;
+         }
+      }
+
+      RouteParams::RouteParams() : mSize(0) {
+
+      }
+
+      size_t RouteParams::size() const {
+         return mSize;
+      }
+      const StringView& RouteParams::name(const size_t index) const {
+         return mNames[index];
+      }
+      const StringView& RouteParams::value(const size_t index) const {
+         return mValues[index];
+      }
+      StringView RouteParams::get(const char* name) const {
+         for(size_t i = 0; i < mSize; ++i) {
+            if(mNames[i] == name) return mValues[i];
+         }
+         return StringView();
+      }
+
+      Router::Router() : mRoot(new Node()) {
+
+      }
+      Router::~Router() {
+
+      }
+
+      void Router::add(const HttpRequest::Method method, const std::string& pattern, const RouteHandler& handler)
+         throw (std::runtime_error) {
+         if(pattern.empty() || '/' != pattern[0]) throw(std::runtime_error(malformed(pattern, "must start with /")));
+
+         Node* node = mRoot.get();
+         size_t params = 0;
+         size_t position = 0;
+         while(position < pattern.size()) {
+            //the static text up to the next parameter or wildcard, which only start segments
+            size_t special = position;
+            while(special < pattern.size() &&
+               !((':' == pattern[special] || '*' == pattern[special]) && '/' == pattern[special - 1])) {
+               ++special;
+            }
+            node = insertStatic(node, pattern.substr(position, special - position));
+            if(special == pattern.size()) break;
+
+            const size_t nameEnd = std::min(pattern.find('/', special), pattern.size());
+            const std::string name = pattern.substr(special + 1, nameEnd - special - 1);
+            if(name.empty()) throw(std::runtime_error(malformed(pattern, "unnamed parameter")));
+            if(++params > MAX_ROUTE_PARAMS) throw(std::runtime_error(malformed(pattern, "too many parameters")));
+
+            std::unique_ptr<Node>& child = (':' == pattern[special]) ? node->param : node->wildcard;
+            if('*' == pattern[special] && nameEnd != pattern.size()) {
+               throw(std::runtime_error(malformed(pattern, "wildcard must be last")));
+            }
+            if(!child) {
+               child.reset(new Node());
+               child->name = name;
+            }
+            else if(child->name != name) {
+               throw(std::runtime_error(malformed(pattern, "parameter " + name + " is named " + child->name +
+                  " by another route")));
+            }
+            node = child.get();
+            position = nameEnd;
+         }
+
+         if(node->handlers[method]) {
+            throw(std::runtime_error("Route " + pattern + " is already routed for " +
+               HttpRequest::methodToString(method)));
+         }
+         node->handlers[method] = handler;
+      }
+
+      void Router::setNotFound(const HttpRequestToResponse& handler) {
+         mNotFound = handler;
+      }
+
+      void Router::build() {
+         std::shared_ptr<Table> table(new Table());
+         table->notFound = mNotFound;
+
+         //breadth first, so each node's static children are enqueued, and laid out, together
+         std::vector<const Node*> queue(1, mRoot.get());
+         table->firstBytes.push_back('\0');
+         for(size_t i = 0; i < queue.size(); ++i) {
+            const Node& node = *queue[i];
+            FlatNode flat;
+            flat.labelOffset = table->labels.size();
+            flat.labelLength = node.label.size();
+            table->labels.append(node.label);
+            flat.nameOffset = table->labels.size();
+            flat.nameLength = node.name.size();
+            table->labels.append(node.name);
+            for(size_t m = 0; m < METHODS; ++m) {
+               flat.handlers[m] = node.handlers[m] ? static_cast<int32_t>(table->handlers.size()) : NONE;
+               if(node.handlers[m]) table->handlers.push_back(node.handlers[m]);
+            }
+
+            flat.firstChild = queue.size();
+            flat.childCount = node.children.size();
+            for(size_t c = 0; c < node.children.size(); ++c) {
+               queue.push_back(node.children[c].get());
+               table->firstBytes.push_back(node.children[c]->label[0]);
+            }
+            flat.param = node.param ? static_cast<int32_t>(queue.size()) : NONE;
+            if(node.param) {
+               queue.push_back(node.param.get());
+               table->firstBytes.push_back('\0');
+            }
+            flat.wildcard = node.wildcard ? static_cast<int32_t>(queue.size()) : NONE;
+            if(node.wildcard) {
+               queue.push_back(node.wildcard.get());
+               table->firstBytes.push_back('\0');
+            }
+            table->nodes.push_back(flat);
+         }
+         mTable = table;
+      }
+
+      bool Router::matchFrom(const Table& table, const unsigned int index, const HttpRequest::Method method,
+         const char* path, const size_t length, const size_t position, RouteParams& params, unsigned int& allowed,
+         const RouteHandler*& found) {
+         const FlatNode& node = table.nodes[index];
+         if(position == length) {
+            for(size_t m = 0; m < METHODS; ++m) {
+               if(NONE != node.handlers[m]) allowed |= 1 << m;
+            }
+            if(NONE != node.handlers[method]) {
+               found = &table.handlers[node.handlers[method]];
+               return true;
+            }
+         }
+         else {
+            //children never share a first byte, so at most one static child can match
+            const char* firstBytes = table.firstBytes.data() + node.firstChild;
+            const char* child = static_cast<const char*>(memchr(firstBytes, path[position], node.childCount));
+            if(0 != child) {
+               const unsigned int childIndex = node.firstChild + (child - firstBytes);
+               const FlatNode& next = table.nodes[childIndex];
+               if(length - position >= next.labelLength &&
+                  0 == memcmp(path + position, table.labels.data() + next.labelOffset, next.labelLength) &&
+                  matchFrom(table, childIndex, method, path, length, position + next.labelLength, params, allowed,
+                     found)) {
+                  return true;
+               }
+            }
+
+            if(NONE != node.param && params.mSize < MAX_ROUTE_PARAMS) {
+               const char* slash = static_cast<const char*>(memchr(path + position, '/', length - position));
+               const size_t end = (0 == slash) ? length : slash - path;
+               if(end > position) {
+                  const FlatNode& param = table.nodes[node.param];
+                  params.mNames[params.mSize] = StringView(table.labels.data() + param.nameOffset, param.nameLength);
+                  params.mValues[params.mSize] = StringView(path + position, end - position);
+                  ++params.mSize;
+                  if(matchFrom(table, node.param, method, path, length, end, params, allowed, found)) return true;
+                  --params.mSize;
+               }
+            }
+         }
+
+         if(NONE != node.wildcard && params.mSize < MAX_ROUTE_PARAMS) {
+            const FlatNode& wildcard = table.nodes[node.wildcard];
+            for(size_t m = 0; m < METHODS; ++m) {
+               if(NONE != wildcard.handlers[m]) allowed |= 1 << m;
+            }
+            if(NONE != wildcard.handlers[method]) {
+               params.mNames[params.mSize] = StringView(table.labels.data() + wildcard.nameOffset,
+                  wildcard.nameLength);
+               params.mValues[params.mSize] = StringView(path + position, length - position);
+               ++params.mSize;
+               found = &table.handlers[wildcard.handlers[method]];
+               return true;
+            }
+         }
+         return false;
+      }
+
+      const RouteHandler* Router::match(const HttpRequest::Method method, const char* path, const size_t length,
+         RouteParams& params, unsigned int& allowed) const {
+         allowed = 0;
+         const RouteHandler* found = 0;
+         if(mTable) matchFrom(*mTable, 0, method, path, length, 0, params, allowed, found);
+         return found;
+      }
+
+      HttpResponse Router::route(const Table& table, const HttpRequest& req) {
+         const std::string& target = req.getTarget();
+         const size_t length = std::min(target.find_first_of("?#"), target.size());
+         RouteParams params;
+         unsigned int allowed = 0;
+         const RouteHandler* found = 0;
+         matchFrom(table, 0, req.getRequestMethod(), target.data(), length, 0, params, allowed, found);
+         if(0 != found) return (*found)(req, params);
+
+         if(0 != allowed) return notAllowed(allowed);
+         if(table.notFound) return table.notFound(req);
+         return HttpResponse(404, "");
+      }
+
+      HttpResponse Router::notAllowed(const unsigned int allowed) {
+         std::string methods;
+         for(size_t m = 0; m < METHODS; ++m) {
+            if(0 == (allowed & (1 << m))) continue;
+            if(!methods.empty()) methods.append(", ");
+            methods.append(HttpRequest::methodToString(static_cast<HttpRequest::Method>(m)));
+         }
+         HttpResponse resp(405, "");
+         resp.setHeader("allow", methods);
+         return resp;
+      }
+
+      HttpResponse Router::route(const HttpRequest& req) const throw (std::runtime_error) {
+         if(!mTable) throw(std::runtime_error("Router must be built before routing"));
+         return route(*mTable, req);
+      }
+
+      HttpRequestToResponse Router::handler() {
+         build();
+         std::shared_ptr<const Table> table = mTable;
+         return [table](HttpRequest req) -> HttpResponse {
+            return route(*table, req);
+         };
+      }
+
+   }
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include "objects/Platform.h"
+#include "objects/HttpRequest.h"
+#include "objects/HttpRequestToResponse.h"
+
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+
+#define MAX_ROUTE_PARAMS 8
+
+namespace c11http {
+namespace objects {
+
+/**
+ * Part of a string owned elsewhere, e.g. a path parameter within a request target. Not null terminated.
+ */
+class OBJECTS_API StringView {
+public:
+   StringView() : mData(0), mLength(0) {}
+   StringView(const char* data, const size_t length) : mData(data), mLength(length) {}
+
+   const char* data() const { return mData; }
+   size_t size() const { return mLength; }
+   bool empty() const { return 0 == mLength; }
+   std::string str() const { return std::string(mData, mLength); }
+
+   bool operator==(const char* other) const {
+      return strlen(other) == mLength && (0 == mLength || 0 == memcmp(mData, other, mLength));
+   }
+   bool operator==(const std::string& other) const {
+      return mLength == other.size() && 0 == other.compare(0, mLength, mData, mLength);
+   }
+
+private:
+   const char* mData;
+   size_t mLength;
+};
+
+/**
+ * Parameters a route captured from a request's path, as views of the request target and of the route's names.
+ * Valid for as long as the request and router are. Holds at most MAX_ROUTE_PARAMS, without allocating.
+ */
+class OBJECTS_API RouteParams {
+public:
+   RouteParams();
+
+   size_t size() const;
+   const StringView& name(const size_t index) const;
+   const StringView& value(const size_t index) const;
+   /**
+    * Value captured for name, empty if the route has no such parameter.
+    */
+   StringView get(const char* name) const;
+
+private:
+   friend class Router;
+   template<typename... Routes> friend class StaticRouter;
+
+   StringView mNames[MAX_ROUTE_PARAMS];
+   StringView mValues[MAX_ROUTE_PARAMS];
+   size_t mSize;
+};
+
+typedef std::function<HttpResponse(const HttpRequest&, const RouteParams&)> RouteHandler;
+
+/**
+ * Maps method and path patterns to handlers. A pattern is a path whose segments may be parameters, ":name",
+ * matching any one non empty segment, e.g. "/users/:id/posts/:post", and whose last segment may be a wildcard,
+ * "*name", matching the rest of the path. Where patterns overlap a static segment wins over a parameter and a
+ * parameter over a wildcard, falling back to the next if the rest of the path does not match.
+ *
+ * Routes are added to a radix tree, which build lays out in a flat array once all are added: each node's static
+ * children are adjacent, and their labels share a single buffer. Matching walks that array, capturing parameters
+ * as views of the target without allocating. Once built the router is read only and safe to share between
+ * threads.
+ */
+class OBJECTS_API Router {
+public:
+   Router();
+   ~Router();
+
+   /**
+    * Route requests for method matching pattern to handler. Throws if pattern is malformed, is already routed for
+    * method, or names a parameter differently from an overlapping pattern.
+    */
+   void add(const HttpRequest::Method method, const std::string& pattern, const RouteHandler& handler)
+         throw (std::runtime_error);
+   /**
+    * Answer requests no route matches, rather than with a 404.
+    */
+   void setNotFound(const HttpRequestToResponse& handler);
+   /**
+    * Lay out the routes added so far for matching. Must be called after the last add, before matching.
+    */
+   void build();
+
+   /**
+    * Find the handler for method and path, filling params, or null if there is none. allowed is set to a bit
+    * per method, 1 << method, that path has a route for.
+    */
+   const RouteHandler* match(const HttpRequest::Method method, const char* path, const size_t length,
+         RouteParams& params, unsigned int& allowed) const;
+   /**
+    * Answer req with its route's handler, with a 405 listing the allowed methods if its path is only routed for
+    * other methods, or else as not found. Throws if the router has not been built.
+    */
+   HttpResponse route(const HttpRequest& req) const throw (std::runtime_error);
+   /**
+    * Build the router, and return a handler routing each request, e.g. for tcp::Server::registerHandler. The
+    * handler shares the built routes, so it remains valid after the router is destroyed.
+    */
+   HttpRequestToResponse handler();
+
+   /**
+    * A 405 whose Allow header lists the methods in allowed, a bit per method as match sets them.
+    */
+   static HttpResponse notAllowed(const unsigned int allowed);
+
+private:
+   Router(const Router&);
+   Router& operator=(const Router&);
+
+   struct Node;
+   struct Table;
+
+   static HttpResponse route(const Table& table, const HttpRequest& req);
+   /**
+    * Match the rest of path from position, the node at index having matched up to it, backtracking to parameters
+    * and wildcards where static children fail.
+    */
+   static bool matchFrom(const Table& table, const unsigned int index, const HttpRequest::Method method,
+         const char* path, const size_t length, const size_t position, RouteParams& params, unsigned int& allowed,
+         const RouteHandler*& found);
+
+   std::unique_ptr<Node> mRoot; //routes as added
+   std::shared_ptr<Table> mTable; //routes as built
+   HttpRequestToResponse mNotFound;
+};
+
+}
+}
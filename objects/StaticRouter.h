@@ -0,0 +1,183 @@
+#pragma once
+
+#include "objects/HttpRequest.h"
+#include "objects/HttpRequestToResponse.h"
+#include "objects/HttpResponse.h"
+#include "objects/Router.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+namespace c11http {
+namespace objects {
+
+/**
+ * Compile time helpers for StaticRouter.
+ */
+namespace staticrouting {
+
+constexpr size_t length(const char* pattern) {
+   return '\0' == *pattern ? 0 : 1 + length(pattern + 1);
+}
+
+/**
+ * Length of the static text before a pattern's first parameter.
+ */
+constexpr size_t prefixLength(const char* pattern) {
+   return ('\0' == *pattern || ':' == *pattern) ? 0 : 1 + prefixLength(pattern + 1);
+}
+
+constexpr bool equal(const char* first, const char* second) {
+   return *first == *second && ('\0' == *first || equal(first + 1, second + 1));
+}
+
+template<typename Route>
+struct Traits {
+   static constexpr size_t LENGTH = length(Route::pattern());
+   static constexpr size_t PREFIX = prefixLength(Route::pattern());
+   static constexpr bool STATIC = PREFIX == LENGTH;
+   static_assert('/' == Route::pattern()[0], "route patterns must start with /");
+};
+
+/**
+ * Whether Route differs from each of Others in method or pattern.
+ */
+template<typename Route, typename... Others>
+struct Distinct {
+   static constexpr bool value = true;
+};
+template<typename Route, typename Other, typename... Others>
+struct Distinct<Route, Other, Others...> {
+   static constexpr bool value = !(Route::method == Other::method && equal(Route::pattern(), Other::pattern())) &&
+         Distinct<Route, Others...>::value;
+};
+
+template<typename... Routes>
+struct AllDistinct {
+   static constexpr bool value = true;
+};
+template<typename Route, typename... Routes>
+struct AllDistinct<Route, Routes...> {
+   static constexpr bool value = Distinct<Route, Routes...>::value && AllDistinct<Routes...>::value;
+};
+
+}
+
+/**
+ * Routes fixed at compile time, for services whose endpoints never change. Each route is a type naming its
+ * method, its pattern, which may have ":name" parameter segments, and a static handler:
+ *
+ *    struct Health {
+ *       static constexpr HttpRequest::Method method = HttpRequest::GET;
+ *       static constexpr const char* pattern() { return "/health"; }
+ *       static HttpResponse handle(const HttpRequest& req, const RouteParams& params);
+ *    };
+ *    typedef StaticRouter<Health, GetUser, UpdateUser> EdgeRoutes;
+ *    server.registerHandler(EdgeRoutes::handler(dynamicRouter.handler()));
+ *
+ * Pattern lengths and static prefixes are computed by the compiler, and the route list is expanded into a chain
+ * of comparisons against those constants, calling each handler directly: there is no table to walk and nothing
+ * is allocated. Static routes are tried first, each a length check and a fixed size compare, then parameterized
+ * routes in the order given. Declaring a route twice fails to compile.
+ */
+template<typename... Routes>
+class StaticRouter {
+   static_assert(staticrouting::AllDistinct<Routes...>::value, "a method and pattern are routed twice");
+
+public:
+   /**
+    * Answer req with its route's handler into resp, returning false if no route matches. allowed gets a bit per
+    * method, 1 << method, that req's path is routed for.
+    */
+   static bool route(const HttpRequest& req, HttpResponse& resp, unsigned int& allowed) {
+      const std::string& target = req.getTarget();
+      const size_t length = std::min(target.find_first_of("?#"), target.size());
+      allowed = 0;
+      return Dispatch<true, Routes...>::route(req, target.data(), length, resp, allowed) ||
+            Dispatch<false, Routes...>::route(req, target.data(), length, resp, allowed);
+   }
+
+   /**
+    * Answer req with its route's handler, with a 405 if its path is only routed for other methods, or a 404.
+    */
+   static HttpResponse route(const HttpRequest& req) {
+      HttpResponse resp;
+      unsigned int allowed = 0;
+      if(route(req, resp, allowed)) return resp;
+      return (0 != allowed) ? Router::notAllowed(allowed) : HttpResponse(404, "");
+   }
+
+   /**
+    * A handler routing each request, passing those no route matches to fallback, e.g. a Router's handler, if
+    * there is one.
+    */
+   static HttpRequestToResponse handler(const HttpRequestToResponse& fallback = HttpRequestToResponse()) {
+      return [fallback](HttpRequest req) -> HttpResponse {
+         HttpResponse resp;
+         unsigned int allowed = 0;
+         if(route(req, resp, allowed)) return resp;
+         if(fallback) return fallback(req);
+         return (0 != allowed) ? Router::notAllowed(allowed) : HttpResponse(404, "");
+      };
+   }
+
+private:
+   /**
+    * Match path against a pattern's parameter segments, from just past its static prefix.
+    */
+   static bool matchParams(const char* pattern, const char* path, const char* end, RouteParams& params) {
+      while('\0' != *pattern) {
+         if(':' == *pattern) {
+            const char* name = ++pattern;
+            while('\0' != *pattern && '/' != *pattern) ++pattern;
+            const char* value = path;
+            while(path != end && '/' != *path) ++path;
+            if(path == value || params.mSize == MAX_ROUTE_PARAMS) return false;
+            params.mNames[params.mSize] = StringView(name, pattern - name);
+            params.mValues[params.mSize] = StringView(value, path - value);
+            ++params.mSize;
+         }
+         else if(path == end || *pattern++ != *path++) {
+            return false;
+         }
+      }
+      return path == end;
+   }
+
+   template<typename Route>
+   static bool matches(const char* path, const size_t length, RouteParams& params) {
+      typedef staticrouting::Traits<Route> Traits;
+      if(Traits::STATIC) return Traits::LENGTH == length && 0 == memcmp(path, Route::pattern(), Traits::LENGTH);
+      return length >= Traits::PREFIX && 0 == memcmp(path, Route::pattern(), Traits::PREFIX) &&
+            matchParams(Route::pattern() + Traits::PREFIX, path + Traits::PREFIX, path + length, params);
+   }
+
+   /**
+    * The routes, static or parameterized as STATIC_PASS says, as a chain of inlined matches.
+    */
+   template<bool STATIC_PASS, typename... Remaining>
+   struct Dispatch {
+      static bool route(const HttpRequest&, const char*, const size_t, HttpResponse&, unsigned int&) {
+         return false;
+      }
+   };
+   template<bool STATIC_PASS, typename Route, typename... Remaining>
+   struct Dispatch<STATIC_PASS, Route, Remaining...> {
+      static bool route(const HttpRequest& req, const char* path, const size_t length, HttpResponse& resp,
+            unsigned int& allowed) {
+         RouteParams params;
+         if(staticrouting::Traits<Route>::STATIC == STATIC_PASS && matches<Route>(path, length, params)) {
+            if(Route::method == req.getRequestMethod()) {
+               resp = Route::handle(req, params);
+               return true;
+            }
+            allowed |= 1 << Route::method;
+         }
+         return Dispatch<STATIC_PASS, Remaining...>::route(req, path, length, resp, allowed);
+      }
+   };
+};
+
+}
+}
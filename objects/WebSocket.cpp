@@ -0,0 +1,316 @@
+#include "objects/WebSocket.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define C11HTTP_WEBSOCKET_SSE2
+#include <emmintrin.h>
+#endif
+
+#include "objects/HttpRequest.h"
+#include "objects/HttpResponse.h"
+
+namespace c11http {
+   namespace objects {
+
+      namespace {
+         const char GUID[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+         const char BASE64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+         uint32_t rotate(const uint32_t value, const unsigned int bits) {
+            return (value << bits) | (value >> (32 - bits));
+         }
+
+         /**
+          * SHA-1 (RFC 3174) of data, only ever needed here for the handshake's accept key.
+          */
+         std::string sha1(const std::string& data) {
+            uint32_t state[5] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0 };
+
+            std::string message(data);
+            message.push_back(static_cast<char>(0x80));
+            while(56 != message.size() % 64) message.push_back('\0');
+            const uint64_t bits = static_cast<uint64_t>(data.size()) * 8;
+            for(int shift = 56; shift >= 0; shift -= 8) message.push_back(static_cast<char>(bits >> shift));
+
+            for(size_t block = 0; block < message.size(); block += 64) {
+               const unsigned char* bytes = reinterpret_cast<const unsigned char*>(message.data() + block);
+               uint32_t words[80];
+               for(int i = 0; i < 16; ++i) {
+                  words[i] = (static_cast<uint32_t>(bytes[i * 4]) << 24) | (bytes[i * 4 + 1] << 16) |
+                     (bytes[i * 4 + 2] << 8) | bytes[i * 4 + 3];
+               }
+               for(int i = 16; i < 80; ++i) {
+                  words[i] = rotate(words[i - 3] ^ words[i - 8] ^ words[i - 14] ^ words[i - 16], 1);
+               }
+
+               uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+               for(int i = 0; i < 80; ++i) {
+                  uint32_t f, k;
+                  if(i < 20) {
+                     f = (b & c) | (~b & d);
+                     k = 0x5a827999;
+                  }
+                  else if(i < 40) {
+                     f = b ^ c ^ d;
+                     k = 0x6ed9eba1;
+                  }
+                  else if(i < 60) {
+                     f = (b & c) | (b & d) | (c & d);
+                     k = 0x8f1bbcdc;
+                  }
+                  else {
+                     f = b ^ c ^ d;
+                     k = 0xca62c1d6;
+                  }
+                  const uint32_t next = rotate(a, 5) + f + e + k + words[i];
+                  e = d;
+                  d = c;
+                  c = rotate(b, 30);
+                  b = a;
+                  a = next;
+               }
+               state[0] += a;
+               state[1] += b;
+               state[2] += c;
+               state[3] += d;
+               state[4] += e;
+            }
+
+            std::string digest;
+            for(int i = 0; i < 5; ++i) {
+               for(int shift = 24; shift >= 0; shift -= 8) digest.push_back(static_cast<char>(state[i] >> shift));
+            }
+            return digest;
+         }
+
+         std::string encodeBase64(const std::string& data) {
+            std::string out;
+            for(size_t i = 0; i < data.size(); i += 3) {
+               const size_t remaining = std::min<size_t>(3, data.size() - i);
+               uint32_t group = 0;
+               for(size_t j = 0; j < 3; ++j) {
+                  group = (group << 8) | (j < remaining ? static_cast<unsigned char>(data[i + j]) : 0);
+               }
+               for(size_t j = 0; j < 4; ++j) {
+                  out.push_back(j <= remaining ? BASE64[(group >> (18 - j * 6)) & 0x3f] : '=');
+               }
+            }
+            return out;
+         }
+
+         bool containsToken(const std::string& value, const std::string& token) {
+            std::string lower(value);
+            std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+            return std::string::npos != lower.find(token);
+         }
+
+         /**
+          * True if data is well formed UTF-8: no overlong forms, surrogates or code points past U+10FFFF.
+          */
+         bool isUtf8(const std::string& data) {
+            const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data.data());
+            const size_t length = data.size();
+            size_t i = 0;
+            while(i < length) {
+               //runs of ASCII, the bulk of most text, are skipped 8 bytes at a time
+               if(i + 8 <= length) {
+                  uint64_t word;
+                  memcpy(&word, bytes + i, sizeof(word));
+                  if(0 == (word & 0x8080808080808080ull)) {
+                     i += 8;
+                     continue;
+                  }
+               }
+               const unsigned char lead = bytes[i];
+               size_t continuation;
+               unsigned char low = 0x80;
+               unsigned char high = 0xbf;
+               if(lead < 0x80) {
+                  ++i;
+                  continue;
+               }
+               else if(lead >= 0xc2 && lead <= 0xdf) continuation = 1;
+               else if(lead >= 0xe0 && lead <= 0xef) {
+                  continuation = 2;
+                  if(0xe0 == lead) low = 0xa0;
+                  if(0xed == lead) high = 0x9f;
+               }
+               else if(lead >= 0xf0 && lead <= 0xf4) {
+                  continuation = 3;
+                  if(0xf0 == lead) low = 0x90;
+                  if(0xf4 == lead) high = 0x8f;
+               }
+               else return false;
+
+               if(i + continuation >= length) return false;
+               if(bytes[i + 1] < low || bytes[i + 1] > high) return false;
+               for(size_t j = 2; j <= continuation; ++j) {
+                  if(0x80 != (bytes[i + j] & 0xc0)) return false;
+               }
+               i += continuation + 1;
+            }
+            return true;
+         }
+      }
+
+      bool WebSocket::isUpgrade(const HttpRequest& request) {
+         return HttpRequest::GET == request.getRequestMethod() &&
+            containsToken(request.getHeader("upgrade"), "websocket") &&
+            containsToken(request.getHeader("connection"), "upgrade") &&
+            !request.getHeader("sec-websocket-key").empty() && "13" == request.getHeader("sec-websocket-version");
+      }
+
+      HttpResponse WebSocket::accept(const HttpRequest& request) {
+         HttpResponse response(101, "");
+         response.setHeader("upgrade", "websocket");
+         response.setHeader("connection", "Upgrade");
+         response.setHeader("sec-websocket-accept", acceptKey(request.getHeader("sec-websocket-key")));
+         return response;
+      }
+
+      std::string WebSocket::acceptKey(const std::string& key) {
+         return encodeBase64(sha1(key + GUID));
+      }
+
+      void WebSocket::serializeFrame(const Opcode opcode, const char* data, const size_t length, std::string& out,
+         const bool final) {
+         out.push_back(static_cast<char>((final ? 0x80 : 0) | opcode));
+         if(length < 126) {
+            out.push_back(static_cast<char>(length));
+         }
+         else if(length <= 0xffff) {
+            out.push_back(static_cast<char>(126));
+            out.push_back(static_cast<char>(length >> 8));
+            out.push_back(static_cast<char>(length));
+         }
+         else {
+            out.push_back(static_cast<char>(127));
+            for(int shift = 56; shift >= 0; shift -= 8) {
+               out.push_back(static_cast<char>(static_cast<uint64_t>(length) >> shift));
+            }
+         }
+         out.append(data, length);
+      }
+
+      void WebSocket::serializeClose(const unsigned short code, std::string& out, const std::string& reason) {
+         std::string payload;
+         payload.push_back(static_cast<char>(code >> 8));
+         payload.push_back(static_cast<char>(code));
+         payload.append(reason, 0, 123);
+         serializeFrame(CLOSE, payload.data(), payload.size(), out);
+      }
+
+      void WebSocket::unmask(char* data, const size_t length, const unsigned char key[4], const size_t offset) {
+         //the key repeats every 4 bytes, so a pattern of it lined up with data is applied to whole words at a time
+         unsigned char pattern[16];
+         for(size_t i = 0; i < sizeof(pattern); ++i) pattern[i] = key[(offset + i) & 3];
+
+         size_t i = 0;
+#ifdef C11HTTP_WEBSOCKET_SSE2
+         const __m128i mask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pattern));
+         for(; i + 16 <= length; i += 16) {
+            __m128i* block = reinterpret_cast<__m128i*>(data + i);
+            _mm_storeu_si128(block, _mm_xor_si128(_mm_loadu_si128(block), mask));
+         }
+#endif
+         uint64_t mask64;
+         memcpy(&mask64, pattern, sizeof(mask64));
+         for(; i + 8 <= length; i += 8) {
+            uint64_t word;
+            memcpy(&word, data + i, sizeof(word));
+            word ^= mask64;
+            memcpy(data + i, &word, sizeof(word));
+         }
+         for(; i < length; ++i) data[i] ^= pattern[i & 3];
+      }
+
+      WebSocketParser::WebSocketParser(const size_t maxMessageSize) : mMessageOpcode(WebSocket::CONTINUATION),
+         mMaxMessageSize(maxMessageSize), mCloseCode(WebSocket::NORMAL_CLOSURE)
+      {
+
+      }
+
+      void WebSocketParser::parse(const char* data, const size_t length, std::vector<Message>& messages)
+            throw (std::runtime_error) {
+         mInput.append(data, length);
+
+         size_t consumed = 0;
+         while(mInput.size() - consumed >= 2) {
+            const unsigned char* header = reinterpret_cast<const unsigned char*>(mInput.data() + consumed);
+            const bool final = 0 != (header[0] & 0x80);
+            const unsigned int opcode = header[0] & 0x0f;
+            const bool control = 0 != (opcode & 0x8);
+            if(0 != (header[0] & 0x70)) fail(WebSocket::PROTOCOL_ERROR, "Reserved bits set without an extension");
+            if(0 == (header[1] & 0x80)) fail(WebSocket::PROTOCOL_ERROR, "Frame from a client is not masked");
+            if((control && opcode > WebSocket::PONG) || (!control && opcode > WebSocket::BINARY)) {
+               fail(WebSocket::PROTOCOL_ERROR, "Reserved opcode");
+            }
+            if(control && !final) fail(WebSocket::PROTOCOL_ERROR, "Fragmented control frame");
+            if(!control && (WebSocket::CONTINUATION == opcode) != (WebSocket::CONTINUATION != mMessageOpcode)) {
+               fail(WebSocket::PROTOCOL_ERROR, "Fragments out of order");
+            }
+
+            uint64_t payloadLength = header[1] & 0x7f;
+            const size_t extendedSize = 126 == payloadLength ? 2 : (127 == payloadLength ? 8 : 0);
+            const size_t headerSize = 2 + extendedSize + 4;
+            if(mInput.size() - consumed < headerSize) break;
+            if(0 != extendedSize) {
+               payloadLength = 0;
+               for(size_t i = 0; i < extendedSize; ++i) payloadLength = (payloadLength << 8) | header[2 + i];
+            }
+            if(control && payloadLength > 125) fail(WebSocket::PROTOCOL_ERROR, "Control frame too large");
+            //refused before any of it is buffered
+            if(!control && payloadLength > mMaxMessageSize - mMessage.size()) {
+               fail(WebSocket::MESSAGE_TOO_BIG, "Message too large");
+            }
+            if(mInput.size() - consumed - headerSize < payloadLength) break;
+
+            const unsigned char* key = header + 2 + extendedSize;
+            const char* payload = mInput.data() + consumed + headerSize;
+            const size_t size = static_cast<size_t>(payloadLength);
+            consumed += headerSize + size;
+
+            if(control) {
+               Message message;
+               message.opcode = static_cast<WebSocket::Opcode>(opcode);
+               message.payload.assign(payload, size);
+               if(0 != size) WebSocket::unmask(&message.payload[0], size, key);
+               if(WebSocket::CLOSE == opcode && 1 == size) fail(WebSocket::PROTOCOL_ERROR, "Malformed close");
+               messages.push_back(message);
+               continue;
+            }
+
+            if(WebSocket::CONTINUATION != opcode) mMessageOpcode = static_cast<WebSocket::Opcode>(opcode);
+            const size_t start = mMessage.size();
+            mMessage.append(payload, size);
+            if(0 != size) WebSocket::unmask(&mMessage[start], size, key);
+            if(!final) continue;
+
+            if(WebSocket::TEXT == mMessageOpcode && !isUtf8(mMessage)) {
+               fail(WebSocket::INVALID_DATA, "Text message is not UTF-8");
+            }
+            messages.push_back(Message());
+            messages.back().opcode = mMessageOpcode;
+            messages.back().payload.swap(mMessage);
+            mMessageOpcode = WebSocket::CONTINUATION;
+         }
+         mInput.erase(0, consumed);
+      }
+
+      unsigned short WebSocketParser::getCloseCode() const {
+         return mCloseCode;
+      }
+
+      void WebSocketParser::fail(const unsigned short code, const char* reason) throw (std::runtime_error) {
+         mCloseCode = code;
+         mInput.clear();
+         mMessage.clear();
+         throw(std::runtime_error(reason));
+      }
+
+   }
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "objects/Platform.h"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace c11http {
+namespace objects {
+
+class HttpRequest;
+class HttpResponse;
+
+/**
+ * The opening handshake and framing of the WebSocket protocol (RFC 6455), as a server speaks it.
+ */
+class OBJECTS_API WebSocket {
+public:
+   enum Opcode {
+      CONTINUATION = 0x0,
+      TEXT = 0x1,
+      BINARY = 0x2,
+      CLOSE = 0x8,
+      PING = 0x9,
+      PONG = 0xa
+   };
+   enum CloseCode {
+      NORMAL_CLOSURE = 1000,
+      PROTOCOL_ERROR = 1002,
+      INVALID_DATA = 1007,
+      MESSAGE_TOO_BIG = 1009
+   };
+
+   /**
+    * True if request asks to open a WebSocket: a GET with "Upgrade: websocket", a Sec-WebSocket-Key, and version 13.
+    */
+   static bool isUpgrade(const HttpRequest& request);
+   /**
+    * The 101 response accepting request's upgrade.
+    */
+   static HttpResponse accept(const HttpRequest& request);
+   /**
+    * Sec-WebSocket-Accept for a Sec-WebSocket-Key: the base64 SHA-1 of the key and the protocol's GUID.
+    */
+   static std::string acceptKey(const std::string& key);
+   /**
+    * Append a frame holding data to out, unmasked as frames from a server are. A message is sent in fragments by
+    * frames with final false, all but the first of them CONTINUATION.
+    */
+   static void serializeFrame(const Opcode opcode, const char* data, const size_t length, std::string& out,
+         const bool final = true);
+   /**
+    * Append a CLOSE frame with code, and optionally a reason, to out.
+    */
+   static void serializeClose(const unsigned short code, std::string& out, const std::string& reason = "");
+   /**
+    * XOR length bytes of a payload with its masking key, in place, data being offset bytes into the payload. Runs 16
+    * bytes at a time with SSE2 where the target has it, 8 at a time otherwise.
+    */
+   static void unmask(char* data, const size_t length, const unsigned char key[4], const size_t offset = 0);
+};
+
+/**
+ * Parses the frames a client sends on one WebSocket connection, unmasking their payloads and joining fragmented
+ * messages back together. Control frames may arrive between the fragments of a message, and are returned as they
+ * arrive.
+ */
+class OBJECTS_API WebSocketParser {
+public:
+   /**
+    * A whole TEXT or BINARY message, or a CLOSE, PING or PONG frame.
+    */
+   struct Message {
+      WebSocket::Opcode opcode;
+      std::string payload;
+   };
+
+   /**
+    * Messages whose payloads, fragments joined, pass maxMessageSize are refused without being buffered.
+    */
+   explicit WebSocketParser(const size_t maxMessageSize = 1024 * 1024);
+
+   /**
+    * Parse data, appending the messages it completes to messages. Throws if the frames break the protocol, or a
+    * message is too large, after which the connection must be closed with getCloseCode.
+    */
+   void parse(const char* data, const size_t length, std::vector<Message>& messages) throw (std::runtime_error);
+   /**
+    * The close code the connection must be closed with once parse has thrown.
+    */
+   unsigned short getCloseCode() const;
+
+private:
+   void fail(const unsigned short code, const char* reason) throw (std::runtime_error);
+
+   std::string mInput; //received bytes not yet a complete frame
+   std::string mMessage; //fragments of a message not yet final
+   WebSocket::Opcode mMessageOpcode; //of the fragmented message, CONTINUATION if there is none
+   size_t mMaxMessageSize;
+   unsigned short mCloseCode;
+};
+
+}
+}
@@ -0,0 +1,244 @@
+#include "tcp/ResponseCache.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <functional>
+
+#include "objects/HttpRequest.h"
+#include "objects/HttpResponse.h"
+
+namespace c11http {
+   namespace tcp {
+
+      namespace {
+         std::string lowerCase(const std::string& value) {
+            std::string result(value);
+            std::transform(result.begin(), result.end(), result.begin(), ::tolower);
+            return result;
+         }
+
+         std::string trim(const std::string& value) {
+            const size_t begin = value.find_first_not_of(" \t");
+            if(std::string::npos == begin) return std::string();
+            return value.substr(begin, value.find_last_not_of(" \t") - begin + 1);
+         }
+
+         /**
+          * Split a comma separated header value into its trimmed, lower cased, non empty elements.
+          */
+         std::vector<std::string> splitList(const std::string& value) {
+            std::vector<std::string> elements;
+            size_t begin = 0;
+            while(begin <= value.size()) {
+               size_t end = value.find(',', begin);
+               if(std::string::npos == end) end = value.size();
+               const std::string element = lowerCase(trim(value.substr(begin, end - begin)));
+               if(!element.empty()) elements.push_back(element);
+               begin = end + 1;
+            }
+            return elements;
+         }
+
+         /**
+          * Seconds given to a Cache-Control directive, or -1 if directive is not present.
+          */
+         long directiveSeconds(const std::vector<std::string>& directives, const std::string& directive) {
+            for(size_t i = 0; i < directives.size(); ++i) {
+               if(0 == directives[i].compare(0, directive.size() + 1, directive + "=")) {
+                  return strtol(directives[i].c_str() + directive.size() + 1, 0, 10);
+               }
+            }
+            return -1;
+         }
+
+         bool isUnreserved(const char c) {
+            return isalnum(static_cast<unsigned char>(c)) || '-' == c || '.' == c || '_' == c || '~' == c;
+         }
+      }
+
+      ResponseCache::Shard::Shard() : bytes(0) {
+
+      }
+
+      ResponseCache::ResponseCache(const size_t maxBytes, const unsigned int defaultTtlMilliseconds,
+         const std::vector<std::string>& vary, const size_t shards) :
+         mMaxBytesPerShard(maxBytes / (0 == shards ? 1 : shards)), mDefaultTtl(defaultTtlMilliseconds), mHits(0),
+         mMisses(0) {
+         for(size_t i = 0; i < vary.size(); ++i) mVary.push_back(lowerCase(vary[i]));
+         for(size_t i = 0; i < (0 == shards ? 1 : shards); ++i) mShards.push_back(new Shard());
+      }
+
+      ResponseCache::~ResponseCache() {
+         for(size_t i = 0; i < mShards.size(); ++i) delete mShards[i];
+      }
+
+      std::string ResponseCache::normalizeTarget(const std::string& target) {
+         std::string normalized;
+         normalized.reserve(target.size());
+         const size_t end = std::min(target.find('#'), target.size());
+         for(size_t i = 0; i < end; ++i) {
+            if('%' == target[i] && i + 2 < end && isxdigit(static_cast<unsigned char>(target[i + 1])) &&
+               isxdigit(static_cast<unsigned char>(target[i + 2]))) {
+               const char decoded = static_cast<char>(strtol(target.substr(i + 1, 2).c_str(), 0, 16));
+               if(isUnreserved(decoded)) {
+                  normalized.push_back(decoded);
+               }
+               else {
+                  normalized.push_back('%');
+                  normalized.push_back(toupper(static_cast<unsigned char>(target[i + 1])));
+                  normalized.push_back(toupper(static_cast<unsigned char>(target[i + 2])));
+               }
+               i += 2;
+            }
+            else {
+               normalized.push_back(target[i]);
+            }
+         }
+         return normalized;
+      }
+
+      std::string ResponseCache::keyFor(const objects::HttpRequest& req) const {
+         if(objects::HttpRequest::GET != req.getRequestMethod()) return std::string();
+         //the client wants the handler's answer, and none kept
+         const std::vector<std::string> directives = splitList(req.getHeader("cache-control"));
+         if(directives.end() != std::find(directives.begin(), directives.end(), "no-store") ||
+            directives.end() != std::find(directives.begin(), directives.end(), "no-cache") ||
+            "no-cache" == lowerCase(trim(req.getHeader("pragma")))) {
+            return std::string();
+         }
+
+         std::string key("GET ");
+         key.append(normalizeTarget(req.getTarget()));
+         for(size_t i = 0; i < mVary.size(); ++i) {
+            key.push_back('\n');
+            key.append(mVary[i]);
+            key.push_back(':');
+            key.append(req.getHeader(mVary[i]));
+         }
+         return key;
+      }
+
+      ResponseCache::Shard& ResponseCache::shardFor(const std::string& key) {
+         return *mShards[std::hash<std::string>()(key) % mShards.size()];
+      }
+
+      size_t ResponseCache::sizeOf(const Entry& entry) {
+         return sizeof(Entry) + entry.key.size() + entry.response->size();
+      }
+
+      ResponseCache::Buffer ResponseCache::lookup(const std::string& key) {
+         Shard& shard = shardFor(key);
+         std::lock_guard<std::mutex> lock(shard.mutex);
+         std::unordered_map<std::string, Lru::iterator>::iterator found = shard.index.find(key);
+         if(shard.index.end() == found) {
+            ++mMisses;
+            return Buffer();
+         }
+
+         if(Clock::now() >= found->second->expires) {
+            shard.bytes -= sizeOf(*found->second);
+            shard.lru.erase(found->second);
+            shard.index.erase(found);
+            ++mMisses;
+            return Buffer();
+         }
+
+         shard.lru.splice(shard.lru.begin(), shard.lru, found->second);
+         ++mHits;
+         return found->second->response;
+      }
+
+      ResponseCache::Clock::duration ResponseCache::lifetimeOf(const objects::HttpResponse& resp,
+         const bool authorized) const {
+         const unsigned int status = resp.getStatus();
+         if(200 != status && 203 != status && 301 != status && 404 != status && 410 != status) {
+            return Clock::duration::zero();
+         }
+         //responses for one client, or that set state, are never shared
+         if(resp.hasHeader("set-cookie")) return Clock::duration::zero();
+
+         const std::vector<std::string> directives = splitList(resp.getHeader("cache-control"));
+         for(size_t i = 0; i < directives.size(); ++i) {
+            if("no-store" == directives[i] || "no-cache" == directives[i] || "private" == directives[i]) {
+               return Clock::duration::zero();
+            }
+         }
+
+         const std::vector<std::string> vary = splitList(resp.getHeader("vary"));
+         for(size_t i = 0; i < vary.size(); ++i) {
+            if(mVary.end() == std::find(mVary.begin(), mVary.end(), vary[i])) return Clock::duration::zero();
+         }
+
+         long seconds = directiveSeconds(directives, "s-maxage");
+         //an authorized response is only shared when the handler says so
+         if(authorized && seconds < 0 && directives.end() == std::find(directives.begin(), directives.end(), "public")) {
+            return Clock::duration::zero();
+         }
+         if(seconds < 0) seconds = directiveSeconds(directives, "max-age");
+         if(seconds < 0) return mDefaultTtl;
+         return std::chrono::seconds(seconds);
+      }
+
+      ResponseCache::Buffer ResponseCache::store(const std::string& key, const objects::HttpResponse& resp,
+         const bool authorized) {
+         std::shared_ptr<std::string> serialized(new std::string());
+         resp.serialize(*serialized);
+
+         const Clock::duration lifetime = lifetimeOf(resp, authorized);
+         if(key.empty() || lifetime <= Clock::duration::zero()) return serialized;
+
+         Entry entry;
+         entry.key = key;
+         entry.response = serialized;
+         entry.expires = Clock::now() + lifetime;
+         const size_t size = sizeOf(entry);
+         if(size > mMaxBytesPerShard) return serialized;
+
+         Shard& shard = shardFor(key);
+         std::lock_guard<std::mutex> lock(shard.mutex);
+         std::unordered_map<std::string, Lru::iterator>::iterator found = shard.index.find(key);
+         if(shard.index.end() != found) {
+            shard.bytes -= sizeOf(*found->second);
+            shard.lru.erase(found->second);
+            shard.index.erase(found);
+         }
+         while(shard.bytes + size > mMaxBytesPerShard && !shard.lru.empty()) {
+            shard.bytes -= sizeOf(shard.lru.back());
+            shard.index.erase(shard.lru.back().key);
+            shard.lru.pop_back();
+         }
+         shard.lru.push_front(entry);
+         shard.index[key] = shard.lru.begin();
+         shard.bytes += size;
+         return serialized;
+      }
+
+      size_t ResponseCache::getEntries() const {
+         size_t total = 0;
+         for(size_t i = 0; i < mShards.size(); ++i) {
+            std::lock_guard<std::mutex> lock(mShards[i]->mutex);
+            total += mShards[i]->index.size();
+         }
+         return total;
+      }
+
+      size_t ResponseCache::getBytes() const {
+         size_t total = 0;
+         for(size_t i = 0; i < mShards.size(); ++i) {
+            std::lock_guard<std::mutex> lock(mShards[i]->mutex);
+            total += mShards[i]->bytes;
+         }
+         return total;
+      }
+
+      size_t ResponseCache::getHits() const {
+         return mHits;
+      }
+
+      size_t ResponseCache::getMisses() const {
+         return mMisses;
+      }
+
+   }
+}
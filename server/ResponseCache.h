@@ -0,0 +1,102 @@
+#pragma once
+
+#include "tcp/Platform.h"
+
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace c11http {
+
+namespace objects {
+class HttpRequest;
+class HttpResponse;
+}
+
+namespace tcp {
+
+/**
+ * Responses already produced by a handler, kept serialized so a repeated request is answered without running the
+ * handler again. A cached response is a reference counted buffer, queued as it is on every connection it answers
+ * and written with writev, never copied. Entries are keyed by method, normalized target and the values of the
+ * request headers the cache varies on, and spread by key over lock striped shards, each evicting its least
+ * recently used entries to stay within its share of the byte budget. Thread safe.
+ */
+class TCP_API ResponseCache {
+public:
+    typedef std::shared_ptr<const std::string> Buffer;
+
+    /**
+     * Responses are kept for their Cache-Control s-maxage or max-age, or defaultTtlMilliseconds if they have
+     * neither. vary names the request headers responses may differ by, e.g. accept-encoding; a response with a
+     * Vary on any other header is not cached.
+     */
+    ResponseCache(const size_t maxBytes, const unsigned int defaultTtlMilliseconds = 0,
+            const std::vector<std::string>& vary = std::vector<std::string>(), const size_t shards = 16);
+    ~ResponseCache();
+
+    /**
+     * Key for a request, or an empty string if it is neither answered from nor stored in the cache: methods other
+     * than GET, and requests whose Cache-Control or Pragma asks for no-store or no-cache.
+     */
+    std::string keyFor(const objects::HttpRequest& req) const;
+    /**
+     * The serialized response stored for key, or null if there is none or it has expired.
+     */
+    Buffer lookup(const std::string& key);
+    /**
+     * Serialize resp, storing it for key if it may be cached. Returns the serialized response either way, so it
+     * is serialized just once. A response to a request carrying Authorization is only stored if it is marked
+     * public or has an s-maxage, since it may be meant for that client alone.
+     */
+    Buffer store(const std::string& key, const objects::HttpResponse& resp, const bool authorized = false);
+
+    size_t getEntries() const;
+    size_t getBytes() const;
+    size_t getHits() const;
+    size_t getMisses() const;
+
+    /**
+     * Decode percent encoded unreserved characters and upper case the remaining escapes, so equivalent targets
+     * share an entry. Any fragment is dropped.
+     */
+    static std::string normalizeTarget(const std::string& target);
+
+private:
+    typedef std::chrono::steady_clock Clock;
+    struct Entry {
+        std::string key;
+        Buffer response;
+        Clock::time_point expires;
+    };
+    typedef std::list<Entry> Lru;
+    struct Shard {
+        Shard();
+        mutable std::mutex mutex;
+        Lru lru; //most recently used first
+        std::unordered_map<std::string, Lru::iterator> index;
+        size_t bytes;
+    };
+
+    /**
+     * How long resp may be cached, 0 if it may not.
+     */
+    Clock::duration lifetimeOf(const objects::HttpResponse& resp, const bool authorized) const;
+    Shard& shardFor(const std::string& key);
+    static size_t sizeOf(const Entry& entry);
+
+    const size_t mMaxBytesPerShard;
+    const std::chrono::milliseconds mDefaultTtl;
+    std::vector<std::string> mVary; //lower cased
+    std::vector<Shard*> mShards;
+    std::atomic<size_t> mHits;
+    std::atomic<size_t> mMisses;
+};
+
+}
+}
@@ -0,0 +1,202 @@
+#include "tcp/ResponseCompressor.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+#include <zlib.h>
+
+#include "objects/HttpResponse.h"
+
+namespace c11http {
+   namespace tcp {
+
+      namespace {
+         const size_t CHUNK_SIZE = 16 * 1024;
+
+         std::string lowerCase(const std::string& value) {
+            std::string result(value);
+            std::transform(result.begin(), result.end(), result.begin(), ::tolower);
+            return result;
+         }
+
+         /**
+          * One thread's deflate state for a coding, reset rather than reallocated between responses.
+          */
+         class Deflater {
+         public:
+            Deflater() : mInitialized(false), mLevel(0) {
+               memset(&mStream, 0, sizeof(mStream));
+            }
+
+            ~Deflater() {
+               if(mInitialized) deflateEnd(&mStream);
+            }
+
+            /**
+             * Ready the stream for a new body, returning false if zlib could not be initialized.
+             */
+            bool begin(const int level, const int windowBits) {
+               if(mInitialized && level == mLevel) return Z_OK == deflateReset(&mStream);
+               if(mInitialized) deflateEnd(&mStream);
+               memset(&mStream, 0, sizeof(mStream));
+               mInitialized = Z_OK == deflateInit2(&mStream, level, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY);
+               mLevel = level;
+               return mInitialized;
+            }
+
+            z_stream& stream() {
+               return mStream;
+            }
+
+         private:
+            z_stream mStream;
+            bool mInitialized;
+            int mLevel;
+         };
+
+         /**
+          * Compress body, appending the output a chunk at a time to out.
+          */
+         bool deflateBody(const std::string& body, const ResponseCompressor::Coding coding, const int level,
+            std::string& out) {
+            //window bits of 15 + 16 write a gzip wrapper, 15 alone the zlib wrapper HTTP calls deflate
+            static thread_local Deflater gzipDeflater;
+            static thread_local Deflater deflateDeflater;
+            Deflater& deflater = (ResponseCompressor::GZIP == coding) ? gzipDeflater : deflateDeflater;
+            if(!deflater.begin(level, (ResponseCompressor::GZIP == coding) ? 15 + 16 : 15)) return false;
+
+            z_stream& stream = deflater.stream();
+            stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(body.data()));
+            stream.avail_in = body.size();
+            Bytef chunk[CHUNK_SIZE];
+            int result = Z_OK;
+            while(Z_OK == result) {
+               stream.next_out = chunk;
+               stream.avail_out = CHUNK_SIZE;
+               result = deflate(&stream, Z_FINISH);
+               out.append(reinterpret_cast<const char*>(chunk), CHUNK_SIZE - stream.avail_out);
+               //the input is exhausted in a single pass, so stop early once output outgrows it
+               if(out.size() >= body.size()) return false;
+            }
+            return Z_STREAM_END == result;
+         }
+      }
+
+      ResponseCompressor::ResponseCompressor(const size_t minimumBytes, const int level,
+         const std::vector<std::string>& types) : mMinimumBytes(minimumBytes), mLevel(level),
+         mTypes(types.empty() ? defaultTypes() : types), mCompressed(0), mBytesIn(0), mBytesOut(0) {
+         for(size_t i = 0; i < mTypes.size(); ++i) mTypes[i] = lowerCase(mTypes[i]);
+      }
+
+      ResponseCompressor::~ResponseCompressor() {
+
+      }
+
+      std::vector<std::string> ResponseCompressor::defaultTypes() {
+         std::vector<std::string> types;
+         types.push_back("text/");
+         types.push_back("application/json");
+         types.push_back("application/javascript");
+         types.push_back("application/xml");
+         types.push_back("image/svg+xml");
+         return types;
+      }
+
+      bool ResponseCompressor::acceptsCoding(const std::string& acceptEncoding, const std::string& coding) {
+         bool accepted = false;
+         size_t begin = 0;
+         while(begin < acceptEncoding.size()) {
+            size_t end = acceptEncoding.find(',', begin);
+            if(std::string::npos == end) end = acceptEncoding.size();
+            const std::string element = acceptEncoding.substr(begin, end - begin);
+            begin = end + 1;
+
+            const size_t nameBegin = element.find_first_not_of(" \t");
+            if(std::string::npos == nameBegin) continue;
+            const size_t nameEnd = std::min(element.find_first_of(" \t;", nameBegin), element.size());
+            const std::string name = lowerCase(element.substr(nameBegin, nameEnd - nameBegin));
+            if(name != coding && name != "*") continue;
+
+            double quality = 1.0;
+            const size_t q = element.find("q=", nameEnd);
+            if(std::string::npos != q) quality = strtod(element.c_str() + q + 2, 0);
+            //an exact match outranks *, whichever comes first
+            if(name == coding) return quality > 0.0;
+            accepted = quality > 0.0;
+         }
+         return accepted;
+      }
+
+      ResponseCompressor::Coding ResponseCompressor::negotiate(const std::string& acceptEncoding) const {
+         if(acceptEncoding.empty()) return IDENTITY;
+         if(acceptsCoding(acceptEncoding, "gzip")) return GZIP;
+         if(acceptsCoding(acceptEncoding, "deflate")) return DEFLATE;
+         return IDENTITY;
+      }
+
+      bool ResponseCompressor::isCompressibleType(const std::string& contentType) const {
+         const std::string type = lowerCase(contentType.substr(0, contentType.find(';')));
+         for(size_t i = 0; i < mTypes.size(); ++i) {
+            if('/' == mTypes[i][mTypes[i].size() - 1] ? 0 == type.compare(0, mTypes[i].size(), mTypes[i]) :
+               type == mTypes[i]) {
+               return true;
+            }
+         }
+         return false;
+      }
+
+      bool ResponseCompressor::isCompressible(const objects::HttpResponse& resp) const {
+         const unsigned int status = resp.getStatus();
+         if(status < 200 || 204 == status || 304 == status) return false;
+         if(resp.getBody().size() < mMinimumBytes || resp.hasHeader("content-encoding")) return false;
+         if(std::string::npos != lowerCase(resp.getHeader("cache-control")).find("no-transform")) return false;
+         return isCompressibleType(resp.getHeader("content-type"));
+      }
+
+      bool ResponseCompressor::compress(const objects::HttpResponse& resp, const Coding coding,
+         objects::HttpResponse& compressed) {
+         if(!isCompressible(resp)) return false;
+
+         std::string body;
+         const bool smaller = IDENTITY != coding && deflateBody(resp.getBody(), coding, mLevel, body);
+         compressed = objects::HttpResponse(resp.getStatus(), smaller ? body : resp.getBody());
+         const objects::HttpResponse::Headers& headers = resp.getHeaders();
+         for(objects::HttpResponse::Headers::const_iterator iter = headers.begin(); iter != headers.end(); ++iter) {
+            compressed.setHeader(iter->first, iter->second);
+         }
+
+         const std::string& vary = resp.getHeader("vary");
+         if(vary.empty()) {
+            compressed.setHeader("vary", "accept-encoding");
+         }
+         else if(std::string::npos == lowerCase(vary).find("accept-encoding") && "*" != vary) {
+            compressed.setHeader("vary", vary + ", accept-encoding");
+         }
+         if(smaller) {
+            compressed.setHeader("content-encoding", (GZIP == coding) ? "gzip" : "deflate");
+            //the encoded bytes are not the handler's, so a strong ETag no longer holds for them
+            const std::string& etag = resp.getHeader("etag");
+            if(!etag.empty() && 0 != etag.compare(0, 2, "W/")) compressed.setHeader("etag", "W/" + etag);
+            ++mCompressed;
+            mBytesIn += resp.getBody().size();
+            mBytesOut += body.size();
+         }
+         return true;
+      }
+
+      size_t ResponseCompressor::getCompressed() const {
+         return mCompressed;
+      }
+
+      size_t ResponseCompressor::getBytesIn() const {
+         return mBytesIn;
+      }
+
+      size_t ResponseCompressor::getBytesOut() const {
+         return mBytesOut;
+      }
+
+   }
+}
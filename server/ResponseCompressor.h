@@ -0,0 +1,78 @@
+#pragma once
+
+#include "tcp/Platform.h"
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace c11http {
+
+namespace objects {
+class HttpResponse;
+}
+
+namespace tcp {
+
+/**
+ * Compresses response bodies with gzip or deflate, as negotiated from a request's Accept-Encoding. Only bodies
+ * of at least minimumBytes with a compressible Content-Type are compressed, and only when that makes them smaller.
+ * Compression runs on the thread that produced the response, a worker for pooled handlers, streaming the body
+ * through deflate in fixed size output chunks. Each thread keeps its deflate state between responses, so a
+ * response costs a reset rather than a fresh allocation of the compressor's windows. Thread safe.
+ */
+class TCP_API ResponseCompressor {
+public:
+    enum Coding {
+        IDENTITY,
+        GZIP,
+        DEFLATE
+    };
+
+    /**
+     * level is the zlib compression level, 1-9. types are Content-Types to compress, an entry ending in '/'
+     * matching every subtype, e.g. "text/"; empty for text, JSON, JavaScript, XML and SVG.
+     */
+    ResponseCompressor(const size_t minimumBytes = 1024, const int level = 6,
+            const std::vector<std::string>& types = std::vector<std::string>());
+    ~ResponseCompressor();
+
+    /**
+     * Coding to answer a request with, gzip preferred over deflate, given its Accept-Encoding value.
+     */
+    Coding negotiate(const std::string& acceptEncoding) const;
+    /**
+     * Whether resp's body is worth compressing: large enough, of a compressible type, not already encoded, and
+     * without Cache-Control no-transform.
+     */
+    bool isCompressible(const objects::HttpResponse& resp) const;
+    /**
+     * Returns false, leaving compressed untouched, if resp is not compressible. Otherwise sets compressed to resp
+     * varying on Accept-Encoding, so caches keep codings apart, with its body encoded with coding if that makes
+     * it smaller. An encoded body's strong ETag is weakened.
+     */
+    bool compress(const objects::HttpResponse& resp, const Coding coding, objects::HttpResponse& compressed);
+
+    size_t getCompressed() const;
+    size_t getBytesIn() const;
+    size_t getBytesOut() const;
+
+    /**
+     * Whether an Accept-Encoding value accepts coding, i.e. lists it, or *, without q=0.
+     */
+    static bool acceptsCoding(const std::string& acceptEncoding, const std::string& coding);
+    static std::vector<std::string> defaultTypes();
+
+private:
+    bool isCompressibleType(const std::string& contentType) const;
+
+    const size_t mMinimumBytes;
+    const int mLevel;
+    std::vector<std::string> mTypes;
+    std::atomic<size_t> mCompressed;
+    std::atomic<size_t> mBytesIn;
+    std::atomic<size_t> mBytesOut;
+};
+
+}
+}
@@ -1,26 +1,214 @@
 #include "tcp/Server.h"
 
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "objects/HttpRequest.h"
+#include "objects/HttpRequestParser.h"
+#include "objects/HttpResponse.h"
+#include "objects/WebSocket.h"
+#include "tcp/ResponseCache.h"
+#include "tcp/ResponseCompressor.h"
+#include "workers/WorkerPool.h"
+
 #ifdef WINDOWS
 #include "tcp/windows/Server.h"
 #include "tcp/windows/Callback.h"
 #else
 #include "tcp/posix/Server.h"
 #include "tcp/posix/Callback.h"
+#include "tcp/posix/AssetArchive.h"
+#include "tcp/posix/Http2Connection.h"
+#include "tcp/posix/StaticFiles.h"
+#include "tcp/posix/Tls.h"
 #endif
 
 namespace c11http {
    namespace tcp {
 
+      /**
+       * Where a response belongs: the connection it answers, and its position among that connection's
+       * responses.
+       */
+      struct ResponseTicket {
+         unsigned long long handle;
+         unsigned long long sequence;
+         std::string identifier;
+         unsigned int stream; //HTTP/2 stream answered, 0 on an HTTP/1.1 connection, which answers in sequence
+      };
+
+      /**
+       * A handler answering requests whose target starts with prefix, and how it is run.
+       */
+      struct MountedHandler {
+         std::string prefix;
+         objects::HttpRequestToResponse handler;
+         Server::Dispatch dispatch;
+      };
+
 #ifdef WINDOWS
       class Server::PlatformCallback : public windows::Callback {
 #else
       class Server::PlatformCallback : public posix::Callback {
 #endif
       public:
-         PlatformCallback(Server* server) : mServer(server) 
+         PlatformCallback(Server* server, workers::WorkerPool* pool) : mServer(server), mPool(pool),
+            mLoadShedder(0)
          {
 
          }
+
+         void registerHandler(const std::string& prefix, const objects::HttpRequestToResponse& handler,
+            const Server::Dispatch dispatch)
+         {
+            if(Server::DISPATCH_POOLED == dispatch && 0 == mPool) {
+               throw(std::runtime_error("A WorkerPool is required for pooled dispatch"));
+            }
+            if(prefix.empty()) {
+               mAsyncHandler = objects::AsyncHttpRequestToResponse();
+            }
+            unmount(prefix);
+            MountedHandler mounted;
+            mounted.prefix = prefix;
+            mounted.handler = handler;
+            mounted.dispatch = dispatch;
+            //longest prefix first, so the first that matches is the most specific
+            std::vector<MountedHandler>::iterator iter = mHandlers.begin();
+            while(iter != mHandlers.end() && iter->prefix.size() >= prefix.size()) ++iter;
+            mHandlers.insert(iter, mounted);
+         }
+
+         void registerAsyncHandler(const objects::AsyncHttpRequestToResponse& handler)
+         {
+            mAsyncHandler = handler;
+            unmount("");
+         }
+
+         void unmount(const std::string& prefix)
+         {
+            for(std::vector<MountedHandler>::iterator iter = mHandlers.begin(); iter != mHandlers.end(); ++iter) {
+               if(iter->prefix == prefix) {
+                  mHandlers.erase(iter);
+                  return;
+               }
+            }
+         }
+
+         const MountedHandler* findHandler(const std::string& target) const
+         {
+            for(std::vector<MountedHandler>::const_iterator iter = mHandlers.begin(); iter != mHandlers.end(); ++iter) {
+               if(0 == target.compare(0, iter->prefix.size(), iter->prefix)) return &(*iter);
+            }
+            return 0;
+         }
+
+         void serveStaticFiles(const std::string& prefix, const std::string& root, const unsigned int maxOpenFiles,
+            const unsigned int revalidateMilliseconds)
+         {
+#ifdef WINDOWS
+            throw(std::runtime_error("Static files are not supported on this platform"));
+#else
+            mStaticPrefix = prefix;
+            mStaticFiles.reset(new posix::StaticFiles(root, maxOpenFiles, revalidateMilliseconds));
+#endif
+         }
+
+         void serveAssetArchive(const std::string& prefix, const std::string& archivePath)
+         {
+#ifdef WINDOWS
+            throw(std::runtime_error("Asset archives are not supported on this platform"));
+#else
+            mAssetPrefix = prefix;
+            mAssets.reset(new posix::AssetArchive(archivePath));
+#endif
+         }
+
+         void enableResponseCache(ResponseCache* cache)
+         {
+            mResponseCache.reset(cache);
+         }
+
+         ResponseCache* getResponseCache() const
+         {
+            return mResponseCache.get();
+         }
+
+         void enableCompression(ResponseCompressor* compressor)
+         {
+            mCompressor.reset(compressor);
+         }
+
+         void enableLoadShedding(const unsigned int targetMilliseconds, const unsigned int intervalMilliseconds,
+            const unsigned int retryAfterSeconds, const Server::RequestPredicate& isPriority)
+         {
+            if(0 == mPool) {
+               throw(std::runtime_error("A WorkerPool is required for load shedding"));
+            }
+            objects::HttpResponse overloaded(503, "");
+            overloaded.setHeader("Retry-After", std::to_string(retryAfterSeconds));
+            std::shared_ptr<std::string> response(new std::string());
+            overloaded.serialize(*response);
+            mOverloadResponse = response;
+            mPriority = isPriority;
+            mLoadShedder = &mPool->getLoadShedder();
+            mLoadShedder->configure(targetMilliseconds * 1000ULL, intervalMilliseconds * 1000ULL);
+         }
+
+         ResponseCompressor* getCompressor() const
+         {
+            return mCompressor.get();
+         }
+
+#ifndef WINDOWS
+         void enableHttp2(const posix::Http2Connection::Settings& settings)
+         {
+            mHttp2Settings.reset(new posix::Http2Connection::Settings(settings));
+         }
+#endif
+
+         void serveWebSockets(const std::string& prefix, const Server::WebSocketHandler& handler,
+            const size_t maxMessageSize)
+         {
+#ifdef WINDOWS
+            throw(std::runtime_error("WebSockets are not supported on this platform"));
+#else
+            mWebSocketPrefix = prefix;
+            mWebSocketParser = objects::WebSocketParser(maxMessageSize);
+            mWebSocketHandler = handler;
+#endif
+         }
+
+         void sendWebSocket(const std::string& identifier, const std::string& message, const bool binary)
+         {
+#ifndef WINDOWS
+            const posix::SharedRegion frame(serializeWebSocketFrame(message, binary));
+            PlatformCallback* callback = this;
+            runOnEventLoop([callback, identifier, frame]() {
+               callback->writeWebSocket(identifier, frame);
+            });
+#endif
+         }
+
+         void broadcastWebSocket(const std::string& message, const bool binary)
+         {
+#ifndef WINDOWS
+            //one frame for every connection, each queue holding a reference to it
+            const posix::SharedRegion frame(serializeWebSocketFrame(message, binary));
+            PlatformCallback* callback = this;
+            runOnEventLoop([callback, frame]() {
+               callback->writeWebSockets(frame);
+            });
+#endif
+         }
+
+         void publishWebSocket(const std::string& topic, const std::string& message, const bool binary);
+
+         workers::WorkerPool* getPool() const
+         {
+            return mPool;
+         }
          /**
          * A send to a connection has completed, with count bytes sent.
          */
@@ -40,8 +228,36 @@ namespace c11http {
          */
          virtual void receiveComplete(const std::string& identifier, const char* data, const unsigned int count)
          {
-            mServer->receiveComplete(identifier, data, count);
+            dispatch(0, identifier, data, count);
+         }
+#ifndef WINDOWS
+         /**
+         * A receive from a connection has completed, along with the handle to complete responses with.
+         */
+         virtual void receiveFromConnection(const posix::ConnectionHandle handle, const std::string& identifier,
+            const char* data, const unsigned int count)
+         {
+            dispatch(handle, identifier, data, count);
+         }
+         /**
+         * Everything queued on a connection has been sent, so an HTTP/2 connection can send more of its streams.
+         */
+         virtual void drained(const posix::ConnectionHandle handle, const std::string& identifier)
+         {
+            std::map<std::string, Http2Session>::iterator session = mHttp2.find(identifier);
+            if(session != mHttp2.end() && session->second.handle == handle) {
+               session->second.connection->drained();
+            }
+         }
+         /**
+         * Reading from a connection has been paused, or resumed, by its queued output.
+         */
+         virtual void readingPaused(const posix::ConnectionHandle handle, const std::string& identifier,
+            const bool paused)
+         {
+            mServer->backpressure(identifier, paused);
          }
+#endif
          /**
          * A connection has been established.
          */
@@ -54,10 +270,141 @@ namespace c11http {
          */
          virtual void disconnected(const std::string& connectedTo)
          {
-
+            mParsers.erase(connectedTo);
+#ifndef WINDOWS
+            mHttp2.erase(connectedTo);
+            mWebSockets.erase(connectedTo);
+#endif
          }
       private:
+#ifndef WINDOWS
+         /**
+          * The HTTP/2 side of a connection, and the handle of the connection it belongs to, as a client can
+          * reconnect under the same identifier before responses for the old connection are done.
+          */
+         struct Http2Session {
+            unsigned long long handle;
+            std::unique_ptr<posix::Http2Connection> connection;
+         };
+         /**
+          * A connection switched to the WebSocket protocol.
+          */
+         struct WebSocketSession {
+            unsigned long long handle;
+            objects::WebSocketParser parser;
+            bool closed; //a close has been sent, nothing more is sent or received
+         };
+#endif
+
+         /**
+          * Parse data received from a connection, and start a handler on each request it completes.
+          */
+         void dispatch(const unsigned long long handle, const std::string& identifier, const char* data,
+            const unsigned int count);
+         /**
+          * Parse data for a connection's HTTP/1.1 requests, returning false if it was malformed, which is
+          * answered here.
+          */
+         bool parse(const unsigned long long handle, const std::string& identifier, const char* data,
+            const unsigned int count, std::vector<objects::HttpRequest>& requests);
+         /**
+          * Start a handler on a request, or answer it from the cache, static files or archive.
+          */
+         void startRequest(const ResponseTicket& ticket, const objects::HttpRequest& req);
+         /**
+          * Queue a response for a request, on the connection in sequence or on its HTTP/2 stream. Safe to call
+          * from any thread.
+          */
+         void complete(const ResponseTicket& ticket, std::string& bytes);
+         void complete(const ResponseTicket& ticket, const ResponseCache::Buffer& buffer);
+#ifndef WINDOWS
+         void complete(const ResponseTicket& ticket, std::string& head, const posix::FileRegion& body);
+         void complete(const ResponseTicket& ticket, const posix::SharedRegion& region);
+         /**
+          * Answer an HTTP/2 stream on the thread in waitForEvents, where its connection is used.
+          */
+         void completeStream(const ResponseTicket& ticket, const posix::SharedRegion& response,
+            const posix::FileRegion& file);
+         void respondStream(const ResponseTicket& ticket, const posix::SharedRegion& response,
+            const posix::FileRegion& file);
+         Http2Session& startHttp2(const unsigned long long handle, const std::string& identifier);
+         /**
+          * Feed data to a connection's HTTP/2 side, starting a handler on each stream it completes.
+          */
+         void receiveHttp2(Http2Session& session, const std::string& identifier, const char* data,
+            const unsigned int count);
+         /**
+          * Switch a connection to HTTP/2 if req, its first request, asks to and HTTP/2 is enabled. Returns false
+          * if the connection stays on HTTP/1.1.
+          */
+         bool upgradeHttp2(const unsigned long long handle, const std::string& identifier,
+            const objects::HttpRequest& req);
+         /**
+          * Switch a connection to the WebSocket protocol if req, its first request, asks to and its target is
+          * served. Returns false if the connection stays on HTTP/1.1.
+          */
+         bool upgradeWebSocket(const ResponseTicket& ticket, const objects::HttpRequest& req);
+         /**
+          * Parse data received on a WebSocket connection, giving each message it completes to the handler and
+          * answering pings and closes.
+          */
+         void receiveWebSocket(WebSocketSession& session, const std::string& identifier, const char* data,
+            const unsigned int count);
+         /**
+          * Queue a frame on a WebSocket connection, or on every one, from the thread in waitForEvents.
+          */
+         void writeWebSocket(const std::string& identifier, const posix::SharedRegion& frame);
+         void writeWebSockets(const posix::SharedRegion& frame);
+         /**
+          * Run task on the thread in waitForEvents, now if called from it.
+          */
+         void runOnEventLoop(const std::function<void()>& task);
+         static posix::SharedBuffer serializeWebSocketFrame(const std::string& message, const bool binary);
+#endif
+         /**
+          * Send the response for a request, compressed with coding if compression is enabled and resp is
+          * compressible. Safe to call from any thread.
+          */
+         void respond(const ResponseTicket& ticket, const objects::HttpResponse& resp,
+            const ResponseCompressor::Coding coding = ResponseCompressor::IDENTITY);
+         /**
+          * Send the response for a request as respond does, caching it for key if it may be cached, authorized if
+          * the request carried Authorization. Safe to call from any thread.
+          */
+         void respondCaching(const ResponseTicket& ticket, const std::string& key, const bool authorized,
+            const ResponseCompressor::Coding coding, const objects::HttpResponse& resp);
+         /**
+          * Answer a request for a static file, returning false if the request is not for one.
+          */
+         bool serveStaticFile(const ResponseTicket& ticket, const objects::HttpRequest& req);
+         /**
+          * Answer a request for an archived asset, returning false if the archive does not hold it.
+          */
+         bool serveAsset(const ResponseTicket& ticket, const objects::HttpRequest& req);
+         bool hasStaticFiles() const;
+
          Server* mServer;
+         workers::WorkerPool* mPool;
+         std::vector<MountedHandler> mHandlers; //longest prefix first, the handler for every other target last
+         objects::AsyncHttpRequestToResponse mAsyncHandler;
+         Server::WebSocketHandler mWebSocketHandler;
+         std::map<std::string, objects::HttpRequestParser> mParsers; //per connection request parsers
+         std::unique_ptr<ResponseCache> mResponseCache;
+         std::unique_ptr<ResponseCompressor> mCompressor;
+         workers::LoadShedder* mLoadShedder; //while shedding load
+         Server::RequestPredicate mPriority;
+         ResponseCache::Buffer mOverloadResponse;
+#ifndef WINDOWS
+         std::string mStaticPrefix;
+         std::unique_ptr<posix::StaticFiles> mStaticFiles;
+         std::string mAssetPrefix;
+         std::unique_ptr<posix::AssetArchive> mAssets;
+         std::unique_ptr<posix::Http2Connection::Settings> mHttp2Settings; //set once HTTP/2 is enabled
+         std::map<std::string, Http2Session> mHttp2; //connections switched to HTTP/2
+         std::string mWebSocketPrefix;
+         objects::WebSocketParser mWebSocketParser; //copied for each connection switched to WebSockets
+         std::map<std::string, WebSocketSession> mWebSockets; //connections switched to WebSockets
+#endif
       };
 
       class Server::PlatformServer {
@@ -67,6 +414,7 @@ namespace c11http {
             mServer = new windows::Server(callback, port);
 #else
             mServer = new posix::Server(callback, port);
+            mHttp2 = false;
 #endif
          }
 
@@ -80,27 +428,695 @@ namespace c11http {
             mServer->send(data, count, identifier);
          }
 
+         ResponseTicket reserve(const unsigned long long handle, const std::string& identifier)
+         {
+            ResponseTicket ticket;
+            ticket.handle = handle;
+            ticket.identifier = identifier;
+            ticket.stream = 0;
+#ifdef WINDOWS
+            ticket.sequence = 0;
+#else
+            ticket.sequence = mServer->reserveSequence(handle);
+#endif
+            return ticket;
+         }
+
+         void complete(const ResponseTicket& ticket, std::string& bytes)
+         {
+#ifdef WINDOWS
+            try
+            {
+               mServer->send(bytes.c_str(), bytes.size(), ticket.identifier);
+            } catch (std::runtime_error&)
+            {
+               //connection closed while the response was being produced
+            }
+#else
+            mServer->complete(ticket.handle, ticket.sequence, bytes);
+#endif
+         }
+
+         void complete(const ResponseTicket& ticket, const ResponseCache::Buffer& buffer)
+         {
+#ifdef WINDOWS
+            std::string bytes(*buffer);
+            complete(ticket, bytes);
+#else
+            mServer->complete(ticket.handle, ticket.sequence, buffer);
+#endif
+         }
+
+#ifndef WINDOWS
+         void complete(const ResponseTicket& ticket, std::string& head, const posix::FileRegion& body)
+         {
+            mServer->complete(ticket.handle, ticket.sequence, head, body);
+         }
+
+         void complete(const ResponseTicket& ticket, const posix::SharedRegion& region)
+         {
+            mServer->complete(ticket.handle, ticket.sequence, region);
+         }
+
+         void write(const unsigned long long handle, std::string& bytes, const posix::SharedRegion& shared,
+            const posix::FileRegion& file)
+         {
+            mServer->write(handle, bytes, shared, file);
+         }
+
+         void fanOut(const unsigned long long handle, const posix::SharedRegion& message)
+         {
+            mServer->fanOut(handle, message);
+         }
+
+         bool isEventLoopThread() const
+         {
+            return mServer->isEventLoopThread();
+         }
+#endif
+
          void broadcast(const char* data, const unsigned int count)
          {
             mServer->broadcast(data, count);
          }
 
+#ifdef WINDOWS
+         void subscribe(const std::string& identifier, const std::string& topic)
+         {
+            throw(std::runtime_error("Topics are not supported on this platform"));
+         }
+
+         void unsubscribe(const std::string& identifier, const std::string& topic)
+         {
+            throw(std::runtime_error("Topics are not supported on this platform"));
+         }
+
+         void publish(const std::string& topic, const char* data, const unsigned int count)
+         {
+            throw(std::runtime_error("Topics are not supported on this platform"));
+         }
+#else
+         void subscribe(const std::string& identifier, const std::string& topic)
+         {
+            mServer->subscribe(identifier, topic);
+         }
+
+         void unsubscribe(const std::string& identifier, const std::string& topic)
+         {
+            mServer->unsubscribe(identifier, topic);
+         }
+
+         void publish(const std::string& topic, const char* data, const unsigned int count)
+         {
+            publish(topic, posix::SharedRegion(std::make_shared<const std::string>(data, count)));
+         }
+
+         void publish(const std::string& topic, const posix::SharedRegion& message)
+         {
+            mServer->publish(topic, message);
+         }
+#endif
+
+#ifdef WINDOWS
+         void enableTls(const std::string& certificateFile, const std::string& privateKeyFile, const bool kernelTls)
+         {
+            throw(std::runtime_error("TLS is not supported on this platform"));
+         }
+
+         void enableHttp2()
+         {
+            throw(std::runtime_error("HTTP/2 is not supported on this platform"));
+         }
+
+         void setOutputWatermarks(const size_t highWatermark, const size_t lowWatermark,
+            const Server::OverflowPolicy policy)
+         {
+            throw(std::runtime_error("Output watermarks are not supported on this platform"));
+         }
+#else
+         void enableTls(const std::string& certificateFile, const std::string& privateKeyFile, const bool kernelTls)
+         {
+            posix::TlsContext::Options options;
+            options.certificateFile = certificateFile;
+            options.privateKeyFile = privateKeyFile;
+            options.kernelTls = kernelTls;
+            mTls = std::make_shared<posix::TlsContext>(options);
+            offerHttp2();
+            mServer->setTlsContext(mTls);
+         }
+
+         void enableHttp2()
+         {
+            mHttp2 = true;
+            offerHttp2();
+         }
+
+         void setOutputWatermarks(const size_t highWatermark, const size_t lowWatermark,
+            const Server::OverflowPolicy policy)
+         {
+            posix::Server::OverflowPolicy overflow = posix::Server::DROP_NEWEST;
+            if(Server::DROP_OLDEST == policy) overflow = posix::Server::DROP_OLDEST;
+            else if(Server::DISCONNECT == policy) overflow = posix::Server::DISCONNECT;
+            mServer->setOutputWatermarks(highWatermark, lowWatermark, overflow);
+         }
+#endif
+
          void shutdown()
          {
             mServer->shutdown();
          }
 
+#ifdef WINDOWS
+         void post(const std::function<void()>& task)
+         {
+            throw(std::runtime_error("Posting tasks is not supported on this platform"));
+         }
+
+         void runAfter(const unsigned int milliseconds, const std::function<void()>& task)
+         {
+            throw(std::runtime_error("Timers are not supported on this platform"));
+         }
+#else
+         void post(const std::function<void()>& task)
+         {
+            mServer->post(task);
+         }
+
+         void runAfter(const unsigned int milliseconds, const std::function<void()>& task)
+         {
+            mServer->runAfter(milliseconds, task);
+         }
+#endif
+
       private:
 #ifdef WINDOWS
          windows::Server* mServer;
 #else
+         /**
+          * Let TLS clients choose HTTP/2 during their handshake, once both are enabled.
+          */
+         void offerHttp2()
+         {
+            if(mTls && mHttp2) {
+               std::vector<std::string> protocols;
+               protocols.push_back("h2");
+               protocols.push_back("http/1.1");
+               mTls->setApplicationProtocols(protocols);
+            }
+         }
+
          posix::Server* mServer;
+         std::shared_ptr<posix::TlsContext> mTls;
+         bool mHttp2;
 #endif
       };
 
-      Server::Server(const unsigned int port)
+      void Server::PlatformCallback::publishWebSocket(const std::string& topic, const std::string& message,
+         const bool binary)
+      {
+#ifdef WINDOWS
+         throw(std::runtime_error("WebSockets are not supported on this platform"));
+#else
+         mServer->mServer->publish(topic, posix::SharedRegion(serializeWebSocketFrame(message, binary)));
+#endif
+      }
+
+      void Server::PlatformCallback::dispatch(const unsigned long long handle, const std::string& identifier,
+         const char* data, const unsigned int count)
+      {
+         if(mHandlers.empty() && !mAsyncHandler && !mWebSocketHandler && !hasStaticFiles()) {
+            mServer->receiveComplete(identifier, data, count);
+            return;
+         }
+
+#ifndef WINDOWS
+         if(mHttp2Settings) {
+            std::map<std::string, Http2Session>::iterator session = mHttp2.find(identifier);
+            if(session != mHttp2.end()) {
+               receiveHttp2(session->second, identifier, data, count);
+               return;
+            }
+            //a client with prior knowledge, or that chose h2 through ALPN, starts with the preface
+            if(mParsers.end() == mParsers.find(identifier) && posix::Http2Connection::isPreface(data, count)) {
+               receiveHttp2(startHttp2(handle, identifier), identifier, data, count);
+               return;
+            }
+         }
+         std::map<std::string, WebSocketSession>::iterator socket = mWebSockets.find(identifier);
+         if(socket != mWebSockets.end()) {
+            receiveWebSocket(socket->second, identifier, data, count);
+            return;
+         }
+#endif
+
+         std::vector<objects::HttpRequest> requests;
+         if(!parse(handle, identifier, data, count, requests)) {
+            return;
+         }
+         while(!requests.empty())
+         {
+            for(std::vector<objects::HttpRequest>::iterator iter = requests.begin(); iter != requests.end(); ++iter)
+            {
+               //reserved in arrival order, so pipelined responses go out in order however they complete
+               const ResponseTicket ticket = mServer->mServer->reserve(handle, identifier);
+#ifndef WINDOWS
+               if(0 == ticket.sequence &&
+                  (upgradeHttp2(handle, identifier, *iter) || upgradeWebSocket(ticket, *iter))) {
+                  return;
+               }
+#endif
+               startRequest(ticket, *iter);
+            }
+
+            //parsing stops after a request asking to upgrade, what followed it is parsed once it was declined
+            if(!requests.back().hasHeader("upgrade")) break;
+            requests.clear();
+            if(!parse(handle, identifier, 0, 0, requests)) {
+               return;
+            }
+         }
+      }
+
+      bool Server::PlatformCallback::parse(const unsigned long long handle, const std::string& identifier,
+         const char* data, const unsigned int count, std::vector<objects::HttpRequest>& requests)
+      {
+         try
+         {
+            mParsers[identifier].parse(data, count, requests);
+         } catch (std::runtime_error&)
+         {
+            //malformed request, answer it and discard whatever was buffered for it
+            mParsers[identifier].reset();
+            respond(mServer->mServer->reserve(handle, identifier), objects::HttpResponse(400, ""));
+            return false;
+         }
+         return true;
+      }
+
+      void Server::PlatformCallback::startRequest(const ResponseTicket& ticket, const objects::HttpRequest& req)
+      {
+         if(serveAsset(ticket, req) || serveStaticFile(ticket, req)) {
+            return;
+         }
+
+         PlatformCallback* callback = this;
+         //compressed by whichever thread produces the response, a worker for pooled handlers
+         const ResponseCompressor::Coding coding = mCompressor ?
+            mCompressor->negotiate(req.getHeader("accept-encoding")) : ResponseCompressor::IDENTITY;
+         objects::HttpResponder responder = [callback, ticket, coding](const objects::HttpResponse& resp) {
+            callback->respond(ticket, resp, coding);
+         };
+         const std::string key = mResponseCache ? mResponseCache->keyFor(req) : std::string();
+         if(!key.empty()) {
+            //a hit queues the stored buffer itself, a miss stores what the handler produces
+            const ResponseCache::Buffer cached = mResponseCache->lookup(key);
+            if(cached) {
+               complete(ticket, cached);
+               return;
+            }
+            const bool authorized = req.hasHeader("authorization");
+            responder = [callback, ticket, key, authorized, coding](const objects::HttpResponse& resp) {
+               callback->respondCaching(ticket, key, authorized, coding, resp);
+            };
+         }
+
+         const MountedHandler* mounted = findHandler(req.getTarget());
+         if(0 == mounted && mAsyncHandler) {
+            mAsyncHandler(req, responder);
+         }
+         else if(0 == mounted) {
+            respond(ticket, objects::HttpResponse(404, ""));
+         }
+         else if(Server::DISPATCH_INLINE == mounted->dispatch) {
+            //already on the event loop, so the response can skip the worker hand off and wakeup
+            responder(mounted->handler(req));
+         }
+         else if(0 != mLoadShedder && !(mPriority && mPriority(req)) &&
+            mLoadShedder->isOverloaded(workers::LoadShedder::Clock::now())) {
+            //the queue is standing, so this would only be answered late, refuse it before it joins
+            mLoadShedder->recordShed();
+            complete(ticket, mOverloadResponse);
+         }
+         else {
+            mPool->addWork(workers::Worker::Work(req, mounted->handler, responder));
+         }
+      }
+
+      void Server::PlatformCallback::complete(const ResponseTicket& ticket, std::string& bytes)
+      {
+#ifndef WINDOWS
+         if(0 != ticket.stream) {
+            std::shared_ptr<std::string> response(new std::string());
+            response->swap(bytes);
+            completeStream(ticket, posix::SharedRegion(response), posix::FileRegion());
+            return;
+         }
+#endif
+         mServer->mServer->complete(ticket, bytes);
+      }
+
+      void Server::PlatformCallback::complete(const ResponseTicket& ticket, const ResponseCache::Buffer& buffer)
+      {
+#ifndef WINDOWS
+         if(0 != ticket.stream) {
+            completeStream(ticket, posix::SharedRegion(buffer), posix::FileRegion());
+            return;
+         }
+#endif
+         mServer->mServer->complete(ticket, buffer);
+      }
+
+#ifndef WINDOWS
+      void Server::PlatformCallback::complete(const ResponseTicket& ticket, std::string& head,
+         const posix::FileRegion& body)
+      {
+         if(0 != ticket.stream) {
+            std::shared_ptr<std::string> response(new std::string());
+            response->swap(head);
+            completeStream(ticket, posix::SharedRegion(response), body);
+            return;
+         }
+         mServer->mServer->complete(ticket, head, body);
+      }
+
+      void Server::PlatformCallback::complete(const ResponseTicket& ticket, const posix::SharedRegion& region)
+      {
+         if(0 != ticket.stream) {
+            completeStream(ticket, region, posix::FileRegion());
+            return;
+         }
+         mServer->mServer->complete(ticket, region);
+      }
+
+      void Server::PlatformCallback::completeStream(const ResponseTicket& ticket,
+         const posix::SharedRegion& response, const posix::FileRegion& file)
+      {
+         if(mServer->mServer->isEventLoopThread()) {
+            respondStream(ticket, response, file);
+            return;
+         }
+         PlatformCallback* callback = this;
+         mServer->mServer->post([callback, ticket, response, file]() {
+            callback->respondStream(ticket, response, file);
+         });
+      }
+
+      void Server::PlatformCallback::respondStream(const ResponseTicket& ticket,
+         const posix::SharedRegion& response, const posix::FileRegion& file)
+      {
+         //the connection may have closed while the response was produced
+         std::map<std::string, Http2Session>::iterator session = mHttp2.find(ticket.identifier);
+         if(session != mHttp2.end() && session->second.handle == ticket.handle) {
+            session->second.connection->respond(ticket.stream, response, file);
+         }
+      }
+
+      Server::PlatformCallback::Http2Session& Server::PlatformCallback::startHttp2(const unsigned long long handle,
+         const std::string& identifier)
+      {
+         PlatformServer* server = mServer->mServer;
+         Http2Session& session = mHttp2[identifier];
+         session.handle = handle;
+         session.connection.reset(new posix::Http2Connection([server, handle](std::string& bytes,
+            const posix::SharedRegion& shared, const posix::FileRegion& file) {
+               server->write(handle, bytes, shared, file);
+            }, *mHttp2Settings));
+         return session;
+      }
+
+      void Server::PlatformCallback::receiveHttp2(Http2Session& session, const std::string& identifier,
+         const char* data, const unsigned int count)
+      {
+         std::vector<posix::Http2Connection::Request> requests;
+         session.connection->receive(data, count, requests);
+
+         ResponseTicket ticket;
+         ticket.handle = session.handle;
+         ticket.sequence = 0;
+         ticket.identifier = identifier;
+         for(std::vector<posix::Http2Connection::Request>::iterator iter = requests.begin(); iter != requests.end();
+            ++iter)
+         {
+            ticket.stream = iter->stream;
+            startRequest(ticket, iter->request);
+         }
+      }
+
+      bool Server::PlatformCallback::upgradeHttp2(const unsigned long long handle, const std::string& identifier,
+         const objects::HttpRequest& req)
+      {
+         if(!mHttp2Settings || std::string::npos == req.getHeader("upgrade").find("h2c") ||
+            !req.hasHeader("http2-settings")) {
+            return false;
+         }
+
+         Http2Session& session = startHttp2(handle, identifier);
+         std::vector<posix::Http2Connection::Request> requests;
+         try
+         {
+            session.connection->upgrade(req, requests);
+         } catch (std::runtime_error&)
+         {
+            //answered over HTTP/1.1 instead
+            mHttp2.erase(identifier);
+            return false;
+         }
+         //the client's preface may have followed its request
+         const std::string pending(mParsers[identifier].takePending());
+         mParsers.erase(identifier);
+
+         ResponseTicket ticket;
+         ticket.handle = handle;
+         ticket.sequence = 0;
+         ticket.identifier = identifier;
+         ticket.stream = requests.front().stream;
+         startRequest(ticket, requests.front().request);
+         if(!pending.empty()) {
+            receiveHttp2(session, identifier, pending.data(), pending.size());
+         }
+         return true;
+      }
+
+      bool Server::PlatformCallback::upgradeWebSocket(const ResponseTicket& ticket, const objects::HttpRequest& req)
+      {
+         if(!mWebSocketHandler || 0 != req.getTarget().compare(0, mWebSocketPrefix.size(), mWebSocketPrefix) ||
+            !objects::WebSocket::isUpgrade(req)) {
+            return false;
+         }
+
+         //the first response on the connection, so it is queued at once, ahead of any frame
+         std::string bytes;
+         objects::WebSocket::accept(req).serialize(bytes);
+         complete(ticket, bytes);
+         //frames may have followed the request
+         const std::string pending(mParsers[ticket.identifier].takePending());
+         mParsers.erase(ticket.identifier);
+
+         WebSocketSession& session = mWebSockets[ticket.identifier];
+         session.handle = ticket.handle;
+         session.parser = mWebSocketParser;
+         session.closed = false;
+         if(!pending.empty()) {
+            receiveWebSocket(session, ticket.identifier, pending.data(), pending.size());
+         }
+         return true;
+      }
+
+      void Server::PlatformCallback::receiveWebSocket(WebSocketSession& session, const std::string& identifier,
+         const char* data, const unsigned int count)
       {
-         mCallback = new PlatformCallback(this);
+         if(session.closed) {
+            return;
+         }
+
+         std::vector<objects::WebSocketParser::Message> messages;
+         std::string failure;
+         try
+         {
+            session.parser.parse(data, count, messages);
+         } catch (std::runtime_error& e)
+         {
+            //messages completed before the error are still delivered
+            failure = e.what();
+         }
+
+         std::string replies;
+         for(std::vector<objects::WebSocketParser::Message>::iterator iter = messages.begin();
+            iter != messages.end() && !session.closed; ++iter)
+         {
+            switch(iter->opcode) {
+            case objects::WebSocket::TEXT:
+            case objects::WebSocket::BINARY:
+               mWebSocketHandler(identifier, iter->payload, objects::WebSocket::BINARY == iter->opcode);
+               break;
+            case objects::WebSocket::PING:
+               objects::WebSocket::serializeFrame(objects::WebSocket::PONG, iter->payload.data(),
+                  iter->payload.size(), replies);
+               break;
+            case objects::WebSocket::CLOSE:
+               //returned with the client's code, the client then closes the connection
+               objects::WebSocket::serializeFrame(objects::WebSocket::CLOSE, iter->payload.data(),
+                  std::min<size_t>(2, iter->payload.size()), replies);
+               session.closed = true;
+               break;
+            default:
+               break;
+            }
+         }
+         if(!failure.empty() && !session.closed) {
+            objects::WebSocket::serializeClose(session.parser.getCloseCode(), replies, failure);
+            session.closed = true;
+         }
+         if(!replies.empty()) {
+            mServer->mServer->write(session.handle, replies, posix::SharedRegion(), posix::FileRegion());
+         }
+      }
+
+      void Server::PlatformCallback::writeWebSocket(const std::string& identifier, const posix::SharedRegion& frame)
+      {
+         //the connection may have closed since the message was sent
+         std::map<std::string, WebSocketSession>::iterator session = mWebSockets.find(identifier);
+         if(session != mWebSockets.end() && !session->second.closed) {
+            std::string none;
+            mServer->mServer->write(session->second.handle, none, frame, posix::FileRegion());
+         }
+      }
+
+      void Server::PlatformCallback::writeWebSockets(const posix::SharedRegion& frame)
+      {
+         for(std::map<std::string, WebSocketSession>::iterator session = mWebSockets.begin();
+            session != mWebSockets.end(); ++session)
+         {
+            if(!session->second.closed) {
+               mServer->mServer->fanOut(session->second.handle, frame);
+            }
+         }
+      }
+
+      void Server::PlatformCallback::runOnEventLoop(const std::function<void()>& task)
+      {
+         if(mServer->mServer->isEventLoopThread()) {
+            task();
+         }
+         else {
+            mServer->mServer->post(task);
+         }
+      }
+
+      posix::SharedBuffer Server::PlatformCallback::serializeWebSocketFrame(const std::string& message,
+         const bool binary)
+      {
+         std::shared_ptr<std::string> frame(new std::string());
+         objects::WebSocket::serializeFrame(binary ? objects::WebSocket::BINARY : objects::WebSocket::TEXT,
+            message.data(), message.size(), *frame);
+         return frame;
+      }
+#endif
+
+      void Server::PlatformCallback::respond(const ResponseTicket& ticket, const objects::HttpResponse& resp,
+         const ResponseCompressor::Coding coding)
+      {
+         objects::HttpResponse compressed;
+         const bool encoded = mCompressor && mCompressor->compress(resp, coding, compressed);
+         std::string bytes;
+         (encoded ? compressed : resp).serialize(bytes);
+         complete(ticket, bytes);
+      }
+
+      void Server::PlatformCallback::respondCaching(const ResponseTicket& ticket, const std::string& key,
+         const bool authorized, const ResponseCompressor::Coding coding, const objects::HttpResponse& resp)
+      {
+         objects::HttpResponse compressed;
+         const bool encoded = mCompressor && mCompressor->compress(resp, coding, compressed);
+         complete(ticket, mResponseCache->store(key, encoded ? compressed : resp, authorized));
+      }
+
+      bool Server::PlatformCallback::hasStaticFiles() const
+      {
+#ifdef WINDOWS
+         return false;
+#else
+         return 0 != mStaticFiles.get() || 0 != mAssets.get();
+#endif
+      }
+
+      bool Server::PlatformCallback::serveAsset(const ResponseTicket& ticket, const objects::HttpRequest& req)
+      {
+#ifdef WINDOWS
+         return false;
+#else
+         const std::string& target = req.getTarget();
+         if(!mAssets || objects::HttpRequest::GET != req.getRequestMethod() ||
+            0 != target.compare(0, mAssetPrefix.size(), mAssetPrefix)) {
+            return false;
+         }
+
+         const size_t end = std::min(target.find_first_of("?#"), target.size());
+         posix::AssetArchive::Asset asset;
+         if(!mAssets->find(target.data() + mAssetPrefix.size(), end - mAssetPrefix.size(), asset)) {
+            return false;
+         }
+
+         //compared weakly, by the quoted tag alone, as the stored ETag is weak
+         const std::string& validator = req.getHeader("if-none-match");
+         const std::string etag(asset.etag, asset.etagLength);
+         if(!validator.empty() && (validator == "*" ||
+            std::string::npos != validator.find(etag.substr(std::min(etag.find('"'), etag.size()))))) {
+            complete(ticket,
+               posix::SharedRegion(mAssets->getOwner(), asset.notModified, asset.notModifiedLength));
+            return true;
+         }
+
+         posix::AssetArchive::Coding coding = posix::AssetArchive::IDENTITY;
+         const std::string& acceptEncoding = req.getHeader("accept-encoding");
+         if(0 != asset.responseLengths[posix::AssetArchive::BROTLI] &&
+            ResponseCompressor::acceptsCoding(acceptEncoding, "br")) {
+            coding = posix::AssetArchive::BROTLI;
+         }
+         else if(0 != asset.responseLengths[posix::AssetArchive::GZIP] &&
+            ResponseCompressor::acceptsCoding(acceptEncoding, "gzip")) {
+            coding = posix::AssetArchive::GZIP;
+         }
+         complete(ticket,
+            posix::SharedRegion(mAssets->getOwner(), asset.responses[coding], asset.responseLengths[coding]));
+         return true;
+#endif
+      }
+
+      bool Server::PlatformCallback::serveStaticFile(const ResponseTicket& ticket, const objects::HttpRequest& req)
+      {
+#ifdef WINDOWS
+         return false;
+#else
+         if(!mStaticFiles || objects::HttpRequest::GET != req.getRequestMethod() ||
+            0 != req.getTarget().compare(0, mStaticPrefix.size(), mStaticPrefix)) {
+            return false;
+         }
+
+         std::shared_ptr<const posix::StaticFiles::File> file =
+            mStaticFiles->find(req.getTarget().substr(mStaticPrefix.size()));
+         if(!file) {
+            respond(ticket, objects::HttpResponse(404, ""));
+            return true;
+         }
+
+         //the heads were serialized when the file was opened, only the body's file range is handed on
+         const std::string& validator = req.getHeader("if-none-match");
+         if(!validator.empty() && (validator == "*" || std::string::npos != validator.find(file->etag))) {
+            std::string head(file->notModified);
+            complete(ticket, head, posix::FileRegion());
+         }
+         else {
+            std::string head(file->head);
+            complete(ticket, head, file->body);
+         }
+         return true;
+#endif
+      }
+
+      Server::Server(const unsigned int port, workers::WorkerPool* pool)
+      {
+         mCallback = new PlatformCallback(this, pool);
          mServer = new PlatformServer(mCallback, port);
       }
 
@@ -113,6 +1129,95 @@ namespace c11http {
          mCallback = 0;
       }
 
+      void Server::registerHandler(const objects::HttpRequestToResponse& handler, const Dispatch dispatch) {
+         mCallback->registerHandler("", handler, dispatch);
+      }
+      void Server::registerHandler(const std::string& prefix, const objects::HttpRequestToResponse& handler,
+         const Dispatch dispatch) {
+         mCallback->registerHandler(prefix, handler, dispatch);
+      }
+      void Server::registerAsyncHandler(const objects::AsyncHttpRequestToResponse& handler) {
+         mCallback->registerAsyncHandler(handler);
+      }
+      void Server::serveStaticFiles(const std::string& prefix, const std::string& root,
+         const unsigned int maxOpenFiles, const unsigned int revalidateMilliseconds) {
+         mCallback->serveStaticFiles(prefix, root, maxOpenFiles, revalidateMilliseconds);
+      }
+      void Server::serveAssetArchive(const std::string& prefix, const std::string& archivePath) {
+         mCallback->serveAssetArchive(prefix, archivePath);
+      }
+      void Server::enableResponseCache(const size_t maxBytes, const unsigned int defaultTtlMilliseconds,
+         const std::vector<std::string>& vary, const size_t shards) {
+         mCallback->enableResponseCache(new ResponseCache(maxBytes, defaultTtlMilliseconds, vary, shards));
+      }
+      ResponseCache* Server::getResponseCache() const {
+         return mCallback->getResponseCache();
+      }
+      void Server::enableCompression(const size_t minimumBytes, const int level,
+         const std::vector<std::string>& types) {
+         mCallback->enableCompression(new ResponseCompressor(minimumBytes, level, types));
+      }
+      ResponseCompressor* Server::getCompressor() const {
+         return mCallback->getCompressor();
+      }
+      void Server::enableLoadShedding(const unsigned int targetMilliseconds, const unsigned int intervalMilliseconds,
+         const unsigned int retryAfterSeconds, const RequestPredicate& isPriority) {
+         mCallback->enableLoadShedding(targetMilliseconds, intervalMilliseconds, retryAfterSeconds, isPriority);
+      }
+      void Server::enableTls(const std::string& certificateFile, const std::string& privateKeyFile,
+         const bool kernelTls) {
+         mServer->enableTls(certificateFile, privateKeyFile, kernelTls);
+      }
+      void Server::enableHttp2(const unsigned int maxConcurrentStreams, const unsigned int initialWindowSize) {
+         //throws where HTTP/2 is not supported, before anything is changed
+         mServer->enableHttp2();
+#ifndef WINDOWS
+         posix::Http2Connection::Settings settings;
+         settings.maxConcurrentStreams = maxConcurrentStreams;
+         settings.initialWindowSize = initialWindowSize;
+         mCallback->enableHttp2(settings);
+#endif
+      }
+      void Server::serveWebSockets(const std::string& prefix, const WebSocketHandler& handler,
+         const size_t maxMessageSize) {
+         mCallback->serveWebSockets(prefix, handler, maxMessageSize);
+      }
+      void Server::sendWebSocket(const std::string& identifier, const std::string& message, const bool binary) {
+         mCallback->sendWebSocket(identifier, message, binary);
+      }
+      void Server::broadcastWebSocket(const std::string& message, const bool binary) {
+         mCallback->broadcastWebSocket(message, binary);
+      }
+      void Server::publishWebSocket(const std::string& topic, const std::string& message, const bool binary) {
+         mCallback->publishWebSocket(topic, message, binary);
+      }
+      void Server::setOutputWatermarks(const size_t highWatermark, const size_t lowWatermark,
+         const OverflowPolicy policy) {
+         mServer->setOutputWatermarks(highWatermark, lowWatermark, policy);
+      }
+      void Server::post(const std::function<void()>& task) {
+         mServer->post(task);
+      }
+      void Server::runAfter(const unsigned int milliseconds, const std::function<void()>& task) {
+         mServer->runAfter(milliseconds, task);
+      }
+      void Server::offload(const std::function<void()>& work, const std::function<void()>& continuation) {
+         workers::WorkerPool* pool = mCallback->getPool();
+         if(0 == pool) throw(std::runtime_error("A WorkerPool is required to offload work"));
+         PlatformServer* server = mServer;
+         objects::HttpRequestToResponse task = [work, continuation, server](objects::HttpRequest) -> objects::HttpResponse {
+            work();
+            server->post(continuation);
+            return objects::HttpResponse();
+         };
+         pool->addWork(workers::Worker::Work(objects::HttpRequest(), task, objects::HttpResponder()));
+      }
+      void Server::receiveComplete(const std::string& identifier, const char* data, const unsigned int count) {
+
+      }
+      void Server::backpressure(const std::string& identifier, const bool paused) {
+
+      }
       void Server::waitForEvents() {
          mServer->waitForEvents();
       }
@@ -122,6 +1227,15 @@ namespace c11http {
       void Server::broadcast(const char* data, const unsigned int count) {
          mServer->broadcast(data, count);
       }
+      void Server::subscribe(const std::string& identifier, const std::string& topic) {
+         mServer->subscribe(identifier, topic);
+      }
+      void Server::unsubscribe(const std::string& identifier, const std::string& topic) {
+         mServer->unsubscribe(identifier, topic);
+      }
+      void Server::publish(const std::string& topic, const char* data, const unsigned int count) {
+         mServer->publish(topic, data, count);
+      }
       void Server::shutdown() {
          mServer->shutdown();
       }
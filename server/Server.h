@@ -2,20 +2,203 @@
 
 #include "tcp/Platform.h"
 
+#include "objects/HttpRequestToResponse.h"
+
+#include <string>
+#include <vector>
+
 namespace c11http {
+
+namespace workers {
+class WorkerPool;
+}
+
 namespace tcp {
 
+class ResponseCache;
+class ResponseCompressor;
+
 /**
  * Generic implementation of a server. Receives data from a platform implementation (posix/winsock) and then
  * passes that information along to a worker.
  */
 class TCP_API Server {
 public:
+    /**
+     * How a registered handler is run once a request has been parsed.
+     */
+    enum Dispatch {
+        /**
+         * The handler is given to the WorkerPool, and its response is sent once a worker has produced it.
+         */
+        DISPATCH_POOLED,
+        /**
+         * The handler runs to completion on the thread in waitForEvents that parsed the request, and its
+         * response is queued directly on the connection. Only for handlers that never block.
+         */
+        DISPATCH_INLINE
+    };
+    /**
+     * What becomes of a broadcast or published message that would take a connection's queued output past its high
+     * watermark.
+     */
+    enum OverflowPolicy {
+        /**
+         * The message is not queued on that connection.
+         */
+        DROP_NEWEST,
+        /**
+         * Broadcast and published messages queued on that connection before it, and not yet begun, are dropped,
+         * oldest first, to make room for it.
+         */
+        DROP_OLDEST,
+        /**
+         * The connection is closed.
+         */
+        DISCONNECT
+    };
+
     /**
      * Create a server listening on the specified port, notifying users of events with the specified callback.
+     * Handlers registered with DISPATCH_POOLED are run by pool.
+     */
+    Server(const unsigned int port, workers::WorkerPool* pool = 0);
+    virtual ~Server();
+
+    /**
+     * Parse data received from connections as HTTP requests, answering each with handler, run as dispatch, unless
+     * a handler is registered for a prefix of its target. Once a handler is registered, receiveComplete is no
+     * longer called.
+     */
+    void registerHandler(const objects::HttpRequestToResponse& handler, const Dispatch dispatch = DISPATCH_POOLED);
+    /**
+     * Answer requests whose target starts with prefix with handler, run as dispatch, rather than with the handler
+     * registered for every other request, e.g. an inline "/health" next to a pooled Router::handler(). The longest
+     * prefix registered wins. Registering a prefix again replaces its handler.
+     */
+    void registerHandler(const std::string& prefix, const objects::HttpRequestToResponse& handler,
+            const Dispatch dispatch = DISPATCH_POOLED);
+    /**
+     * Parse data received from connections as HTTP requests, starting each with handler on the thread in
+     * waitForEvents. The handler must not block: it starts its work (timers, client calls, offloads) and returns,
+     * and the response is sent when the responder is called. No thread is held while a request is in flight.
+     */
+    void registerAsyncHandler(const objects::AsyncHttpRequestToResponse& handler);
+    /**
+     * Serve GET requests whose target starts with prefix from the files below root, e.g. prefix "/static/" and
+     * root "/var/www" map "/static/app.js" to "/var/www/app.js". Files are sent straight from the page cache to
+     * the socket with sendfile, and kept open between requests, at most maxOpenFiles of them, along with
+     * precomputed response heads. An open file is checked for changes once revalidateMilliseconds have passed.
+     * Requests for missing files get a 404, others go to the registered handler. Files are served on the thread
+     * in waitForEvents.
+     */
+    void serveStaticFiles(const std::string& prefix, const std::string& root, const unsigned int maxOpenFiles = 1024,
+            const unsigned int revalidateMilliseconds = 1000);
+    /**
+     * Serve GET requests whose target starts with prefix from an archive packed by AssetArchive::pack, e.g. prefix
+     * "/assets" and an archive holding "/app.js" answer "/assets/app.js". Each request gets the br, gzip or
+     * identity response its Accept-Encoding allows, or a 304 if its If-None-Match holds the asset's ETag, written
+     * straight from the mapped archive. Requests for assets not in the archive go on to static files, if served,
+     * and then to the registered handler. Throws if the archive cannot be mapped.
+     */
+    void serveAssetArchive(const std::string& prefix, const std::string& archivePath);
+    /**
+     * Answer repeated GET requests from a cache of the responses the registered handler produced for them,
+     * without running the handler again. See ResponseCache for what is cached and for how long.
+     */
+    void enableResponseCache(const size_t maxBytes, const unsigned int defaultTtlMilliseconds = 0,
+            const std::vector<std::string>& vary = std::vector<std::string>(), const size_t shards = 16);
+    ResponseCache* getResponseCache() const;
+    /**
+     * Compress the registered handler's responses with gzip or deflate when a request's Accept-Encoding allows
+     * it, for bodies of at least minimumBytes of one of types. See ResponseCompressor. Compressed responses vary
+     * on Accept-Encoding, so a response cache only keeps them if it was enabled to vary on accept-encoding.
+     */
+    void enableCompression(const size_t minimumBytes = 1024, const int level = 6,
+            const std::vector<std::string>& types = std::vector<std::string>());
+    ResponseCompressor* getCompressor() const;
+    /**
+     * Accept only TLS connections from now on, presenting the PEM certificate chain in certificateFile with the
+     * private key in privateKeyFile. Handshakes are driven by waitForEvents without blocking it, and returning
+     * clients resume their sessions from a cache shared by every connection. With kernelTls, sessions the kernel
+     * can encrypt are handed to it once their handshake completes, so responses and static files are written and
+     * sent as on a plain connection. Throws if the certificate or key can not be loaded.
+     */
+    void enableTls(const std::string& certificateFile, const std::string& privateKeyFile,
+            const bool kernelTls = false);
+    /**
+     * Serve HTTP/2 alongside HTTP/1.1, to clients that start with its connection preface, knowing to from ALPN
+     * when TLS is enabled or from prior knowledge, and to those whose first request asks to upgrade to h2c. The
+     * requests of a connection's streams are answered as HTTP/1.1 requests are, by the same handler, dispatch,
+     * cache, compression, static files and archive, and their responses are sent as each completes, interleaved
+     * over the one connection. A client opens at most maxConcurrentStreams streams at once, each with a receive
+     * window of initialWindowSize. Response bodies are held back by the client's windows, and by how much is
+     * still queued on its connection, so a slow client holds only a bounded amount of output.
      */
-    Server(const unsigned int port);
-    ~Server();
+    void enableHttp2(const unsigned int maxConcurrentStreams = 256,
+            const unsigned int initialWindowSize = 1024 * 1024);
+    /**
+     * Picks out requests that must not be refused.
+     */
+    typedef std::function<bool(const objects::HttpRequest& request)> RequestPredicate;
+    /**
+     * Refuse requests for pooled handlers while the WorkerPool is overloaded, rather than accepting them all and
+     * answering every one late: once every piece of work taken from its queues during an interval of
+     * intervalMilliseconds waited more than targetMilliseconds, new requests are answered straight away from the
+     * thread in waitForEvents with a 503 carrying retryAfterSeconds in Retry-After, serialized once here. Requests
+     * isPriority accepts are always queued, as are those answered without the pool. See workers::LoadShedder.
+     * Throws if the server has no WorkerPool.
+     */
+    void enableLoadShedding(const unsigned int targetMilliseconds = 5, const unsigned int intervalMilliseconds = 100,
+            const unsigned int retryAfterSeconds = 1, const RequestPredicate& isPriority = RequestPredicate());
+    /**
+     * Bound the output queued on each connection. Once more than highWatermark bytes are queued on a connection it
+     * is no longer read from, so it sends no more requests, and backpressure is called; once its output drains to
+     * lowWatermark it is read from again. Broadcast, published and WebSocket broadcast messages that would take a
+     * connection past highWatermark are handled by policy. Must be called before waitForEvents.
+     */
+    void setOutputWatermarks(const size_t highWatermark, const size_t lowWatermark,
+            const OverflowPolicy policy = DROP_NEWEST);
+    /**
+     * A message received on a WebSocket connection: text, or binary if binary is set.
+     */
+    typedef std::function<void(const std::string& identifier, const std::string& message, const bool binary)>
+            WebSocketHandler;
+    /**
+     * Accept WebSocket upgrades of requests whose target starts with prefix, when they are a connection's first
+     * request. handler is given every message received on those connections, on the thread in waitForEvents, and
+     * must not block. Pings are answered, and a close is returned, without involving handler. Connections sending a
+     * message larger than maxMessageSize, or breaking the protocol, are sent a close with the reason.
+     */
+    void serveWebSockets(const std::string& prefix, const WebSocketHandler& handler,
+            const size_t maxMessageSize = 1024 * 1024);
+    /**
+     * Send a message to a WebSocket connection. Safe to call from any thread.
+     */
+    void sendWebSocket(const std::string& identifier, const std::string& message, const bool binary = false);
+    /**
+     * Send a message to every WebSocket connection. Its frame is serialized once, and that one buffer is queued on
+     * every connection, never copied. Safe to call from any thread.
+     */
+    void broadcastWebSocket(const std::string& message, const bool binary = false);
+    /**
+     * Send a message to every WebSocket connection subscribed to topic, its frame serialized once and shared as
+     * for broadcastWebSocket. Safe to call from any thread.
+     */
+    void publishWebSocket(const std::string& topic, const std::string& message, const bool binary = false);
+    /**
+     * Run task on the thread in waitForEvents. Safe to call from any thread, e.g. to continue an asynchronous
+     * handler from a client callback.
+     */
+    void post(const std::function<void()>& task);
+    /**
+     * Run task on the thread in waitForEvents once milliseconds have elapsed. Must be called from that thread.
+     */
+    void runAfter(const unsigned int milliseconds, const std::function<void()>& task);
+    /**
+     * Run blocking work on the WorkerPool, then run continuation on the thread in waitForEvents.
+     */
+    void offload(const std::function<void()>& work, const std::function<void()>& continuation);
 
     /**
      * Blocks the current thread, waiting until an event occurs. Events include connection attempts, sending/receiving
@@ -23,19 +206,38 @@ public:
      */
     void waitForEvents();
     /**
-     * Send a message to a specific connection, as indicated by the identifier.
+     * Send a message to a specific connection, as indicated by the identifier. Safe to call from any thread. The
+     * message counts against the high watermark, see setOutputWatermarks.
      */
     void send(const char* data, const unsigned int count, const std::string& identifier);
     /**
-     * Send a message to all connections.
+     * Send a message to all connections. It is copied once, into a buffer every connection's queue refers to.
      */
     void broadcast(const char* data, const unsigned int count);
+    /**
+     * Add a connection to the subscribers of topic, until it is unsubscribed or closes. Safe to call from any thread.
+     */
+    void subscribe(const std::string& identifier, const std::string& topic);
+    void unsubscribe(const std::string& identifier, const std::string& topic);
+    /**
+     * Send a message to every connection subscribed to topic, copied once as for broadcast. Safe to call from any
+     * thread.
+     */
+    void publish(const std::string& topic, const char* data, const unsigned int count);
     /**
      * Shutdown this server, closing all connections.
      */
     void shutdown();
 
-    virtual void receiveComplete(const std::string& identifier, const char* data, const unsigned int count) = 0;
+    /**
+     * Raw data has been received from a connection. Only called when no handler has been registered.
+     */
+    virtual void receiveComplete(const std::string& identifier, const char* data, const unsigned int count);
+    /**
+     * Reading from a connection has been paused, as its queued output passed the high watermark, or resumed, as it
+     * drained to the low one. Called on the thread in waitForEvents.
+     */
+    virtual void backpressure(const std::string& identifier, const bool paused);
 
 private:
 
@@ -0,0 +1,405 @@
+#ifndef WINDOWS
+#include "tcp/posix/AssetArchive.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#include <zlib.h>
+#ifdef HAVE_BROTLI
+#include <brotli/encode.h>
+#endif
+
+#include "tcp/posix/StaticFiles.h"
+
+namespace c11http {
+namespace tcp {
+namespace posix {
+
+namespace
+{
+
+const char MAGIC[8] = { 'C', '1', '1', 'H', 'A', 'R', 'C', '1' };
+
+/**
+ * Start of an archive, followed by the hash index slots, the asset records, and the bytes they refer to. Offsets
+ * are from the start of the archive.
+ */
+struct ArchiveHeader
+{
+    char magic[8];
+    uint64_t assetCount;
+    uint64_t slotCount; //power of two, each slot holding a record index + 1, or 0 if empty
+    uint64_t slotsOffset;
+    uint64_t recordsOffset;
+    uint64_t length;
+};
+
+struct ArchiveRecord
+{
+    uint64_t hash;
+    uint64_t pathOffset;
+    uint64_t pathLength;
+    uint64_t etagOffset;
+    uint64_t etagLength;
+    uint64_t notModifiedOffset;
+    uint64_t notModifiedLength;
+    uint64_t responseOffsets[AssetArchive::CODINGS];
+    uint64_t responseLengths[AssetArchive::CODINGS];
+};
+
+/**
+ * FNV-1a, cheap enough to run on every lookup.
+ */
+uint64_t hashPath(const char* path, const size_t length)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < length; ++i)
+    {
+        hash ^= static_cast<unsigned char>(path[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+struct Unmapper
+{
+    explicit Unmapper(const size_t length)
+            : mLength(length)
+    {
+    }
+    void operator()(const void* base) const
+    {
+        ::munmap(const_cast<void*>(base), mLength);
+    }
+    size_t mLength;
+};
+
+std::string systemError(const std::string& what, const std::string& path)
+{
+    std::stringstream sstr;
+    sstr << what << " " << path << ": " << strerror(errno);
+    return sstr.str();
+}
+
+/**
+ * Collect the regular files below directory, as pairs of request path and file system path.
+ */
+void collectFiles(const std::string& directory, const std::string& prefix,
+        std::vector<std::pair<std::string, std::string> >& files) throw (std::runtime_error)
+{
+    DIR* dir = ::opendir(directory.c_str());
+    if (0 == dir)
+        throw(std::runtime_error(systemError("Failed to open directory", directory)));
+
+    while (struct dirent* entry = ::readdir(dir))
+    {
+        const std::string name(entry->d_name);
+        if ("." == name || ".." == name)
+            continue;
+
+        const std::string path = directory + "/" + name;
+        struct stat info;
+        if (-1 == ::stat(path.c_str(), &info))
+            continue;
+        if (S_ISDIR(info.st_mode))
+            collectFiles(path, prefix + name + "/", files);
+        else if (S_ISREG(info.st_mode))
+            files.push_back(std::make_pair(prefix + name, path));
+    }
+    ::closedir(dir);
+}
+
+std::string readFile(const std::string& path) throw (std::runtime_error)
+{
+    std::ifstream in(path.c_str(), std::ios::binary);
+    if (!in)
+        throw(std::runtime_error(systemError("Failed to read", path)));
+    std::stringstream contents;
+    contents << in.rdbuf();
+    return contents.str();
+}
+
+bool gzipCompress(const std::string& input, const int level, std::string& output)
+{
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    //window bits of 15 + 16 write a gzip wrapper rather than a zlib one
+    if (Z_OK != deflateInit2(&stream, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY))
+        return false;
+
+    output.resize(deflateBound(&stream, input.size()) + 32);
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    stream.avail_in = input.size();
+    stream.next_out = reinterpret_cast<Bytef*>(&output[0]);
+    stream.avail_out = output.size();
+    const int result = deflate(&stream, Z_FINISH);
+    output.resize(stream.total_out);
+    deflateEnd(&stream);
+    return Z_STREAM_END == result;
+}
+
+bool brotliCompress(const std::string& input, const int quality, std::string& output)
+{
+#ifdef HAVE_BROTLI
+    size_t length = BrotliEncoderMaxCompressedSize(input.size());
+    if (0 == length)
+        return false;
+    output.resize(length);
+    if (!BrotliEncoderCompress(quality, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_GENERIC, input.size(),
+            reinterpret_cast<const uint8_t*>(input.data()), &length, reinterpret_cast<uint8_t*>(&output[0])))
+        return false;
+    output.resize(length);
+    return true;
+#else
+    return false;
+#endif
+}
+
+}
+
+AssetArchive::PackOptions::PackOptions()
+        : gzipLevel(9), brotliQuality(11), minimumSavings(0.05)
+{
+
+}
+
+AssetArchive::AssetArchive(const std::string& path) throw (std::runtime_error)
+        : mBase(0), mLength(0)
+{
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (-1 == fd)
+        throw(std::runtime_error(systemError("Failed to open asset archive", path)));
+
+    struct stat info;
+    if (-1 == ::fstat(fd, &info))
+    {
+        ::close(fd);
+        throw(std::runtime_error(systemError("Failed to stat asset archive", path)));
+    }
+    mLength = info.st_size;
+    void* base = (mLength > 0) ? ::mmap(0, mLength, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    if (MAP_FAILED == base)
+        throw(std::runtime_error(systemError("Failed to map asset archive", path)));
+    mMapping.reset(base, Unmapper(mLength));
+    mBase = static_cast<const char*>(base);
+
+    //everything the index refers to must lie within the mapping, so lookups need no further checks
+    const ArchiveHeader* header = reinterpret_cast<const ArchiveHeader*>(mBase);
+    if (mLength < sizeof(ArchiveHeader) || 0 != memcmp(header->magic, MAGIC, sizeof(MAGIC))
+            || header->length != mLength || 0 == header->slotCount
+            || 0 != (header->slotCount & (header->slotCount - 1))
+            || header->slotsOffset + header->slotCount * sizeof(uint64_t) > mLength
+            || header->recordsOffset + header->assetCount * sizeof(ArchiveRecord) > mLength)
+        throw(std::runtime_error("Not a valid asset archive: " + path));
+
+    const uint64_t* slots = reinterpret_cast<const uint64_t*>(mBase + header->slotsOffset);
+    for (uint64_t i = 0; i < header->slotCount; ++i)
+    {
+        if (slots[i] > header->assetCount)
+            throw(std::runtime_error("Corrupt asset archive index: " + path));
+    }
+    const ArchiveRecord* records = reinterpret_cast<const ArchiveRecord*>(mBase + header->recordsOffset);
+    for (uint64_t i = 0; i < header->assetCount; ++i)
+    {
+        bool valid = records[i].pathOffset + records[i].pathLength <= mLength
+                && records[i].etagOffset + records[i].etagLength <= mLength
+                && records[i].notModifiedOffset + records[i].notModifiedLength <= mLength;
+        for (int coding = 0; coding < CODINGS; ++coding)
+            valid = valid && records[i].responseOffsets[coding] + records[i].responseLengths[coding] <= mLength;
+        if (!valid)
+            throw(std::runtime_error("Corrupt asset archive record: " + path));
+    }
+}
+
+AssetArchive::~AssetArchive()
+{
+
+}
+
+size_t AssetArchive::size() const
+{
+    return reinterpret_cast<const ArchiveHeader*>(mBase)->assetCount;
+}
+
+const std::shared_ptr<const void>& AssetArchive::getOwner() const
+{
+    return mMapping;
+}
+
+bool AssetArchive::find(const char* path, const size_t length, Asset& asset) const
+{
+    const ArchiveHeader* header = reinterpret_cast<const ArchiveHeader*>(mBase);
+    const uint64_t* slots = reinterpret_cast<const uint64_t*>(mBase + header->slotsOffset);
+    const ArchiveRecord* records = reinterpret_cast<const ArchiveRecord*>(mBase + header->recordsOffset);
+
+    //linear probing, the table is kept at most half full
+    const uint64_t hash = hashPath(path, length);
+    const uint64_t mask = header->slotCount - 1;
+    for (uint64_t probe = 0, slot = hash & mask; probe < header->slotCount; ++probe, slot = (slot + 1) & mask)
+    {
+        if (0 == slots[slot])
+            return false;
+
+        const ArchiveRecord& record = records[slots[slot] - 1];
+        if (record.hash != hash || record.pathLength != length
+                || 0 != memcmp(mBase + record.pathOffset, path, length))
+            continue;
+
+        asset.etag = mBase + record.etagOffset;
+        asset.etagLength = record.etagLength;
+        asset.notModified = mBase + record.notModifiedOffset;
+        asset.notModifiedLength = record.notModifiedLength;
+        for (int coding = 0; coding < CODINGS; ++coding)
+        {
+            asset.responses[coding] = mBase + record.responseOffsets[coding];
+            asset.responseLengths[coding] = record.responseLengths[coding];
+        }
+        return true;
+    }
+    return false;
+}
+
+size_t AssetArchive::pack(const std::string& directory, const std::string& path, const PackOptions& options)
+        throw (std::runtime_error)
+{
+    std::vector<std::pair<std::string, std::string> > files;
+    collectFiles(directory, "/", files);
+    std::sort(files.begin(), files.end());
+
+    //records are built with offsets into blob, made absolute once the layout is known
+    std::vector<ArchiveRecord> records;
+    std::vector<std::string> paths;
+    std::string blob;
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        const std::string contents = readFile(files[i].second);
+        ArchiveRecord record;
+        memset(&record, 0, sizeof(record));
+
+        //weak, as the codings stored share it while their bytes differ
+        std::stringstream etag;
+        etag << "W/\"" << std::hex << hashPath(contents.data(), contents.size()) << '"';
+        record.etagOffset = blob.size();
+        record.etagLength = etag.str().size();
+        blob.append(etag.str());
+
+        std::stringstream validators;
+        validators << "etag: " << etag.str() << "\r\n" << "vary: accept-encoding\r\n";
+        const std::string notModified = "HTTP/1.1 304 Not Modified\r\n" + validators.str() + "\r\n";
+        record.notModifiedOffset = blob.size();
+        record.notModifiedLength = notModified.size();
+        blob.append(notModified);
+
+        std::string encoded[CODINGS];
+        bool stored[CODINGS] = { true, false, false };
+        const size_t worthwhile = static_cast<size_t>(contents.size() * (1.0 - options.minimumSavings));
+        stored[GZIP] = gzipCompress(contents, options.gzipLevel, encoded[GZIP]) && encoded[GZIP].size() < worthwhile;
+        stored[BROTLI] = brotliCompress(contents, options.brotliQuality, encoded[BROTLI])
+                && encoded[BROTLI].size() < worthwhile;
+        const char* codingNames[CODINGS] = { 0, "gzip", "br" };
+
+        for (int coding = 0; coding < CODINGS; ++coding)
+        {
+            if (!stored[coding])
+                continue;
+            const std::string& body = (IDENTITY == coding) ? contents : encoded[coding];
+            std::stringstream head;
+            head << "HTTP/1.1 200 OK\r\n" << "content-length: " << body.size() << "\r\n" << "content-type: "
+                    << StaticFiles::contentType(files[i].first) << "\r\n";
+            if (0 != codingNames[coding])
+                head << "content-encoding: " << codingNames[coding] << "\r\n";
+            head << validators.str() << "\r\n";
+
+            //head and body side by side, so a response is a single region
+            record.responseOffsets[coding] = blob.size();
+            record.responseLengths[coding] = head.str().size() + body.size();
+            blob.append(head.str());
+            blob.append(body);
+        }
+
+        records.push_back(record);
+        paths.push_back(files[i].first);
+
+        //a directory's index is also found under the directory itself
+        const std::string index("index.html");
+        if (files[i].first.size() >= index.size()
+                && 0 == files[i].first.compare(files[i].first.size() - index.size(), index.size(), index)
+                && '/' == files[i].first[files[i].first.size() - index.size() - 1])
+        {
+            records.push_back(record);
+            paths.push_back(files[i].first.substr(0, files[i].first.size() - index.size()));
+        }
+    }
+
+    for (size_t i = 0; i < records.size(); ++i)
+    {
+        records[i].hash = hashPath(paths[i].data(), paths[i].size());
+        records[i].pathOffset = blob.size();
+        records[i].pathLength = paths[i].size();
+        blob.append(paths[i]);
+    }
+
+    ArchiveHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.assetCount = records.size();
+    header.slotCount = 1;
+    while (header.slotCount < 2 * records.size())
+        header.slotCount <<= 1;
+    header.slotsOffset = sizeof(ArchiveHeader);
+    header.recordsOffset = header.slotsOffset + header.slotCount * sizeof(uint64_t);
+    const uint64_t blobOffset = header.recordsOffset + records.size() * sizeof(ArchiveRecord);
+    header.length = blobOffset + blob.size();
+
+    std::vector<uint64_t> slots(header.slotCount, 0);
+    for (size_t i = 0; i < records.size(); ++i)
+    {
+        records[i].pathOffset += blobOffset;
+        records[i].etagOffset += blobOffset;
+        records[i].notModifiedOffset += blobOffset;
+        for (int coding = 0; coding < CODINGS; ++coding)
+        {
+            if (records[i].responseLengths[coding] > 0)
+                records[i].responseOffsets[coding] += blobOffset;
+        }
+
+        uint64_t slot = records[i].hash & (header.slotCount - 1);
+        while (0 != slots[slot])
+            slot = (slot + 1) & (header.slotCount - 1);
+        slots[slot] = i + 1;
+    }
+
+    const std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary.c_str(), std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(&slots[0]), slots.size() * sizeof(uint64_t));
+        if (!records.empty())
+            out.write(reinterpret_cast<const char*>(&records[0]), records.size() * sizeof(ArchiveRecord));
+        out.write(blob.data(), blob.size());
+        if (!out)
+            throw(std::runtime_error(systemError("Failed to write asset archive", temporary)));
+    }
+    if (-1 == ::rename(temporary.c_str(), path.c_str()))
+        throw(std::runtime_error(systemError("Failed to replace asset archive", path)));
+    return records.size();
+}
+
+}
+}
+}
+
+#endif
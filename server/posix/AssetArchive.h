@@ -0,0 +1,89 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "tcp/posix/Platform.h"
+#include "tcp/posix/posix.h"
+
+namespace c11http {
+namespace tcp {
+namespace posix {
+
+/**
+ * A directory of static assets packed into one file, memory mapped when served. Every asset is stored as complete
+ * responses, head and body side by side: identity, gzip and, when built with brotli, br, each only if it saves
+ * space. The heads carry a weak content hash ETag, shared by every coding, and a 304 head is stored alongside. Answering a request is then a
+ * lookup in a hash index inside the mapping, which allocates nothing, and a write straight from the page cache;
+ * nothing is opened, read or compressed per request or at startup.
+ *
+ * A directory containing index.html is also indexed under its path ending in '/'. Paths are matched as they are
+ * stored, without percent decoding. Archives use the byte order of the machine that packed them.
+ */
+class TCP_POSIX_API AssetArchive
+{
+public:
+    enum Coding
+    {
+        IDENTITY,
+        GZIP,
+        BROTLI,
+        CODINGS
+    };
+
+    /**
+     * Where an asset's responses are in the mapping. Lengths are 0 for codings that were not stored.
+     */
+    struct Asset
+    {
+        const char* etag;
+        size_t etagLength;
+        const char* notModified; //304 head
+        size_t notModifiedLength;
+        const char* responses[CODINGS]; //200 head and body
+        size_t responseLengths[CODINGS];
+    };
+
+    struct PackOptions
+    {
+        PackOptions();
+        int gzipLevel;
+        int brotliQuality;
+        double minimumSavings; //fraction of the identity size an encoding must save to be stored
+    };
+
+    /**
+     * Map an archive, throwing if it cannot be read or is not an archive.
+     */
+    explicit AssetArchive(const std::string& path) throw (std::runtime_error);
+    ~AssetArchive();
+
+    /**
+     * Find the asset stored for path, e.g. "/js/app.js". Returns false if there is none.
+     */
+    bool find(const char* path, const size_t length, Asset& asset) const;
+    size_t size() const;
+    /**
+     * Keeps the mapping alive, e.g. for a SharedRegion of one of its responses still being sent.
+     */
+    const std::shared_ptr<const void>& getOwner() const;
+
+    /**
+     * Pack the files below directory into an archive at path, returning the number of assets packed. The archive
+     * is written beside path and renamed into place, so a server mapping the old archive is never disturbed.
+     */
+    static size_t pack(const std::string& directory, const std::string& path,
+            const PackOptions& options = PackOptions()) throw (std::runtime_error);
+
+private:
+    AssetArchive(const AssetArchive&);
+    AssetArchive& operator=(const AssetArchive&);
+
+    std::shared_ptr<const void> mMapping;
+    const char* mBase;
+    size_t mLength;
+};
+
+}
+}
+}
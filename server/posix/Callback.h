@@ -3,6 +3,7 @@
 #include <string>
 
 #include "tcp/posix/Platform.h"
+#include "tcp/posix/posix.h"
 
 namespace c11http {
 namespace tcp {
@@ -36,6 +37,32 @@ public:
      */
     virtual void receiveComplete(const std::string& identifier,
             const char* data, const unsigned int count) = 0;
+    /**
+     * A receive from a connection has completed, also providing the handle used to complete responses
+     * on that connection. Defaults to receiveComplete.
+     */
+    virtual void receiveFromConnection(const ConnectionHandle handle,
+            const std::string& identifier, const char* data,
+            const unsigned int count)
+    {
+        receiveComplete(identifier, data, count);
+    }
+    /**
+     * Everything queued on a connection has been written to its socket. Called on the thread in waitForEvents,
+     * which may queue more.
+     */
+    virtual void drained(const ConnectionHandle handle,
+            const std::string& identifier)
+    {
+    }
+    /**
+     * Reading from a connection has been paused, as its queued output passed the server's high watermark, or
+     * resumed, as it drained to the low one.
+     */
+    virtual void readingPaused(const ConnectionHandle handle,
+            const std::string& identifier, const bool paused)
+    {
+    }
     /**
      * A connection has been established.
      */
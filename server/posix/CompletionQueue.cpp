@@ -0,0 +1,42 @@
+#ifndef WINDOWS
+#include "tcp/posix/CompletionQueue.h"
+
+namespace c11http {
+namespace tcp {
+namespace posix {
+
+CompletionQueue::CompletionQueue()
+{
+
+}
+
+CompletionQueue::~CompletionQueue()
+{
+
+}
+
+bool CompletionQueue::push(Completion& completion)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    const bool wasEmpty = mCompletions.empty();
+    mCompletions.push_back(Completion());
+    //take the bytes rather than copying them
+    mCompletions.back().handle = completion.handle;
+    mCompletions.back().sequence = completion.sequence;
+    mCompletions.back().bytes.swap(completion.bytes);
+    mCompletions.back().shared = completion.shared;
+    mCompletions.back().file = completion.file;
+    return wasEmpty;
+}
+
+void CompletionQueue::drain(std::vector<Completion>& batch)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    batch.swap(mCompletions);
+}
+
+}
+}
+}
+
+#endif
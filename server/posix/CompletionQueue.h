@@ -0,0 +1,55 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "tcp/posix/Platform.h"
+#include "tcp/posix/posix.h"
+#include "tcp/posix/FileRegion.h"
+
+namespace c11http {
+namespace tcp {
+namespace posix {
+
+/**
+ * A finished response, tagged with the connection it belongs to and its position among that connection's
+ * responses. The response is its bytes, followed by the shared region and the file range if they are set.
+ */
+struct Completion
+{
+    ConnectionHandle handle;
+    unsigned long long sequence;
+    std::string bytes;
+    SharedRegion shared;
+    FileRegion file;
+};
+
+/**
+ * Queue of finished responses, pushed by any thread and drained in batches by the thread running the
+ * server's event loop. One queue exists per event loop.
+ */
+class TCP_POSIX_API CompletionQueue
+{
+public:
+    CompletionQueue();
+    ~CompletionQueue();
+
+    /**
+     * Add a completion, returning true if the queue was empty. Only the push that makes the queue non-empty
+     * needs to wake the event loop, later pushes are picked up by the same drain.
+     */
+    bool push(Completion& completion);
+    /**
+     * Move every queued completion into batch.
+     */
+    void drain(std::vector<Completion>& batch);
+
+private:
+    std::vector<Completion> mCompletions;
+    std::mutex mMutex;
+};
+
+}
+}
+}
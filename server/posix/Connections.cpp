@@ -23,20 +23,30 @@ Connections::Connections(fd_set& _read)
 void Connections::addServerConnection(ServerConnection* client)
 {
     mContainer.push_back(client);
-    mMapping[client->getIdentifier()] = client;
+    if (client->isOpen())
+        mMapping[client->getIdentifier()] = client;
+    mHandles[client->getHandle()] = client;
     mFdMax = std::max(mFdMax, client->getSocket());
     FD_SET(client->getSocket(), &mRead);
 }
 
+void Connections::identified(ServerConnection* client)
+{
+    mMapping[client->getIdentifier()] = client;
+}
+
 void Connections::removeServerConnection(const int sckt)
 {
     FD_CLR(sckt, &mRead);
-    std::vector<ServerConnection*>::iterator iter = std::remove_if(
+    //find_if, not remove_if: remove_if leaves unspecified values past its result
+    std::vector<ServerConnection*>::iterator iter = std::find_if(
             mContainer.begin(), mContainer.end(), ServerConnectionFinder(sckt));
 
     if (iter != mContainer.end())
     {
-        mMapping.erase((*iter)->getIdentifier());
+        if ((*iter)->isOpen())
+            mMapping.erase((*iter)->getIdentifier());
+        mHandles.erase((*iter)->getHandle());
         delete (*iter);
 
         mContainer.erase(iter);
@@ -50,6 +60,14 @@ void Connections::removeServerConnection(const int sckt)
     }
 }
 
+void Connections::setReading(const int sckt, const bool reading)
+{
+    if (reading)
+        FD_SET(sckt, &mRead);
+    else
+        FD_CLR(sckt, &mRead);
+}
+
 Connections::~Connections()
 {
     clear();
@@ -72,6 +90,13 @@ ServerConnection* Connections::getServerConnection(const int sckt)
     return 0;
 }
 
+ServerConnection* Connections::findServerConnection(const ConnectionHandle handle)
+{
+    std::unordered_map<ConnectionHandle, ServerConnection*>::iterator iter =
+            mHandles.find(handle);
+    return (iter == mHandles.end()) ? 0 : iter->second;
+}
+
 ServerConnection* Connections::getServerConnection(
         const std::string& identifier) throw (std::runtime_error)
 {
@@ -91,6 +116,8 @@ void Connections::clear()
     }
 
     mContainer.clear();
+    mMapping.clear();
+    mHandles.clear();
 }
 
 int Connections::getMax() const
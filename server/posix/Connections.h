@@ -1,6 +1,7 @@
 #pragma once
 
 #include <map>
+#include <unordered_map>
 #include <vector>
 
 #include "tcp/posix/Platform.h"
@@ -36,8 +37,19 @@ public:
     Connections(fd_set& read);
     ~Connections();
 
+    /**
+     * Add a connection, found by its identifier once it is open.
+     */
     void addServerConnection(ServerConnection* client);
+    /**
+     * A connection added before it was open has identified itself.
+     */
+    void identified(ServerConnection* client);
     void removeServerConnection(const int sckt);
+    /**
+     * Stop selecting a connection for reads, or start again.
+     */
+    void setReading(const int sckt, const bool reading);
     void clear();
     /**
      * Retrieve a server connection by the identifier associated with the connection.
@@ -48,6 +60,10 @@ public:
      * Retrieve a server connection by the file descriptor utilized by the connection.
      */
     ServerConnection* getServerConnection(const int sckt);
+    /**
+     * Retrieve a server connection by its handle, returning 0 if it has been closed.
+     */
+    ServerConnection* findServerConnection(const ConnectionHandle handle);
     std::vector<ServerConnection*>& getConnections();
 
     int getMax() const;
@@ -55,6 +71,7 @@ public:
 private:
     std::vector<ServerConnection*> mContainer;
     std::map<std::string, ServerConnection*> mMapping;
+    std::unordered_map<ConnectionHandle, ServerConnection*> mHandles;
     fd_set& mRead;
     int mFdMax;
 };
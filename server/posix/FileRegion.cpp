@@ -0,0 +1,30 @@
+#ifndef WINDOWS
+#include "tcp/posix/FileRegion.h"
+
+#include <unistd.h>
+
+namespace c11http {
+namespace tcp {
+namespace posix {
+
+OpenFile::OpenFile(const int fd)
+        : mDescriptor(fd)
+{
+
+}
+
+OpenFile::~OpenFile()
+{
+    ::close(mDescriptor);
+}
+
+int OpenFile::getDescriptor() const
+{
+    return mDescriptor;
+}
+
+}
+}
+}
+
+#endif
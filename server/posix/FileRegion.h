@@ -0,0 +1,47 @@
+#pragma once
+
+#include <memory>
+
+#include "tcp/posix/Platform.h"
+#include "tcp/posix/posix.h"
+
+namespace c11http {
+namespace tcp {
+namespace posix {
+
+/**
+ * An open file descriptor, closed once nothing refers to it. Shared between a cache and the connections
+ * sending from it, so a file dropped from the cache is not closed while it is still being sent.
+ */
+class TCP_POSIX_API OpenFile
+{
+public:
+    explicit OpenFile(const int fd);
+    ~OpenFile();
+
+    int getDescriptor() const;
+
+private:
+    OpenFile(const OpenFile&);
+    OpenFile& operator=(const OpenFile&);
+
+    int mDescriptor;
+};
+
+/**
+ * Range of an open file sent after a response's bytes, straight from the file to the socket.
+ */
+struct FileRegion
+{
+    FileRegion()
+            : offset(0), length(0)
+    {
+    }
+    std::shared_ptr<const OpenFile> file;
+    unsigned long long offset;
+    size_t length;
+};
+
+}
+}
+}
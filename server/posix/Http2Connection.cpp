@@ -0,0 +1,853 @@
+#ifndef WINDOWS
+#include "tcp/posix/Http2Connection.h"
+
+#include <string.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+#include "objects/HttpResponse.h"
+
+namespace c11http {
+namespace tcp {
+namespace posix {
+
+namespace {
+const char PREFACE[] = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+const size_t PREFACE_SIZE = sizeof(PREFACE) - 1;
+const char CRLF[] = "\r\n";
+const size_t FRAME_HEADER_SIZE = 9;
+//the largest frame the client may send, as no other size is advertised
+const size_t MAX_FRAME_SIZE = 16384;
+const unsigned int DEFAULT_WINDOW = 65535;
+const long long MAX_WINDOW = 0x7fffffff;
+
+enum FrameType
+{
+    DATA = 0x0,
+    HEADERS = 0x1,
+    PRIORITY = 0x2,
+    RST_STREAM = 0x3,
+    SETTINGS = 0x4,
+    PUSH_PROMISE = 0x5,
+    PING = 0x6,
+    GOAWAY = 0x7,
+    WINDOW_UPDATE = 0x8,
+    CONTINUATION = 0x9
+};
+
+const unsigned char FLAG_END_STREAM = 0x1;
+const unsigned char FLAG_ACK = 0x1;
+const unsigned char FLAG_END_HEADERS = 0x4;
+const unsigned char FLAG_PADDED = 0x8;
+const unsigned char FLAG_PRIORITY = 0x20;
+
+enum ErrorCode
+{
+    NO_ERROR = 0x0,
+    PROTOCOL_ERROR = 0x1,
+    FLOW_CONTROL_ERROR = 0x3,
+    STREAM_CLOSED = 0x5,
+    FRAME_SIZE_ERROR = 0x6,
+    REFUSED_STREAM = 0x7,
+    COMPRESSION_ERROR = 0x9,
+    ENHANCE_YOUR_CALM = 0xb
+};
+
+enum SettingId
+{
+    HEADER_TABLE_SIZE = 0x1,
+    ENABLE_PUSH = 0x2,
+    MAX_CONCURRENT_STREAMS = 0x3,
+    INITIAL_WINDOW_SIZE = 0x4,
+    MAX_FRAME_SIZE_SETTING = 0x5,
+    MAX_HEADER_LIST_SIZE = 0x6
+};
+
+unsigned int read32(const char* data)
+{
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    return (static_cast<unsigned int>(bytes[0]) << 24) | (bytes[1] << 16) | (bytes[2] << 8) | bytes[3];
+}
+
+void write32(const unsigned int value, std::string& out)
+{
+    out.push_back(static_cast<char>(value >> 24));
+    out.push_back(static_cast<char>(value >> 16));
+    out.push_back(static_cast<char>(value >> 8));
+    out.push_back(static_cast<char>(value));
+}
+
+/**
+ * HTTP2-Settings is base64url without padding, RFC 4648 section 5.
+ */
+std::string decodeBase64Url(const std::string& encoded) throw (std::runtime_error)
+{
+    std::string decoded;
+    unsigned int bits = 0;
+    int count = 0;
+    for (std::string::const_iterator iter = encoded.begin(); iter != encoded.end(); ++iter)
+    {
+        const char c = *iter;
+        int value = 0;
+        if (c >= 'A' && c <= 'Z')
+            value = c - 'A';
+        else if (c >= 'a' && c <= 'z')
+            value = c - 'a' + 26;
+        else if (c >= '0' && c <= '9')
+            value = c - '0' + 52;
+        else if (c == '-' || c == '+')
+            value = 62;
+        else if (c == '_' || c == '/')
+            value = 63;
+        else if (c == '=')
+            break;
+        else
+            throw(std::runtime_error("Invalid HTTP2-Settings"));
+        bits = (bits << 6) | value;
+        count += 6;
+        if (count >= 8)
+        {
+            count -= 8;
+            decoded.push_back(static_cast<char>(bits >> count));
+        }
+    }
+    return decoded;
+}
+
+/**
+ * Fields that only mean something to a single HTTP/1.1 connection, never sent over HTTP/2.
+ */
+bool connectionSpecific(const std::string& name)
+{
+    return name == "connection" || name == "keep-alive" || name == "proxy-connection"
+            || name == "transfer-encoding" || name == "upgrade";
+}
+}
+
+Http2Connection::Settings::Settings()
+        : maxConcurrentStreams(256), initialWindowSize(1024 * 1024), connectionWindowSize(16 * 1024 * 1024),
+          maxHeaderListSize(64 * 1024), outputBudget(256 * 1024), maxRequestBody(1024 * 1024)
+{
+}
+
+Http2Connection::Stream::Stream()
+        : sendWindow(DEFAULT_WINDOW), unacknowledged(0), remoteClosed(false), responding(false), refused(false),
+          ready(false)
+{
+}
+
+Http2Connection::Http2Connection(const Writer& writer, const Settings& settings)
+        : mWriter(writer), mSettings(settings), mDecoder(4096, settings.maxHeaderListSize), mHeaderStream(0),
+          mHeaderEndStream(false), mLastStream(0), mPrefaceSent(false), mPrefaceReceived(false),
+          mSettingsReceived(false), mClosed(false), mGoingAway(false), mConnectionSendWindow(DEFAULT_WINDOW),
+          mConnectionUnacknowledged(0), mPeerInitialWindow(DEFAULT_WINDOW), mPeerMaxFrameSize(MAX_FRAME_SIZE),
+          mBudgetUsed(0)
+{
+}
+
+Http2Connection::~Http2Connection()
+{
+}
+
+void Http2Connection::receive(const char* data, const size_t length, std::vector<Request>& requests)
+{
+    if (mClosed)
+        return;
+    sendPreface();
+    mInput.append(data, length);
+
+    size_t consumed = 0;
+    if (!mPrefaceReceived)
+    {
+        if (0 != memcmp(mInput.data(), PREFACE, std::min(mInput.size(), PREFACE_SIZE)))
+        {
+            goAway(PROTOCOL_ERROR);
+        }
+        else if (mInput.size() >= PREFACE_SIZE)
+        {
+            consumed = PREFACE_SIZE;
+            mPrefaceReceived = true;
+        }
+    }
+
+    while (mPrefaceReceived && !mClosed && mInput.size() - consumed >= FRAME_HEADER_SIZE)
+    {
+        const unsigned char* header = reinterpret_cast<const unsigned char*>(mInput.data() + consumed);
+        const size_t frameLength = (header[0] << 16) | (header[1] << 8) | header[2];
+        if (frameLength > MAX_FRAME_SIZE)
+        {
+            goAway(FRAME_SIZE_ERROR);
+            break;
+        }
+        if (mInput.size() - consumed < FRAME_HEADER_SIZE + frameLength)
+            break;
+
+        const unsigned int stream = read32(mInput.data() + consumed + 5) & 0x7fffffff;
+        const char* payload = mInput.data() + consumed + FRAME_HEADER_SIZE;
+        consumed += FRAME_HEADER_SIZE + frameLength;
+        handleFrame(header[3], header[4], stream, payload, frameLength, requests);
+    }
+
+    if (mClosed)
+        mInput.clear();
+    else
+        mInput.erase(0, consumed);
+    flush();
+}
+
+void Http2Connection::upgrade(const objects::HttpRequest& request, std::vector<Request>& requests)
+        throw (std::runtime_error)
+{
+    const std::string settings(decodeBase64Url(request.getHeader("http2-settings")));
+    if (0 != settings.size() % 6)
+        throw(std::runtime_error("Invalid HTTP2-Settings"));
+
+    mOutput.append("HTTP/1.1 101 Switching Protocols\r\nconnection: Upgrade\r\nupgrade: h2c\r\n\r\n");
+    sendPreface();
+    //acknowledged by the switch itself
+    if (NO_ERROR != applySettings(settings.data(), settings.size()))
+    {
+        goAway(PROTOCOL_ERROR);
+        flush();
+        return;
+    }
+
+    //the request was sent whole over HTTP/1.1, only its response is left
+    mLastStream = 1;
+    Stream& state = mStreams[1];
+    state.sendWindow = mPeerInitialWindow;
+    state.remoteClosed = true;
+    Request upgraded;
+    upgraded.stream = 1;
+    upgraded.request = request;
+    requests.push_back(upgraded);
+    flush();
+}
+
+void Http2Connection::respond(const unsigned int stream, const SharedRegion& response, const FileRegion& file)
+{
+    std::map<unsigned int, Stream>::iterator found = mStreams.find(stream);
+    if (mClosed || found == mStreams.end() || found->second.responding)
+        return;
+    Stream& state = found->second;
+    state.responding = true;
+
+    const char* begin = response.data;
+    const char* end = response.data + response.length;
+    const char* headEnd = end;
+    for (const char* iter = begin; iter + 3 < end; ++iter)
+    {
+        if (0 == memcmp(iter, "\r\n\r\n", 4))
+        {
+            headEnd = iter + 2;
+            break;
+        }
+    }
+
+    //status line, "HTTP/1.1 200 OK", then "name: value" lines
+    const char* lineEnd = std::search(begin, headEnd, CRLF, CRLF + 2);
+    const char* status = std::find(begin, lineEnd, ' ');
+    objects::HeaderList fields;
+    fields.push_back(std::make_pair(":status",
+            std::string(std::min(status + 1, lineEnd), std::min(status + 4, lineEnd))));
+    for (const char* line = lineEnd + 2; line < headEnd;)
+    {
+        const char* next = std::search(line, headEnd, CRLF, CRLF + 2);
+        const char* colon = std::find(line, next, ':');
+        if (colon != next)
+        {
+            std::string name(line, colon);
+            std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+            const char* value = colon + 1;
+            while (value < next && (' ' == *value || '\t' == *value))
+                ++value;
+            if (!connectionSpecific(name))
+                fields.push_back(std::make_pair(name, std::string(value, next)));
+        }
+        line = next + 2;
+    }
+
+    const char* bodyBegin = std::min(headEnd + 2, end);
+    state.data = SharedRegion(response.owner, bodyBegin, end - bodyBegin);
+    state.file = file;
+    const bool hasBody = state.data.length > 0 || state.file.length > 0;
+
+    std::string block;
+    mEncoder.encode(fields, block);
+    size_t offset = 0;
+    do
+    {
+        const size_t fragment = std::min<size_t>(block.size() - offset, mPeerMaxFrameSize);
+        const bool last = offset + fragment == block.size();
+        const unsigned char flags = (last ? FLAG_END_HEADERS : 0) | (hasBody ? 0 : FLAG_END_STREAM);
+        writeFrameHeader(fragment, 0 == offset ? HEADERS : CONTINUATION,
+                0 == offset ? flags : (flags & FLAG_END_HEADERS), stream);
+        mOutput.append(block, offset, fragment);
+        offset += fragment;
+    } while (offset < block.size());
+
+    if (hasBody)
+        markReady(stream, state);
+    else
+        closeStream(stream);
+    flush();
+}
+
+void Http2Connection::drained()
+{
+    mBudgetUsed = 0;
+    flush();
+}
+
+size_t Http2Connection::getOpenStreams() const
+{
+    return mStreams.size();
+}
+
+bool Http2Connection::isClosed() const
+{
+    return mClosed;
+}
+
+bool Http2Connection::isPreface(const char* data, const size_t length)
+{
+    return length > 0 && 0 == memcmp(data, PREFACE, std::min(length, PREFACE_SIZE));
+}
+
+bool Http2Connection::handleFrame(const unsigned char type, const unsigned char flags, const unsigned int stream,
+        const char* payload, const size_t length, std::vector<Request>& requests)
+{
+    //a header block is continued by nothing but its own CONTINUATION frames
+    if ((0 != mHeaderStream && (CONTINUATION != type || stream != mHeaderStream))
+            || (0 == mHeaderStream && CONTINUATION == type))
+    {
+        return goAway(PROTOCOL_ERROR);
+    }
+    if (!mSettingsReceived && SETTINGS != type)
+        return goAway(PROTOCOL_ERROR);
+
+    switch (type)
+    {
+    case DATA:
+        return handleData(flags, stream, payload, length, requests);
+    case HEADERS:
+    {
+        if (0 == stream || 0 == stream % 2)
+            return goAway(PROTOCOL_ERROR);
+        size_t offset = 0;
+        size_t padding = 0;
+        if (flags & FLAG_PADDED)
+        {
+            if (length < 1)
+                return goAway(PROTOCOL_ERROR);
+            padding = static_cast<unsigned char>(payload[0]);
+            offset = 1;
+        }
+        //priorities are advisory, and streams are served in turn regardless
+        if (flags & FLAG_PRIORITY)
+            offset += 5;
+        if (offset + padding > length)
+            return goAway(PROTOCOL_ERROR);
+
+        mHeaderBlock.assign(payload + offset, length - offset - padding);
+        mHeaderEndStream = 0 != (flags & FLAG_END_STREAM);
+        if (flags & FLAG_END_HEADERS)
+            return handleHeaders(stream, mHeaderEndStream, requests);
+        mHeaderStream = stream;
+        return true;
+    }
+    case CONTINUATION:
+    {
+        mHeaderBlock.append(payload, length);
+        if (mHeaderBlock.size() > mSettings.maxHeaderListSize)
+            return goAway(ENHANCE_YOUR_CALM);
+        if (0 == (flags & FLAG_END_HEADERS))
+            return true;
+        mHeaderStream = 0;
+        return handleHeaders(stream, mHeaderEndStream, requests);
+    }
+    case PRIORITY:
+        if (0 == stream)
+            return goAway(PROTOCOL_ERROR);
+        if (5 != length)
+            resetStream(stream, FRAME_SIZE_ERROR);
+        return true;
+    case RST_STREAM:
+        if (0 == stream || stream > mLastStream)
+            return goAway(PROTOCOL_ERROR);
+        if (4 != length)
+            return goAway(FRAME_SIZE_ERROR);
+        //whatever was left of its response is dropped, a stale entry in the rotation is skipped
+        mStreams.erase(stream);
+        return true;
+    case SETTINGS:
+        if (0 != stream)
+            return goAway(PROTOCOL_ERROR);
+        return handleSettings(flags, payload, length);
+    case PUSH_PROMISE:
+        return goAway(PROTOCOL_ERROR);
+    case PING:
+        if (0 != stream)
+            return goAway(PROTOCOL_ERROR);
+        if (8 != length)
+            return goAway(FRAME_SIZE_ERROR);
+        if (0 == (flags & FLAG_ACK))
+        {
+            writeFrameHeader(8, PING, FLAG_ACK, 0);
+            mOutput.append(payload, 8);
+        }
+        return true;
+    case GOAWAY:
+        if (0 != stream)
+            return goAway(PROTOCOL_ERROR);
+        mGoingAway = true;
+        return true;
+    case WINDOW_UPDATE:
+        return handleWindowUpdate(stream, payload, length);
+    default:
+        //unknown frame types are ignored
+        return true;
+    }
+}
+
+bool Http2Connection::handleHeaders(const unsigned int stream, const bool endStream,
+        std::vector<Request>& requests)
+{
+    //decoded whatever becomes of the stream, to keep the table in step with the client's
+    objects::HeaderList headers;
+    try
+    {
+        mDecoder.decode(mHeaderBlock.data(), mHeaderBlock.size(), headers);
+    } catch (std::runtime_error&)
+    {
+        return goAway(COMPRESSION_ERROR);
+    }
+    mHeaderBlock.clear();
+
+    std::map<unsigned int, Stream>::iterator found = mStreams.find(stream);
+    if (found != mStreams.end())
+    {
+        //trailers, which end the request
+        if (found->second.remoteClosed)
+        {
+            mStreams.erase(found);
+            resetStream(stream, STREAM_CLOSED);
+            return true;
+        }
+        if (!endStream)
+            return goAway(PROTOCOL_ERROR);
+        completeRequest(stream, found->second, requests);
+        return true;
+    }
+    //frames still in flight on a stream already closed
+    if (stream <= mLastStream)
+        return true;
+
+    mLastStream = stream;
+    if (mGoingAway || mStreams.size() >= mSettings.maxConcurrentStreams)
+    {
+        resetStream(stream, REFUSED_STREAM);
+        return true;
+    }
+
+    Stream& state = mStreams[stream];
+    state.sendWindow = mPeerInitialWindow;
+    try
+    {
+        if (!buildRequest(headers, state.request))
+        {
+            mStreams.erase(stream);
+            resetStream(stream, PROTOCOL_ERROR);
+            return true;
+        }
+    } catch (std::runtime_error&)
+    {
+        //a method no handler can be given, answered as an HTTP/1.1 connection would be
+        state.refused = true;
+        state.remoteClosed = endStream;
+        respondStatus(stream, 400);
+        return true;
+    }
+
+    if (endStream)
+        completeRequest(stream, state, requests);
+    return true;
+}
+
+bool Http2Connection::handleData(const unsigned char flags, const unsigned int stream, const char* payload,
+        const size_t length, std::vector<Request>& requests)
+{
+    if (0 == stream)
+        return goAway(PROTOCOL_ERROR);
+
+    //the connection window counts every DATA frame, whatever becomes of its stream
+    mConnectionUnacknowledged += length;
+    if (mConnectionUnacknowledged > mSettings.connectionWindowSize)
+        return goAway(FLOW_CONTROL_ERROR);
+    if (mConnectionUnacknowledged >= mSettings.connectionWindowSize / 2)
+    {
+        writeWindowUpdate(0, mConnectionUnacknowledged);
+        mConnectionUnacknowledged = 0;
+    }
+
+    std::map<unsigned int, Stream>::iterator found = mStreams.find(stream);
+    if (found == mStreams.end())
+        return stream <= mLastStream ? true : goAway(PROTOCOL_ERROR);
+    Stream& state = found->second;
+    if (state.remoteClosed)
+    {
+        mStreams.erase(found);
+        resetStream(stream, STREAM_CLOSED);
+        return true;
+    }
+
+    state.unacknowledged += length;
+    if (state.unacknowledged > mSettings.initialWindowSize)
+        return goAway(FLOW_CONTROL_ERROR);
+
+    size_t offset = 0;
+    size_t padding = 0;
+    if (flags & FLAG_PADDED)
+    {
+        if (length < 1 || static_cast<unsigned char>(payload[0]) >= length)
+            return goAway(PROTOCOL_ERROR);
+        padding = static_cast<unsigned char>(payload[0]);
+        offset = 1;
+    }
+    const bool endStream = 0 != (flags & FLAG_END_STREAM);
+
+    if (!state.refused)
+    {
+        if (state.body.size() + length - offset - padding > mSettings.maxRequestBody)
+        {
+            //answered now, and the rest of the body is not waited for
+            state.refused = true;
+            state.remoteClosed = endStream;
+            state.body.clear();
+            respondStatus(stream, 413);
+            return true;
+        }
+        state.body.append(payload + offset, length - offset - padding);
+        //the window is returned as the body is buffered, up to the largest body accepted
+        if (!endStream && state.unacknowledged >= mSettings.initialWindowSize / 2)
+        {
+            writeWindowUpdate(stream, state.unacknowledged);
+            state.unacknowledged = 0;
+        }
+    }
+
+    if (endStream)
+        completeRequest(stream, state, requests);
+    return true;
+}
+
+bool Http2Connection::handleSettings(const unsigned char flags, const char* payload, const size_t length)
+{
+    if (flags & FLAG_ACK)
+        return 0 == length ? true : goAway(FRAME_SIZE_ERROR);
+    if (0 != length % 6)
+        return goAway(FRAME_SIZE_ERROR);
+
+    const unsigned int error = applySettings(payload, length);
+    if (NO_ERROR != error)
+        return goAway(error);
+    mSettingsReceived = true;
+    writeFrameHeader(0, SETTINGS, FLAG_ACK, 0);
+    return true;
+}
+
+unsigned int Http2Connection::applySettings(const char* payload, const size_t length)
+{
+    for (size_t offset = 0; offset + 6 <= length; offset += 6)
+    {
+        const unsigned int id = (static_cast<unsigned char>(payload[offset]) << 8)
+                | static_cast<unsigned char>(payload[offset + 1]);
+        const unsigned int value = read32(payload + offset + 2);
+        switch (id)
+        {
+        case HEADER_TABLE_SIZE:
+            mEncoder.setMaxTableSize(value);
+            break;
+        case ENABLE_PUSH:
+            if (value > 1)
+                return PROTOCOL_ERROR;
+            break;
+        case INITIAL_WINDOW_SIZE:
+        {
+            if (value > MAX_WINDOW)
+                return FLOW_CONTROL_ERROR;
+            //applies to every open stream, which may be left with a negative window
+            const long long delta = static_cast<long long>(value) - mPeerInitialWindow;
+            mPeerInitialWindow = value;
+            for (std::map<unsigned int, Stream>::iterator iter = mStreams.begin(); iter != mStreams.end(); ++iter)
+            {
+                iter->second.sendWindow += delta;
+                if (iter->second.sendWindow > MAX_WINDOW)
+                    return FLOW_CONTROL_ERROR;
+                markReady(iter->first, iter->second);
+            }
+            break;
+        }
+        case MAX_FRAME_SIZE_SETTING:
+            if (value < MAX_FRAME_SIZE || value > 0xffffff)
+                return PROTOCOL_ERROR;
+            mPeerMaxFrameSize = value;
+            break;
+        default:
+            //MAX_CONCURRENT_STREAMS limits pushes, which are never sent, others are unknown
+            break;
+        }
+    }
+    return NO_ERROR;
+}
+
+bool Http2Connection::handleWindowUpdate(const unsigned int stream, const char* payload, const size_t length)
+{
+    if (4 != length)
+        return goAway(FRAME_SIZE_ERROR);
+    const unsigned int increment = read32(payload) & 0x7fffffff;
+
+    if (0 == stream)
+    {
+        if (0 == increment)
+            return goAway(PROTOCOL_ERROR);
+        mConnectionSendWindow += increment;
+        return mConnectionSendWindow > MAX_WINDOW ? goAway(FLOW_CONTROL_ERROR) : true;
+    }
+
+    std::map<unsigned int, Stream>::iterator found = mStreams.find(stream);
+    if (found == mStreams.end())
+        return stream <= mLastStream ? true : goAway(PROTOCOL_ERROR);
+    found->second.sendWindow += increment;
+    if (0 == increment || found->second.sendWindow > MAX_WINDOW)
+    {
+        mStreams.erase(found);
+        resetStream(stream, 0 == increment ? PROTOCOL_ERROR : FLOW_CONTROL_ERROR);
+        return true;
+    }
+    markReady(stream, found->second);
+    return true;
+}
+
+bool Http2Connection::buildRequest(const objects::HeaderList& headers, objects::HttpRequest& request) const
+{
+    std::string method;
+    std::string path;
+    std::string authority;
+    objects::HttpRequest::Headers fields;
+    bool regular = false;
+    for (objects::HeaderList::const_iterator iter = headers.begin(); iter != headers.end(); ++iter)
+    {
+        const std::string& name = iter->first;
+        if (name.empty())
+            return false;
+        if (':' == name[0])
+        {
+            //pseudo header fields come before all others
+            if (regular)
+                return false;
+            if (name == ":method")
+                method = iter->second;
+            else if (name == ":path")
+                path = iter->second;
+            else if (name == ":authority")
+                authority = iter->second;
+            else if (name != ":scheme")
+                return false;
+            continue;
+        }
+
+        regular = true;
+        if (name.end() != std::find_if(name.begin(), name.end(), ::isupper) || connectionSpecific(name)
+                || (name == "te" && iter->second != "trailers"))
+        {
+            return false;
+        }
+        //repeated fields are joined as one, cookies as their own list
+        std::string& value = fields[name];
+        if (!value.empty())
+            value.append(name == "cookie" ? "; " : ", ");
+        value.append(iter->second);
+    }
+    if (method.empty() || path.empty())
+        return false;
+
+    request = objects::HttpRequest(objects::HttpRequest::methodFromString(method), path, "");
+    for (objects::HttpRequest::Headers::const_iterator iter = fields.begin(); iter != fields.end(); ++iter)
+    {
+        request.setHeader(iter->first, iter->second);
+    }
+    if (!authority.empty() && !request.hasHeader("host"))
+        request.setHeader("host", authority);
+    return true;
+}
+
+void Http2Connection::completeRequest(const unsigned int stream, Stream& state, std::vector<Request>& requests)
+{
+    state.remoteClosed = true;
+    if (state.refused)
+        return;
+
+    Request complete;
+    complete.stream = stream;
+    complete.request = state.request;
+    complete.request.setBody(state.body);
+    requests.push_back(complete);
+    state.request = objects::HttpRequest();
+    state.body.clear();
+}
+
+void Http2Connection::respondStatus(const unsigned int stream, const unsigned int status)
+{
+    std::shared_ptr<std::string> bytes(new std::string());
+    objects::HttpResponse(status, "").serialize(*bytes);
+    respond(stream, SharedRegion(bytes));
+}
+
+void Http2Connection::resetStream(const unsigned int stream, const unsigned int error)
+{
+    writeFrameHeader(4, RST_STREAM, 0, stream);
+    write32(error, mOutput);
+}
+
+void Http2Connection::closeStream(const unsigned int stream)
+{
+    std::map<unsigned int, Stream>::iterator found = mStreams.find(stream);
+    if (found == mStreams.end())
+        return;
+    //answered before the request was complete, the client need not send the rest
+    if (!found->second.remoteClosed)
+        resetStream(stream, NO_ERROR);
+    mStreams.erase(found);
+}
+
+void Http2Connection::markReady(const unsigned int stream, Stream& state)
+{
+    if (!state.ready && state.responding && state.sendWindow > 0
+            && (state.data.length > 0 || state.file.length > 0))
+    {
+        state.ready = true;
+        mReady.push_back(stream);
+    }
+}
+
+bool Http2Connection::goAway(const unsigned int error)
+{
+    if (mClosed)
+        return false;
+    writeFrameHeader(8, GOAWAY, 0, 0);
+    write32(mLastStream, mOutput);
+    write32(error, mOutput);
+    mClosed = true;
+    mReady.clear();
+    return false;
+}
+
+void Http2Connection::sendPreface()
+{
+    if (mPrefaceSent)
+        return;
+    mPrefaceSent = true;
+
+    std::vector<std::pair<unsigned short, unsigned int> > settings;
+    settings.push_back(std::make_pair(MAX_CONCURRENT_STREAMS, mSettings.maxConcurrentStreams));
+    settings.push_back(std::make_pair(INITIAL_WINDOW_SIZE, mSettings.initialWindowSize));
+    settings.push_back(std::make_pair(MAX_HEADER_LIST_SIZE, mSettings.maxHeaderListSize));
+    writeSettings(settings);
+    //the connection window starts at its default, whatever the settings
+    if (mSettings.connectionWindowSize > DEFAULT_WINDOW)
+        writeWindowUpdate(0, mSettings.connectionWindowSize - DEFAULT_WINDOW);
+}
+
+void Http2Connection::writeFrameHeader(const size_t length, const unsigned char type, const unsigned char flags,
+        const unsigned int stream)
+{
+    mOutput.push_back(static_cast<char>(length >> 16));
+    mOutput.push_back(static_cast<char>(length >> 8));
+    mOutput.push_back(static_cast<char>(length));
+    mOutput.push_back(static_cast<char>(type));
+    mOutput.push_back(static_cast<char>(flags));
+    write32(stream, mOutput);
+}
+
+void Http2Connection::writeSettings(const std::vector<std::pair<unsigned short, unsigned int> >& settings)
+{
+    writeFrameHeader(6 * settings.size(), SETTINGS, 0, 0);
+    for (std::vector<std::pair<unsigned short, unsigned int> >::const_iterator iter = settings.begin();
+            iter != settings.end(); ++iter)
+    {
+        mOutput.push_back(static_cast<char>(iter->first >> 8));
+        mOutput.push_back(static_cast<char>(iter->first));
+        write32(iter->second, mOutput);
+    }
+}
+
+void Http2Connection::writeWindowUpdate(const unsigned int stream, const unsigned int increment)
+{
+    writeFrameHeader(4, WINDOW_UPDATE, 0, stream);
+    write32(increment, mOutput);
+}
+
+void Http2Connection::flush()
+{
+    while (!mReady.empty() && mConnectionSendWindow > 0 && mBudgetUsed < mSettings.outputBudget)
+    {
+        const unsigned int stream = mReady.front();
+        mReady.pop_front();
+        std::map<unsigned int, Stream>::iterator found = mStreams.find(stream);
+        if (found == mStreams.end())
+            continue;
+        Stream& state = found->second;
+        state.ready = false;
+        if (state.sendWindow <= 0)
+            continue;
+
+        const size_t remaining = state.data.length + state.file.length;
+        size_t length = std::min<size_t>(remaining, mPeerMaxFrameSize);
+        length = std::min<size_t>(length, state.sendWindow);
+        length = std::min<size_t>(length, mConnectionSendWindow);
+        length = std::min<size_t>(length, mSettings.outputBudget - mBudgetUsed);
+        const bool last = length == remaining;
+        writeFrameHeader(length, DATA, last ? FLAG_END_STREAM : 0, stream);
+
+        //the payload is a slice of the response's own bytes or file, queued after the frame header
+        const size_t fromData = std::min(length, state.data.length);
+        if (fromData > 0)
+        {
+            mWriter(mOutput, SharedRegion(state.data.owner, state.data.data, fromData), FileRegion());
+            mOutput.clear();
+            state.data.data += fromData;
+            state.data.length -= fromData;
+        }
+        if (length > fromData)
+        {
+            FileRegion slice(state.file);
+            slice.length = length - fromData;
+            mWriter(mOutput, SharedRegion(), slice);
+            mOutput.clear();
+            state.file.offset += slice.length;
+            state.file.length -= slice.length;
+        }
+
+        state.sendWindow -= length;
+        mConnectionSendWindow -= length;
+        mBudgetUsed += length;
+        if (last)
+            closeStream(stream);
+        else
+            markReady(stream, state);
+    }
+
+    if (!mOutput.empty())
+    {
+        mWriter(mOutput, SharedRegion(), FileRegion());
+        mOutput.clear();
+    }
+}
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "tcp/posix/Platform.h"
+#include "tcp/posix/posix.h"
+#include "tcp/posix/FileRegion.h"
+
+#include "objects/Hpack.h"
+#include "objects/HttpRequest.h"
+
+namespace c11http {
+namespace tcp {
+namespace posix {
+
+/**
+ * The HTTP/2 (RFC 9113) side of one connection: frames received from the client are turned into requests, one per
+ * stream, and responses given for those streams are framed and written, many streams at once over the one socket.
+ * Response bodies are written as DATA frames whose payloads are slices of the shared region or file the response was
+ * given in, never copied. DATA is held back by the client's flow control windows, and by an output budget that is
+ * released once the connection's queued output has drained to the socket, so a slow reader only ever holds that
+ * much queued output however many streams it has open. Used from the thread in the server's waitForEvents only.
+ */
+class TCP_POSIX_API Http2Connection
+{
+public:
+    struct Settings
+    {
+        Settings();
+        unsigned int maxConcurrentStreams; //streams opened past this are refused
+        unsigned int initialWindowSize; //each stream's receive window
+        unsigned int connectionWindowSize; //receive window of the whole connection
+        unsigned int maxHeaderListSize; //decoded header fields of one request
+        size_t outputBudget; //DATA bytes queued on the connection before waiting for it to drain
+        size_t maxRequestBody; //requests with larger bodies are answered with 413
+    };
+    /**
+     * A request completed on a stream.
+     */
+    struct Request
+    {
+        unsigned int stream;
+        objects::HttpRequest request;
+    };
+    /**
+     * Queues bytes, taking them, followed by shared and file if they are set, on the connection.
+     */
+    typedef std::function<void(std::string& bytes, const SharedRegion& shared, const FileRegion& file)> Writer;
+
+    explicit Http2Connection(const Writer& writer, const Settings& settings = Settings());
+    ~Http2Connection();
+
+    /**
+     * Process bytes received from the client, starting with its connection preface, appending the requests they
+     * complete to requests. A connection error is answered with GOAWAY, after which nothing more is processed.
+     */
+    void receive(const char* data, const size_t length, std::vector<Request>& requests);
+    /**
+     * Switch a connection to HTTP/2 from request, an HTTP/1.1 request with "Upgrade: h2c" and HTTP2-Settings,
+     * which becomes stream 1. The client's connection preface is expected next. Throws if HTTP2-Settings is
+     * invalid, before anything is written.
+     */
+    void upgrade(const objects::HttpRequest& request, std::vector<Request>& requests) throw (std::runtime_error);
+    /**
+     * Answer a stream with a response serialized as for HTTP/1.1: its status line and headers, then as much of
+     * its body as response holds, followed by file if it is set. Responses for streams the client has reset are
+     * dropped.
+     */
+    void respond(const unsigned int stream, const SharedRegion& response, const FileRegion& file = FileRegion());
+    /**
+     * Everything queued on the connection has been written to the socket, so more DATA can follow.
+     */
+    void drained();
+
+    size_t getOpenStreams() const;
+    bool isClosed() const;
+
+    /**
+     * True if data, the first bytes received on a connection, are the start of the HTTP/2 connection preface.
+     */
+    static bool isPreface(const char* data, const size_t length);
+
+private:
+    struct Stream
+    {
+        Stream();
+        long long sendWindow;
+        size_t unacknowledged; //received DATA bytes not yet returned with WINDOW_UPDATE
+        bool remoteClosed; //the request has been received in full
+        bool responding; //a response has been given
+        bool refused; //the request was answered before it was complete, what remains of it is discarded
+        bool ready; //in the send rotation
+        objects::HttpRequest request;
+        std::string body;
+        SharedRegion data; //body left to send from the response
+        FileRegion file; //then from the file
+    };
+
+    Http2Connection(const Http2Connection&);
+    Http2Connection& operator=(const Http2Connection&);
+
+    /**
+     * Handle one frame, returning false after a connection error.
+     */
+    bool handleFrame(const unsigned char type, const unsigned char flags, const unsigned int stream,
+            const char* payload, const size_t length, std::vector<Request>& requests);
+    bool handleHeaders(const unsigned int stream, const bool endStream, std::vector<Request>& requests);
+    bool handleData(const unsigned char flags, const unsigned int stream, const char* payload,
+            const size_t length, std::vector<Request>& requests);
+    bool handleSettings(const unsigned char flags, const char* payload, const size_t length);
+    /**
+     * Apply the client's settings, returning the error they cause, if any.
+     */
+    unsigned int applySettings(const char* payload, const size_t length);
+    bool handleWindowUpdate(const unsigned int stream, const char* payload, const size_t length);
+    /**
+     * Build the request of a stream from its header block, returning false if it is malformed.
+     */
+    bool buildRequest(const objects::HeaderList& headers, objects::HttpRequest& request) const;
+    void completeRequest(const unsigned int stream, Stream& state, std::vector<Request>& requests);
+    /**
+     * Answer a stream with a response of status and an empty body.
+     */
+    void respondStatus(const unsigned int stream, const unsigned int status);
+    void resetStream(const unsigned int stream, const unsigned int error);
+    void closeStream(const unsigned int stream);
+    /**
+     * Put a stream in the send rotation if it has DATA to send and window to send it in.
+     */
+    void markReady(const unsigned int stream, Stream& state);
+    /**
+     * Answer a connection error with GOAWAY, returning false.
+     */
+    bool goAway(const unsigned int error);
+
+    /**
+     * Write the server's connection preface, its SETTINGS, once.
+     */
+    void sendPreface();
+
+    void writeFrameHeader(const size_t length, const unsigned char type, const unsigned char flags,
+            const unsigned int stream);
+    void writeSettings(const std::vector<std::pair<unsigned short, unsigned int> >& settings);
+    void writeWindowUpdate(const unsigned int stream, const unsigned int increment);
+    /**
+     * Write DATA for streams with a response body, a frame per stream in turn, as far as the windows and the
+     * output budget allow, then hand everything written to the connection.
+     */
+    void flush();
+
+    Writer mWriter;
+    const Settings mSettings;
+    objects::HpackDecoder mDecoder;
+    objects::HpackEncoder mEncoder;
+    std::map<unsigned int, Stream> mStreams;
+    std::deque<unsigned int> mReady; //streams with DATA to send and window to send it in, in turn
+    std::string mInput; //received bytes not yet a complete frame
+    std::string mOutput; //frames not yet handed to the connection
+    std::string mHeaderBlock; //of a HEADERS frame continued by CONTINUATION frames
+    unsigned int mHeaderStream; //stream whose header block is being continued, 0 for none
+    bool mHeaderEndStream;
+    unsigned int mLastStream; //highest stream the client has opened
+    bool mPrefaceSent;
+    bool mPrefaceReceived;
+    bool mSettingsReceived;
+    bool mClosed;
+    bool mGoingAway; //the client sent GOAWAY, no new streams are opened
+    long long mConnectionSendWindow;
+    size_t mConnectionUnacknowledged;
+    unsigned int mPeerInitialWindow;
+    unsigned int mPeerMaxFrameSize;
+    size_t mBudgetUsed; //DATA bytes written since the connection last drained
+};
+
+}
+}
+}
@@ -9,11 +9,13 @@
 #include <algorithm>
 #include <aio.h>
 #include <poll.h>
+#include <unistd.h>
 
 #include "tcp/posix/ServerConnection.h"
 #include "tcp/posix/Connections.h"
 #include "tcp/posix/Socket.h"
 #include "tcp/posix/Callback.h"
+#include "tcp/posix/Tls.h"
 
 namespace c11http {
 namespace tcp {
@@ -21,9 +23,10 @@ namespace posix {
 
 Server::Server(Callback* _callback, const unsigned int _port)
         throw (std::runtime_error)
-        : mPort(_port), mCallback(_callback), mHasBeenShutdown(false)
+        : mPort(_port), mCallback(_callback), mHasBeenShutdown(false), mNextHandle(1), mHighWatermark(0),
+          mLowWatermark(0), mOverflowPolicy(DROP_NEWEST)
 {
-    int result = 0;
+    int result = 1;
     //create a socket to accept connections/data on
     mConnectSocket = new Socket();
 
@@ -56,7 +59,7 @@ Server::Server(Callback* _callback, const unsigned int _port)
     }
 
     //have our connection socket start listening
-    if (-1 == listen(mConnectSocket->getSocket(), 10))
+    if (-1 == listen(mConnectSocket->getSocket(), SOMAXCONN))
     {
         std::stringstream sstr;
         sstr << "listen error " << strerror(errno);
@@ -82,10 +85,12 @@ void Server::waitForEvents() throw (std::runtime_error)
     fd_set readFds;
     fd_set writeFds;
     FD_ZERO(&masterRead);
+    FD_ZERO(&mMasterWrite);
     FD_SET(mWakeupPipe[0], &masterRead);
     FD_SET(mConnectSocket->getSocket(), &masterRead);
     mConnections = new Connections(masterRead);
     int serverMax = std::max(mWakeupPipe[0], mConnectSocket->getSocket());
+    mEventLoopThread = std::this_thread::get_id();
 
     while (!mHasBeenShutdown)
     {
@@ -100,11 +105,17 @@ void Server::waitForEvents() throw (std::runtime_error)
         writeFds = mMasterWrite;
 
         /**
-         * Select from specified file descriptors, will block
+         * Select from specified file descriptors, will block until a descriptor is ready or
+         * the next timer tick
          */
-        numfds = select(fdmax + 1, &readFds, &writeFds, NULL, 0);
-
-        if (-1 == numfds)
+        struct timeval timeout;
+        const int timeoutMs = mTimers.nextTimeout(workers::TimerWheel::Clock::now());
+        timeout.tv_sec = timeoutMs / 1000;
+        timeout.tv_usec = (timeoutMs % 1000) * 1000;
+        numfds = select(fdmax + 1, &readFds, &writeFds, NULL,
+                (-1 == timeoutMs) ? NULL : &timeout);
+
+        if (-1 == numfds && EINTR != errno)
         {
             std::stringstream sstr;
             sstr << "select error " << strerror(errno);
@@ -114,6 +125,13 @@ void Server::waitForEvents() throw (std::runtime_error)
         if (mHasBeenShutdown)
             break;
 
+        mTimers.advance(workers::TimerWheel::Clock::now());
+        runPostedTasks();
+        drainCompletions();
+
+        if (numfds <= 0)
+            continue;
+
         /**
          * Check all the file descriptors to see which were hit
          */
@@ -129,17 +147,7 @@ void Server::waitForEvents() throw (std::runtime_error)
                 if (i == mConnectSocket->getSocket())
                 {
                     //handle new connection
-                    try
-                    {
-                        ServerConnection* client = new ServerConnection(
-                        		mConnectSocket->getSocket()); //performs accept, gets identifier
-                        getCallback()->connected(client->getIdentifier());
-                        mConnections->addServerConnection(client);
-                    } catch (std::runtime_error& ex)
-                    {
-                        //TODO: log connection failure
-                        //std::cout << "failure: " << ex.what() << std::endl;
-                    }
+                    acceptConnection();
                 }
                 else
                 {
@@ -154,8 +162,9 @@ void Server::waitForEvents() throw (std::runtime_error)
              */
             if (FD_ISSET(mWakeupPipe[0], &readFds)) //performing wakeup
             {
-                char buffer[1];
-                ::recv(mWakeupPipe[0], &mBuffer, sizeof(mBuffer), 0);
+                ::read(mWakeupPipe[0], mBuffer, sizeof(mBuffer));
+                //drained, don't read (and block) again for the remaining descriptors
+                FD_CLR(mWakeupPipe[0], &readFds);
             }
 
             /**
@@ -166,18 +175,243 @@ void Server::waitForEvents() throw (std::runtime_error)
                 //ready for write
                 ServerConnection* connection = mConnections->getServerConnection(
                         i);
-                if (0 != connection)
+                if (0 != connection && connection->isHandshaking())
                 {
-                    connection->sendQueuedMessage(getCallback());
+                    handleHandshake(connection);
+                }
+                //once everything queued is written, clear it from the select list
+                else if (0 == connection)
+                {
+                    FD_CLR(i, &mMasterWrite);
+                }
+                else
+                {
+                    const bool remaining = connection->sendQueuedMessage(getCallback());
+                    if (connection->isReadingPaused()
+                            && connection->getQueuedBytes() <= mLowWatermark)
+                    {
+                        connection->setReadingPaused(false);
+                        mConnections->setReading(i, true);
+                        getCallback()->readingPaused(connection->getHandle(),
+                                connection->getIdentifier(), false);
+                    }
+                    if (!remaining)
+                    {
+                        FD_CLR(i, &mMasterWrite);
+                        //which may queue more, setting it again
+                        getCallback()->drained(connection->getHandle(),
+                                connection->getIdentifier());
+                    }
                 }
-                //write complete, clear it from the select list
-                FD_CLR(i, &mMasterWrite);
             }
         }
     }
 
 }
 
+void Server::acceptConnection()
+{
+    ServerConnection* client = 0;
+    try
+    {
+        //performs accept, and for a plain connection gets its identifier
+        client = new ServerConnection(mConnectSocket->getSocket(), mNextHandle++, mTls.get());
+    } catch (std::runtime_error& ex)
+    {
+        //TODO: log connection failure
+        //std::cout << "failure: " << ex.what() << std::endl;
+        return;
+    }
+
+    mConnections->addServerConnection(client);
+    if (client->isOpen())
+    {
+        connected(client);
+        return;
+    }
+
+    //a client that never finishes its handshake is not left holding the connection
+    if (0 != mTls->getHandshakeMilliseconds())
+    {
+        const ConnectionHandle handle = client->getHandle();
+        mTimers.schedule(mTls->getHandshakeMilliseconds(), [this, handle]()
+        {
+            ServerConnection* connection = mConnections->findServerConnection(handle);
+            if (0 != connection && !connection->isOpen())
+            {
+                FD_CLR(connection->getSocket(), &mMasterWrite);
+                mConnections->removeServerConnection(connection->getSocket());
+            }
+        });
+    }
+    handleHandshake(client);
+}
+
+void Server::handleHandshake(ServerConnection* connection)
+{
+    const int sckt = connection->getSocket();
+    bool identified = false;
+    try
+    {
+        identified = connection->continueHandshake();
+        if (connection->wantsWrite())
+            FD_SET(sckt, &mMasterWrite);
+        else
+            FD_CLR(sckt, &mMasterWrite);
+    } catch (std::runtime_error&)
+    {
+        //never connected, so there is nothing to tell the callback
+        FD_CLR(sckt, &mMasterWrite);
+        mConnections->removeServerConnection(sckt);
+        return;
+    }
+
+    if (identified)
+    {
+        mConnections->identified(connection);
+        connected(connection);
+    }
+}
+
+void Server::connected(ServerConnection* connection)
+{
+    Callback* callback = getCallback();
+    callback->connected(connection->getIdentifier());
+
+    std::vector<char> received(connection->takeReceivedAfterIdentifier());
+    if (!received.empty())
+    {
+        callback->receiveFromConnection(connection->getHandle(),
+                connection->getIdentifier(), &(received[0]), received.size());
+    }
+}
+
+void Server::write(const ConnectionHandle handle, std::string& bytes,
+        const SharedRegion& shared, const FileRegion& file)
+{
+    ServerConnection* connection = mConnections->findServerConnection(handle);
+    if (0 != connection)
+    {
+        connection->write(bytes, shared, file);
+        queued(connection);
+    }
+}
+
+void Server::setTlsContext(const std::shared_ptr<TlsContext>& context)
+{
+    mTls = context;
+}
+
+unsigned long long Server::reserveSequence(const ConnectionHandle handle)
+        throw (std::runtime_error)
+{
+    ServerConnection* connection = mConnections->findServerConnection(handle);
+    if (0 == connection)
+        throw(std::runtime_error("Connection not found"));
+    return connection->reserveSequence();
+}
+
+void Server::complete(const ConnectionHandle handle,
+        const unsigned long long sequence, std::string& bytes,
+        const FileRegion& file)
+{
+    Completion completion;
+    completion.handle = handle;
+    completion.sequence = sequence;
+    completion.bytes.swap(bytes);
+    completion.file = file;
+    submit(completion);
+}
+
+void Server::complete(const ConnectionHandle handle,
+        const unsigned long long sequence, const SharedRegion& region)
+{
+    Completion completion;
+    completion.handle = handle;
+    completion.sequence = sequence;
+    completion.shared = region;
+    submit(completion);
+}
+
+void Server::submit(Completion& completion)
+{
+    if (isEventLoopThread())
+    {
+        applyCompletion(completion);
+    }
+    else if (mCompletions.push(completion))
+    {
+        //first completion of a batch, later ones ride along on this wakeup
+        performWakeup();
+    }
+}
+
+void Server::drainCompletions()
+{
+    mCompletions.drain(mCompletionBatch);
+    for (std::vector<Completion>::iterator iter = mCompletionBatch.begin();
+            iter != mCompletionBatch.end(); ++iter)
+    {
+        applyCompletion(*iter);
+    }
+    mCompletionBatch.clear();
+}
+
+void Server::applyCompletion(Completion& completion)
+{
+    ServerConnection* connection = mConnections->findServerConnection(
+            completion.handle);
+    if (0 != connection
+            && connection->completeResponse(completion.sequence, completion.bytes,
+                    completion.file, completion.shared))
+    {
+        queued(connection);
+    }
+}
+
+void Server::runPostedTasks()
+{
+    std::vector<std::function<void()> > tasks;
+    {
+        std::lock_guard<std::mutex> lock(mPostedTasksMutex);
+        tasks.swap(mPostedTasks);
+    }
+    for (std::vector<std::function<void()> >::iterator iter = tasks.begin();
+            iter != tasks.end(); ++iter)
+    {
+        (*iter)();
+    }
+}
+
+void Server::post(const std::function<void()>& task)
+{
+    bool needsWakeup = false;
+    {
+        std::lock_guard<std::mutex> lock(mPostedTasksMutex);
+        //a wakeup is already pending if there were tasks waiting
+        needsWakeup = mPostedTasks.empty();
+        mPostedTasks.push_back(task);
+    }
+    if (needsWakeup)
+        performWakeup();
+}
+
+workers::TimerWheel::TimerId Server::runAfter(const unsigned int milliseconds,
+        const std::function<void()>& task)
+{
+    return mTimers.schedule(milliseconds, task);
+}
+
+bool Server::cancelTimer(const workers::TimerWheel::TimerId id)
+{
+    return mTimers.cancel(id);
+}
+
+bool Server::isEventLoopThread() const
+{
+    return std::this_thread::get_id() == mEventLoopThread;
+}
+
 /**
  * Self pipe technique for wake up from select
  */
@@ -200,7 +434,12 @@ void Server::handleServerConnection(int sckt)
 {
     //determine connection
     ServerConnection* connection = mConnections->getServerConnection(sckt);
-    if (0 != connection)
+    if (0 != connection && !connection->isOpen())
+    {
+        handleHandshake(connection);
+    }
+    //paused since the descriptors were selected
+    else if (0 != connection && !connection->isReadingPaused())
     {
         Callback* callback = getCallback();
         try
@@ -208,10 +447,10 @@ void Server::handleServerConnection(int sckt)
             //receive data
             std::vector<char> result = connection->performReceive();
 
-            if (0 != callback)
+            if (0 != callback && !result.empty())
             {
-                callback->receiveComplete(connection->getIdentifier(), &(result[0]),
-                        result.size());
+                callback->receiveFromConnection(connection->getHandle(),
+                        connection->getIdentifier(), &(result[0]), result.size());
             }
 
         } catch (std::runtime_error)
@@ -240,45 +479,216 @@ Server::~Server()
 void Server::broadcast(const char* byteStream, const unsigned int count)
         throw (std::runtime_error)
 {
+    broadcast(SharedRegion(std::make_shared<const std::string>(byteStream, count)));
+}
+
+void Server::broadcast(const SharedRegion& message)
+{
+    if (!isEventLoopThread())
+    {
+        post([this, message]()
+        {
+            broadcast(message);
+        });
+        return;
+    }
+
     std::vector<ServerConnection*>& conns = mConnections->getConnections();
     for (std::vector<ServerConnection*>::iterator iter = conns.begin();
             iter != conns.end(); ++iter)
     {
-        send(byteStream, count, (*iter));
+        if ((*iter)->isOpen())
+            fanOut((*iter), message);
     }
-    performWakeup();
+}
+
+void Server::subscribe(const std::string& identifier, const std::string& topic)
+{
+    if (!isEventLoopThread())
+    {
+        post([this, identifier, topic]()
+        {
+            subscribe(identifier, topic);
+        });
+        return;
+    }
+
+    try
+    {
+        const ConnectionHandle handle = mConnections->getServerConnection(identifier)->getHandle();
+        mTopics[topic].insert(handle);
+    } catch (std::runtime_error&)
+    {
+        //closed before it could subscribe
+    }
+}
+
+void Server::unsubscribe(const std::string& identifier, const std::string& topic)
+{
+    if (!isEventLoopThread())
+    {
+        post([this, identifier, topic]()
+        {
+            unsubscribe(identifier, topic);
+        });
+        return;
+    }
+
+    std::unordered_map<std::string, std::unordered_set<ConnectionHandle> >::iterator found = mTopics.find(topic);
+    if (found == mTopics.end())
+        return;
+    try
+    {
+        found->second.erase(mConnections->getServerConnection(identifier)->getHandle());
+    } catch (std::runtime_error&)
+    {
+        //closed, and dropped from its topics when they are next published
+    }
+    if (found->second.empty())
+        mTopics.erase(found);
+}
+
+void Server::publish(const std::string& topic, const SharedRegion& message)
+{
+    if (!isEventLoopThread())
+    {
+        post([this, topic, message]()
+        {
+            publish(topic, message);
+        });
+        return;
+    }
+
+    std::unordered_map<std::string, std::unordered_set<ConnectionHandle> >::iterator found = mTopics.find(topic);
+    if (found == mTopics.end())
+        return;
+    std::unordered_set<ConnectionHandle>& subscribers = found->second;
+    for (std::unordered_set<ConnectionHandle>::iterator iter = subscribers.begin();
+            iter != subscribers.end();)
+    {
+        ServerConnection* connection = mConnections->findServerConnection(*iter);
+        if (0 == connection)
+        {
+            iter = subscribers.erase(iter);
+            continue;
+        }
+        fanOut(connection, message);
+        ++iter;
+    }
+    if (subscribers.empty())
+        mTopics.erase(found);
 }
 
 void Server::send(const char* data, const unsigned int count,
         ServerConnection* connection) throw (std::runtime_error)
 {
+    connection->addQueuedMessage(data, count);
     /**
      * Need to add our socket to the write list now that it has data ready. If
      * we added it earlier with no data available, it would constantly be shown
      * as ready by the select call. It is ready since it has no data, and can
-     * write immediately.
+     * write immediately. Counted against the high watermark like any output.
      */
-    FD_SET(connection->getSocket(), &mMasterWrite);
-    connection->addQueuedMessage(data, count);
+    queued(connection);
 }
 
-void Server::send(const char* data, const unsigned int count,
-        const std::string& identifier) throw (std::runtime_error)
+void Server::fanOut(const ConnectionHandle handle, const SharedRegion& message)
 {
-    ServerConnection* connection = mConnections->getServerConnection(identifier);
+    ServerConnection* connection = mConnections->findServerConnection(handle);
     if (0 != connection)
+        fanOut(connection, message);
+}
+
+void Server::fanOut(ServerConnection* connection, const SharedRegion& message)
+{
+    if (!mOverflowed.empty() && 0 != mOverflowed.count(connection->getHandle()))
+        return;
+
+    if (0 != mHighWatermark
+            && connection->getQueuedBytes() + message.length > mHighWatermark)
+    {
+        if (DISCONNECT == mOverflowPolicy)
+        {
+            //closed once the fan-out is done, as the caller may be going through the connections
+            if (mOverflowed.empty())
+            {
+                post([this]()
+                {
+                    closeOverflowed();
+                });
+            }
+            mOverflowed.insert(connection->getHandle());
+            return;
+        }
+        //room can not always be made, e.g. when responses fill the queue
+        if (DROP_NEWEST == mOverflowPolicy || message.length > mHighWatermark
+                || !connection->dropOldest(mHighWatermark - message.length))
+            return;
+    }
+
+    //each connection's queue refers to the one message
+    connection->queueFanOut(message);
+    queued(connection);
+}
+
+void Server::queued(ServerConnection* connection)
+{
+    FD_SET(connection->getSocket(), &mMasterWrite);
+    if (0 != mHighWatermark && !connection->isReadingPaused()
+            && connection->getQueuedBytes() > mHighWatermark)
     {
-        send(data, count, connection);
+        connection->setReadingPaused(true);
+        mConnections->setReading(connection->getSocket(), false);
+        getCallback()->readingPaused(connection->getHandle(),
+                connection->getIdentifier(), true);
+    }
+}
 
+void Server::closeOverflowed()
+{
+    for (std::unordered_set<ConnectionHandle>::iterator iter = mOverflowed.begin();
+            iter != mOverflowed.end(); ++iter)
+    {
+        ServerConnection* connection = mConnections->findServerConnection(*iter);
+        if (0 != connection)
+        {
+            getCallback()->disconnected(connection->getIdentifier());
+            FD_CLR(connection->getSocket(), &mMasterWrite);
+            mConnections->removeServerConnection(connection->getSocket());
+        }
     }
-    else
+    mOverflowed.clear();
+}
+
+void Server::setOutputWatermarks(const size_t high, const size_t low,
+        const OverflowPolicy policy)
+{
+    mHighWatermark = high;
+    mLowWatermark = std::min(low, high);
+    mOverflowPolicy = policy;
+}
+
+void Server::send(const char* data, const unsigned int count,
+        const std::string& identifier) throw (std::runtime_error)
+{
+    if (!isEventLoopThread())
     {
-        std::stringstream sstr;
-        sstr << "Connection not found: " << identifier;
-        throw(std::runtime_error(sstr.str()));
+        //copied, the caller's buffer may be gone by the time the loop gets to it
+        const std::string message(data, count);
+        post([this, message, identifier]()
+        {
+            try
+            {
+                send(message.data(), message.size(), identifier);
+            } catch (std::runtime_error&)
+            {
+                //closed before the message was queued
+            }
+        });
+        return;
     }
-    performWakeup();
 
+    send(data, count, mConnections->getServerConnection(identifier));
 }
 
 void Server::shutdown()
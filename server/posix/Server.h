@@ -1,10 +1,21 @@
 #pragma once
 
 #include <vector>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "tcp/posix/Platform.h"
 #include "tcp/posix/posix.h"
 
+#include "tcp/posix/CompletionQueue.h"
+
+#include "workers/TimerWheel.h"
+
 namespace c11http {
 namespace tcp {
 namespace posix {
@@ -13,6 +24,7 @@ class Callback;
 class Socket;
 class Connections;
 class ServerConnection;
+class TlsContext;
 
 /**
  * Implementation of a server using posix calls. Will listen for connections on a port, accept those connections
@@ -22,6 +34,17 @@ class ServerConnection;
 class TCP_POSIX_API Server
 {
 public:
+    /**
+     * What becomes of a fan-out message, e.g. a broadcast, that would take a connection's queued output past the
+     * high watermark.
+     */
+    enum OverflowPolicy
+    {
+        DROP_NEWEST, //the message is not queued on that connection
+        DROP_OLDEST, //fan-out messages queued before it, and not yet begun, are dropped to make room for it
+        DISCONNECT //the connection is closed
+    };
+
     /**
      * Create a server listening on the specified port, notifying users of events with the specified callback.
      */
@@ -30,15 +53,81 @@ public:
     ~Server();
 
     /**
-     * Send a message to all connections.
+     * Send a message to all connections. The message is copied once, into a buffer queued on every connection.
+     * Safe to call from any thread.
      */
     void broadcast(const char* data, const unsigned int count)
             throw (std::runtime_error);
     /**
-     * Send a message to a specific connection, as indicated by the identifier.
+     * Queue message on every open connection, referring to it rather than copying it. Safe to call from any
+     * thread; the message is queued from the thread in waitForEvents.
+     */
+    void broadcast(const SharedRegion& message);
+    /**
+     * Add the connection identified by identifier to the subscribers of topic, until it is unsubscribed or
+     * closes. Safe to call from any thread; connections that are not found are ignored.
+     */
+    void subscribe(const std::string& identifier, const std::string& topic);
+    void unsubscribe(const std::string& identifier, const std::string& topic);
+    /**
+     * Queue message on every connection subscribed to topic, as broadcast does. Safe to call from any thread.
+     */
+    void publish(const std::string& topic, const SharedRegion& message);
+    /**
+     * Queue message, one sent to many connections, on a connection as broadcast does, under the overflow policy.
+     * Must be called from the thread in waitForEvents.
+     */
+    void fanOut(const ConnectionHandle handle, const SharedRegion& message);
+    /**
+     * Bound the output queued on each connection: once more than high bytes are queued, the connection is not
+     * read from until its output drains to low, and fan-out messages that would take it past high are handled by
+     * policy. A high of 0, the default, leaves output unbounded. Must be called before waitForEvents, or from its
+     * thread.
+     */
+    void setOutputWatermarks(const size_t high, const size_t low,
+            const OverflowPolicy policy);
+    /**
+     * Send a message to a specific connection, as indicated by the identifier. Safe to call from any thread;
+     * from the thread in waitForEvents it throws if the connection is not found, from any other the message is
+     * copied and queued on that thread, and dropped if the connection is gone by then.
      */
     void send(const char* data, const unsigned int count,
             const std::string& identifier) throw (std::runtime_error);
+    /**
+     * Reserve the position of the next response on a connection. Must be called from the thread in
+     * waitForEvents, in the order requests were received.
+     */
+    unsigned long long reserveSequence(const ConnectionHandle handle)
+            throw (std::runtime_error);
+    /**
+     * A response for a connection is finished. Safe to call from any thread; responses completed off the
+     * event loop are queued and spliced into the connection's output in batches, in sequence order. The
+     * bytes are taken, leaving bytes empty, and are followed by file if it is not empty. Completions for closed
+     * connections are dropped.
+     */
+    void complete(const ConnectionHandle handle,
+            const unsigned long long sequence, std::string& bytes,
+            const FileRegion& file = FileRegion());
+    /**
+     * A response held in shared memory is finished, as above. The region is queued on the connection as it
+     * is, never copied.
+     */
+    void complete(const ConnectionHandle handle,
+            const unsigned long long sequence, const SharedRegion& region);
+    /**
+     * Queue bytes, taking them, followed by shared and file if they are set, on a connection outside of the order
+     * responses were reserved in, e.g. the frames of a multiplexed protocol. Must be called from the thread in
+     * waitForEvents. Writes to closed connections are dropped.
+     */
+    void write(const ConnectionHandle handle, std::string& bytes,
+            const SharedRegion& shared = SharedRegion(),
+            const FileRegion& file = FileRegion());
+    /**
+     * Secure connections accepted from now on with context: each is identified once its handshake completes,
+     * driven by the select loop like any other I/O, and connections that are not by the context's handshake
+     * deadline are closed. Must be called before waitForEvents, or from its thread.
+     */
+    void setTlsContext(const std::shared_ptr<TlsContext>& context);
     /**
      * Blocks the current thread, waiting until an event occurs. Events include connection attempts, sending/receiving
      * data, and shutdown.
@@ -48,6 +137,23 @@ public:
      * Shutdown this server, closing all connections.
      */
     void shutdown();
+    /**
+     * Run task on the thread in waitForEvents. Safe to call from any thread; tasks run in the order posted.
+     */
+    void post(const std::function<void()>& task);
+    /**
+     * Run task on the thread in waitForEvents once milliseconds have elapsed. Must be called from that thread.
+     */
+    workers::TimerWheel::TimerId runAfter(const unsigned int milliseconds,
+            const std::function<void()>& task);
+    /**
+     * Cancel a timer created by runAfter. Must be called from the thread in waitForEvents.
+     */
+    bool cancelTimer(const workers::TimerWheel::TimerId id);
+    /**
+     * True when called from the thread in waitForEvents.
+     */
+    bool isEventLoopThread() const;
 
     Callback* getCallback() const;
 
@@ -61,10 +167,52 @@ private:
      */
     void handleServerConnection(int sckt);
     /**
-     * Send data to a specified ServerConnection
+     * Accept a connection on the listening socket, secured if a TLS context is set.
+     */
+    void acceptConnection();
+    /**
+     * Continue a TLS connection's handshake, telling the callback once the connection is identified.
+     */
+    void handleHandshake(ServerConnection* connection);
+    /**
+     * Tell the callback a connection has identified itself, then pass on what the client sent after its
+     * identifier as though just received.
+     */
+    void connected(ServerConnection* connection);
+    /**
+     * Run tasks posted from other threads.
+     */
+    void runPostedTasks();
+    /**
+     * Splice responses completed by other threads into their connections.
+     */
+    void drainCompletions();
+    /**
+     * Apply a completion now if called from the event loop thread, otherwise queue it for the event loop.
+     */
+    void submit(Completion& completion);
+    /**
+     * Queue a completed response on its connection, from the event loop thread.
+     */
+    void applyCompletion(Completion& completion);
+    /**
+     * Send data to a specified ServerConnection, from the thread in waitForEvents.
      */
     void send(const char* data, const unsigned int count,
             ServerConnection* connection) throw (std::runtime_error);
+    /**
+     * Queue a fan-out message on a connection, from the thread in waitForEvents.
+     */
+    void fanOut(ServerConnection* connection, const SharedRegion& message);
+    /**
+     * Output has been queued on a connection: select it for writes, and stop reading from it if its output has
+     * passed the high watermark.
+     */
+    void queued(ServerConnection* connection);
+    /**
+     * Close connections whose fan-out messages overflowed under the DISCONNECT policy.
+     */
+    void closeOverflowed();
 
     Socket* mConnectSocket;
     Connections* mConnections;
@@ -74,6 +222,20 @@ private:
     bool mHasBeenShutdown;
     int mWakeupPipe[2];
     fd_set mMasterWrite;
+    workers::TimerWheel mTimers;
+    std::vector<std::function<void()> > mPostedTasks;
+    std::mutex mPostedTasksMutex;
+    std::thread::id mEventLoopThread;
+    CompletionQueue mCompletions;
+    std::vector<Completion> mCompletionBatch;
+    ConnectionHandle mNextHandle;
+    std::shared_ptr<TlsContext> mTls;
+    //subscribers of each topic, closed connections are dropped as the topic is published
+    std::unordered_map<std::string, std::unordered_set<ConnectionHandle> > mTopics;
+    size_t mHighWatermark;
+    size_t mLowWatermark;
+    OverflowPolicy mOverflowPolicy;
+    std::unordered_set<ConnectionHandle> mOverflowed; //to be closed once the fan-out in progress is done
 };
 
 }
@@ -8,16 +8,30 @@
 #include <errno.h>
 #include <sstream>
 #include <poll.h>
+#include <sys/uio.h>
+#include <algorithm>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
 
 #include "tcp/posix/Socket.h"
 #include "tcp/posix/Callback.h"
+#include "tcp/posix/Tls.h"
 
 namespace c11http {
 namespace tcp {
 namespace posix {
 
-ServerConnection::ServerConnection(const int serverSocket)
-		throw (std::runtime_error) {
+namespace {
+const char ACK[] = "ack";
+const size_t ACK_SIZE = sizeof(ACK) - 1;
+//ends the identifier, so requests sent straight after it may arrive with it
+const char IDENTIFIER_END = '\n';
+}
+
+ServerConnection::ServerConnection(const int serverSocket, const ConnectionHandle handle, TlsContext* tls)
+		throw (std::runtime_error) : mHandle(handle), mNextSequence(0), mNextToQueue(0), mState(OPEN),
+		mHandshakeWantsWrite(false), mQueuedBytes(0), mReadingPaused(false) {
 	struct sockaddr_in server;
 	socklen_t serversize = sizeof(server);
 	/**
@@ -38,31 +52,129 @@ ServerConnection::ServerConnection(const int serverSocket)
 	mSocket = acceptSocket.getSocket();
 	acceptSocket.makeNonBlocking();
 
+	if (0 != tls) {
+		//the handshake, acknowledgement and identifier follow as the socket becomes ready, see continueHandshake
+		try {
+			mTls.reset(new TlsStream(*tls, mSocket));
+		} catch (std::runtime_error&) {
+			acceptSocket.closeSocket();
+			throw;
+		}
+		mState = TLS_HANDSHAKE;
+		return;
+	}
+
 	//send an acknowledgement to the client, acknowledging connection
-	std::string ack("ack");
-	::send(mSocket, ack.c_str(), ack.size(), 0);
+	::send(mSocket, ACK, ACK_SIZE, 0);
 
 	//wait for data back from the client, indicating who the client is
 	pollfd fd;
 	fd.fd = mSocket;
 	fd.events = POLLIN | POLLPRI;
 
-	//poll blocks current thread until receive occurs
-	if (-1 == poll(&fd, 1, -1)) {
-		std::stringstream sstr;
-		sstr << "failed to poll socket for receive: " << strerror(errno);
-		throw(std::runtime_error(sstr.str()));
+	do {
+		//poll blocks current thread until receive occurs
+		if (-1 == poll(&fd, 1, -1)) {
+			std::stringstream sstr;
+			sstr << "failed to poll socket for receive: " << strerror(errno);
+			throw(std::runtime_error(sstr.str()));
+		}
+
+		//receive data from the client, creating the identifier
+	} while (!readIdentifier(performReceive()));
+}
+
+bool ServerConnection::isOpen() const {
+	return OPEN == mState;
+}
+
+bool ServerConnection::isHandshaking() const {
+	return TLS_HANDSHAKE == mState;
+}
+
+bool ServerConnection::continueHandshake() throw (std::runtime_error) {
+	mHandshakeWantsWrite = false;
+	if (TLS_HANDSHAKE == mState) {
+		const TlsStream::Status status = mTls->handshake();
+		if (TlsStream::TLS_WANT_READ == status
+				|| TlsStream::TLS_WANT_WRITE == status) {
+			mHandshakeWantsWrite = TlsStream::TLS_WANT_WRITE == status;
+			return false;
+		}
+		if (TlsStream::TLS_OK != status) {
+			throw(std::runtime_error("TLS handshake failed: " + mTls->getError()));
+		}
+
+		//acknowledge the connection, queueing whatever the socket does not take yet
+		size_t count = 0;
+		const TlsStream::Status ackStatus = mTls->write(ACK, ACK_SIZE, count);
+		if (TlsStream::TLS_OK != ackStatus
+				&& TlsStream::TLS_WANT_READ != ackStatus
+				&& TlsStream::TLS_WANT_WRITE != ackStatus) {
+			throw(std::runtime_error("failed to acknowledge connection: " + mTls->getError()));
+		}
+		if (count < ACK_SIZE) {
+			addQueuedMessage(ACK + count, ACK_SIZE - count);
+		}
+		mState = IDENTIFYING;
 	}
 
-	//receive data from the client, creating the identifier
-	std::vector<char> res = performReceive();
-	mIdentifier = std::string(&res[0], res.size());
+	//the client sends its identifier once it has read the acknowledgement
+	if (!readIdentifier(performReceive())) {
+		return false;
+	}
+	mState = OPEN;
+	return true;
+}
+
+bool ServerConnection::readIdentifier(const std::vector<char>& received) {
+	std::vector<char>::const_iterator end = std::find(received.begin(), received.end(), IDENTIFIER_END);
+	mIdentifier.append(received.begin(), end);
+	if (received.end() == end) {
+		return false;
+	}
+	mAfterIdentifier.assign(end + 1, received.end());
+	return true;
+}
+
+std::vector<char> ServerConnection::takeReceivedAfterIdentifier() {
+	std::vector<char> received;
+	received.swap(mAfterIdentifier);
+	return received;
+}
+
+bool ServerConnection::wantsWrite() const {
+	return mHandshakeWantsWrite || hasQueuedOutput();
 }
 
 std::vector<char> ServerConnection::performReceive() throw (std::runtime_error) {
 	std::vector<char> result;
 	bool shouldRead = true;
 
+	if (0 != mTls.get()) {
+		/**
+		 * Records already read from the socket are not signalled by select, so read until the session
+		 * waits on the socket again
+		 */
+		while (true) {
+			size_t count = 0;
+			const TlsStream::Status status = mTls->read(mBuffer, MAX_BUFFER_SIZE, count);
+			if (TlsStream::TLS_OK == status) {
+				result.insert(result.end(), mBuffer, mBuffer + count);
+			} else if (TlsStream::TLS_WANT_READ == status
+					|| TlsStream::TLS_WANT_WRITE == status) {
+				return result;
+			} else if (TlsStream::TLS_CLOSED == status && !result.empty()) {
+				//the close is seen again on the next receive
+				return result;
+			} else if (TlsStream::TLS_CLOSED == status) {
+				throw(std::runtime_error("remote device closing connection"));
+			} else {
+				throw(std::runtime_error("failed to recv from socket: " + mTls->getError()));
+			}
+		}
+	}
+
 	/**
 	 * At this point, we have polled/selected and know the socket is ready to recv
 	 * from. This function is only called when a poll/select has been performed.
@@ -89,6 +201,10 @@ std::vector<char> ServerConnection::performReceive() throw (std::runtime_error)
 }
 
 ServerConnection::~ServerConnection() {
+    if (0 != mTls.get()) {
+        mTls->shutdown();
+        mTls.reset();
+    }
     Socket sckt(mSocket);
     sckt.closeSocket();
 }
@@ -96,6 +212,9 @@ ServerConnection::~ServerConnection() {
 const int ServerConnection::getSocket() const {
 	return mSocket;
 }
+const ConnectionHandle ServerConnection::getHandle() const {
+	return mHandle;
+}
 const char* ServerConnection::getBuffer() const {
 	return mBuffer;
 }
@@ -103,27 +222,287 @@ const std::string& ServerConnection::getIdentifier() const {
 	return mIdentifier;
 }
 
+const char* ServerConnection::Output::data() const {
+	return shared.owner ? shared.data : bytes.data();
+}
+
+size_t ServerConnection::Output::size() const {
+	return shared.owner ? shared.length : bytes.size();
+}
+
 void ServerConnection::addQueuedMessage(const char* data,
 		const unsigned int count) {
-	mOutgoingBytes.reserve(mOutgoingBytes.size() + count);
-	mOutgoingBytes.insert(mOutgoingBytes.begin(), data, data + count);
+	if (mOutput.empty() || mOutput.back().shared.owner
+			|| mOutput.back().file.length > 0) {
+		mOutput.push_back(Output());
+	}
+	mOutput.back().bytes.append(data, count);
+	mQueuedBytes += count;
 }
 
-void ServerConnection::sendQueuedMessage(Callback* callback) {
-	std::vector<char> bytesToSend;
-	//use the closest a vector has to an atomic operation to get data to send
-	mOutgoingBytes.swap(bytesToSend);
+void ServerConnection::queue(std::string& bytes, const SharedRegion& shared,
+		const FileRegion& file) {
+	mQueuedBytes += bytes.size() + (shared.owner ? shared.length : 0) + file.length;
+	if (!bytes.empty()) {
+		if (mOutput.empty() || mOutput.back().shared.owner
+				|| mOutput.back().file.length > 0) {
+			mOutput.push_back(Output());
+			mOutput.back().bytes.swap(bytes);
+		} else {
+			mOutput.back().bytes.append(bytes);
+		}
+	}
+	if (shared.owner && shared.length > 0) {
+		mOutput.push_back(Output());
+		mOutput.back().shared = shared;
+	}
+	if (file.length > 0) {
+		mOutput.push_back(Output());
+		mOutput.back().file = file;
+	}
+}
+
+void ServerConnection::write(std::string& bytes, const SharedRegion& shared,
+		const FileRegion& file) {
+	queue(bytes, shared, file);
+	bytes.clear();
+}
+
+void ServerConnection::queueFanOut(const SharedRegion& message) {
+	if (0 == message.length)
+		return;
+	mOutput.push_back(Output());
+	mOutput.back().shared = message;
+	mOutput.back().droppable = true;
+	mQueuedBytes += message.length;
+}
 
-	const int expected = bytesToSend.size();
+bool ServerConnection::dropOldest(const size_t limit) {
+	//the front may be part way through a write that must be retried as it was, e.g. a TLS record
+	std::deque<Output>::iterator iter = mOutput.begin();
+	if (iter != mOutput.end())
+		++iter;
+	while (mQueuedBytes > limit && iter != mOutput.end()) {
+		if (iter->droppable && 0 == iter->sent) {
+			mQueuedBytes -= iter->size();
+			iter = mOutput.erase(iter);
+		} else {
+			++iter;
+		}
+	}
+	return mQueuedBytes <= limit;
+}
+
+unsigned long long ServerConnection::reserveSequence() {
+	return mNextSequence++;
+}
+
+bool ServerConnection::completeResponse(const unsigned long long sequence,
+		std::string& bytes, const FileRegion& file, const SharedRegion& shared) {
+	if (sequence != mNextToQueue) {
+		//an earlier response is still outstanding, hold on to this one
+		Held& held = mOutOfOrder[sequence];
+		held.bytes.swap(bytes);
+		held.shared = shared;
+		held.file = file;
+		return false;
+	}
+
+	queue(bytes, shared, file);
+	++mNextToQueue;
+
+	//release anything that was waiting on this response
+	std::map<unsigned long long, Held>::iterator iter = mOutOfOrder.begin();
+	while (iter != mOutOfOrder.end() && iter->first == mNextToQueue) {
+		queue(iter->second.bytes, iter->second.shared, iter->second.file);
+		++mNextToQueue;
+		mOutOfOrder.erase(iter++);
+	}
+	return true;
+}
+
+bool ServerConnection::hasQueuedOutput() const {
+	return !mOutput.empty();
+}
+
+size_t ServerConnection::getQueuedBytes() const {
+	return mQueuedBytes;
+}
+
+bool ServerConnection::isReadingPaused() const {
+	return mReadingPaused;
+}
+
+void ServerConnection::setReadingPaused(const bool paused) {
+	mReadingPaused = paused;
+}
+
+bool ServerConnection::sendQueuedMessage(Callback* callback) {
+	size_t total = 0;
 
 	/**
 	 * At this point, a poll/select has been performed that indicates
-	 * that this socket is available for sending. We can then send
-	 * all of our available data.
+	 * that this socket is available for sending. Send until the socket
+	 * would block, keeping whatever is left for the next time it is
+	 * writable.
+	 */
+	while (!mOutput.empty()) {
+		if (mOutput.front().file.length > 0) {
+			if (!sendFile(mOutput.front(), callback, total))
+				break;
+			mOutput.pop_front();
+		} else if (!sendBuffers(callback, total)) {
+			break;
+		}
+	}
+
+	if (total > 0) {
+		callback->sendComplete(mIdentifier, total);
+	}
+	return !mOutput.empty();
+}
+
+bool ServerConnection::encryptsRecords() const {
+	return 0 != mTls.get() && !mTls->isKernelTls();
+}
+
+bool ServerConnection::sendBuffers(Callback* callback, size_t& total) {
+	if (encryptsRecords())
+		return sendRecords(callback, total);
+
+	//gather every buffer up to the next file, so pipelined responses go out in one call
+	struct iovec vectors[MAX_GATHERED_BUFFERS];
+	int count = 0;
+	size_t expected = 0;
+	for (std::deque<Output>::iterator iter = mOutput.begin();
+			iter != mOutput.end() && 0 == iter->file.length
+					&& count < MAX_GATHERED_BUFFERS; ++iter) {
+		vectors[count].iov_base = const_cast<char*>(iter->data() + iter->sent);
+		vectors[count].iov_len = iter->size() - iter->sent;
+		expected += vectors[count].iov_len;
+		++count;
+	}
+
+	ssize_t nbytes = -1;
+	do {
+		nbytes = ::writev(mSocket, vectors, count);
+	} while (-1 == nbytes && EINTR == errno);
+	if (-1 == nbytes) {
+		if (EAGAIN != errno && EWOULDBLOCK != errno)
+			failSend(callback);
+		return false;
+	}
+	total += nbytes;
+	mQueuedBytes -= nbytes;
+
+	//drop what was written, leaving a partly written buffer at the front
+	size_t written = nbytes;
+	while (!mOutput.empty() && 0 == mOutput.front().file.length) {
+		Output& front = mOutput.front();
+		const size_t remaining = front.size() - front.sent;
+		if (written < remaining) {
+			front.sent += written;
+			break;
+		}
+		written -= remaining;
+		mOutput.pop_front();
+	}
+	return static_cast<size_t>(nbytes) == expected;
+}
+
+bool ServerConnection::sendRecords(Callback* callback, size_t& total) {
+	//there is no gathering write for records encrypted in user space, each buffer is written in turn
+	while (!mOutput.empty() && 0 == mOutput.front().file.length) {
+		Output& front = mOutput.front();
+		if (front.sent < front.size()) {
+			size_t count = 0;
+			const TlsStream::Status status = mTls->write(
+					front.data() + front.sent, front.size() - front.sent, count);
+			if (TlsStream::TLS_OK != status) {
+				if (TlsStream::TLS_WANT_READ != status
+						&& TlsStream::TLS_WANT_WRITE != status)
+					failSend(callback, mTls->getError());
+				return false;
+			}
+			front.sent += count;
+			total += count;
+			mQueuedBytes -= count;
+		}
+		if (front.sent == front.size())
+			mOutput.pop_front();
+	}
+	return true;
+}
+
+bool ServerConnection::sendFile(Output& output, Callback* callback,
+		size_t& total) {
+	FileRegion& file = output.file;
+	while (file.length > 0 && encryptsRecords()) {
+		size_t count = 0;
+		const TlsStream::Status status = mTls->sendFile(
+				file.file->getDescriptor(), file.offset, file.length, count);
+		if (TlsStream::TLS_OK != status) {
+			if (TlsStream::TLS_WANT_READ != status
+					&& TlsStream::TLS_WANT_WRITE != status)
+				failSend(callback, mTls->getError());
+			return false;
+		}
+		if (0 == count) {
+			failSend(callback, "file truncated while being sent");
+			return false;
+		}
+		file.offset += count;
+		file.length -= count;
+		total += count;
+		mQueuedBytes -= count;
+	}
+	/**
+	 * Plain connections, and those whose records the kernel encrypts, are sent from the file as it is:
+	 * the kernel frames what sendfile writes into records as it goes
 	 */
-	if (expected == ::send(mSocket, &(bytesToSend[0]), expected, 0)) {
-		callback->sendComplete(mIdentifier, expected);
+	while (file.length > 0) {
+#ifdef __linux__
+		//straight from the page cache to the socket, never copied through user space
+		off_t offset = file.offset;
+		const ssize_t nbytes = ::sendfile(mSocket, file.file->getDescriptor(),
+				&offset, file.length);
+#else
+		ssize_t nbytes = ::pread(file.file->getDescriptor(), mBuffer,
+				std::min<size_t>(file.length, MAX_BUFFER_SIZE), file.offset);
+		if (nbytes > 0) {
+			nbytes = ::send(mSocket, mBuffer, nbytes, 0);
+		}
+#endif
+		if (-1 == nbytes) {
+			if (EINTR == errno)
+				continue;
+			if (EAGAIN != errno && EWOULDBLOCK != errno)
+				failSend(callback);
+			return false;
+		}
+		if (0 == nbytes) {
+			//the file was truncated after its response head promised more
+			failSend(callback);
+			return false;
+		}
+		file.offset += nbytes;
+		file.length -= nbytes;
+		total += nbytes;
+		mQueuedBytes -= nbytes;
 	}
+	return true;
+}
+
+void ServerConnection::failSend(Callback* callback) {
+	failSend(callback, strerror(errno));
+}
+
+void ServerConnection::failSend(Callback* callback, const std::string& reason) {
+	callback->sendFailed(mIdentifier, reason);
+	//what is left can no longer be framed correctly, the connection closes on its next receive
+	mOutput.clear();
+	mQueuedBytes = 0;
+	::shutdown(mSocket, SHUT_WR);
 }
 
 }
@@ -1,15 +1,20 @@
 #pragma once
 
+#include <deque>
+#include <map>
 #include <vector>
 
 #include "tcp/posix/Platform.h"
 #include "tcp/posix/posix.h"
+#include "tcp/posix/FileRegion.h"
 
 namespace c11http {
 namespace tcp {
 namespace posix {
 
 class Callback;
+class TlsContext;
+class TlsStream;
 
 /**
  * Represent a connection between a server and a client. An underlying file descriptor (socket)
@@ -20,35 +25,165 @@ class TCP_POSIX_API ServerConnection
 public:
     /**
      * Accept an incoming connection on the server listening socket, creating a new connection between
-     * the server and the client for sending and receiving data.
+     * the server and the client for sending and receiving data. With tls, the connection is accepted before
+     * its handshake, and is open once continueHandshake has identified the client.
      */
-    ServerConnection(const int serverSocket) throw (std::runtime_error);
+    ServerConnection(const int serverSocket, const ConnectionHandle handle, TlsContext* tls = 0)
+            throw (std::runtime_error);
     ~ServerConnection();
 
+    /**
+     * True once the client has identified itself.
+     */
+    bool isOpen() const;
+    bool isHandshaking() const;
+    /**
+     * Continue the TLS handshake, then acknowledge the client and read its identifier over the secured channel,
+     * as far as the socket allows without blocking. Returns true once the client is identified. Throws if the
+     * handshake fails or the client closes the connection.
+     */
+    bool continueHandshake() throw (std::runtime_error);
+    /**
+     * Bytes that arrived after the identifier, with it, and have not been taken yet. The server hands them on as
+     * though received once the connection is open.
+     */
+    std::vector<char> takeReceivedAfterIdentifier();
+    /**
+     * True while the handshake waits for the socket to be writable, or while output is queued.
+     */
+    bool wantsWrite() const;
+
     /**
      * Add a message to send to the client. When the socket is available for writing, the message will be sent.
      */
     void addQueuedMessage(const char* data, const unsigned int count);
     /**
-     * Send a queued message to the client. Socket must be available for writing, and will not block when
-     * when the write occurs, as indicated by a select or poll.
+     * Queue bytes, taking them, followed by shared and file if they are set, ahead of any response still to be
+     * completed.
+     */
+    void write(std::string& bytes, const SharedRegion& shared = SharedRegion(),
+            const FileRegion& file = FileRegion());
+    /**
+     * Queue a message sent to many connections at once, e.g. a broadcast. Until any of it has been sent, it may be
+     * dropped by dropOldest.
+     */
+    void queueFanOut(const SharedRegion& message);
+    /**
+     * Drop queued fan-out messages none of which has been sent, oldest first, until at most limit bytes are
+     * queued. Returns false if dropping them all is not enough.
+     */
+    bool dropOldest(const size_t limit);
+    /**
+     * Reserve the position of the next response on this connection. Responses are sent in the order their
+     * sequence numbers were reserved, regardless of the order they complete in.
+     */
+    unsigned long long reserveSequence();
+    /**
+     * A response has been produced: its bytes, followed by shared and file if they are set. It is queued once
+     * every response reserved before it has been queued, returning true if anything was queued.
+     */
+    bool completeResponse(const unsigned long long sequence, std::string& bytes,
+            const FileRegion& file = FileRegion(),
+            const SharedRegion& shared = SharedRegion());
+    /**
+     * Send queued output to the client, as much as the socket accepts without blocking. Socket must be available
+     * for writing, as indicated by a select or poll. Returns true if output remains, to be sent once the socket
+     * is writable again.
      */
-    void sendQueuedMessage(Callback* callback);
+    bool sendQueuedMessage(Callback* callback);
+    bool hasQueuedOutput() const;
+    /**
+     * Bytes queued and not yet sent, responses held back for an earlier one aside.
+     */
+    size_t getQueuedBytes() const;
+    /**
+     * True while the server is not reading from this connection, until its output drains.
+     */
+    bool isReadingPaused() const;
+    void setReadingPaused(const bool paused);
     /**
      * Receive data from a client, storing it in a vector. Data must be available on the socket, as indicated
-     * by a select or poll operation.
+     * by a select or poll operation. Over TLS, the data may have been only a part of a record, leaving the
+     * vector empty.
      */
     std::vector<char> performReceive() throw (std::runtime_error);
 
     const int getSocket() const;
+    const ConnectionHandle getHandle() const;
 	const char* getBuffer() const;
 	const std::string& getIdentifier() const;
 
 private:
-    std::vector<char> mOutgoingBytes;
+    enum State
+    {
+        TLS_HANDSHAKE, IDENTIFYING, OPEN
+    };
+
+    /**
+     * A piece of queued output: bytes of its own, a shared region, or a range of a file. Consecutive bytes of
+     * its own are gathered into one piece.
+     */
+    struct Output
+    {
+        Output()
+                : sent(0), droppable(false)
+        {
+        }
+        const char* data() const;
+        size_t size() const;
+
+        std::string bytes;
+        SharedRegion shared;
+        size_t sent; //of bytes or shared, already written
+        FileRegion file; //advanced as it is written
+        bool droppable; //a fan-out message
+    };
+    /**
+     * A response completed ahead of an earlier one.
+     */
+    struct Held
+    {
+        std::string bytes;
+        SharedRegion shared;
+        FileRegion file;
+    };
+    /**
+     * Write the buffers at the front of the output queue with a single writev, returning false once the socket
+     * would block or has failed.
+     */
+    bool sendBuffers(Callback* callback, size_t& total);
+    /**
+     * Encrypt the buffers at the front of the output queue in turn, for TLS the kernel does not encrypt.
+     */
+    bool sendRecords(Callback* callback, size_t& total);
+    bool sendFile(Output& output, Callback* callback, size_t& total);
+    /**
+     * True if TLS records are encrypted in user space, rather than by the kernel as the socket is written.
+     */
+    bool encryptsRecords() const;
+    void queue(std::string& bytes, const SharedRegion& shared, const FileRegion& file);
+    /**
+     * Add received bytes to the identifier, up to the newline ending it, keeping any after it. Returns true once
+     * the identifier is complete.
+     */
+    bool readIdentifier(const std::vector<char>& received);
+    void failSend(Callback* callback);
+    void failSend(Callback* callback, const std::string& reason);
+
+    std::deque<Output> mOutput;
     int mSocket; //file descriptor of socket
     char mBuffer[MAX_BUFFER_SIZE]; //buffer to store send/recv information in
     std::string mIdentifier; //identifier of this server connection
+    std::vector<char> mAfterIdentifier; //received with the identifier, not yet handed on
+    ConnectionHandle mHandle;
+    unsigned long long mNextSequence; //next sequence to reserve
+    unsigned long long mNextToQueue; //next sequence to be queued for sending
+    std::map<unsigned long long, Held> mOutOfOrder; //completed ahead of an earlier response
+    std::unique_ptr<TlsStream> mTls;
+    State mState;
+    bool mHandshakeWantsWrite;
+    size_t mQueuedBytes; //of mOutput, not yet sent
+    bool mReadingPaused;
 };
 
 }
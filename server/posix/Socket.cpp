@@ -8,6 +8,7 @@
 #include <fcntl.h>
 #include <sstream>
 #include <string.h>
+#include <unistd.h>
 
 namespace c11http {
 namespace tcp {
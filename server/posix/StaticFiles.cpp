@@ -0,0 +1,239 @@
+#ifndef WINDOWS
+#include "tcp/posix/StaticFiles.h"
+
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <cctype>
+#include <cstdlib>
+#include <sstream>
+
+namespace c11http {
+namespace tcp {
+namespace posix {
+
+namespace
+{
+
+struct ContentType
+{
+    const char* extension;
+    const char* type;
+};
+
+const ContentType CONTENT_TYPES[] = {
+        { "html", "text/html; charset=utf-8" },
+        { "htm", "text/html; charset=utf-8" },
+        { "css", "text/css; charset=utf-8" },
+        { "js", "application/javascript" },
+        { "json", "application/json" },
+        { "txt", "text/plain; charset=utf-8" },
+        { "xml", "application/xml" },
+        { "svg", "image/svg+xml" },
+        { "png", "image/png" },
+        { "jpg", "image/jpeg" },
+        { "jpeg", "image/jpeg" },
+        { "gif", "image/gif" },
+        { "ico", "image/x-icon" },
+        { "webp", "image/webp" },
+        { "woff", "font/woff" },
+        { "woff2", "font/woff2" },
+        { "wasm", "application/wasm" },
+        { "pdf", "application/pdf" } };
+
+int hexValue(const char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    return tolower(static_cast<unsigned char>(c)) - 'a' + 10;
+}
+
+std::string httpDate(const time_t when)
+{
+    struct tm parts;
+    gmtime_r(&when, &parts);
+    char formatted[64];
+    strftime(formatted, sizeof(formatted), "%a, %d %b %Y %H:%M:%S GMT", &parts);
+    return formatted;
+}
+
+}
+
+StaticFiles::StaticFiles(const std::string& root, const size_t maxOpenFiles,
+        const unsigned int revalidateMilliseconds)
+        : mRoot(root), mMaxOpenFiles(0 == maxOpenFiles ? 1 : maxOpenFiles),
+          mRevalidateAfter(revalidateMilliseconds)
+{
+
+}
+
+StaticFiles::~StaticFiles()
+{
+
+}
+
+size_t StaticFiles::size() const
+{
+    return mLru.size();
+}
+
+const char* StaticFiles::contentType(const std::string& name)
+{
+    const size_t dot = name.rfind('.');
+    if (std::string::npos != dot && std::string::npos == name.find('/', dot))
+    {
+        std::string extension(name.substr(dot + 1));
+        for (std::string::iterator iter = extension.begin(); iter != extension.end(); ++iter)
+            *iter = tolower(static_cast<unsigned char>(*iter));
+        for (size_t i = 0; i < sizeof(CONTENT_TYPES) / sizeof(CONTENT_TYPES[0]); ++i)
+        {
+            if (extension == CONTENT_TYPES[i].extension)
+                return CONTENT_TYPES[i].type;
+        }
+    }
+    return "application/octet-stream";
+}
+
+std::shared_ptr<const StaticFiles::File> StaticFiles::find(const std::string& path)
+{
+    std::string resolved;
+    if (!resolve(path, resolved))
+        return std::shared_ptr<const File>();
+
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    std::unordered_map<std::string, Lru::iterator>::iterator found = mIndex.find(resolved);
+    if (mIndex.end() != found)
+    {
+        Entry& entry = *found->second;
+        mLru.splice(mLru.begin(), mLru, found->second);
+        if (now - entry.validatedAt < mRevalidateAfter)
+            return entry.file;
+
+        //unchanged if it is still the same inode, with the same size and modification time
+        struct stat current;
+        if (0 == ::stat(resolved.c_str(), &current) && current.st_dev == entry.file->device
+                && current.st_ino == entry.file->inode && current.st_size == entry.file->size
+                && current.st_mtime == entry.file->modified)
+        {
+            entry.validatedAt = now;
+            return entry.file;
+        }
+        forget(resolved);
+    }
+
+    std::shared_ptr<const File> file = open(resolved);
+    if (!file)
+        return file;
+
+    Entry entry;
+    entry.path = resolved;
+    entry.file = file;
+    entry.validatedAt = now;
+    mLru.push_front(entry);
+    mIndex[resolved] = mLru.begin();
+    while (mLru.size() > mMaxOpenFiles)
+    {
+        mIndex.erase(mLru.back().path);
+        mLru.pop_back();
+    }
+    return file;
+}
+
+void StaticFiles::forget(const std::string& resolved)
+{
+    std::unordered_map<std::string, Lru::iterator>::iterator found = mIndex.find(resolved);
+    if (mIndex.end() == found)
+        return;
+    //connections still sending the file hold their own reference, it is closed once they finish
+    mLru.erase(found->second);
+    mIndex.erase(found);
+}
+
+bool StaticFiles::resolve(const std::string& path, std::string& resolved) const
+{
+    std::string decoded;
+    const size_t end = path.find_first_of("?#");
+    const size_t length = (std::string::npos == end) ? path.size() : end;
+    for (size_t i = 0; i < length; ++i)
+    {
+        if ('%' == path[i])
+        {
+            if (i + 2 >= length || !isxdigit(static_cast<unsigned char>(path[i + 1]))
+                    || !isxdigit(static_cast<unsigned char>(path[i + 2])))
+                return false;
+            decoded.push_back(static_cast<char>(hexValue(path[i + 1]) * 16 + hexValue(path[i + 2])));
+            i += 2;
+        }
+        else
+        {
+            decoded.push_back(path[i]);
+        }
+    }
+
+    //every segment must name something below the root
+    resolved = mRoot;
+    size_t begin = 0;
+    while (begin <= decoded.size())
+    {
+        size_t slash = decoded.find('/', begin);
+        if (std::string::npos == slash)
+            slash = decoded.size();
+        const std::string segment(decoded, begin, slash - begin);
+        if (".." == segment || std::string::npos != segment.find('\0'))
+            return false;
+        if (!segment.empty() && "." != segment)
+        {
+            resolved.push_back('/');
+            resolved.append(segment);
+        }
+        begin = slash + 1;
+    }
+
+    if (decoded.empty() || '/' == decoded[decoded.size() - 1])
+        resolved.append("/index.html");
+    return true;
+}
+
+std::shared_ptr<const StaticFiles::File> StaticFiles::open(const std::string& resolved) const
+{
+    const int fd = ::open(resolved.c_str(), O_RDONLY | O_CLOEXEC);
+    if (-1 == fd)
+        return std::shared_ptr<const File>();
+
+    std::shared_ptr<OpenFile> opened(new OpenFile(fd));
+    struct stat info;
+    if (-1 == fstat(fd, &info) || !S_ISREG(info.st_mode))
+        return std::shared_ptr<const File>();
+
+    std::shared_ptr<File> file(new File());
+    file->body.file = opened;
+    file->body.offset = 0;
+    file->body.length = info.st_size;
+    file->device = info.st_dev;
+    file->inode = info.st_ino;
+    file->size = info.st_size;
+    file->modified = info.st_mtime;
+
+    std::stringstream etag;
+    etag << '"' << std::hex << info.st_size << '-' << info.st_mtime << '"';
+    file->etag = etag.str();
+    const std::string modified = httpDate(info.st_mtime);
+
+    //heads are built once per open, in the same form HttpResponse::serialize uses
+    std::stringstream validators;
+    validators << "etag: " << file->etag << "\r\n" << "last-modified: " << modified << "\r\n";
+
+    std::stringstream head;
+    head << "HTTP/1.1 200 OK\r\n" << "content-length: " << info.st_size << "\r\n" << "content-type: "
+            << contentType(resolved) << "\r\n" << validators.str() << "\r\n";
+    file->head = head.str();
+    file->notModified = "HTTP/1.1 304 Not Modified\r\n" + validators.str() + "\r\n";
+    return file;
+}
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <chrono>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include <sys/types.h>
+
+#include "tcp/posix/Platform.h"
+#include "tcp/posix/posix.h"
+#include "tcp/posix/FileRegion.h"
+
+namespace c11http {
+namespace tcp {
+namespace posix {
+
+/**
+ * Files below a root directory, ready to be sent with sendfile. Each file found is kept open along with its stat
+ * results and the response heads announcing it, so serving a cached file needs no system call until it is sent.
+ * At most maxOpenFiles are kept, the least recently used closed first. A cached file is checked against the file
+ * system again once revalidateMilliseconds have passed, and reopened if it has been replaced or modified. Not thread
+ * safe, owned by the event loop serving the files.
+ */
+class TCP_POSIX_API StaticFiles
+{
+public:
+    struct File
+    {
+        FileRegion body; //the whole file
+        std::string head; //200 response head, Content-Length, Content-Type, ETag and Last-Modified included
+        std::string notModified; //304 response head, for requests already holding this version
+        std::string etag;
+        dev_t device;
+        ino_t inode;
+        off_t size;
+        time_t modified;
+    };
+
+    StaticFiles(const std::string& root, const size_t maxOpenFiles = 1024,
+            const unsigned int revalidateMilliseconds = 1000);
+    ~StaticFiles();
+
+    /**
+     * Find the regular file at path, relative to the root and percent encoded as in a request target. A path
+     * naming a directory finds its index.html. Returns null if there is no such file, or the path would leave
+     * the root.
+     */
+    std::shared_ptr<const File> find(const std::string& path);
+    /**
+     * Number of files held open.
+     */
+    size_t size() const;
+
+    /**
+     * Content-Type for a file name, from its extension.
+     */
+    static const char* contentType(const std::string& name);
+
+private:
+    struct Entry
+    {
+        std::string path; //file system path
+        std::shared_ptr<const File> file;
+        std::chrono::steady_clock::time_point validatedAt;
+    };
+    typedef std::list<Entry> Lru;
+
+    /**
+     * Map a request path to a file system path, returning false if it is not a valid path below the root.
+     */
+    bool resolve(const std::string& path, std::string& resolved) const;
+    std::shared_ptr<const File> open(const std::string& resolved) const;
+    void forget(const std::string& resolved);
+
+    const std::string mRoot;
+    const size_t mMaxOpenFiles;
+    const std::chrono::milliseconds mRevalidateAfter;
+    Lru mLru; //most recently used first
+    std::unordered_map<std::string, Lru::iterator> mIndex;
+};
+
+}
+}
+}
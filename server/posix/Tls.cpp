@@ -0,0 +1,262 @@
+#ifndef WINDOWS
+#include "tcp/posix/Tls.h"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+
+namespace c11http {
+namespace tcp {
+namespace posix {
+
+namespace {
+//a full record, the most one SSL_write encrypts at once
+const size_t RECORD_SIZE = 16 * 1024;
+const unsigned char SESSION_ID_CONTEXT[] = "c11http";
+
+/**
+ * what, followed by the reason OpenSSL gives for the error it last queued.
+ */
+std::string describe(const std::string& what)
+{
+    char reason[256];
+    const unsigned long error = ERR_get_error();
+    ERR_clear_error();
+    if (0 == error)
+        return what;
+    ERR_error_string_n(error, reason, sizeof(reason));
+    return what + ": " + reason;
+}
+}
+
+TlsContext::Options::Options()
+        : sessionCacheSize(20480), sessionTimeoutSeconds(300), handshakeMilliseconds(10000), kernelTls(false)
+{
+}
+
+TlsContext::TlsContext(const Options& options) throw (std::runtime_error)
+        : mContext(SSL_CTX_new(TLS_server_method())), mHandshakeMilliseconds(options.handshakeMilliseconds),
+          mHandshakes(0), mResumed(0), mKernelTls(0)
+{
+    if (0 == mContext)
+        throw(std::runtime_error(describe("Failed to create TLS context")));
+
+    SSL_CTX_set_min_proto_version(mContext, TLS1_2_VERSION);
+    uint64_t sslOptions = SSL_OP_NO_RENEGOTIATION | SSL_OP_CIPHER_SERVER_PREFERENCE | SSL_OP_IGNORE_UNEXPECTED_EOF;
+#ifdef SSL_OP_ENABLE_KTLS
+    if (options.kernelTls)
+        sslOptions |= SSL_OP_ENABLE_KTLS;
+#endif
+    SSL_CTX_set_options(mContext, sslOptions);
+    //writes are retried from the output queue, whose buffers move as responses are appended
+    SSL_CTX_set_mode(mContext,
+            SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER | SSL_MODE_RELEASE_BUFFERS);
+
+    if (1 != SSL_CTX_use_certificate_chain_file(mContext, options.certificateFile.c_str())
+            || 1 != SSL_CTX_use_PrivateKey_file(mContext, options.privateKeyFile.c_str(), SSL_FILETYPE_PEM)
+            || 1 != SSL_CTX_check_private_key(mContext))
+    {
+        const std::string reason(describe("Failed to load certificate " + options.certificateFile));
+        SSL_CTX_free(mContext);
+        throw(std::runtime_error(reason));
+    }
+
+    /**
+     * Sessions are kept by ID, for clients resuming that way, and tickets are issued under keys generated for
+     * this context, one per full handshake as a client holds on to only the latest
+     */
+    SSL_CTX_set_session_id_context(mContext, SESSION_ID_CONTEXT, sizeof(SESSION_ID_CONTEXT) - 1);
+    SSL_CTX_set_session_cache_mode(mContext, SSL_SESS_CACHE_SERVER);
+    SSL_CTX_sess_set_cache_size(mContext, options.sessionCacheSize);
+    SSL_CTX_set_timeout(mContext, options.sessionTimeoutSeconds);
+    SSL_CTX_set_num_tickets(mContext, 1);
+}
+
+TlsContext::~TlsContext()
+{
+    SSL_CTX_free(mContext);
+}
+
+void TlsContext::setApplicationProtocols(const std::vector<std::string>& protocols)
+{
+    //kept in the wire format, each name preceded by its length
+    mApplicationProtocols.clear();
+    for (std::vector<std::string>::const_iterator iter = protocols.begin(); iter != protocols.end(); ++iter)
+    {
+        mApplicationProtocols.push_back(static_cast<char>(iter->size()));
+        mApplicationProtocols.append(*iter);
+    }
+    SSL_CTX_set_alpn_select_cb(mContext, &TlsContext::selectProtocol, this);
+}
+
+int TlsContext::selectProtocol(SSL* ssl, const unsigned char** out, unsigned char* outLength,
+        const unsigned char* in, unsigned int inLength, void* context)
+{
+    const std::string& protocols = static_cast<TlsContext*>(context)->mApplicationProtocols;
+    unsigned char* selected = 0;
+    //the first of ours the client also offers, so the server's preference wins
+    if (OPENSSL_NPN_NEGOTIATED
+            != SSL_select_next_proto(&selected, outLength,
+                    reinterpret_cast<const unsigned char*>(protocols.data()), protocols.size(), in, inLength))
+    {
+        return SSL_TLSEXT_ERR_NOACK;
+    }
+    *out = selected;
+    return SSL_TLSEXT_ERR_OK;
+}
+
+unsigned int TlsContext::getHandshakeMilliseconds() const
+{
+    return mHandshakeMilliseconds;
+}
+
+size_t TlsContext::getHandshakes() const
+{
+    return mHandshakes;
+}
+
+size_t TlsContext::getResumed() const
+{
+    return mResumed;
+}
+
+size_t TlsContext::getKernelTls() const
+{
+    return mKernelTls;
+}
+
+TlsStream::TlsStream(TlsContext& context, const int socket) throw (std::runtime_error)
+        : mContext(context), mSession(SSL_new(context.mContext)), mKernelTls(false)
+{
+    if (0 == mSession)
+        throw(std::runtime_error(describe("Failed to create TLS session")));
+    if (1 != SSL_set_fd(mSession, socket))
+    {
+        const std::string reason(describe("Failed to attach TLS session"));
+        SSL_free(mSession);
+        throw(std::runtime_error(reason));
+    }
+    SSL_set_accept_state(mSession);
+}
+
+TlsStream::~TlsStream()
+{
+    SSL_free(mSession);
+}
+
+TlsStream::Status TlsStream::handshake()
+{
+    ERR_clear_error();
+    const int result = SSL_do_handshake(mSession);
+    if (1 != result)
+        return status(result);
+
+    mKernelTls = BIO_get_ktls_send(SSL_get_wbio(mSession));
+    ++mContext.mHandshakes;
+    if (SSL_session_reused(mSession))
+        ++mContext.mResumed;
+    if (mKernelTls)
+        ++mContext.mKernelTls;
+    return TLS_OK;
+}
+
+TlsStream::Status TlsStream::read(char* buffer, const size_t length, size_t& count)
+{
+    ERR_clear_error();
+    const int result = SSL_read_ex(mSession, buffer, length, &count);
+    if (1 == result)
+        return TLS_OK;
+    count = 0;
+    return status(result);
+}
+
+TlsStream::Status TlsStream::write(const char* data, const size_t length, size_t& count)
+{
+    ERR_clear_error();
+    const int result = SSL_write_ex(mSession, data, length, &count);
+    if (1 == result)
+        return TLS_OK;
+    count = 0;
+    return status(result);
+}
+
+TlsStream::Status TlsStream::sendFile(const int fd, const unsigned long long offset, const size_t length,
+        size_t& count)
+{
+    count = 0;
+    if (mKernelTls)
+    {
+        ERR_clear_error();
+        const ossl_ssize_t result = SSL_sendfile(mSession, fd, offset, length, 0);
+        if (result < 0)
+            return status(result);
+        count = result;
+        return TLS_OK;
+    }
+
+    /**
+     * A write waiting on the socket is retried with the same bytes, so each attempt reads the same record's
+     * worth from the same offset
+     */
+    mRecord.resize(RECORD_SIZE);
+    ssize_t nbytes = -1;
+    do
+    {
+        nbytes = ::pread(fd, &mRecord[0], std::min(length, RECORD_SIZE), offset);
+    } while (-1 == nbytes && EINTR == errno);
+    if (-1 == nbytes)
+    {
+        mError = strerror(errno);
+        return TLS_FAILED;
+    }
+    if (0 == nbytes)
+        return TLS_OK;
+    return write(&mRecord[0], nbytes, count);
+}
+
+void TlsStream::shutdown()
+{
+    ERR_clear_error();
+    SSL_shutdown(mSession);
+    ERR_clear_error();
+}
+
+bool TlsStream::isKernelTls() const
+{
+    return mKernelTls;
+}
+
+std::string TlsStream::getError() const
+{
+    return mError;
+}
+
+TlsStream::Status TlsStream::status(const int result)
+{
+    const int savedErrno = errno;
+    switch (SSL_get_error(mSession, result))
+    {
+    case SSL_ERROR_WANT_READ:
+        return TLS_WANT_READ;
+    case SSL_ERROR_WANT_WRITE:
+        return TLS_WANT_WRITE;
+    case SSL_ERROR_ZERO_RETURN:
+        return TLS_CLOSED;
+    case SSL_ERROR_SYSCALL:
+        mError = describe(0 == savedErrno ? "connection reset" : strerror(savedErrno));
+        return TLS_FAILED;
+    default:
+        mError = describe("TLS error");
+        return TLS_FAILED;
+    }
+}
+
+}
+}
+}
+
+#endif
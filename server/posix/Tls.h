@@ -0,0 +1,134 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "tcp/posix/Platform.h"
+#include "tcp/posix/posix.h"
+
+struct ssl_st;
+struct ssl_ctx_st;
+
+namespace c11http {
+namespace tcp {
+namespace posix {
+
+/**
+ * TLS settings shared by the connections of one or more servers: the certificate, and what lets a returning client
+ * resume its session with an abbreviated handshake. A session is resumed either by ID, from a cache kept here, or
+ * from a ticket the client holds, encrypted with keys kept here, so connections accepted through the same context,
+ * by any server, resume each other's sessions.
+ */
+class TCP_POSIX_API TlsContext
+{
+public:
+    struct Options
+    {
+        Options();
+        std::string certificateFile; //PEM, the certificate followed by any intermediates
+        std::string privateKeyFile; //PEM
+        unsigned long sessionCacheSize; //sessions kept for resumption by ID
+        unsigned int sessionTimeoutSeconds; //how long a session, by ID or by ticket, can be resumed
+        unsigned int handshakeMilliseconds; //connections not identified by then are closed, 0 for no limit
+        /**
+         * Once a handshake completes, hand record encryption to the kernel where it supports it, so responses
+         * are written and sent from files as on a plain connection. Sessions it cannot take stay in user space.
+         */
+        bool kernelTls;
+    };
+
+    /**
+     * Load the certificate and key. Throws if either can not be loaded, or they do not match.
+     */
+    explicit TlsContext(const Options& options) throw (std::runtime_error);
+    ~TlsContext();
+
+    /**
+     * Offer protocols to clients through ALPN, most preferred first, e.g. "h2" then "http/1.1". Clients offering
+     * none of them carry on without one. Must be called before connections are accepted.
+     */
+    void setApplicationProtocols(const std::vector<std::string>& protocols);
+
+    unsigned int getHandshakeMilliseconds() const;
+    size_t getHandshakes() const;
+    size_t getResumed() const; //handshakes that resumed an earlier session
+    size_t getKernelTls() const; //sessions whose sends were handed to the kernel
+
+private:
+    friend class TlsStream;
+
+    TlsContext(const TlsContext&);
+    TlsContext& operator=(const TlsContext&);
+
+    static int selectProtocol(ssl_st* ssl, const unsigned char** out, unsigned char* outLength,
+            const unsigned char* in, unsigned int inLength, void* context);
+
+    ssl_ctx_st* mContext;
+    std::string mApplicationProtocols;
+    const unsigned int mHandshakeMilliseconds;
+    std::atomic<size_t> mHandshakes;
+    std::atomic<size_t> mResumed;
+    std::atomic<size_t> mKernelTls;
+};
+
+/**
+ * The TLS session of one accepted connection, reading and writing its non-blocking socket. A call the socket can
+ * not complete yet says whether it waits for the socket to be readable or writable, and is retried once it is; a
+ * write is retried with the same bytes, though they may have moved.
+ */
+class TCP_POSIX_API TlsStream
+{
+public:
+    enum Status
+    {
+        TLS_OK, TLS_WANT_READ, TLS_WANT_WRITE, TLS_CLOSED, TLS_FAILED
+    };
+
+    TlsStream(TlsContext& context, const int socket) throw (std::runtime_error);
+    ~TlsStream();
+
+    /**
+     * Continue the server side of the handshake.
+     */
+    Status handshake();
+    /**
+     * Read decrypted bytes into buffer, count of them.
+     */
+    Status read(char* buffer, const size_t length, size_t& count);
+    /**
+     * Encrypt and write up to length bytes, count of them.
+     */
+    Status write(const char* data, const size_t length, size_t& count);
+    /**
+     * Send up to length bytes of the file from offset, count of them. Read through a buffer of one record at
+     * a time, unless the kernel encrypts this session, when the file is sent from the page cache.
+     */
+    Status sendFile(const int fd, const unsigned long long offset, const size_t length, size_t& count);
+    /**
+     * Tell the client the session is closing, without waiting for its reply.
+     */
+    void shutdown();
+
+    /**
+     * True once the kernel encrypts what is sent, so the socket can be written like a plain one.
+     */
+    bool isKernelTls() const;
+    std::string getError() const;
+
+private:
+    TlsStream(const TlsStream&);
+    TlsStream& operator=(const TlsStream&);
+
+    Status status(const int result);
+
+    TlsContext& mContext;
+    ssl_st* mSession;
+    bool mKernelTls;
+    std::string mError;
+    std::vector<char> mRecord; //file bytes being encrypted
+};
+
+}
+}
+}
@@ -1,6 +1,45 @@
 #pragma once
 
 #define MAX_BUFFER_SIZE 1024
+#define MAX_GATHERED_BUFFERS 64 //buffers written by one writev
 
+#include <memory>
 #include <stdexcept>
+#include <string>
 #include <sys/socket.h>
+
+namespace c11http {
+namespace tcp {
+namespace posix {
+
+/**
+ * Identifies a connection for the lifetime of a server. Unlike a socket, a handle is never reused.
+ */
+typedef unsigned long long ConnectionHandle;
+typedef std::shared_ptr<const std::string> SharedBuffer;
+/**
+ * Immutable bytes kept alive by owner, e.g. a cached response or a memory mapped archive. Queued on any number of
+ * connections at once, and written without copying.
+ */
+struct SharedRegion
+{
+    SharedRegion()
+            : data(0), length(0)
+    {
+    }
+    SharedRegion(const SharedBuffer& buffer)
+            : owner(buffer), data(buffer->data()), length(buffer->size())
+    {
+    }
+    SharedRegion(const std::shared_ptr<const void>& regionOwner, const char* regionData, const size_t regionLength)
+            : owner(regionOwner), data(regionData), length(regionLength)
+    {
+    }
+    std::shared_ptr<const void> owner;
+    const char* data;
+    size_t length;
+};
+
+}
+}
+}
@@ -0,0 +1,141 @@
+#ifndef WINDOWS
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "client/posix/ClientEngine.h"
+#include "objects/HttpRequest.h"
+#include "objects/HttpResponse.h"
+#include "tcp/Server.h"
+#include "tcp/posix/AssetArchive.h"
+
+#pragma warning(disable:4251)
+#include <gtest/gtest.h>
+
+using namespace c11http;
+
+namespace {
+
+void writeAsset(const std::string& path, const std::string& contents) {
+   std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+   out << contents;
+}
+
+std::string compressible() {
+   std::string contents;
+   for(int i = 0; i < 500; ++i) contents.append("function handler() { return 'compressible'; }\n");
+   return contents;
+}
+
+}
+
+TEST(ASSET_ARCHIVE_TEST, TEST_PACK_AND_FIND)
+{
+   char directory[] = "/tmp/c11http-assets-XXXXXX";
+   ASSERT_TRUE(0 != mkdtemp(directory));
+   const std::string root(directory);
+   ASSERT_EQ(0, mkdir((root + "/docs").c_str(), 0700));
+   writeAsset(root + "/app.js", compressible());
+   writeAsset(root + "/tiny.txt", "x");
+   writeAsset(root + "/docs/index.html", "<html></html>");
+   const std::string archivePath = root + ".assets";
+
+   //three files, and the directory alias of the index
+   EXPECT_EQ(4u, tcp::posix::AssetArchive::pack(root, archivePath));
+   tcp::posix::AssetArchive archive(archivePath);
+   EXPECT_EQ(4u, archive.size());
+
+   tcp::posix::AssetArchive::Asset asset;
+   ASSERT_TRUE(archive.find("/app.js", 7, asset));
+   EXPECT_LT(0u, asset.responseLengths[tcp::posix::AssetArchive::IDENTITY]);
+   EXPECT_LT(0u, asset.responseLengths[tcp::posix::AssetArchive::GZIP]);
+   EXPECT_GT(asset.responseLengths[tcp::posix::AssetArchive::IDENTITY],
+         asset.responseLengths[tcp::posix::AssetArchive::GZIP]);
+   EXPECT_EQ(0u, std::string(asset.responses[0], asset.responseLengths[0]).find("HTTP/1.1 200 OK\r\n"));
+
+   //a single byte cannot be made smaller, so only identity is stored
+   ASSERT_TRUE(archive.find("/tiny.txt", 9, asset));
+   EXPECT_EQ(0u, asset.responseLengths[tcp::posix::AssetArchive::GZIP]);
+   EXPECT_EQ(0u, asset.responseLengths[tcp::posix::AssetArchive::BROTLI]);
+
+   ASSERT_TRUE(archive.find("/docs/", 6, asset));
+   EXPECT_FALSE(archive.find("/docs", 5, asset));
+   EXPECT_FALSE(archive.find("/missing.js", 11, asset));
+
+   unlink(archivePath.c_str());
+   unlink((root + "/app.js").c_str());
+   unlink((root + "/tiny.txt").c_str());
+   unlink((root + "/docs/index.html").c_str());
+   rmdir((root + "/docs").c_str());
+   rmdir(root.c_str());
+}
+
+TEST(ASSET_ARCHIVE_TEST, TEST_SERVE_ENCODINGS)
+{
+   char directory[] = "/tmp/c11http-assets-XXXXXX";
+   ASSERT_TRUE(0 != mkdtemp(directory));
+   const std::string root(directory);
+   const std::string contents = compressible();
+   writeAsset(root + "/app.js", contents);
+   const std::string archivePath = root + ".assets";
+   tcp::posix::AssetArchive::pack(root, archivePath);
+
+   tcp::Server server(8090);
+   server.serveAssetArchive("/assets", archivePath);
+   server.registerHandler([](const objects::HttpRequest& req) {
+      return objects::HttpResponse(200, "dynamic");
+   }, tcp::Server::DISPATCH_INLINE);
+   std::thread serverThread(&tcp::Server::waitForEvents, &server);
+   std::this_thread::sleep_for(std::chrono::milliseconds(25));
+
+   client::posix::ClientEngine engine;
+   std::thread engineThread(&client::posix::ClientEngine::run, &engine);
+   client::posix::ClientEngine::Connection* connection = engine.connect("127.0.0.1", 8090, "AssetClient");
+
+   objects::HttpResponse identity = connection->sendRequestToServer(
+         objects::HttpRequest(objects::HttpRequest::GET, "/assets/app.js?v=1", ""));
+   EXPECT_EQ(200u, identity.getStatus());
+   EXPECT_EQ(std::string("application/javascript"), identity.getHeader("content-type"));
+   EXPECT_TRUE(identity.getHeader("content-encoding").empty());
+   EXPECT_TRUE(contents == identity.getBody());
+
+   objects::HttpRequest gzipped(objects::HttpRequest::GET, "/assets/app.js", "");
+   gzipped.setHeader("Accept-Encoding", "gzip, br;q=0");
+   objects::HttpResponse compressed = connection->sendRequestToServer(gzipped);
+   EXPECT_EQ(200u, compressed.getStatus());
+   EXPECT_EQ(std::string("gzip"), compressed.getHeader("content-encoding"));
+   ASSERT_LT(2u, compressed.getBody().size());
+   EXPECT_EQ('\x1f', compressed.getBody()[0]);
+   EXPECT_EQ('\x8b', compressed.getBody()[1]);
+   //the codings' bytes differ, so the ETag they share is weak
+   EXPECT_EQ(identity.getHeader("etag"), compressed.getHeader("etag"));
+   EXPECT_EQ(0u, identity.getHeader("etag").find("W/\""));
+
+   objects::HttpRequest conditional(objects::HttpRequest::GET, "/assets/app.js", "");
+   conditional.setHeader("If-None-Match", identity.getHeader("etag"));
+   EXPECT_EQ(304u, connection->sendRequestToServer(conditional).getStatus());
+   conditional.setHeader("If-None-Match", "\"other\", " + identity.getHeader("etag").substr(2));
+   EXPECT_EQ(304u, connection->sendRequestToServer(conditional).getStatus());
+   conditional.setHeader("If-None-Match", "W/\"other\"");
+   EXPECT_EQ(200u, connection->sendRequestToServer(conditional).getStatus());
+
+   EXPECT_EQ(std::string("dynamic"), connection->sendRequestToServer(
+         objects::HttpRequest(objects::HttpRequest::GET, "/assets/missing.js", "")).getBody());
+
+   delete connection;
+   engine.shutdown();
+   engineThread.join();
+   server.shutdown();
+   serverThread.join();
+
+   unlink(archivePath.c_str());
+   unlink((root + "/app.js").c_str());
+   rmdir(root.c_str());
+}
+#endif
@@ -0,0 +1,115 @@
+#include <string>
+#include <vector>
+
+#include "client/interface/IClient.h"
+#include "objects/HttpRequest.h"
+#include "objects/HttpResponse.h"
+
+#pragma warning(disable:4251)
+#include <gtest/gtest.h>
+
+using namespace c11http;
+
+/**
+ * Client that records written requests instead of sending them, so responses can be fed back by hand.
+ */
+class RecordingClient : public client::IClient {
+public:
+   RecordingClient() : client::IClient(ClientResponseCallback()) {
+
+   }
+   virtual objects::HttpResponse sendRequestToServer(const objects::HttpRequest& req) {
+      return sendRequestAsync(req).get();
+   }
+   virtual void connectToServer(const std::string& ip, const unsigned int port) {
+
+   }
+   virtual void disconnect() {
+      failRequests("disconnected");
+   }
+   std::vector<std::string> mWritten;
+protected:
+   virtual void performServerConnection(const std::string& ip, const unsigned int port) {
+
+   }
+   virtual void writeRequest(const std::string& bytes) {
+      mWritten.push_back(bytes);
+   }
+};
+
+TEST(ASYNC_CLIENT_TEST, TEST_PIPELINED_FIFO)
+{
+   RecordingClient client;
+   client.setMaxInFlight(2);
+
+   std::vector<std::string> answered;
+   for(int i = 0; i < 3; ++i) {
+      std::string target = std::string("/") + char('a' + i);
+      client.sendRequestAsync(objects::HttpRequest(objects::HttpRequest::GET, target, ""),
+            [&answered, target](const objects::HttpResponse& resp) {
+         answered.push_back(target + "=" + resp.getBody());
+      });
+   }
+
+   //third request is held until the first is answered
+   ASSERT_EQ(2u, client.mWritten.size());
+   EXPECT_EQ(2u, client.getInFlight());
+   EXPECT_EQ(std::string("GET /a HTTP/1.1\r\n\r\n"), client.mWritten[0]);
+
+   client.receiveResponseFromServer(objects::HttpResponse("1"));
+   ASSERT_EQ(3u, client.mWritten.size());
+   client.receiveResponseFromServer(objects::HttpResponse("2"));
+   client.receiveResponseFromServer(objects::HttpResponse("3"));
+
+   ASSERT_EQ(3u, answered.size());
+   EXPECT_EQ(std::string("/a=1"), answered[0]);
+   EXPECT_EQ(std::string("/b=2"), answered[1]);
+   EXPECT_EQ(std::string("/c=3"), answered[2]);
+   EXPECT_EQ(0u, client.getInFlight());
+}
+
+TEST(ASYNC_CLIENT_TEST, TEST_FAILED_FUTURE)
+{
+   RecordingClient client;
+   std::future<objects::HttpResponse> answered = client.sendRequestAsync(objects::HttpRequest());
+   std::future<objects::HttpResponse> failed = client.sendRequestAsync(objects::HttpRequest());
+
+   client.receiveResponseFromServer(objects::HttpResponse(204, ""));
+   client.disconnect();
+
+   EXPECT_EQ(204u, answered.get().getStatus());
+   EXPECT_THROW(failed.get(), std::runtime_error);
+}
+
+TEST(ASYNC_CLIENT_TEST, TEST_COALESCED_GETS)
+{
+   RecordingClient client;
+   client.setCoalesceGets(true);
+
+   std::vector<std::string> answered;
+   client::IClient::ClientResponseCallback record = [&answered](const objects::HttpResponse& resp) {
+      answered.push_back(resp.getBody());
+   };
+   for(int i = 0; i < 3; ++i) {
+      client.sendRequestAsync(objects::HttpRequest(objects::HttpRequest::GET, "/config", ""), record);
+   }
+   client.sendRequestAsync(objects::HttpRequest(objects::HttpRequest::GET, "/catalog", ""), record);
+
+   //one request per distinct GET
+   ASSERT_EQ(2u, client.mWritten.size());
+   EXPECT_EQ(2u, client.getCoalesced());
+
+   client.receiveResponseFromServer(objects::HttpResponse("config"));
+   ASSERT_EQ(3u, answered.size());
+   EXPECT_EQ(std::string("config"), answered[2]);
+
+   //answered, so the next one is sent again, and a failure reaches every waiter
+   std::future<objects::HttpResponse> first = client.sendRequestAsync(
+         objects::HttpRequest(objects::HttpRequest::GET, "/config", ""));
+   std::future<objects::HttpResponse> second = client.sendRequestAsync(
+         objects::HttpRequest(objects::HttpRequest::GET, "/config", ""));
+   EXPECT_EQ(3u, client.mWritten.size());
+   client.disconnect();
+   EXPECT_THROW(first.get(), std::runtime_error);
+   EXPECT_THROW(second.get(), std::runtime_error);
+}
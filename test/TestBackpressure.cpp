@@ -0,0 +1,266 @@
+#ifndef WINDOWS
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "objects/HttpRequest.h"
+#include "objects/HttpResponse.h"
+#include "tcp/Server.h"
+
+#include "TestSupport.h"
+
+#pragma warning(disable:4251)
+#include <gtest/gtest.h>
+
+using namespace c11http;
+
+namespace {
+
+/**
+ * A client with a small receive buffer, so that what it has not read stays queued on the server.
+ */
+class SlowClient : public test::RawClient {
+public:
+   SlowClient(const unsigned short port, const std::string& identifier) :
+         test::RawClient(port, identifier, 0, "", 4096) {
+
+   }
+
+   /**
+    * Everything sent until nothing more arrives for a while, and whether the server closed the connection.
+    */
+   std::string drain(bool& closed) {
+      setTimeout(250);
+      std::string received;
+      int count;
+      while((count = receive(received)) > 0);
+      closed = 0 == count;
+      return received;
+   }
+};
+
+class BackpressureServer : public tcp::Server {
+public:
+   BackpressureServer(const unsigned int port) : tcp::Server(port) {
+
+   }
+
+   virtual void backpressure(const std::string& identifier, const bool paused) {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mEvents.push_back(identifier + (paused ? " paused" : " resumed"));
+   }
+
+   std::vector<std::string> getEvents() {
+      std::lock_guard<std::mutex> lock(mMutex);
+      return mEvents;
+   }
+
+private:
+   std::mutex mMutex;
+   std::vector<std::string> mEvents;
+};
+
+const size_t MESSAGE_SIZE = 64 * 1024;
+const int MESSAGES = 128;
+
+std::string numbered(const int index) {
+   char number[8];
+   snprintf(number, sizeof(number), "#%05d", index);
+   return std::string(number).append(MESSAGE_SIZE - 6, 'm');
+}
+
+/**
+ * Broadcast numbered messages, the fast client reading each before the next is sent, and then return the indices
+ * of the whole messages the slow client had queued for it.
+ */
+std::vector<int> broadcastPastSlowClient(tcp::Server& server, SlowClient& fast, SlowClient& slow, bool& closed) {
+   for(int i = 0; i < MESSAGES; ++i) {
+      const std::string message(numbered(i));
+      server.broadcast(message.data(), message.size());
+      std::string received;
+      EXPECT_TRUE(fast.read(received, MESSAGE_SIZE));
+      EXPECT_EQ(message, received);
+   }
+
+   const std::string stream(slow.drain(closed));
+   //a connection closed part way through a message is cut short
+   if(!closed) {
+      EXPECT_EQ(0u, stream.size() % MESSAGE_SIZE);
+   }
+   std::vector<int> indices;
+   for(size_t offset = 0; offset + MESSAGE_SIZE <= stream.size(); offset += MESSAGE_SIZE) {
+      EXPECT_EQ(stream.substr(offset, MESSAGE_SIZE), numbered(atoi(stream.c_str() + offset + 1)));
+      indices.push_back(atoi(stream.c_str() + offset + 1));
+   }
+   return indices;
+}
+
+}
+
+TEST(BACKPRESSURE_TEST, TEST_READ_PAUSED)
+{
+   BackpressureServer server(8099);
+   std::atomic<int> handled(0);
+   server.registerHandler([&handled](const objects::HttpRequest& req) {
+      ++handled;
+      return objects::HttpResponse(200, std::string(1024 * 1024, 'x') + "#" + req.getTarget());
+   }, tcp::Server::DISPATCH_INLINE);
+   server.setOutputWatermarks(1024 * 1024, 256 * 1024);
+   std::thread serverThread(&tcp::Server::waitForEvents, &server);
+   std::this_thread::sleep_for(std::chrono::milliseconds(25));
+
+   SlowClient client(8099, "PausedClient");
+   ASSERT_TRUE(client.isConnected());
+   std::string first;
+   std::string second;
+   for(int i = 0; i < 8; ++i) {
+      first += "GET /" + std::to_string(i) + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+      second += "GET /" + std::to_string(i + 8) + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+   }
+
+   //requests already read are answered, but no more are read while their responses wait on the client
+   client.write(first);
+   std::this_thread::sleep_for(std::chrono::milliseconds(100));
+   client.write(second);
+   std::this_thread::sleep_for(std::chrono::milliseconds(100));
+   EXPECT_EQ(8, handled.load());
+   ASSERT_EQ(1u, server.getEvents().size());
+   EXPECT_EQ(std::string("PausedClient paused"), server.getEvents()[0]);
+
+   const std::string responses(client.readUntil("#/15"));
+   EXPECT_EQ(16, handled.load());
+   size_t count = 0;
+   for(size_t found = responses.find("HTTP/1.1 200"); std::string::npos != found;
+         found = responses.find("HTTP/1.1 200", found + 1)) {
+      ++count;
+   }
+   EXPECT_EQ(16u, count);
+
+   std::this_thread::sleep_for(std::chrono::milliseconds(25));
+   const std::vector<std::string> events(server.getEvents());
+   ASSERT_EQ(0u, events.size() % 2);
+   for(size_t i = 0; i < events.size(); ++i) {
+      EXPECT_EQ(std::string(0 == i % 2 ? "PausedClient paused" : "PausedClient resumed"), events[i]);
+   }
+
+   server.shutdown();
+   serverThread.join();
+}
+
+TEST(BACKPRESSURE_TEST, TEST_SEND_PAUSED)
+{
+   BackpressureServer server(8104);
+   server.setOutputWatermarks(1024 * 1024, 256 * 1024);
+   std::thread serverThread(&tcp::Server::waitForEvents, &server);
+   std::this_thread::sleep_for(std::chrono::milliseconds(25));
+
+   SlowClient client(8104, "SendClient");
+   ASSERT_TRUE(client.isConnected());
+
+   //messages sent by the application count against the watermark as responses do, more of them than the socket
+   //buffers can take, though those may take enough between sends to resume reading for a while
+   const std::string message(1024 * 1024, 's');
+   for(int i = 0; i < 16; ++i) {
+      server.send(message.data(), message.size(), "SendClient");
+   }
+   server.send("end", 3, "SendClient");
+   server.send("lost", 4, "Missing");
+   std::this_thread::sleep_for(std::chrono::milliseconds(100));
+   std::vector<std::string> events(server.getEvents());
+   ASSERT_EQ(1u, events.size() % 2);
+   EXPECT_EQ(std::string("SendClient paused"), events.back());
+
+   EXPECT_EQ(16 * message.size() + 3, client.readUntil("end").size());
+   std::this_thread::sleep_for(std::chrono::milliseconds(25));
+   events = server.getEvents();
+   ASSERT_EQ(0u, events.size() % 2);
+   for(size_t i = 0; i < events.size(); ++i) {
+      EXPECT_EQ(std::string(0 == i % 2 ? "SendClient paused" : "SendClient resumed"), events[i]);
+   }
+
+   server.shutdown();
+   serverThread.join();
+}
+
+TEST(BACKPRESSURE_TEST, TEST_DROP_NEWEST)
+{
+   tcp::Server server(8100);
+   server.setOutputWatermarks(256 * 1024, 64 * 1024, tcp::Server::DROP_NEWEST);
+   std::thread serverThread(&tcp::Server::waitForEvents, &server);
+   std::this_thread::sleep_for(std::chrono::milliseconds(25));
+
+   SlowClient fast(8100, "FastClient");
+   SlowClient slow(8100, "SlowClient");
+   ASSERT_TRUE(fast.isConnected());
+   ASSERT_TRUE(slow.isConnected());
+
+   //the slow client misses the messages sent while its queue was full, later ones get in again whenever its
+   //socket buffers drain and make room
+   bool closed;
+   const std::vector<int> indices(broadcastPastSlowClient(server, fast, slow, closed));
+   EXPECT_FALSE(closed);
+   ASSERT_FALSE(indices.empty());
+   EXPECT_EQ(0, indices.front());
+   EXPECT_GT(MESSAGES, static_cast<int>(indices.size()));
+   for(size_t i = 1; i < indices.size(); ++i) {
+      EXPECT_LT(indices[i - 1], indices[i]);
+   }
+
+   server.shutdown();
+   serverThread.join();
+}
+
+TEST(BACKPRESSURE_TEST, TEST_DROP_OLDEST)
+{
+   tcp::Server server(8101);
+   server.setOutputWatermarks(256 * 1024, 64 * 1024, tcp::Server::DROP_OLDEST);
+   std::thread serverThread(&tcp::Server::waitForEvents, &server);
+   std::this_thread::sleep_for(std::chrono::milliseconds(25));
+
+   SlowClient fast(8101, "FastClient");
+   SlowClient slow(8101, "SlowClient");
+   ASSERT_TRUE(fast.isConnected());
+   ASSERT_TRUE(slow.isConnected());
+
+   //the slow client skips from what was already on its way to the newest messages
+   bool closed;
+   const std::vector<int> indices(broadcastPastSlowClient(server, fast, slow, closed));
+   EXPECT_FALSE(closed);
+   ASSERT_FALSE(indices.empty());
+   EXPECT_GT(MESSAGES, static_cast<int>(indices.size()));
+   EXPECT_EQ(MESSAGES - 1, indices.back());
+   for(size_t i = 1; i < indices.size(); ++i) {
+      EXPECT_LT(indices[i - 1], indices[i]);
+   }
+
+   server.shutdown();
+   serverThread.join();
+}
+
+TEST(BACKPRESSURE_TEST, TEST_DISCONNECT)
+{
+   tcp::Server server(8102);
+   server.setOutputWatermarks(256 * 1024, 64 * 1024, tcp::Server::DISCONNECT);
+   std::thread serverThread(&tcp::Server::waitForEvents, &server);
+   std::this_thread::sleep_for(std::chrono::milliseconds(25));
+
+   SlowClient fast(8102, "FastClient");
+   SlowClient slow(8102, "SlowClient");
+   ASSERT_TRUE(fast.isConnected());
+   ASSERT_TRUE(slow.isConnected());
+
+   //the slow client is closed once its queue would overflow, and the fast one is sent everything
+   bool closed;
+   const std::vector<int> indices(broadcastPastSlowClient(server, fast, slow, closed));
+   EXPECT_TRUE(closed);
+   EXPECT_GT(MESSAGES, static_cast<int>(indices.size()));
+
+   server.shutdown();
+   serverThread.join();
+}
+#endif
@@ -0,0 +1,62 @@
+#ifndef WINDOWS
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tcp/Server.h"
+
+#include "TestSupport.h"
+
+#pragma warning(disable:4251)
+#include <gtest/gtest.h>
+
+using namespace c11http;
+
+TEST(BROADCAST_TEST, TEST_TOPICS)
+{
+   tcp::Server server(8098);
+   std::thread serverThread(&tcp::Server::waitForEvents, &server);
+   std::this_thread::sleep_for(std::chrono::milliseconds(25));
+
+   std::vector<std::unique_ptr<test::RawClient> > clients;
+   for(int i = 0; i < 3; ++i) {
+      clients.push_back(std::unique_ptr<test::RawClient>(new test::RawClient(8098, "Subscriber" + std::to_string(i))));
+      ASSERT_TRUE(clients.back()->isConnected());
+   }
+
+   server.subscribe("Subscriber0", "prices");
+   server.subscribe("Subscriber1", "prices");
+   server.subscribe("Subscriber1", "prices");
+   server.subscribe("Subscriber2", "news");
+   server.subscribe("Missing", "news");
+
+   const std::string prices("AAPL 101;");
+   const std::string news("market open;");
+   const std::string large(256 * 1024, 'z');
+   server.publish("prices", prices.data(), prices.size());
+   server.publish("news", news.data(), news.size());
+   server.publish("nobody", news.data(), news.size());
+   server.broadcast(large.data(), large.size());
+   server.broadcast("end", 3);
+
+   //each subscribed once, however many times it asked to be
+   EXPECT_EQ(prices + large + "end", clients[0]->readUntil("end"));
+   EXPECT_EQ(prices + large + "end", clients[1]->readUntil("end"));
+   EXPECT_EQ(news + large + "end", clients[2]->readUntil("end"));
+
+   //unsubscribed, and closed, connections are sent nothing more
+   server.unsubscribe("Subscriber0", "prices");
+   clients[2].reset();
+   std::this_thread::sleep_for(std::chrono::milliseconds(25));
+   server.publish("prices", prices.data(), prices.size());
+   server.publish("news", news.data(), news.size());
+   server.broadcast("done", 4);
+   EXPECT_EQ(std::string("done"), clients[0]->readUntil("done"));
+   EXPECT_EQ(prices + "done", clients[1]->readUntil("done"));
+
+   server.shutdown();
+   serverThread.join();
+}
+#endif
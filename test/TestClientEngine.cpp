@@ -0,0 +1,79 @@
+#ifndef WINDOWS
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "client/posix/ClientEngine.h"
+#include "objects/HttpRequest.h"
+#include "objects/HttpResponse.h"
+#include "tcp/Server.h"
+
+#pragma warning(disable:4251)
+#include <gtest/gtest.h>
+
+using namespace c11http;
+
+TEST(CLIENT_ENGINE_TEST, TEST_PIPELINED_CONNECTIONS)
+{
+   tcp::Server server(8082);
+   server.registerHandler([](const objects::HttpRequest& req) {
+      return objects::HttpResponse(200, req.getTarget());
+   }, tcp::Server::DISPATCH_INLINE);
+   std::thread serverThread(&tcp::Server::waitForEvents, &server);
+   std::this_thread::sleep_for(std::chrono::milliseconds(25));
+
+   client::posix::ClientEngine engine;
+   std::thread engineThread(&client::posix::ClientEngine::run, &engine);
+
+   std::vector<client::posix::ClientEngine::Connection*> connections;
+   for(int i = 0; i < 4; ++i) {
+      connections.push_back(engine.connect("127.0.0.1", 8082, std::string("EngineClient") + char('0' + i)));
+   }
+   EXPECT_EQ(4u, engine.getConnectionCount());
+
+   //requests are queued until each connection is established, then pipelined
+   std::vector<std::future<objects::HttpResponse> > responses;
+   for(int i = 0; i < 12; ++i) {
+      std::string target = std::string("/") + char('a' + i);
+      responses.push_back(connections[i % 4]->sendRequestAsync(
+            objects::HttpRequest(objects::HttpRequest::GET, target, "")));
+   }
+   for(int i = 0; i < 12; ++i) {
+      ASSERT_EQ(std::future_status::ready, responses[i].wait_for(std::chrono::seconds(5)));
+      EXPECT_EQ(std::string("/") + char('a' + i), responses[i].get().getBody());
+   }
+
+   objects::HttpResponse resp = connections[0]->sendRequestToServer(
+         objects::HttpRequest(objects::HttpRequest::GET, "/blocking", ""));
+   EXPECT_EQ(std::string("/blocking"), resp.getBody());
+
+   delete connections[0];
+   EXPECT_EQ(3u, engine.getConnectionCount());
+
+   engine.shutdown();
+   engineThread.join();
+   server.shutdown();
+   serverThread.join();
+}
+
+TEST(CLIENT_ENGINE_TEST, TEST_FAILED_CONNECT)
+{
+   client::posix::ClientEngine engine;
+   std::thread engineThread(&client::posix::ClientEngine::run, &engine);
+
+   //nothing listens on this port, so the request fails once the connect is refused
+   client::posix::ClientEngine::Connection* connection = engine.connect("127.0.0.1", 8083, "Refused");
+   std::future<objects::HttpResponse> resp = connection->sendRequestAsync(objects::HttpRequest());
+   ASSERT_EQ(std::future_status::ready, resp.wait_for(std::chrono::seconds(5)));
+   EXPECT_THROW(resp.get(), std::runtime_error);
+   EXPECT_FALSE(connection->isConnected());
+
+   //nor is a request sent once it has closed left waiting
+   resp = connection->sendRequestAsync(objects::HttpRequest());
+   ASSERT_EQ(std::future_status::ready, resp.wait_for(std::chrono::seconds(5)));
+   EXPECT_THROW(resp.get(), std::runtime_error);
+
+   engine.shutdown();
+   engineThread.join();
+}
+#endif
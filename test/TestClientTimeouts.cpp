@@ -0,0 +1,125 @@
+#ifndef WINDOWS
+#include <chrono>
+#include <future>
+#include <thread>
+
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "client/posix/Callback.h"
+#include "client/posix/Client.h"
+#include "objects/HttpRequest.h"
+#include "objects/HttpResponse.h"
+#include "tcp/Server.h"
+
+#pragma warning(disable:4251)
+#include <gtest/gtest.h>
+
+using namespace c11http;
+
+/**
+ * Records the failure reported for a connection.
+ */
+class FailureCallback : public client::posix::Callback {
+public:
+   FailureCallback() : mConnected(false), mDisconnected(false) {
+
+   }
+   virtual void sendComplete(const std::string& identifier, const unsigned int count) {
+
+   }
+   virtual void sendFailed(const std::string& identifier, const std::string& message) {
+      mFailure = message;
+   }
+   virtual void receiveComplete(const std::string& identifier, const char* data, const unsigned int count) {
+
+   }
+   virtual void connected(const std::string& connectedTo) {
+      mConnected = true;
+   }
+   virtual void disconnected(const std::string& connectedTo) {
+      mDisconnected = true;
+   }
+
+   std::string mFailure;
+   bool mConnected;
+   bool mDisconnected;
+};
+
+TEST(CLIENT_TIMEOUTS_TEST, TEST_HANDSHAKE_TIMEOUT)
+{
+   //a listener that never accepts, so the connect succeeds but no acknowledgement ever arrives
+   int listener = ::socket(AF_INET, SOCK_STREAM, 0);
+   int reuse = 1;
+   setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+   struct sockaddr_in address;
+   memset(&address, 0, sizeof(address));
+   address.sin_family = AF_INET;
+   address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+   address.sin_port = htons(8084);
+   ASSERT_EQ(0, bind(listener, (struct sockaddr*) &address, sizeof(address)));
+   ASSERT_EQ(0, listen(listener, 1));
+
+   FailureCallback callback;
+   client::posix::Client::Timeouts timeouts;
+   timeouts.handshakeMilliseconds = 50;
+   client::posix::Client client(&callback, "127.0.0.1", 8084, "Blackholed",
+         client::IClient::ClientResponseCallback(), timeouts);
+   std::future<objects::HttpResponse> resp = client.sendRequestAsync(objects::HttpRequest());
+
+   //returns once the deadline closes the connection
+   std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+   client.waitForEvents();
+   EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(2));
+
+   EXPECT_FALSE(callback.mConnected);
+   EXPECT_TRUE(callback.mDisconnected);
+   EXPECT_EQ(std::string("Timed out waiting for server acknowledgement"), callback.mFailure);
+   EXPECT_THROW(resp.get(), std::runtime_error);
+   ::close(listener);
+}
+
+TEST(CLIENT_TIMEOUTS_TEST, TEST_REQUEST_TIMEOUT)
+{
+   //a server that never answers
+   tcp::Server server(8085);
+   server.registerAsyncHandler([](const objects::HttpRequest&, const objects::HttpResponder&) {
+
+   });
+   std::thread serverThread(&tcp::Server::waitForEvents, &server);
+   std::this_thread::sleep_for(std::chrono::milliseconds(25));
+
+   FailureCallback callback;
+   client::posix::Client::Timeouts timeouts;
+   timeouts.requestMilliseconds = 50;
+   client::posix::Client client(&callback, "127.0.0.1", 8085, "Unanswered",
+         client::IClient::ClientResponseCallback(), timeouts);
+   std::future<objects::HttpResponse> resp = client.sendRequestAsync(objects::HttpRequest());
+
+   client.waitForEvents();
+
+   EXPECT_TRUE(callback.mConnected);
+   EXPECT_TRUE(callback.mDisconnected);
+   EXPECT_EQ(std::string("Timed out waiting for response"), callback.mFailure);
+   EXPECT_THROW(resp.get(), std::runtime_error);
+
+   server.shutdown();
+   serverThread.join();
+}
+
+TEST(CLIENT_TIMEOUTS_TEST, TEST_SEND_AFTER_FAILED_CONNECT)
+{
+   //nothing listens on this port
+   FailureCallback callback;
+   client::posix::Client client(&callback, "127.0.0.1", 8107, "Refused");
+   client.waitForEvents();
+   EXPECT_TRUE(callback.mDisconnected);
+
+   //the closed connection would never answer, so the request fails at once
+   std::future<objects::HttpResponse> resp = client.sendRequestAsync(objects::HttpRequest());
+   ASSERT_EQ(std::future_status::ready, resp.wait_for(std::chrono::seconds(5)));
+   EXPECT_THROW(resp.get(), std::runtime_error);
+}
+#endif
@@ -0,0 +1,92 @@
+#include <thread>
+#include <chrono>
+
+#include "client/interface/ConnectionPool.h"
+#include "client/interface/IClient.h"
+#include "objects/HttpRequest.h"
+#include "objects/HttpResponse.h"
+
+#pragma warning(disable:4251)
+#include <gtest/gtest.h>
+
+using namespace c11http;
+
+class FakeClient : public client::IClient {
+public:
+   FakeClient() : client::IClient(ClientResponseCallback()), mHealthy(true) {
+
+   }
+   virtual objects::HttpResponse sendRequestToServer(const objects::HttpRequest& req) {
+      return objects::HttpResponse();
+   }
+   virtual void connectToServer(const std::string& ip, const unsigned int port) {
+
+   }
+   virtual void disconnect() {
+
+   }
+   bool mHealthy;
+protected:
+   virtual void performServerConnection(const std::string& ip, const unsigned int port) {
+
+   }
+   virtual void writeRequest(const std::string& bytes) {
+
+   }
+};
+
+TEST(CONNECTION_POOL_TEST, TEST_REUSE_AND_LIMITS)
+{
+   int created = 0;
+   client::ConnectionPool::Limits limits;
+   limits.maxIdlePerHost = 1;
+   limits.maxActivePerHost = 2;
+   client::ConnectionPool pool([&created](const std::string&, const unsigned int) -> client::IClient* {
+      ++created;
+      return new FakeClient();
+   }, limits, [](client::IClient* client) {
+      return static_cast<FakeClient*>(client)->mHealthy;
+   });
+
+   client::IClient* first = pool.acquire("127.0.0.1", 8080);
+   client::IClient* second = pool.acquire("127.0.0.1", 8080);
+   EXPECT_THROW(pool.acquire("127.0.0.1", 8080), std::runtime_error);
+   EXPECT_EQ(2, created);
+
+   //only one idle connection is kept
+   pool.release(first);
+   pool.release(second);
+   EXPECT_EQ(1u, pool.idleCount("127.0.0.1", 8080));
+   EXPECT_EQ(0u, pool.activeCount("127.0.0.1", 8080));
+
+   //idle connection is reused, other hosts get their own
+   client::IClient* reused = pool.acquire("127.0.0.1", 8080);
+   EXPECT_EQ(first, reused);
+   pool.acquire("127.0.0.1", 9090);
+   EXPECT_EQ(3, created);
+
+   //unhealthy connections are not kept
+   static_cast<FakeClient*>(reused)->mHealthy = false;
+   pool.release(reused);
+   EXPECT_EQ(0u, pool.idleCount("127.0.0.1", 8080));
+}
+
+TEST(CONNECTION_POOL_TEST, TEST_IDLE_EVICTION)
+{
+   workers::TimerWheel timers(5, 16); //must outlive the pool
+   client::ConnectionPool::Limits limits;
+   limits.idleTimeoutMilliseconds = 10;
+   limits.evictionIntervalMilliseconds = 10;
+   client::ConnectionPool pool([](const std::string&, const unsigned int) -> client::IClient* {
+      return new FakeClient();
+   }, limits);
+   pool.scheduleEviction(timers);
+
+   pool.release(pool.acquire("127.0.0.1", 8080));
+   EXPECT_EQ(1u, pool.idleCount("127.0.0.1", 8080));
+
+   std::this_thread::sleep_for(std::chrono::milliseconds(30));
+   timers.advance(workers::TimerWheel::Clock::now());
+   EXPECT_EQ(0u, pool.idleCount("127.0.0.1", 8080));
+   EXPECT_EQ(1u, timers.size()); //eviction reschedules itself
+}
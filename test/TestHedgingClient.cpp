@@ -0,0 +1,116 @@
+#ifndef WINDOWS
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "client/interface/CachingClient.h"
+#include "client/interface/HedgingClient.h"
+#include "client/interface/ResponseCache.h"
+#include "client/posix/ClientEngine.h"
+#include "objects/HttpRequest.h"
+#include "objects/HttpResponse.h"
+#include "tcp/Server.h"
+
+#pragma warning(disable:4251)
+#include <gtest/gtest.h>
+
+using namespace c11http;
+
+TEST(HEDGING_CLIENT_TEST, TEST_HEDGE_TO_FAST_ENDPOINT)
+{
+   tcp::Server slow(8086);
+   slow.registerHandler([](const objects::HttpRequest& req) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(300));
+      return objects::HttpResponse(200, "slow");
+   }, tcp::Server::DISPATCH_INLINE);
+   tcp::Server fast(8087);
+   fast.registerHandler([](const objects::HttpRequest& req) {
+      return objects::HttpResponse(200, "fast");
+   }, tcp::Server::DISPATCH_INLINE);
+   std::thread slowThread(&tcp::Server::waitForEvents, &slow);
+   std::thread fastThread(&tcp::Server::waitForEvents, &fast);
+   std::this_thread::sleep_for(std::chrono::milliseconds(25));
+
+   client::posix::ClientEngine engine;
+   std::thread engineThread(&client::posix::ClientEngine::run, &engine);
+   std::vector<client::IClient*> endpoints;
+   endpoints.push_back(engine.connect("127.0.0.1", 8086, "HedgeSlow"));
+   endpoints.push_back(engine.connect("127.0.0.1", 8087, "HedgeFast"));
+   client::HedgingClient::Scheduler scheduler = [&engine](const unsigned int milliseconds,
+         const std::function<void()>& task) {
+      engine.runAfter(milliseconds, task);
+   };
+
+   client::HedgingClient::Policy policy;
+   policy.initialDelayMilliseconds = 20;
+   client::HedgingClient hedging(endpoints, scheduler, policy);
+
+   //sent to the slow endpoint first, the hedge answers well before it does
+   const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+   std::future<objects::HttpResponse> resp = hedging.sendRequestAsync(
+         objects::HttpRequest(objects::HttpRequest::GET, "/item", ""));
+   ASSERT_EQ(std::future_status::ready, resp.wait_for(std::chrono::seconds(5)));
+   EXPECT_EQ(std::string("fast"), resp.get().getBody());
+   EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(250));
+   EXPECT_EQ(1u, hedging.getHedges());
+   EXPECT_EQ(1u, hedging.getHedgeWins());
+
+   //with the budget spent, the slow endpoint is waited for
+   policy.budgetBurst = 0;
+   policy.budgetPercent = 0;
+   client::HedgingClient unbudgeted(endpoints, scheduler, policy);
+   resp = unbudgeted.sendRequestAsync(objects::HttpRequest(objects::HttpRequest::GET, "/item", ""));
+   ASSERT_EQ(std::future_status::ready, resp.wait_for(std::chrono::seconds(5)));
+   EXPECT_EQ(std::string("slow"), resp.get().getBody());
+   EXPECT_EQ(0u, unbudgeted.getHedges());
+   EXPECT_EQ(0.0, unbudgeted.getHedgeRate());
+
+   for(size_t i = 0; i < endpoints.size(); ++i) delete endpoints[i];
+   engine.shutdown();
+   engineThread.join();
+   slow.shutdown();
+   fast.shutdown();
+   slowThread.join();
+   fastThread.join();
+}
+
+TEST(HEDGING_CLIENT_TEST, TEST_CACHED_IN_FRONT)
+{
+   tcp::Server server(8109);
+   server.registerHandler([](const objects::HttpRequest& req) {
+      objects::HttpResponse resp(200, "item");
+      resp.setHeader("Cache-Control", "max-age=60");
+      return resp;
+   }, tcp::Server::DISPATCH_INLINE);
+   std::thread serverThread(&tcp::Server::waitForEvents, &server);
+   std::this_thread::sleep_for(std::chrono::milliseconds(25));
+
+   client::posix::ClientEngine engine;
+   std::thread engineThread(&client::posix::ClientEngine::run, &engine);
+   std::vector<client::IClient*> endpoints;
+   endpoints.push_back(engine.connect("127.0.0.1", 8109, "CachedHedgeA"));
+   endpoints.push_back(engine.connect("127.0.0.1", 8109, "CachedHedgeB"));
+   client::HedgingClient hedging(endpoints, [&engine](const unsigned int milliseconds,
+         const std::function<void()>& task) {
+      engine.runAfter(milliseconds, task);
+   });
+
+   //only what the cache can not answer is hedged
+   client::ResponseCache cache;
+   client::CachingClient caching(&hedging, &cache);
+   for(int i = 0; i < 3; ++i) {
+      std::future<objects::HttpResponse> resp = caching.sendRequestAsync(
+            objects::HttpRequest(objects::HttpRequest::GET, "/item", ""));
+      ASSERT_EQ(std::future_status::ready, resp.wait_for(std::chrono::seconds(5)));
+      EXPECT_EQ(std::string("item"), resp.get().getBody());
+   }
+   EXPECT_EQ(1u, hedging.getRequests());
+   EXPECT_EQ(2u, caching.getStats().hits.load());
+
+   for(size_t i = 0; i < endpoints.size(); ++i) delete endpoints[i];
+   engine.shutdown();
+   engineThread.join();
+   server.shutdown();
+   serverThread.join();
+}
+#endif
@@ -0,0 +1,103 @@
+#include <string>
+
+#include "objects/Hpack.h"
+
+#pragma warning(disable:4251)
+#include <gtest/gtest.h>
+
+using namespace c11http::objects;
+
+namespace {
+
+std::string fromHex(const std::string& hex) {
+   std::string bytes;
+   for(size_t i = 0; i + 1 < hex.size(); i += 2) {
+      bytes.push_back(static_cast<char>(std::stoi(hex.substr(i, 2), 0, 16)));
+   }
+   return bytes;
+}
+
+HeaderList decoded(HpackDecoder& decoder, const std::string& block) {
+   HeaderList headers;
+   decoder.decode(block.data(), block.size(), headers);
+   return headers;
+}
+
+}
+
+/**
+ * RFC 7541 C.4, three requests on one connection, Huffman coded and sharing the dynamic table.
+ */
+TEST(HPACK_TEST, TEST_REQUEST_EXAMPLES)
+{
+   HeaderList first;
+   first.push_back(std::make_pair(":method", "GET"));
+   first.push_back(std::make_pair(":scheme", "http"));
+   first.push_back(std::make_pair(":path", "/"));
+   first.push_back(std::make_pair(":authority", "www.example.com"));
+   HeaderList second(first);
+   second.push_back(std::make_pair("cache-control", "no-cache"));
+   HeaderList third;
+   third.push_back(std::make_pair(":method", "GET"));
+   third.push_back(std::make_pair(":scheme", "https"));
+   third.push_back(std::make_pair(":path", "/index.html"));
+   third.push_back(std::make_pair(":authority", "www.example.com"));
+   third.push_back(std::make_pair("custom-key", "custom-value"));
+
+   const std::string blocks[] = {
+      fromHex("828684418cf1e3c2e5f23a6ba0ab90f4ff"),
+      fromHex("828684be5886a8eb10649cbf"),
+      fromHex("828785bf408825a849e95ba97d7f8925a849e95bb8e8b4bf")
+   };
+
+   HpackDecoder decoder;
+   EXPECT_TRUE(first == decoded(decoder, blocks[0]));
+   EXPECT_TRUE(second == decoded(decoder, blocks[1]));
+   EXPECT_TRUE(third == decoded(decoder, blocks[2]));
+
+   HpackEncoder encoder;
+   std::string out;
+   encoder.encode(first, out);
+   EXPECT_EQ(blocks[0], out);
+   out.clear();
+   encoder.encode(second, out);
+   EXPECT_EQ(blocks[1], out);
+   out.clear();
+   encoder.encode(third, out);
+   EXPECT_EQ(blocks[2], out);
+}
+
+TEST(HPACK_TEST, TEST_ROUND_TRIP_AND_LIMITS)
+{
+   HeaderList response;
+   response.push_back(std::make_pair(":status", "200"));
+   response.push_back(std::make_pair("content-type", "application/json"));
+   response.push_back(std::make_pair("content-length", "1234"));
+   response.push_back(std::make_pair("set-cookie", "session=abc"));
+   response.push_back(std::make_pair("x-binary", std::string("\0\xff\x7f", 3)));
+
+   //the table shrinking is signalled first, and later responses still decode
+   HpackEncoder encoder;
+   HpackDecoder decoder;
+   std::string out;
+   encoder.encode(response, out);
+   const size_t firstSize = out.size();
+   EXPECT_TRUE(response == decoded(decoder, out));
+   out.clear();
+   encoder.encode(response, out);
+   EXPECT_LT(out.size(), firstSize);
+   EXPECT_TRUE(response == decoded(decoder, out));
+   encoder.setMaxTableSize(0);
+   out.clear();
+   encoder.encode(response, out);
+   EXPECT_EQ('\x20', out[0]);
+   EXPECT_TRUE(response == decoded(decoder, out));
+
+   //indices past the tables, truncated strings, bad padding and oversized lists are refused
+   HpackDecoder strict(4096, 100);
+   EXPECT_THROW(decoded(strict, fromHex("be")), std::runtime_error);
+   EXPECT_THROW(decoded(strict, fromHex("418cf1e3")), std::runtime_error);
+   EXPECT_THROW(decoded(strict, fromHex("418100")), std::runtime_error);
+   EXPECT_THROW(decoded(strict, fromHex("3fe21f")), std::runtime_error);
+   EXPECT_THROW(decoded(strict, fromHex("00017864") + std::string(100, 'v')), std::runtime_error);
+}
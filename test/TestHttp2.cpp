@@ -0,0 +1,314 @@
+#ifndef WINDOWS
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <openssl/ssl.h>
+
+#include "objects/Hpack.h"
+#include "objects/HttpRequest.h"
+#include "objects/HttpResponse.h"
+#include "tcp/Server.h"
+#include "workers/WorkerPool.h"
+
+#include "TestSupport.h"
+
+#pragma warning(disable:4251)
+#include <gtest/gtest.h>
+
+using namespace c11http;
+
+namespace {
+
+const char PREFACE[] = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+
+std::string frame(const unsigned char type, const unsigned char flags, const unsigned int stream,
+      const std::string& payload) {
+   std::string out;
+   out.push_back(static_cast<char>(payload.size() >> 16));
+   out.push_back(static_cast<char>(payload.size() >> 8));
+   out.push_back(static_cast<char>(payload.size()));
+   out.push_back(static_cast<char>(type));
+   out.push_back(static_cast<char>(flags));
+   for(int shift = 24; shift >= 0; shift -= 8) out.push_back(static_cast<char>(stream >> shift));
+   return out.append(payload);
+}
+
+std::string uint32(const unsigned int value) {
+   std::string out;
+   for(int shift = 24; shift >= 0; shift -= 8) out.push_back(static_cast<char>(value >> shift));
+   return out;
+}
+
+std::string setting(const unsigned short id, const unsigned int value) {
+   std::string out;
+   out.push_back(static_cast<char>(id >> 8));
+   out.push_back(static_cast<char>(id));
+   return out.append(uint32(value));
+}
+
+/**
+ * A client speaking raw HTTP/2 frames.
+ */
+class Http2TestClient : public test::RawClient {
+public:
+   Http2TestClient(const unsigned short port, const std::string& identifier, SSL_CTX* tls = 0,
+         const std::string& protocols = "") : test::RawClient(port, identifier, tls, protocols) {
+
+   }
+
+   bool readFrame(unsigned char& type, unsigned char& flags, unsigned int& stream, std::string& payload) {
+      std::string header;
+      if(!read(header, 9)) return false;
+      const unsigned char* bytes = (const unsigned char*) header.data();
+      type = bytes[3];
+      flags = bytes[4];
+      stream = ((bytes[5] & 0x7f) << 24) | (bytes[6] << 16) | (bytes[7] << 8) | bytes[8];
+      return read(payload, (bytes[0] << 16) | (bytes[1] << 8) | bytes[2]);
+   }
+};
+
+/**
+ * What the server sent on each stream, read until every expected stream has ended.
+ */
+struct Responses {
+   Responses() : goAwayError(-1) {
+
+   }
+   std::map<unsigned int, std::string> statuses;
+   std::map<unsigned int, std::string> bodies;
+   std::map<unsigned int, unsigned int> resets;
+   int goAwayError;
+};
+
+/**
+ * Read frames until count streams have ended or the server goes away. DATA is acknowledged as it arrives, so
+ * bodies larger than the windows the client advertised still arrive.
+ */
+void readResponses(Http2TestClient& client, objects::HpackDecoder& decoder, const size_t count,
+      Responses& responses) {
+   size_t ended = 0;
+   unsigned char type = 0;
+   unsigned char flags = 0;
+   unsigned int stream = 0;
+   std::string payload;
+   std::string block;
+   while(ended < count && -1 == responses.goAwayError && client.readFrame(type, flags, stream, payload)) {
+      if(0x4 == type && 0 == (flags & 0x1)) {
+         client.write(frame(0x4, 0x1, 0, ""));
+      }
+      else if(0x1 == type || 0x9 == type) {
+         block.append(payload);
+         if(flags & 0x4) {
+            objects::HeaderList headers;
+            decoder.decode(block.data(), block.size(), headers);
+            block.clear();
+            EXPECT_EQ(std::string(":status"), headers.front().first);
+            responses.statuses[stream] = headers.front().second;
+         }
+         if(flags & 0x1) ++ended;
+      }
+      else if(0x0 == type) {
+         responses.bodies[stream].append(payload);
+         if(!payload.empty()) {
+            std::string updates(frame(0x8, 0, 0, uint32(payload.size())));
+            if(0 == (flags & 0x1)) updates.append(frame(0x8, 0, stream, uint32(payload.size())));
+            client.write(updates);
+         }
+         if(flags & 0x1) ++ended;
+      }
+      else if(0x3 == type) {
+         responses.resets[stream] = ((unsigned char) payload[3]);
+         ++ended;
+      }
+      else if(0x7 == type) {
+         responses.goAwayError = (unsigned char) payload[7];
+      }
+   }
+}
+
+std::string headers(objects::HpackEncoder& encoder, const unsigned int stream, const std::string& method,
+      const std::string& path, const bool endStream) {
+   objects::HeaderList fields;
+   fields.push_back(std::make_pair(":method", method));
+   fields.push_back(std::make_pair(":scheme", "http"));
+   fields.push_back(std::make_pair(":path", path));
+   fields.push_back(std::make_pair(":authority", "localhost"));
+   std::string block;
+   encoder.encode(fields, block);
+   return frame(0x1, 0x4 | (endStream ? 0x1 : 0), stream, block);
+}
+
+}
+
+TEST(HTTP2_TEST, TEST_PRIOR_KNOWLEDGE_MULTIPLEXING)
+{
+   char directory[] = "/tmp/c11http-h2-XXXXXX";
+   ASSERT_TRUE(0 != mkdtemp(directory));
+   const std::string root(directory);
+   const std::string large(test::largeFile());
+   {
+      std::ofstream out((root + "/app.js").c_str(), std::ios::binary);
+      out << large;
+   }
+
+   workers::WorkerPool pool(2);
+   tcp::Server server(8094, &pool);
+   server.enableHttp2();
+   server.serveStaticFiles("/static/", root);
+   server.registerHandler([](const objects::HttpRequest& req) {
+      return objects::HttpResponse(200, "stream " + req.getTarget() + req.getBody());
+   });
+   std::thread serverThread(&tcp::Server::waitForEvents, &server);
+   std::this_thread::sleep_for(std::chrono::milliseconds(25));
+
+   Http2TestClient client(8094, "Http2Client");
+   ASSERT_TRUE(client.isConnected());
+   objects::HpackEncoder encoder;
+   objects::HpackDecoder decoder;
+
+   //small stream windows, so the file is only sent as the client returns them
+   std::string opening(PREFACE);
+   opening.append(frame(0x4, 0, 0, setting(0x4, 16384)));
+   for(unsigned int stream = 1; stream < 100; stream += 2) {
+      opening.append(headers(encoder, stream, "GET", "/items/" + std::to_string(stream), true));
+   }
+   opening.append(headers(encoder, 101, "GET", "/static/app.js", true));
+   opening.append(headers(encoder, 103, "POST", "/echo", false));
+   opening.append(frame(0x0, 0x1, 103, " hello"));
+   opening.append(headers(encoder, 105, "PATCH", "/items", true));
+   client.write(opening);
+
+   Responses responses;
+   readResponses(client, decoder, 53, responses);
+   EXPECT_EQ(-1, responses.goAwayError);
+   for(unsigned int stream = 1; stream < 100; stream += 2) {
+      EXPECT_EQ(std::string("200"), responses.statuses[stream]);
+      EXPECT_EQ("stream /items/" + std::to_string(stream), responses.bodies[stream]);
+   }
+   EXPECT_EQ(std::string("200"), responses.statuses[101]);
+   EXPECT_TRUE(large == responses.bodies[101]);
+   EXPECT_EQ(std::string("stream /echo hello"), responses.bodies[103]);
+   //a method no handler can be given, as over HTTP/1.1
+   EXPECT_EQ(std::string("400"), responses.statuses[105]);
+
+   //streams carry on once the first batch is done, using the header tables built up so far
+   client.write(headers(encoder, 107, "GET", "/items/107", true) + frame(0x6, 0, 0, "pingpong"));
+   Responses later;
+   readResponses(client, decoder, 1, later);
+   EXPECT_EQ(std::string("stream /items/107"), later.bodies[107]);
+
+   server.shutdown();
+   serverThread.join();
+   unlink((root + "/app.js").c_str());
+   rmdir(root.c_str());
+}
+
+TEST(HTTP2_TEST, TEST_UPGRADE_REFUSAL_AND_ERRORS)
+{
+   tcp::Server server(8095);
+   server.enableHttp2(2);
+   server.registerHandler([](const objects::HttpRequest& req) {
+      return objects::HttpResponse(200, "inline " + req.getTarget());
+   }, tcp::Server::DISPATCH_INLINE);
+   std::thread serverThread(&tcp::Server::waitForEvents, &server);
+   std::this_thread::sleep_for(std::chrono::milliseconds(25));
+
+   {
+      //the preface follows the upgrade request straight away, without waiting for the switch
+      Http2TestClient client(8095, "UpgradeClient");
+      ASSERT_TRUE(client.isConnected());
+      client.write(std::string("GET /upgraded HTTP/1.1\r\nHost: localhost\r\nConnection: Upgrade, HTTP2-Settings\r\n"
+            "Upgrade: h2c\r\nHTTP2-Settings: AAMAAABkAAQAAP__\r\n\r\n") + PREFACE + frame(0x4, 0, 0, ""));
+      EXPECT_EQ(0u, client.readHead().find("HTTP/1.1 101 Switching Protocols"));
+
+      objects::HpackEncoder encoder;
+      objects::HpackDecoder decoder;
+      Responses upgraded;
+      readResponses(client, decoder, 1, upgraded);
+      EXPECT_EQ(std::string("200"), upgraded.statuses[1]);
+      EXPECT_EQ(std::string("inline /upgraded"), upgraded.bodies[1]);
+
+      //two streams at once are allowed, a third is refused
+      //encoded in turn, as each block refers to the table the one before it left
+      std::string opening(headers(encoder, 3, "GET", "/a", true));
+      opening.append(headers(encoder, 5, "GET", "/b", true));
+      opening.append(headers(encoder, 7, "GET", "/c", true));
+      client.write(opening);
+      Responses limited;
+      readResponses(client, decoder, 3, limited);
+      EXPECT_EQ(std::string("inline /a"), limited.bodies[3]);
+      EXPECT_EQ(std::string("inline /b"), limited.bodies[5]);
+      EXPECT_EQ(7u, limited.resets[7]);
+
+      //a header block that can not be decoded ends the connection
+      client.write(frame(0x1, 0x5, 9, "\xff\x7f"));
+      Responses failed;
+      readResponses(client, decoder, 1, failed);
+      EXPECT_EQ(9, failed.goAwayError);
+   }
+
+   {
+      Http2TestClient client(8095, "Http11Client");
+      client.write("GET /plain HTTP/1.1\r\nHost: localhost\r\n\r\n");
+      EXPECT_EQ(0u, client.readHead().find("HTTP/1.1 200 OK"));
+      std::string body;
+      EXPECT_TRUE(client.read(body, 13));
+      EXPECT_EQ(std::string("inline /plain"), body);
+   }
+
+   server.shutdown();
+   serverThread.join();
+}
+
+TEST(HTTP2_TEST, TEST_ALPN)
+{
+   char directory[] = "/tmp/c11http-h2-XXXXXX";
+   ASSERT_TRUE(0 != mkdtemp(directory));
+   const std::string root(directory);
+   test::writeCertificate(root);
+
+   tcp::Server server(8096);
+   server.enableTls(root + "/cert.pem", root + "/key.pem");
+   server.enableHttp2();
+   server.registerHandler([](const objects::HttpRequest& req) {
+      return objects::HttpResponse(200, "secure " + req.getTarget());
+   }, tcp::Server::DISPATCH_INLINE);
+   std::thread serverThread(&tcp::Server::waitForEvents, &server);
+   std::this_thread::sleep_for(std::chrono::milliseconds(25));
+
+   SSL_CTX* context = SSL_CTX_new(TLS_client_method());
+   SSL_CTX_set_verify(context, SSL_VERIFY_NONE, 0);
+   {
+      Http2TestClient client(8096, "AlpnClient", context, std::string("\x02h2\x08http/1.1", 12));
+      ASSERT_TRUE(client.isConnected());
+      EXPECT_EQ(std::string("h2"), client.getProtocol());
+
+      objects::HpackEncoder encoder;
+      objects::HpackDecoder decoder;
+      client.write(PREFACE + frame(0x4, 0, 0, "") + headers(encoder, 1, "GET", "/negotiated", true));
+      Responses responses;
+      readResponses(client, decoder, 1, responses);
+      EXPECT_EQ(std::string("secure /negotiated"), responses.bodies[1]);
+   }
+   {
+      Http2TestClient client(8096, "Http11AlpnClient", context, std::string("\x08http/1.1", 9));
+      ASSERT_TRUE(client.isConnected());
+      EXPECT_EQ(std::string("http/1.1"), client.getProtocol());
+      client.write("GET /negotiated HTTP/1.1\r\n\r\n");
+      EXPECT_EQ(0u, client.readHead().find("HTTP/1.1 200 OK"));
+   }
+   SSL_CTX_free(context);
+
+   server.shutdown();
+   serverThread.join();
+   unlink((root + "/cert.pem").c_str());
+   unlink((root + "/key.pem").c_str());
+   rmdir(root.c_str());
+}
+#endif
@@ -0,0 +1,158 @@
+#include <string>
+#include <vector>
+
+#include "objects/HttpRequestParser.h"
+#include "objects/HttpResponse.h"
+#include "objects/HttpResponseParser.h"
+
+#pragma warning(disable:4251)
+#include <gtest/gtest.h>
+
+using namespace c11http::objects;
+
+TEST(HTTP_REQUEST_PARSER_TEST, TEST_SPLIT_REQUEST)
+{
+   HttpRequestParser parser;
+   std::vector<HttpRequest> requests;
+   std::string raw("POST /items HTTP/1.1\r\nHost: localhost\r\nContent-Length: 5\r\n\r\nhello");
+
+   //feed one byte at a time, as a slow connection would
+   for(size_t i = 0; i < raw.size(); ++i) {
+      parser.parse(raw.c_str() + i, 1, requests);
+      EXPECT_EQ(i + 1 == raw.size() ? 1u : 0u, requests.size());
+   }
+
+   EXPECT_EQ(HttpRequest::POST, requests[0].getRequestMethod());
+   EXPECT_EQ(std::string("/items"), requests[0].getTarget());
+   EXPECT_EQ(std::string("localhost"), requests[0].getHeader("HOST"));
+   EXPECT_EQ(std::string("hello"), requests[0].getBody());
+}
+
+TEST(HTTP_REQUEST_PARSER_TEST, TEST_PIPELINED_REQUESTS)
+{
+   HttpRequestParser parser;
+   std::vector<HttpRequest> requests;
+   std::string raw("GET /a HTTP/1.1\r\n\r\nGET /b HTTP/1.1\r\n\r\nDELETE /c HTTP/1.1\r\n");
+
+   parser.parse(raw.c_str(), raw.size(), requests);
+   ASSERT_EQ(2u, requests.size());
+   EXPECT_EQ(std::string("/a"), requests[0].getTarget());
+   EXPECT_EQ(std::string("/b"), requests[1].getTarget());
+
+   parser.parse("\r\n", 2, requests);
+   ASSERT_EQ(3u, requests.size());
+   EXPECT_EQ(HttpRequest::DELETE, requests[2].getRequestMethod());
+}
+
+TEST(HTTP_REQUEST_PARSER_TEST, TEST_MALFORMED_REQUEST)
+{
+   HttpRequestParser parser;
+   std::vector<HttpRequest> requests;
+   std::string raw("BREW /pot HTTP/1.1\r\n\r\n");
+
+   EXPECT_THROW(parser.parse(raw.c_str(), raw.size(), requests), std::runtime_error);
+}
+
+TEST(HTTP_REQUEST_PARSER_TEST, TEST_RESPONSE_SERIALIZE)
+{
+   HttpResponse resp(404, "missing");
+   resp.setHeader("Content-Type", "text/plain");
+   std::string bytes;
+   resp.serialize(bytes);
+
+   EXPECT_EQ(std::string("HTTP/1.1 404 Not Found\r\ncontent-type: text/plain\r\ncontent-length: 7\r\n\r\nmissing"), bytes);
+}
+
+TEST(HTTP_REQUEST_PARSER_TEST, TEST_PIPELINED_RESPONSES)
+{
+   HttpResponseParser parser;
+   std::vector<HttpResponse> responses;
+   std::string raw("HTTP/1.1 200 OK\r\nContent-Length: 3\r\n\r\nabcHTTP/1.1 304 Not Modified\r\nETag: \"x\"\r\n\r\nHTTP/1.1 404 Not Found\r\ncontent-length: 2\r\n\r\nn");
+
+   parser.parse(raw.c_str(), raw.size(), responses);
+   ASSERT_EQ(2u, responses.size());
+   EXPECT_EQ(std::string("abc"), responses[0].getBody());
+   EXPECT_EQ(304u, responses[1].getStatus());
+   EXPECT_EQ(std::string("\"x\""), responses[1].getHeader("etag"));
+
+   parser.parse("o", 1, responses);
+   ASSERT_EQ(3u, responses.size());
+   EXPECT_EQ(404u, responses[2].getStatus());
+   EXPECT_EQ(std::string("no"), responses[2].getBody());
+}
+
+/**
+ * Records what the response parser streams, one fragment at a time.
+ */
+class RecordingConsumer : public HttpResponseParser::Consumer {
+public:
+   virtual void head(const HttpResponse& response) {
+      mStatuses.push_back(response.getStatus());
+      mBodies.push_back("");
+   }
+   virtual void body(const char* data, const size_t count) {
+      mBodies.back().append(data, count);
+      ++mFragments;
+   }
+   virtual void complete() {
+      ++mCompleted;
+   }
+   RecordingConsumer() : mFragments(0), mCompleted(0) {
+
+   }
+   std::vector<unsigned int> mStatuses;
+   std::vector<std::string> mBodies;
+   unsigned int mFragments;
+   unsigned int mCompleted;
+};
+
+TEST(HTTP_REQUEST_PARSER_TEST, TEST_CHUNKED_RESPONSES)
+{
+   std::string raw("HTTP/1.1 100 Continue\r\n\r\n"
+         "HTTP/1.1 200 OK\r\nTransfer-Encoding: gzip, chunked\r\n\r\n"
+         "5;ext=1\r\nhello\r\n7\r\n, world\r\n0\r\nExpires: never\r\n\r\n"
+         "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok");
+
+   //byte at a time, so every state is resumed mid way
+   HttpResponseParser parser;
+   RecordingConsumer consumer;
+   for(size_t i = 0; i < raw.size(); ++i) parser.parse(raw.data() + i, 1, consumer);
+
+   ASSERT_EQ(2u, consumer.mStatuses.size());
+   EXPECT_EQ(2u, consumer.mCompleted);
+   EXPECT_EQ(std::string("hello, world"), consumer.mBodies[0]);
+   EXPECT_EQ(std::string("ok"), consumer.mBodies[1]);
+   EXPECT_EQ(14u, consumer.mFragments);
+
+   //all at once, bodies are streamed without being gathered first
+   HttpResponseParser whole;
+   RecordingConsumer wholeConsumer;
+   whole.parse(raw.data(), raw.size(), wholeConsumer);
+   EXPECT_EQ(3u, wholeConsumer.mFragments);
+
+   HttpResponseParser invalid;
+   std::vector<HttpResponse> responses;
+   std::string badChunk("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n");
+   EXPECT_THROW(invalid.parse(badChunk.data(), badChunk.size(), responses), std::runtime_error);
+}
+
+TEST(HTTP_REQUEST_PARSER_TEST, TEST_CLOSE_DELIMITED_RESPONSE)
+{
+   HttpResponseParser parser;
+   std::vector<HttpResponse> responses;
+   std::string raw("HTTP/1.0 200 OK\r\nContent-Type: text/plain\r\n\r\nuntil the ");
+
+   parser.parse(raw.data(), raw.size(), responses);
+   parser.parse("end", 3, responses);
+   EXPECT_TRUE(responses.empty());
+
+   parser.finish(responses);
+   ASSERT_EQ(1u, responses.size());
+   EXPECT_EQ(std::string("until the end"), responses[0].getBody());
+
+   //a close part way through a length delimited body loses the response
+   std::string cut("HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\nshort");
+   parser.parse(cut.data(), cut.size(), responses);
+   EXPECT_THROW(parser.finish(responses), std::runtime_error);
+   EXPECT_EQ(1u, responses.size());
+}
@@ -1,5 +1,14 @@
 #include <thread>
 #include <chrono>
+#include <mutex>
+#include <string>
+
+#ifndef WINDOWS
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
 
 #include "tcp/Client.h"
 #include "tcp/Server.h"
@@ -87,4 +96,51 @@ TEST(TCP_TEST, TEST_CONNECTIONS)
    client.runTest();
 
    std::this_thread::sleep_for(startupWaitTime * 5); //give our test time to run
-}
\ No newline at end of file
+}
+#ifndef WINDOWS
+class RecordingServer : public c11http::tcp::Server {
+public:
+   RecordingServer(const unsigned int port) : c11http::tcp::Server(port) {
+
+   }
+   virtual void receiveComplete(const std::string& identifier, const char* data, const unsigned int count) {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mReceived += identifier + ":" + std::string(data, count) + ";";
+   }
+   std::string getReceived() {
+      std::lock_guard<std::mutex> lock(mMutex);
+      return mReceived;
+   }
+private:
+   std::mutex mMutex;
+   std::string mReceived;
+};
+
+TEST(TCP_TEST, TEST_DATA_WITH_IDENTIFIER)
+{
+   RecordingServer server(8108);
+   std::thread serverThread(&c11http::tcp::Server::waitForEvents, &server);
+   std::this_thread::sleep_for(std::chrono::milliseconds(25));
+
+   int sckt = socket(AF_INET, SOCK_STREAM, 0);
+   struct sockaddr_in address;
+   address.sin_family = AF_INET;
+   address.sin_port = htons(8108);
+   address.sin_addr.s_addr = inet_addr("127.0.0.1");
+   ASSERT_EQ(0, connect(sckt, (struct sockaddr*) &address, sizeof(address)));
+   char ack[3];
+   ASSERT_EQ(3, recv(sckt, ack, 3, MSG_WAITALL));
+
+   //the identifier ends at its newline, and what follows it in the same send is data
+   const std::string sent("RawClient\nfirst");
+   send(sckt, sent.data(), sent.size(), 0);
+   std::this_thread::sleep_for(std::chrono::milliseconds(25));
+   send(sckt, "second", 6, 0);
+   std::this_thread::sleep_for(std::chrono::milliseconds(25));
+   EXPECT_EQ(std::string("RawClient:first;RawClient:second;"), server.getReceived());
+
+   close(sckt);
+   server.shutdown();
+   serverThread.join();
+}
+#endif
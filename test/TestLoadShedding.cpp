@@ -0,0 +1,163 @@
+#ifndef WINDOWS
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "objects/HttpRequest.h"
+#include "objects/HttpResponse.h"
+#include "tcp/Server.h"
+#include "workers/WorkerPool.h"
+
+#include "TestSupport.h"
+
+#pragma warning(disable:4251)
+#include <gtest/gtest.h>
+
+using namespace c11http;
+
+namespace {
+
+/**
+ * A client pipelining requests and reading back the status and Retry-After of each response.
+ */
+class PipeliningClient : public test::RawClient {
+public:
+   struct Response {
+      unsigned int status;
+      std::string retryAfter;
+   };
+
+   PipeliningClient(const unsigned short port, const std::string& identifier) : test::RawClient(port, identifier) {
+
+   }
+
+   void request(const std::string& target, const bool priority) {
+      write("GET " + target + " HTTP/1.1\r\nHost: localhost\r\n" +
+            (priority ? "X-Priority: 1\r\n" : "") + "\r\n");
+   }
+
+   /**
+    * The next response, with status 0 if none arrived.
+    */
+   Response readResponse() {
+      Response response;
+      response.status = 0;
+      size_t end;
+      while(std::string::npos == (end = mInput.find("\r\n\r\n"))) {
+         if(receive(mInput) <= 0) return response;
+      }
+      const std::string head(mInput.substr(0, end + 2));
+      const size_t length = header(head, "content-length").empty() ? 0 : atoi(header(head, "content-length").c_str());
+      while(mInput.size() < end + 4 + length) {
+         if(receive(mInput) <= 0) return response;
+      }
+      mInput.erase(0, end + 4 + length);
+      response.status = atoi(head.c_str() + head.find(' ') + 1);
+      response.retryAfter = header(head, "retry-after");
+      return response;
+   }
+
+private:
+   static std::string header(const std::string& head, const std::string& name) {
+      std::string lower(head);
+      for(size_t i = 0; i < lower.size(); ++i) lower[i] = tolower(lower[i]);
+      const size_t found = lower.find("\r\n" + name + ":");
+      if(std::string::npos == found) return "";
+      const size_t start = head.find_first_not_of(' ', found + name.size() + 3);
+      return head.substr(start, head.find("\r\n", start) - start);
+   }
+
+   std::string mInput;
+};
+
+}
+
+TEST(LOAD_SHEDDING_TEST, TEST_SHED_UNDER_OVERLOAD)
+{
+   workers::WorkerPool pool(1);
+   tcp::Server server(8103, &pool);
+   server.registerHandler([](const objects::HttpRequest& req) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      return objects::HttpResponse(200, req.getTarget());
+   });
+   server.enableLoadShedding(2, 20, 3, [](const objects::HttpRequest& req) {
+      return req.hasHeader("x-priority");
+   });
+   std::thread serverThread(&tcp::Server::waitForEvents, &server);
+   std::this_thread::sleep_for(std::chrono::milliseconds(25));
+
+   PipeliningClient client(8103, "SheddingClient");
+   ASSERT_TRUE(client.isConnected());
+
+   //arriving five times faster than the one worker serves them
+   const int requests = 150;
+   for(int i = 0; i < requests; ++i) {
+      client.request("/" + std::to_string(i), 0 == i % 10);
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+   }
+
+   int served = 0;
+   int shed = 0;
+   for(int i = 0; i < requests; ++i) {
+      const PipeliningClient::Response response = client.readResponse();
+      if(503 == response.status) {
+         ++shed;
+         EXPECT_EQ(std::string("3"), response.retryAfter);
+         EXPECT_NE(0, i % 10) << "priority request " << i << " was shed";
+      }
+      else {
+         ++served;
+         EXPECT_EQ(200u, response.status);
+      }
+   }
+   EXPECT_LT(0, served);
+   EXPECT_LT(0, shed);
+   EXPECT_EQ(static_cast<unsigned long long>(shed), pool.getLoadShedder().getShedCount());
+
+   //once the queue has drained, requests are let in again
+   std::this_thread::sleep_for(std::chrono::milliseconds(50));
+   client.request("/after", false);
+   EXPECT_EQ(200u, client.readResponse().status);
+
+   server.shutdown();
+   serverThread.join();
+}
+
+TEST(LOAD_SHEDDING_TEST, TEST_SHED_WHILE_HANDLERS_OUTLAST_INTERVAL)
+{
+   workers::WorkerPool pool(1);
+   tcp::Server server(8105, &pool);
+   server.registerHandler([](const objects::HttpRequest& req) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      return objects::HttpResponse(200, req.getTarget());
+   });
+   server.enableLoadShedding(2, 10, 1);
+   std::thread serverThread(&tcp::Server::waitForEvents, &server);
+   std::this_thread::sleep_for(std::chrono::milliseconds(25));
+
+   PipeliningClient client(8105, "StalledClient");
+   ASSERT_TRUE(client.isConnected());
+
+   //the worker takes nothing for several intervals at a time, while what it let in still queues behind it
+   const int requests = 40;
+   for(int i = 0; i < requests; ++i) {
+      client.request("/" + std::to_string(i), false);
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+   }
+
+   std::vector<unsigned int> statuses;
+   for(int i = 0; i < requests; ++i) {
+      statuses.push_back(client.readResponse().status);
+   }
+   EXPECT_EQ(200u, statuses.front());
+   //long after the queue first stood, and long before it drained
+   for(int i = requests / 2; i < requests; ++i) {
+      EXPECT_EQ(503u, statuses[i]) << "request " << i << " was let in";
+   }
+
+   server.shutdown();
+   serverThread.join();
+}
+#endif
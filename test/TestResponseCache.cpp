@@ -0,0 +1,139 @@
+#include <string>
+#include <vector>
+
+#include "client/interface/CachingClient.h"
+#include "client/interface/IClient.h"
+#include "client/interface/ResponseCache.h"
+#include "objects/HttpRequest.h"
+#include "objects/HttpResponse.h"
+
+#pragma warning(disable:4251)
+#include <gtest/gtest.h>
+
+using namespace c11http;
+
+namespace {
+
+/**
+ * Client that records written requests, answered by hand with receiveResponseFromServer.
+ */
+class ScriptedClient : public client::IClient {
+public:
+   ScriptedClient() : client::IClient(ClientResponseCallback()) {
+
+   }
+   virtual objects::HttpResponse sendRequestToServer(const objects::HttpRequest& req) {
+      return sendRequestAsync(req).get();
+   }
+   virtual void connectToServer(const std::string& ip, const unsigned int port) {
+
+   }
+   virtual void disconnect() {
+      failRequests("disconnected");
+   }
+   std::vector<std::string> mWritten;
+protected:
+   virtual void performServerConnection(const std::string& ip, const unsigned int port) {
+
+   }
+   virtual void writeRequest(const std::string& bytes) {
+      mWritten.push_back(bytes);
+   }
+};
+
+objects::HttpResponse cacheable(const std::string& body, const std::string& cacheControl) {
+   objects::HttpResponse resp(200, body);
+   resp.setHeader("Cache-Control", cacheControl);
+   resp.setHeader("ETag", "\"v1\"");
+   return resp;
+}
+
+}
+
+TEST(RESPONSE_CACHE_TEST, TEST_FRESH_HIT)
+{
+   ScriptedClient client;
+   client::ResponseCache cache;
+   client::CachingClient caching(&client, &cache, "config:80");
+
+   std::vector<std::string> answered;
+   client::IClient::ClientResponseCallback record = [&answered](const objects::HttpResponse& resp) {
+      answered.push_back(resp.getBody());
+   };
+   caching.sendRequestAsync(objects::HttpRequest(objects::HttpRequest::GET, "/settings", ""), record);
+   ASSERT_EQ(1u, client.mWritten.size());
+   client.receiveResponseFromServer(cacheable("a=1", "max-age=60"));
+
+   //answered without writing anything
+   caching.sendRequestAsync(objects::HttpRequest(objects::HttpRequest::GET, "/settings", ""), record);
+   EXPECT_EQ(1u, client.mWritten.size());
+   ASSERT_EQ(2u, answered.size());
+   EXPECT_EQ(std::string("a=1"), answered[1]);
+   EXPECT_EQ(1u, caching.getStats().hits.load());
+
+   //as it is when used as any other client
+   client::IClient* stacked = &caching;
+   std::future<objects::HttpResponse> resp = stacked->sendRequestAsync(
+         objects::HttpRequest(objects::HttpRequest::GET, "/settings", ""));
+   EXPECT_EQ(std::string("a=1"), resp.get().getBody());
+   EXPECT_EQ(1u, client.mWritten.size());
+
+   //not stored: private, and non GET requests invalidate
+   caching.sendRequestAsync(objects::HttpRequest(objects::HttpRequest::GET, "/user", ""), record);
+   client.receiveResponseFromServer(cacheable("me", "private, max-age=60"));
+   caching.sendRequestAsync(objects::HttpRequest(objects::HttpRequest::PUT, "/settings", "a=2"), record);
+   client.receiveResponseFromServer(objects::HttpResponse(204, ""));
+   EXPECT_EQ(0u, cache.getEntries());
+}
+
+TEST(RESPONSE_CACHE_TEST, TEST_REVALIDATION)
+{
+   ScriptedClient client;
+   client::ResponseCache cache;
+   client::CachingClient caching(&client, &cache);
+
+   std::vector<std::string> answered;
+   client::IClient::ClientResponseCallback record = [&answered](const objects::HttpResponse& resp) {
+      answered.push_back(resp.getBody());
+   };
+   caching.sendRequestAsync(objects::HttpRequest(objects::HttpRequest::GET, "/catalog", ""), record);
+   client.receiveResponseFromServer(cacheable("items", "max-age=0"));
+
+   //stale, so the stored validator is sent along
+   caching.sendRequestAsync(objects::HttpRequest(objects::HttpRequest::GET, "/catalog", ""), record);
+   ASSERT_EQ(2u, client.mWritten.size());
+   EXPECT_NE(std::string::npos, client.mWritten[1].find("if-none-match: \"v1\"\r\n"));
+
+   objects::HttpResponse notModified(304, "");
+   notModified.setHeader("Cache-Control", "max-age=60");
+   client.receiveResponseFromServer(notModified);
+   ASSERT_EQ(2u, answered.size());
+   EXPECT_EQ(std::string("items"), answered[1]);
+   EXPECT_EQ(1u, caching.getStats().revalidations.load());
+
+   //refreshed by the 304
+   EXPECT_EQ(std::string("items"), caching.sendRequestToServer(
+         objects::HttpRequest(objects::HttpRequest::GET, "/catalog", "")).getBody());
+   EXPECT_EQ(2u, client.mWritten.size());
+}
+
+TEST(RESPONSE_CACHE_TEST, TEST_LRU_EVICTION)
+{
+   //a single shard with room for about two entries
+   client::ResponseCache cache(2 * (sizeof(client::ResponseCache::Entry) + 1200), 1);
+
+   for(int i = 0; i < 3; ++i) {
+      std::shared_ptr<client::ResponseCache::Entry> entry(new client::ResponseCache::Entry());
+      entry->response = objects::HttpResponse(std::string(1000, 'a' + i));
+      if(2 == i) {
+         EXPECT_TRUE(0 != cache.lookup("0")); //makes 1 the least recently used
+      }
+      cache.store(std::string(1, '0' + i), entry);
+   }
+
+   EXPECT_EQ(2u, cache.getEntries());
+   EXPECT_TRUE(0 != cache.lookup("0"));
+   EXPECT_TRUE(0 == cache.lookup("1"));
+   EXPECT_TRUE(0 != cache.lookup("2"));
+   EXPECT_LE(cache.getBytes(), 2 * (sizeof(client::ResponseCache::Entry) + 1200));
+}
@@ -0,0 +1,148 @@
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include <zlib.h>
+
+#include "objects/HttpRequest.h"
+#include "objects/HttpResponse.h"
+#include "tcp/ResponseCompressor.h"
+#include "tcp/Server.h"
+#include "workers/WorkerPool.h"
+#ifndef WINDOWS
+#include "client/posix/ClientEngine.h"
+#endif
+
+#pragma warning(disable:4251)
+#include <gtest/gtest.h>
+
+using namespace c11http;
+
+namespace {
+
+std::string jsonBody() {
+   std::string body("[");
+   for(int i = 0; i < 400; ++i) body.append("{\"id\":1,\"name\":\"item\",\"price\":9.99},");
+   body.append("{}]");
+   return body;
+}
+
+/**
+ * Inflate a gzip or zlib wrapped body, whichever it is.
+ */
+std::string inflateBody(const std::string& compressed) {
+   z_stream stream;
+   memset(&stream, 0, sizeof(stream));
+   inflateInit2(&stream, 15 + 32);
+   stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(compressed.data()));
+   stream.avail_in = compressed.size();
+   std::string out;
+   char chunk[4096];
+   int result = Z_OK;
+   while(Z_OK == result) {
+      stream.next_out = reinterpret_cast<Bytef*>(chunk);
+      stream.avail_out = sizeof(chunk);
+      result = inflate(&stream, Z_NO_FLUSH);
+      out.append(chunk, sizeof(chunk) - stream.avail_out);
+   }
+   inflateEnd(&stream);
+   return out;
+}
+
+}
+
+TEST(RESPONSE_COMPRESSOR_TEST, TEST_NEGOTIATION_AND_POLICY)
+{
+   tcp::ResponseCompressor compressor(1024);
+   EXPECT_EQ(tcp::ResponseCompressor::GZIP, compressor.negotiate("deflate, gzip;q=0.5"));
+   EXPECT_EQ(tcp::ResponseCompressor::DEFLATE, compressor.negotiate("gzip;q=0, deflate"));
+   EXPECT_EQ(tcp::ResponseCompressor::GZIP, compressor.negotiate("*"));
+   EXPECT_EQ(tcp::ResponseCompressor::IDENTITY, compressor.negotiate("br"));
+   EXPECT_EQ(tcp::ResponseCompressor::IDENTITY, compressor.negotiate(""));
+
+   objects::HttpResponse json(200, jsonBody());
+   json.setHeader("Content-Type", "application/json; charset=utf-8");
+   EXPECT_TRUE(compressor.isCompressible(json));
+
+   objects::HttpResponse small(200, "{}");
+   small.setHeader("Content-Type", "application/json");
+   objects::HttpResponse image(200, jsonBody());
+   image.setHeader("Content-Type", "image/png");
+   objects::HttpResponse untransformed(json);
+   untransformed.setHeader("Cache-Control", "public, no-transform");
+   EXPECT_FALSE(compressor.isCompressible(small));
+   EXPECT_FALSE(compressor.isCompressible(image));
+   EXPECT_FALSE(compressor.isCompressible(untransformed));
+
+   objects::HttpResponse compressed;
+   ASSERT_TRUE(compressor.compress(json, tcp::ResponseCompressor::GZIP, compressed));
+   EXPECT_EQ(std::string("gzip"), compressed.getHeader("content-encoding"));
+   EXPECT_EQ(std::string("accept-encoding"), compressed.getHeader("vary"));
+   EXPECT_LT(compressed.getBody().size() * 10, json.getBody().size());
+   EXPECT_EQ(json.getBody(), inflateBody(compressed.getBody()));
+
+   //the thread's deflate state is reset and reused for the next body
+   objects::HttpResponse deflated;
+   ASSERT_TRUE(compressor.compress(json, tcp::ResponseCompressor::DEFLATE, deflated));
+   EXPECT_EQ(std::string("deflate"), deflated.getHeader("content-encoding"));
+   EXPECT_EQ(json.getBody(), inflateBody(deflated.getBody()));
+   EXPECT_EQ(2u, compressor.getCompressed());
+
+   //identity still varies, so a cache never hands it to a client that accepts gzip
+   objects::HttpResponse identity;
+   ASSERT_TRUE(compressor.compress(json, tcp::ResponseCompressor::IDENTITY, identity));
+   EXPECT_FALSE(identity.hasHeader("content-encoding"));
+   EXPECT_EQ(std::string("accept-encoding"), identity.getHeader("vary"));
+   EXPECT_FALSE(compressor.compress(image, tcp::ResponseCompressor::GZIP, identity));
+
+   //the handler's strong ETag describes its own bytes, so it only holds weakly once they are encoded
+   objects::HttpResponse tagged(json);
+   tagged.setHeader("ETag", "\"v1\"");
+   ASSERT_TRUE(compressor.compress(tagged, tcp::ResponseCompressor::GZIP, compressed));
+   EXPECT_EQ(std::string("W/\"v1\""), compressed.getHeader("etag"));
+   ASSERT_TRUE(compressor.compress(tagged, tcp::ResponseCompressor::IDENTITY, identity));
+   EXPECT_EQ(std::string("\"v1\""), identity.getHeader("etag"));
+   tagged.setHeader("ETag", "W/\"v1\"");
+   ASSERT_TRUE(compressor.compress(tagged, tcp::ResponseCompressor::DEFLATE, deflated));
+   EXPECT_EQ(std::string("W/\"v1\""), deflated.getHeader("etag"));
+}
+
+#ifndef WINDOWS
+TEST(RESPONSE_COMPRESSOR_TEST, TEST_POOLED_COMPRESSION)
+{
+   workers::WorkerPool pool(2);
+   tcp::Server server(8091, &pool);
+   server.enableCompression();
+   server.registerHandler([](const objects::HttpRequest& req) {
+      objects::HttpResponse resp(200, jsonBody());
+      resp.setHeader("Content-Type", "application/json");
+      return resp;
+   });
+   std::thread serverThread(&tcp::Server::waitForEvents, &server);
+   std::this_thread::sleep_for(std::chrono::milliseconds(25));
+
+   client::posix::ClientEngine engine;
+   std::thread engineThread(&client::posix::ClientEngine::run, &engine);
+   client::posix::ClientEngine::Connection* connection = engine.connect("127.0.0.1", 8091, "CompressionClient");
+
+   objects::HttpRequest gzipped(objects::HttpRequest::GET, "/items", "");
+   gzipped.setHeader("Accept-Encoding", "gzip, deflate");
+   objects::HttpResponse compressed = connection->sendRequestToServer(gzipped);
+   EXPECT_EQ(200u, compressed.getStatus());
+   EXPECT_EQ(std::string("gzip"), compressed.getHeader("content-encoding"));
+   EXPECT_EQ(jsonBody(), inflateBody(compressed.getBody()));
+
+   objects::HttpResponse plain = connection->sendRequestToServer(
+         objects::HttpRequest(objects::HttpRequest::GET, "/items", ""));
+   EXPECT_FALSE(plain.hasHeader("content-encoding"));
+   EXPECT_EQ(jsonBody(), plain.getBody());
+   EXPECT_EQ(1u, server.getCompressor()->getCompressed());
+
+   delete connection;
+   engine.shutdown();
+   engineThread.join();
+   server.shutdown();
+   serverThread.join();
+}
+#endif
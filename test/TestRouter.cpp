@@ -0,0 +1,119 @@
+#include <sstream>
+#include <string>
+
+#include "objects/HttpRequest.h"
+#include "objects/HttpResponse.h"
+#include "objects/Router.h"
+
+#pragma warning(disable:4251)
+#include <gtest/gtest.h>
+
+using namespace c11http::objects;
+
+namespace {
+
+/**
+ * Answers with the route's name followed by each captured parameter.
+ */
+RouteHandler describe(const std::string& route) {
+   return [route](const HttpRequest& req, const RouteParams& params) {
+      std::string body(route);
+      for(size_t i = 0; i < params.size(); ++i) {
+         body.append(" " + params.name(i).str() + "=" + params.value(i).str());
+      }
+      return HttpResponse(200, body);
+   };
+}
+
+std::string routed(const Router& router, const HttpRequest::Method method, const std::string& target) {
+   return router.route(HttpRequest(method, target, "")).getBody();
+}
+
+}
+
+TEST(ROUTER_TEST, TEST_STATIC_PARAMS_AND_WILDCARDS)
+{
+   Router router;
+   router.add(HttpRequest::GET, "/", describe("root"));
+   router.add(HttpRequest::GET, "/users", describe("users"));
+   router.add(HttpRequest::GET, "/users/new", describe("new"));
+   router.add(HttpRequest::GET, "/users/:id", describe("user"));
+   router.add(HttpRequest::PUT, "/users/:id", describe("update"));
+   router.add(HttpRequest::GET, "/users/:id/posts/:post", describe("post"));
+   router.add(HttpRequest::GET, "/usage", describe("usage"));
+   router.add(HttpRequest::GET, "/files/*path", describe("file"));
+   router.add(HttpRequest::GET, "/files/readme", describe("readme"));
+   router.build();
+
+   EXPECT_EQ(std::string("root"), routed(router, HttpRequest::GET, "/"));
+   EXPECT_EQ(std::string("users"), routed(router, HttpRequest::GET, "/users"));
+   EXPECT_EQ(std::string("usage"), routed(router, HttpRequest::GET, "/usage"));
+   //a static segment wins over a parameter, which still matches anything else
+   EXPECT_EQ(std::string("new"), routed(router, HttpRequest::GET, "/users/new"));
+   EXPECT_EQ(std::string("user id=42"), routed(router, HttpRequest::GET, "/users/42?fields=name"));
+   EXPECT_EQ(std::string("update id=42"), routed(router, HttpRequest::PUT, "/users/42"));
+   EXPECT_EQ(std::string("post id=new post=7"), routed(router, HttpRequest::GET, "/users/new/posts/7"));
+   EXPECT_EQ(std::string("file path=css/site.css"), routed(router, HttpRequest::GET, "/files/css/site.css"));
+   EXPECT_EQ(std::string("readme"), routed(router, HttpRequest::GET, "/files/readme"));
+   EXPECT_EQ(std::string("file path=readme/old"), routed(router, HttpRequest::GET, "/files/readme/old"));
+
+   EXPECT_EQ(404u, router.route(HttpRequest(HttpRequest::GET, "/users/42/posts", "")).getStatus());
+   EXPECT_EQ(404u, router.route(HttpRequest(HttpRequest::GET, "/user", "")).getStatus());
+   HttpResponse notAllowed = router.route(HttpRequest(HttpRequest::DELETE, "/users/42", ""));
+   EXPECT_EQ(405u, notAllowed.getStatus());
+   EXPECT_EQ(std::string("GET, PUT"), notAllowed.getHeader("allow"));
+
+   //parameters are views of the path itself
+   const std::string path("/users/abc/posts/def");
+   RouteParams params;
+   unsigned int allowed = 0;
+   ASSERT_TRUE(0 != router.match(HttpRequest::GET, path.data(), path.size(), params, allowed));
+   EXPECT_EQ(path.data() + 7, params.get("id").data());
+   EXPECT_TRUE(params.get("post") == "def");
+   EXPECT_TRUE(params.get("missing").empty());
+}
+
+TEST(ROUTER_TEST, TEST_MALFORMED_ROUTES)
+{
+   Router router;
+   router.add(HttpRequest::GET, "/items/:id", describe("item"));
+   EXPECT_THROW(router.add(HttpRequest::GET, "items", describe("relative")), std::runtime_error);
+   EXPECT_THROW(router.add(HttpRequest::GET, "/items/:", describe("unnamed")), std::runtime_error);
+   EXPECT_THROW(router.add(HttpRequest::GET, "/items/*rest/more", describe("wildcard")), std::runtime_error);
+   EXPECT_THROW(router.add(HttpRequest::GET, "/items/:item/parts", describe("renamed")), std::runtime_error);
+   EXPECT_THROW(router.add(HttpRequest::GET, "/items/:id", describe("duplicate")), std::runtime_error);
+   EXPECT_THROW(router.route(HttpRequest(HttpRequest::GET, "/items/1", "")), std::runtime_error);
+
+   router.setNotFound([](HttpRequest req) {
+      return HttpResponse(404, "nothing at " + req.getTarget());
+   });
+   HttpRequestToResponse handler = router.handler();
+   EXPECT_EQ(std::string("item id=1"), handler(HttpRequest(HttpRequest::GET, "/items/1", "")).getBody());
+   EXPECT_EQ(std::string("nothing at /other"), handler(HttpRequest(HttpRequest::GET, "/other", "")).getBody());
+}
+
+TEST(ROUTER_TEST, TEST_MANY_ROUTES)
+{
+   //a few hundred routes sharing prefixes, as an application's API would
+   Router router;
+   for(int resource = 0; resource < 100; ++resource) {
+      std::stringstream base;
+      base << "/api/v1/resource" << resource;
+      router.add(HttpRequest::GET, base.str(), describe(base.str()));
+      router.add(HttpRequest::GET, base.str() + "/:id", describe(base.str() + " item"));
+      router.add(HttpRequest::POST, base.str() + "/:id/actions/:action", describe(base.str() + " action"));
+      router.add(HttpRequest::GET, base.str() + "/:id/children", describe(base.str() + " children"));
+   }
+   HttpRequestToResponse handler = router.handler();
+
+   for(int resource = 0; resource < 100; ++resource) {
+      std::stringstream base;
+      base << "/api/v1/resource" << resource;
+      EXPECT_EQ(base.str(), handler(HttpRequest(HttpRequest::GET, base.str(), "")).getBody());
+      EXPECT_EQ(base.str() + " item id=9", handler(HttpRequest(HttpRequest::GET, base.str() + "/9", "")).getBody());
+      EXPECT_EQ(base.str() + " action id=9 action=run",
+            handler(HttpRequest(HttpRequest::POST, base.str() + "/9/actions/run", "")).getBody());
+      EXPECT_EQ(base.str() + " children id=9",
+            handler(HttpRequest(HttpRequest::GET, base.str() + "/9/children", "")).getBody());
+   }
+}
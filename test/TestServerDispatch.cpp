@@ -0,0 +1,74 @@
+#ifndef WINDOWS
+#include <chrono>
+#include <future>
+#include <thread>
+
+#include "client/posix/ClientEngine.h"
+#include "objects/HttpRequest.h"
+#include "objects/HttpResponse.h"
+#include "tcp/Server.h"
+#include "workers/WorkerPool.h"
+
+#pragma warning(disable:4251)
+#include <gtest/gtest.h>
+
+using namespace c11http;
+
+TEST(SERVER_DISPATCH_TEST, TEST_INLINE_NEXT_TO_POOLED)
+{
+   workers::WorkerPool pool(1);
+   tcp::Server server(8106, &pool);
+   std::promise<void> release;
+   std::shared_future<void> released(release.get_future());
+   server.registerHandler([released](const objects::HttpRequest& req) {
+      released.wait();
+      return objects::HttpResponse(200, "pooled " + req.getTarget());
+   });
+   std::thread::id inlineThread;
+   server.registerHandler("/health", [&inlineThread](const objects::HttpRequest& req) {
+      inlineThread = std::this_thread::get_id();
+      return objects::HttpResponse(200, "inline " + req.getTarget());
+   }, tcp::Server::DISPATCH_INLINE);
+   server.registerHandler("/health/deep", [](const objects::HttpRequest& req) {
+      return objects::HttpResponse(200, "deep " + req.getTarget());
+   });
+   std::thread serverThread(&tcp::Server::waitForEvents, &server);
+   std::this_thread::sleep_for(std::chrono::milliseconds(25));
+   std::promise<std::thread::id> loop;
+   server.post([&loop]() {
+      loop.set_value(std::this_thread::get_id());
+   });
+   const std::thread::id loopThread = loop.get_future().get();
+
+   client::posix::ClientEngine engine;
+   std::thread engineThread(&client::posix::ClientEngine::run, &engine);
+   client::posix::ClientEngine::Connection* slow = engine.connect("127.0.0.1", 8106, "DispatchSlow");
+   client::posix::ClientEngine::Connection* health = engine.connect("127.0.0.1", 8106, "DispatchHealth");
+
+   //the only worker is held by the pooled handler, the inline one still answers from the event loop
+   std::future<objects::HttpResponse> pooled = slow->sendRequestAsync(
+         objects::HttpRequest(objects::HttpRequest::GET, "/orders", ""));
+   std::future<objects::HttpResponse> checked = health->sendRequestAsync(
+         objects::HttpRequest(objects::HttpRequest::GET, "/health?full=1", ""));
+   ASSERT_EQ(std::future_status::ready, checked.wait_for(std::chrono::seconds(5)));
+   EXPECT_EQ(std::string("inline /health?full=1"), checked.get().getBody());
+   EXPECT_EQ(loopThread, inlineThread);
+   EXPECT_EQ(std::future_status::timeout, pooled.wait_for(std::chrono::milliseconds(0)));
+
+   //the longest prefix wins, and is pooled, so it waits behind the held worker too
+   std::future<objects::HttpResponse> deep = health->sendRequestAsync(
+         objects::HttpRequest(objects::HttpRequest::GET, "/health/deep", ""));
+   release.set_value();
+   ASSERT_EQ(std::future_status::ready, pooled.wait_for(std::chrono::seconds(5)));
+   EXPECT_EQ(std::string("pooled /orders"), pooled.get().getBody());
+   ASSERT_EQ(std::future_status::ready, deep.wait_for(std::chrono::seconds(5)));
+   EXPECT_EQ(std::string("deep /health/deep"), deep.get().getBody());
+
+   delete slow;
+   delete health;
+   engine.shutdown();
+   engineThread.join();
+   server.shutdown();
+   serverThread.join();
+}
+#endif
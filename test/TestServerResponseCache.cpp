@@ -0,0 +1,170 @@
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "objects/HttpRequest.h"
+#include "objects/HttpResponse.h"
+#include "tcp/ResponseCache.h"
+#include "tcp/Server.h"
+#include "workers/WorkerPool.h"
+#ifndef WINDOWS
+#include "client/posix/ClientEngine.h"
+#endif
+
+#pragma warning(disable:4251)
+#include <gtest/gtest.h>
+
+using namespace c11http;
+
+TEST(SERVER_RESPONSE_CACHE_TEST, TEST_KEYS_AND_LIFETIMES)
+{
+   std::vector<std::string> vary;
+   vary.push_back("Accept-Encoding");
+   tcp::ResponseCache cache(1024 * 1024, 60000, vary);
+
+   EXPECT_EQ(std::string("/a~b/%2F?q=1"), tcp::ResponseCache::normalizeTarget("/a%7eb/%2f?q=1#top"));
+
+   objects::HttpRequest plain(objects::HttpRequest::GET, "/catalog", "");
+   objects::HttpRequest gzip(objects::HttpRequest::GET, "/catalog", "");
+   gzip.setHeader("Accept-Encoding", "gzip");
+   EXPECT_NE(cache.keyFor(plain), cache.keyFor(gzip));
+   EXPECT_TRUE(cache.keyFor(objects::HttpRequest(objects::HttpRequest::POST, "/catalog", "")).empty());
+
+   //stored once serialized, and handed back as the same buffer
+   tcp::ResponseCache::Buffer stored = cache.store(cache.keyFor(plain), objects::HttpResponse("items"));
+   EXPECT_EQ(stored, cache.lookup(cache.keyFor(plain)));
+   EXPECT_TRUE(0 == cache.lookup(cache.keyFor(gzip)).get());
+
+   objects::HttpResponse uncacheable("mine");
+   uncacheable.setHeader("Cache-Control", "private");
+   cache.store("private", uncacheable);
+   objects::HttpResponse varies("by language");
+   varies.setHeader("Vary", "Accept-Language");
+   cache.store("varies", varies);
+   objects::HttpResponse expired("stale");
+   expired.setHeader("Cache-Control", "max-age=0");
+   cache.store("expired", expired);
+   EXPECT_TRUE(0 == cache.lookup("private").get());
+   EXPECT_TRUE(0 == cache.lookup("varies").get());
+   EXPECT_TRUE(0 == cache.lookup("expired").get());
+   EXPECT_EQ(1u, cache.getEntries());
+
+   //least recently used entries make room within the budget
+   tcp::ResponseCache small(4096, 60000, std::vector<std::string>(), 1);
+   for(int i = 0; i < 8; ++i) small.store(std::string(1, 'a' + i), objects::HttpResponse(std::string(1000, 'x')));
+   EXPECT_LE(small.getBytes(), 4096u);
+   EXPECT_TRUE(0 != small.lookup("h").get());
+   EXPECT_TRUE(0 == small.lookup("a").get());
+}
+
+TEST(SERVER_RESPONSE_CACHE_TEST, TEST_REQUESTS_BYPASSING_CACHE)
+{
+   tcp::ResponseCache cache(1024 * 1024, 60000);
+
+   //asked not to answer from or keep in the cache
+   objects::HttpRequest noStore(objects::HttpRequest::GET, "/catalog", "");
+   noStore.setHeader("Cache-Control", "no-store");
+   objects::HttpRequest noCache(objects::HttpRequest::GET, "/catalog", "");
+   noCache.setHeader("Cache-Control", "max-age=0, No-Cache");
+   objects::HttpRequest pragma(objects::HttpRequest::GET, "/catalog", "");
+   pragma.setHeader("Pragma", "no-cache");
+   EXPECT_TRUE(cache.keyFor(noStore).empty());
+   EXPECT_TRUE(cache.keyFor(noCache).empty());
+   EXPECT_TRUE(cache.keyFor(pragma).empty());
+
+   //responses to authorized requests are kept only when marked as shared
+   cache.store("default", objects::HttpResponse("mine"), true);
+   objects::HttpResponse shared("everyone's");
+   shared.setHeader("Cache-Control", "public, max-age=60");
+   cache.store("public", shared, true);
+   objects::HttpResponse sharedFor("everyone's for a while");
+   sharedFor.setHeader("Cache-Control", "s-maxage=60");
+   cache.store("s-maxage", sharedFor, true);
+   EXPECT_TRUE(0 == cache.lookup("default").get());
+   EXPECT_TRUE(0 != cache.lookup("public").get());
+   EXPECT_TRUE(0 != cache.lookup("s-maxage").get());
+}
+
+#ifndef WINDOWS
+TEST(SERVER_RESPONSE_CACHE_TEST, TEST_HANDLER_RUNS_ONCE)
+{
+   int calls = 0;
+   tcp::Server server(8089);
+   server.enableResponseCache(1024 * 1024, 60000);
+   server.registerHandler([&calls](const objects::HttpRequest& req) {
+      ++calls;
+      return objects::HttpResponse(200, std::string(10000, 'c'));
+   }, tcp::Server::DISPATCH_INLINE);
+   std::thread serverThread(&tcp::Server::waitForEvents, &server);
+   std::this_thread::sleep_for(std::chrono::milliseconds(25));
+
+   client::posix::ClientEngine engine;
+   std::thread engineThread(&client::posix::ClientEngine::run, &engine);
+   client::posix::ClientEngine::Connection* connection = engine.connect("127.0.0.1", 8089, "CacheClient");
+
+   EXPECT_EQ(10000u, connection->sendRequestToServer(
+         objects::HttpRequest(objects::HttpRequest::GET, "/catalog", "")).getBody().size());
+   //pipelined hits are gathered into writev calls from the one shared buffer
+   std::vector<std::future<objects::HttpResponse> > responses;
+   for(int i = 0; i < 20; ++i) {
+      responses.push_back(connection->sendRequestAsync(objects::HttpRequest(objects::HttpRequest::GET,
+            "/catalog", "")));
+   }
+   for(size_t i = 0; i < responses.size(); ++i) {
+      ASSERT_EQ(std::future_status::ready, responses[i].wait_for(std::chrono::seconds(5)));
+      EXPECT_EQ(std::string(10000, 'c'), responses[i].get().getBody());
+   }
+   EXPECT_EQ(1, calls);
+   EXPECT_EQ(20u, server.getResponseCache()->getHits());
+
+   delete connection;
+   engine.shutdown();
+   engineThread.join();
+   server.shutdown();
+   serverThread.join();
+}
+
+TEST(SERVER_RESPONSE_CACHE_TEST, TEST_MISS_OFF_EVENT_LOOP)
+{
+   workers::WorkerPool pool(1);
+   tcp::Server server(8110, &pool);
+   server.enableResponseCache(1024 * 1024, 60000);
+   server.registerHandler("/pooled", [](const objects::HttpRequest& req) {
+      return objects::HttpResponse(200, std::string(10000, 'p'));
+   });
+   //answered from another thread, as an upstream call would be
+   std::vector<std::thread> responders;
+   server.registerAsyncHandler([&responders](const objects::HttpRequest& req, const objects::HttpResponder& responder) {
+      responders.push_back(std::thread([responder]() {
+         responder(objects::HttpResponse(200, std::string(10000, 'a')));
+      }));
+   });
+   std::thread serverThread(&tcp::Server::waitForEvents, &server);
+   std::this_thread::sleep_for(std::chrono::milliseconds(25));
+
+   client::posix::ClientEngine engine;
+   std::thread engineThread(&client::posix::ClientEngine::run, &engine);
+   client::posix::ClientEngine::Connection* connection = engine.connect("127.0.0.1", 8110, "OffLoopClient");
+
+   //a miss completed by a worker or another thread is queued as the cached buffer, and then hits are too
+   for(int i = 0; i < 2; ++i) {
+      std::future<objects::HttpResponse> pooled = connection->sendRequestAsync(
+            objects::HttpRequest(objects::HttpRequest::GET, "/pooled", ""));
+      ASSERT_EQ(std::future_status::ready, pooled.wait_for(std::chrono::seconds(5)));
+      EXPECT_EQ(std::string(10000, 'p'), pooled.get().getBody());
+      std::future<objects::HttpResponse> async = connection->sendRequestAsync(
+            objects::HttpRequest(objects::HttpRequest::GET, "/async", ""));
+      ASSERT_EQ(std::future_status::ready, async.wait_for(std::chrono::seconds(5)));
+      EXPECT_EQ(std::string(10000, 'a'), async.get().getBody());
+   }
+   EXPECT_EQ(2u, server.getResponseCache()->getHits());
+
+   delete connection;
+   engine.shutdown();
+   engineThread.join();
+   server.shutdown();
+   serverThread.join();
+   for(size_t i = 0; i < responders.size(); ++i) responders[i].join();
+}
+#endif
@@ -0,0 +1,114 @@
+#ifndef WINDOWS
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "client/posix/ClientEngine.h"
+#include "objects/HttpRequest.h"
+#include "objects/HttpResponse.h"
+#include "tcp/Server.h"
+#include "tcp/posix/StaticFiles.h"
+
+#pragma warning(disable:4251)
+#include <gtest/gtest.h>
+
+using namespace c11http;
+
+namespace {
+
+void writeFile(const std::string& path, const std::string& contents) {
+   std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+   out << contents;
+}
+
+}
+
+TEST(STATIC_FILES_TEST, TEST_SENDFILE_RESPONSES)
+{
+   char directory[] = "/tmp/c11http-static-XXXXXX";
+   ASSERT_TRUE(0 != mkdtemp(directory));
+   const std::string root(directory);
+   //larger than a socket buffer, so the file is sent over several writable events
+   std::string large(4 * 1024 * 1024, 'x');
+   for(size_t i = 0; i < large.size(); i += 4096) large[i] = 'a' + (i / 4096) % 26;
+   writeFile(root + "/app.js", large);
+   writeFile(root + "/index.html", "<html></html>");
+
+   tcp::Server server(8088);
+   server.serveStaticFiles("/static/", root);
+   server.registerHandler([](const objects::HttpRequest& req) {
+      return objects::HttpResponse(200, "dynamic");
+   }, tcp::Server::DISPATCH_INLINE);
+   std::thread serverThread(&tcp::Server::waitForEvents, &server);
+   std::this_thread::sleep_for(std::chrono::milliseconds(25));
+
+   client::posix::ClientEngine engine;
+   std::thread engineThread(&client::posix::ClientEngine::run, &engine);
+   client::posix::ClientEngine::Connection* connection = engine.connect("127.0.0.1", 8088, "StaticClient");
+
+   objects::HttpResponse resp = connection->sendRequestToServer(
+         objects::HttpRequest(objects::HttpRequest::GET, "/static/app.js", ""));
+   EXPECT_EQ(200u, resp.getStatus());
+   EXPECT_EQ(std::string("application/javascript"), resp.getHeader("content-type"));
+   EXPECT_TRUE(large == resp.getBody());
+
+   //the cached validator answers a conditional request without a body
+   objects::HttpRequest conditional(objects::HttpRequest::GET, "/static/app.js", "");
+   conditional.setHeader("If-None-Match", resp.getHeader("etag"));
+   EXPECT_EQ(304u, connection->sendRequestToServer(conditional).getStatus());
+
+   EXPECT_EQ(std::string("<html></html>"), connection->sendRequestToServer(
+         objects::HttpRequest(objects::HttpRequest::GET, "/static/", "")).getBody());
+   EXPECT_EQ(404u, connection->sendRequestToServer(
+         objects::HttpRequest(objects::HttpRequest::GET, "/static/missing.css", "")).getStatus());
+   EXPECT_EQ(404u, connection->sendRequestToServer(
+         objects::HttpRequest(objects::HttpRequest::GET, "/static/../etc/passwd", "")).getStatus());
+   EXPECT_EQ(std::string("dynamic"), connection->sendRequestToServer(
+         objects::HttpRequest(objects::HttpRequest::GET, "/api", "")).getBody());
+
+   delete connection;
+   engine.shutdown();
+   engineThread.join();
+   server.shutdown();
+   serverThread.join();
+
+   unlink((root + "/app.js").c_str());
+   unlink((root + "/index.html").c_str());
+   rmdir(root.c_str());
+}
+
+TEST(STATIC_FILES_TEST, TEST_REVALIDATION)
+{
+   char directory[] = "/tmp/c11http-static-XXXXXX";
+   ASSERT_TRUE(0 != mkdtemp(directory));
+   const std::string root(directory);
+   writeFile(root + "/a.txt", "one");
+   writeFile(root + "/b.txt", "two");
+
+   //revalidated on every lookup, with room for a single open file
+   tcp::posix::StaticFiles files(root, 1, 0);
+   std::shared_ptr<const tcp::posix::StaticFiles::File> first = files.find("/a.txt");
+   ASSERT_TRUE(0 != first.get());
+   EXPECT_EQ(3u, first->body.length);
+   EXPECT_EQ(first, files.find("/a.txt"));
+
+   writeFile(root + "/a.txt", "three");
+   std::shared_ptr<const tcp::posix::StaticFiles::File> second = files.find("/a.txt");
+   ASSERT_TRUE(0 != second.get());
+   EXPECT_EQ(5u, second->body.length);
+   EXPECT_NE(first->etag, second->etag);
+
+   EXPECT_TRUE(0 != files.find("/b.txt").get());
+   EXPECT_EQ(1u, files.size());
+   EXPECT_TRUE(0 == files.find("/c.txt").get());
+
+   unlink((root + "/a.txt").c_str());
+   unlink((root + "/b.txt").c_str());
+   rmdir(root.c_str());
+}
+#endif
@@ -0,0 +1,103 @@
+#include <string>
+
+#include "objects/HttpRequest.h"
+#include "objects/HttpResponse.h"
+#include "objects/Router.h"
+#include "objects/StaticRouter.h"
+
+#pragma warning(disable:4251)
+#include <gtest/gtest.h>
+
+using namespace c11http::objects;
+
+namespace {
+
+struct Health {
+   static constexpr HttpRequest::Method method = HttpRequest::GET;
+   static constexpr const char* pattern() { return "/health"; }
+   static HttpResponse handle(const HttpRequest& req, const RouteParams& params) {
+      return HttpResponse(200, "ok");
+   }
+};
+
+struct Healthz {
+   static constexpr HttpRequest::Method method = HttpRequest::GET;
+   static constexpr const char* pattern() { return "/healthz"; }
+   static HttpResponse handle(const HttpRequest& req, const RouteParams& params) {
+      return HttpResponse(200, "okz");
+   }
+};
+
+struct GetUser {
+   static constexpr HttpRequest::Method method = HttpRequest::GET;
+   static constexpr const char* pattern() { return "/users/:id"; }
+   static HttpResponse handle(const HttpRequest& req, const RouteParams& params) {
+      return HttpResponse(200, "user " + params.get("id").str());
+   }
+};
+
+struct UpdateUser {
+   static constexpr HttpRequest::Method method = HttpRequest::PUT;
+   static constexpr const char* pattern() { return "/users/:id"; }
+   static HttpResponse handle(const HttpRequest& req, const RouteParams& params) {
+      return HttpResponse(200, "updated " + params.get("id").str());
+   }
+};
+
+struct UserSetting {
+   static constexpr HttpRequest::Method method = HttpRequest::GET;
+   static constexpr const char* pattern() { return "/users/:id/settings/:name"; }
+   static HttpResponse handle(const HttpRequest& req, const RouteParams& params) {
+      return HttpResponse(200, params.get("id").str() + " " + params.get("name").str());
+   }
+};
+
+struct UserMe {
+   static constexpr HttpRequest::Method method = HttpRequest::GET;
+   static constexpr const char* pattern() { return "/users/me"; }
+   static HttpResponse handle(const HttpRequest& req, const RouteParams& params) {
+      return HttpResponse(200, "me");
+   }
+};
+
+//UserMe is declared after GetUser, but as a static route is still tried first
+typedef StaticRouter<Health, Healthz, GetUser, UpdateUser, UserSetting, UserMe> EdgeRoutes;
+
+std::string routed(const HttpRequest::Method method, const std::string& target) {
+   return EdgeRoutes::route(HttpRequest(method, target, "")).getBody();
+}
+
+}
+
+TEST(STATIC_ROUTER_TEST, TEST_COMPILED_ROUTES)
+{
+   static_assert(staticrouting::Traits<UserSetting>::PREFIX == 7, "static prefix is computed at compile time");
+   static_assert(staticrouting::Traits<Health>::STATIC, "routes without parameters are static");
+
+   EXPECT_EQ(std::string("ok"), routed(HttpRequest::GET, "/health"));
+   EXPECT_EQ(std::string("okz"), routed(HttpRequest::GET, "/healthz?verbose"));
+   EXPECT_EQ(std::string("me"), routed(HttpRequest::GET, "/users/me"));
+   EXPECT_EQ(std::string("user 42"), routed(HttpRequest::GET, "/users/42"));
+   EXPECT_EQ(std::string("updated 42"), routed(HttpRequest::PUT, "/users/42"));
+   EXPECT_EQ(std::string("42 theme"), routed(HttpRequest::GET, "/users/42/settings/theme"));
+
+   EXPECT_EQ(404u, EdgeRoutes::route(HttpRequest(HttpRequest::GET, "/users/", "")).getStatus());
+   EXPECT_EQ(404u, EdgeRoutes::route(HttpRequest(HttpRequest::GET, "/users/42/settings", "")).getStatus());
+   EXPECT_EQ(404u, EdgeRoutes::route(HttpRequest(HttpRequest::GET, "/healthy", "")).getStatus());
+   HttpResponse notAllowed = EdgeRoutes::route(HttpRequest(HttpRequest::DELETE, "/users/42", ""));
+   EXPECT_EQ(405u, notAllowed.getStatus());
+   EXPECT_EQ(std::string("GET, PUT"), notAllowed.getHeader("allow"));
+}
+
+TEST(STATIC_ROUTER_TEST, TEST_DYNAMIC_FALLBACK)
+{
+   Router dynamic;
+   dynamic.add(HttpRequest::GET, "/reports/:name", [](const HttpRequest& req, const RouteParams& params) {
+      return HttpResponse(200, "report " + params.get("name").str());
+   });
+   HttpRequestToResponse handler = EdgeRoutes::handler(dynamic.handler());
+
+   EXPECT_EQ(std::string("ok"), handler(HttpRequest(HttpRequest::GET, "/health", "")).getBody());
+   EXPECT_EQ(std::string("report daily"), handler(HttpRequest(HttpRequest::GET, "/reports/daily", "")).getBody());
+   EXPECT_EQ(404u, handler(HttpRequest(HttpRequest::GET, "/missing", "")).getStatus());
+}
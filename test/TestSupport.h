@@ -0,0 +1,166 @@
+#pragma once
+
+#ifndef WINDOWS
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+
+namespace c11http {
+namespace test {
+
+/**
+ * A client over a blocking socket to a server on this machine, optionally secured, that identifies itself as every
+ * client of the server does: it reads the acknowledgement, then sends its identifier ending in a newline.
+ */
+class RawClient {
+public:
+   /**
+    * A receiveBuffer other than 0 sizes the socket's, so that what is not read stays queued on the server.
+    */
+   RawClient(const unsigned short port, const std::string& identifier, SSL_CTX* tls = 0,
+         const std::string& protocols = "", const int receiveBuffer = 0) : mSsl(0) {
+      mSocket = socket(AF_INET, SOCK_STREAM, 0);
+      if(0 != receiveBuffer) setsockopt(mSocket, SOL_SOCKET, SO_RCVBUF, &receiveBuffer, sizeof(receiveBuffer));
+      setTimeout(5000);
+      struct sockaddr_in address;
+      address.sin_family = AF_INET;
+      address.sin_port = htons(port);
+      address.sin_addr.s_addr = inet_addr("127.0.0.1");
+      mConnected = 0 == connect(mSocket, (struct sockaddr*) &address, sizeof(address));
+
+      if(0 != tls) {
+         mSsl = SSL_new(tls);
+         SSL_set_alpn_protos(mSsl, (const unsigned char*) protocols.data(), protocols.size());
+         SSL_set_fd(mSsl, mSocket);
+         mConnected = mConnected && 1 == SSL_connect(mSsl);
+         const unsigned char* selected = 0;
+         unsigned int length = 0;
+         SSL_get0_alpn_selected(mSsl, &selected, &length);
+         mProtocol.assign((const char*) selected, length);
+      }
+
+      std::string ack;
+      mConnected = mConnected && read(ack, 3) && ack == "ack";
+      write(identifier + "\n");
+   }
+   virtual ~RawClient() {
+      if(0 != mSsl) SSL_free(mSsl);
+      close(mSocket);
+   }
+
+   bool isConnected() const {
+      return mConnected;
+   }
+   const std::string& getProtocol() const {
+      return mProtocol;
+   }
+
+   void setTimeout(const int milliseconds) {
+      struct timeval timeout;
+      timeout.tv_sec = milliseconds / 1000;
+      timeout.tv_usec = (milliseconds % 1000) * 1000;
+      setsockopt(mSocket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+   }
+
+   void write(const std::string& bytes) {
+      if(0 != mSsl) SSL_write(mSsl, bytes.data(), bytes.size());
+      else send(mSocket, bytes.data(), bytes.size(), 0);
+   }
+
+   /**
+    * Append whatever arrives next to out, returning its size, 0 once the server has closed the connection, and less
+    * than 0 when nothing arrived in time.
+    */
+   int receive(std::string& out, const size_t most = 65536) {
+      char buffer[65536];
+      const size_t wanted = std::min(sizeof(buffer), most);
+      const int received = 0 != mSsl ? SSL_read(mSsl, buffer, wanted) : recv(mSocket, buffer, wanted, 0);
+      if(received > 0) out.append(buffer, received);
+      return received;
+   }
+
+   bool read(std::string& out, const size_t count) {
+      out.clear();
+      while(out.size() < count) {
+         if(receive(out, count - out.size()) <= 0) return false;
+      }
+      return true;
+   }
+
+   /**
+    * Read up to and including the empty line ending an HTTP/1.1 head.
+    */
+   std::string readHead() {
+      std::string head;
+      while(std::string::npos == head.find("\r\n\r\n") && receive(head, 1) > 0);
+      return head;
+   }
+
+   /**
+    * Everything up to, and including, a final marker.
+    */
+   std::string readUntil(const std::string& marker) {
+      std::string received;
+      while(received.size() < marker.size() || 0 != received.compare(received.size() - marker.size(),
+            marker.size(), marker)) {
+         if(receive(received) <= 0) break;
+      }
+      return received;
+   }
+
+private:
+   int mSocket;
+   SSL* mSsl;
+   bool mConnected;
+   std::string mProtocol;
+};
+
+/**
+ * More than a few records, so the file is sent over several writes.
+ */
+inline std::string largeFile() {
+   std::string large(256 * 1024, 'x');
+   for(size_t i = 0; i < large.size(); i += 1000) large[i] = 'a' + (i / 1000) % 26;
+   return large;
+}
+
+/**
+ * A self-signed certificate for localhost, and its key, written to directory.
+ */
+inline void writeCertificate(const std::string& directory) {
+   EVP_PKEY* key = EVP_EC_gen("P-256");
+   X509* certificate = X509_new();
+   ASN1_INTEGER_set(X509_get_serialNumber(certificate), 1);
+   X509_gmtime_adj(X509_getm_notBefore(certificate), 0);
+   X509_gmtime_adj(X509_getm_notAfter(certificate), 3600);
+   X509_set_pubkey(certificate, key);
+   X509_NAME* name = X509_get_subject_name(certificate);
+   X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char*) "localhost", -1, -1, 0);
+   X509_set_issuer_name(certificate, name);
+   X509_sign(certificate, key, EVP_sha256());
+
+   FILE* out = fopen((directory + "/cert.pem").c_str(), "w");
+   PEM_write_X509(out, certificate);
+   fclose(out);
+   out = fopen((directory + "/key.pem").c_str(), "w");
+   PEM_write_PrivateKey(out, key, 0, 0, 0, 0, 0);
+   fclose(out);
+
+   X509_free(certificate);
+   EVP_PKEY_free(key);
+}
+
+}
+}
+#endif
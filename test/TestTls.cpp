@@ -0,0 +1,171 @@
+#ifndef WINDOWS
+#include <chrono>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "client/posix/Callback.h"
+#include "client/posix/Client.h"
+#include "client/posix/Tls.h"
+#include "objects/HttpRequest.h"
+#include "objects/HttpResponse.h"
+#include "tcp/Server.h"
+
+#include "TestSupport.h"
+
+#pragma warning(disable:4251)
+#include <gtest/gtest.h>
+
+using namespace c11http;
+
+namespace {
+
+class TlsCallback : public client::posix::Callback {
+public:
+   virtual void sendComplete(const std::string& identifier, const unsigned int count) {
+
+   }
+   virtual void sendFailed(const std::string& identifier, const std::string& message) {
+      mFailure = message;
+   }
+   virtual void receiveComplete(const std::string& identifier, const char* data, const unsigned int count) {
+
+   }
+   virtual void connected(const std::string& connectedTo) {
+
+   }
+   virtual void disconnected(const std::string& connectedTo) {
+
+   }
+
+   std::string mFailure;
+};
+
+void writeFile(const std::string& path, const std::string& contents) {
+   std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+   out << contents;
+}
+
+void removeDirectory(const std::string& directory) {
+   unlink((directory + "/cert.pem").c_str());
+   unlink((directory + "/key.pem").c_str());
+   unlink((directory + "/app.js").c_str());
+   rmdir(directory.c_str());
+}
+
+}
+
+TEST(TLS_TEST, TEST_HANDSHAKE_AND_RESUMPTION)
+{
+   char directory[] = "/tmp/c11http-tls-XXXXXX";
+   ASSERT_TRUE(0 != mkdtemp(directory));
+   const std::string root(directory);
+   test::writeCertificate(root);
+   const std::string large(test::largeFile());
+   writeFile(root + "/app.js", large);
+
+   tcp::Server server(8092);
+   server.enableTls(root + "/cert.pem", root + "/key.pem");
+   server.serveStaticFiles("/static/", root);
+   server.registerHandler([](const objects::HttpRequest& req) {
+      return objects::HttpResponse(200, "secure " + req.getTarget());
+   }, tcp::Server::DISPATCH_INLINE);
+   std::thread serverThread(&tcp::Server::waitForEvents, &server);
+   std::this_thread::sleep_for(std::chrono::milliseconds(25));
+
+   client::posix::TlsContext::Options options;
+   options.trustedCertificates = root + "/cert.pem";
+   options.serverName = "localhost";
+   std::shared_ptr<client::posix::TlsContext> context(new client::posix::TlsContext(options));
+
+   //the second connection resumes the session the first was issued
+   for(int connection = 0; connection < 2; ++connection) {
+      TlsCallback callback;
+      client::posix::Client client(&callback, "127.0.0.1", 8092, "TlsClient",
+            client::IClient::ClientResponseCallback(), client::posix::Client::Timeouts(), context);
+      std::thread clientThread(&client::posix::Client::waitForEvents, &client);
+
+      EXPECT_EQ(std::string("secure /hello"), client.sendRequestToServer(
+            objects::HttpRequest(objects::HttpRequest::GET, "/hello", "")).getBody());
+      objects::HttpResponse resp = client.sendRequestToServer(
+            objects::HttpRequest(objects::HttpRequest::GET, "/static/app.js", ""));
+      EXPECT_EQ(200u, resp.getStatus());
+      EXPECT_TRUE(large == resp.getBody());
+      EXPECT_TRUE(callback.mFailure.empty());
+
+      client.disconnect();
+      clientThread.join();
+   }
+   EXPECT_EQ(2u, context->getHandshakes());
+   EXPECT_EQ(1u, context->getResumed());
+   EXPECT_EQ(1u, context->getCachedSessions());
+
+   server.shutdown();
+   serverThread.join();
+   removeDirectory(root);
+}
+
+TEST(TLS_TEST, TEST_KERNEL_TLS_AND_VERIFICATION)
+{
+   char directory[] = "/tmp/c11http-tls-XXXXXX";
+   ASSERT_TRUE(0 != mkdtemp(directory));
+   const std::string root(directory);
+   test::writeCertificate(root);
+   const std::string large(test::largeFile());
+   writeFile(root + "/app.js", large);
+
+   //sessions the kernel can not take, e.g. without its tls module, stay in user space and are served the same
+   tcp::Server server(8093);
+   EXPECT_THROW(server.enableTls(root + "/missing.pem", root + "/key.pem"), std::runtime_error);
+   server.enableTls(root + "/cert.pem", root + "/key.pem", true);
+   server.serveStaticFiles("/static/", root);
+   server.registerHandler([](const objects::HttpRequest& req) {
+      return objects::HttpResponse(200, std::string(64 * 1024, 'k'));
+   }, tcp::Server::DISPATCH_INLINE);
+   std::thread serverThread(&tcp::Server::waitForEvents, &server);
+   std::this_thread::sleep_for(std::chrono::milliseconds(25));
+
+   client::posix::TlsContext::Options options;
+   options.trustedCertificates = root + "/cert.pem";
+   options.serverName = "localhost";
+   {
+      TlsCallback callback;
+      client::posix::Client client(&callback, "127.0.0.1", 8093, "KernelTlsClient",
+            client::IClient::ClientResponseCallback(), client::posix::Client::Timeouts(),
+            std::make_shared<client::posix::TlsContext>(options));
+      std::thread clientThread(&client::posix::Client::waitForEvents, &client);
+
+      EXPECT_EQ(64u * 1024, client.sendRequestToServer(
+            objects::HttpRequest(objects::HttpRequest::GET, "/api", "")).getBody().size());
+      EXPECT_TRUE(large == client.sendRequestToServer(
+            objects::HttpRequest(objects::HttpRequest::GET, "/static/app.js", "")).getBody());
+
+      client.disconnect();
+      clientThread.join();
+   }
+
+   //a certificate for another name is refused before anything is sent
+   options.serverName = "example.com";
+   {
+      TlsCallback callback;
+      client::posix::Client client(&callback, "127.0.0.1", 8093, "Mismatched",
+            client::IClient::ClientResponseCallback(), client::posix::Client::Timeouts(),
+            std::make_shared<client::posix::TlsContext>(options));
+      std::future<objects::HttpResponse> resp = client.sendRequestAsync(
+            objects::HttpRequest(objects::HttpRequest::GET, "/api", ""));
+      client.waitForEvents();
+
+      EXPECT_THROW(resp.get(), std::runtime_error);
+      EXPECT_EQ(0u, callback.mFailure.find("TLS handshake failed"));
+   }
+
+   server.shutdown();
+   serverThread.join();
+   removeDirectory(root);
+}
+#endif
@@ -0,0 +1,240 @@
+#ifndef WINDOWS
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "objects/HttpRequest.h"
+#include "objects/HttpResponse.h"
+#include "objects/WebSocket.h"
+#include "tcp/Server.h"
+
+#include "TestSupport.h"
+
+#pragma warning(disable:4251)
+#include <gtest/gtest.h>
+
+using namespace c11http;
+
+namespace {
+
+const unsigned char KEY[4] = { 0x37, 0xfa, 0x21, 0x3d };
+
+/**
+ * A frame as a client sends it, masked with KEY.
+ */
+std::string clientFrame(const unsigned char first, const std::string& payload) {
+   std::string frame;
+   frame.push_back(static_cast<char>(first));
+   if(payload.size() < 126) {
+      frame.push_back(static_cast<char>(0x80 | payload.size()));
+   }
+   else {
+      frame.push_back(static_cast<char>(0x80 | 127));
+      for(int shift = 56; shift >= 0; shift -= 8) frame.push_back(static_cast<char>((unsigned long long) payload.size() >> shift));
+   }
+   frame.append((const char*) KEY, 4);
+   for(size_t i = 0; i < payload.size(); ++i) frame.push_back(static_cast<char>(payload[i] ^ KEY[i % 4]));
+   return frame;
+}
+
+/**
+ * A WebSocket client.
+ */
+class WebSocketTestClient : public test::RawClient {
+public:
+   WebSocketTestClient(const unsigned short port, const std::string& identifier) : test::RawClient(port, identifier) {
+
+   }
+
+   /**
+    * Read a frame from the server, which are never masked.
+    */
+   bool readFrame(unsigned char& opcode, std::string& payload) {
+      std::string header;
+      if(!read(header, 2)) return false;
+      opcode = header[0] & 0x0f;
+      unsigned long long length = header[1] & 0x7f;
+      std::string extended;
+      if(126 == length || 127 == length) {
+         if(!read(extended, 126 == length ? 2 : 8)) return false;
+         length = 0;
+         for(size_t i = 0; i < extended.size(); ++i) length = (length << 8) | (unsigned char) extended[i];
+      }
+      return read(payload, length);
+   }
+
+   /**
+    * Open a WebSocket on target, returning the server's response head.
+    */
+   std::string upgrade(const std::string& target) {
+      write("GET " + target + " HTTP/1.1\r\nHost: localhost\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+            "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n");
+      return readHead();
+   }
+};
+
+}
+
+TEST(WEBSOCKET_TEST, TEST_FRAMES)
+{
+   //RFC 6455 section 1.3
+   EXPECT_EQ(std::string("s3pPLMBiTxaQ9kYGzzhZRbK+xOo="), objects::WebSocket::acceptKey("dGhlIHNhbXBsZSBub25jZQ=="));
+
+   //RFC 6455 section 5.7
+   std::string out;
+   objects::WebSocket::serializeFrame(objects::WebSocket::TEXT, "Hello", 5, out);
+   EXPECT_EQ(std::string("\x81\x05Hello"), out);
+   out.clear();
+   std::string medium(256, 'm');
+   objects::WebSocket::serializeFrame(objects::WebSocket::BINARY, medium.data(), medium.size(), out);
+   EXPECT_EQ(std::string("\x82\x7e\x01\x00", 4), out.substr(0, 4));
+   EXPECT_EQ(260u, out.size());
+   out.clear();
+   std::string large(65536, 'l');
+   objects::WebSocket::serializeFrame(objects::WebSocket::BINARY, large.data(), large.size(), out, false);
+   EXPECT_EQ(std::string("\x02\x7f\x00\x00\x00\x00\x00\x01\x00\x00", 10), out.substr(0, 10));
+
+   //a masked "Hello" in fragments, with a ping between them, fed a byte at a time
+   const std::string frames = clientFrame(0x01, "Hel") + clientFrame(0x89, "ping") + clientFrame(0x80, "lo");
+   EXPECT_EQ(std::string("\x81\x85\x37\xfa\x21\x3d\x7f\x9f\x4d\x51\x58"), clientFrame(0x81, "Hello"));
+   objects::WebSocketParser parser;
+   std::vector<objects::WebSocketParser::Message> messages;
+   for(size_t i = 0; i < frames.size(); ++i) parser.parse(frames.data() + i, 1, messages);
+   ASSERT_EQ(2u, messages.size());
+   EXPECT_EQ(objects::WebSocket::PING, messages[0].opcode);
+   EXPECT_EQ(std::string("ping"), messages[0].payload);
+   EXPECT_EQ(objects::WebSocket::TEXT, messages[1].opcode);
+   EXPECT_EQ(std::string("Hello"), messages[1].payload);
+
+   //frames a client may not send
+   const std::string unmasked("\x81\x02hi");
+   objects::WebSocketParser strict;
+   EXPECT_THROW(strict.parse(unmasked.data(), unmasked.size(), messages), std::runtime_error);
+   EXPECT_EQ(objects::WebSocket::PROTOCOL_ERROR, strict.getCloseCode());
+
+   const std::string continuation = clientFrame(0x80, "orphan");
+   objects::WebSocketParser ordered;
+   EXPECT_THROW(ordered.parse(continuation.data(), continuation.size(), messages), std::runtime_error);
+   EXPECT_EQ(objects::WebSocket::PROTOCOL_ERROR, ordered.getCloseCode());
+
+   //refused from the header, before the payload arrives
+   const std::string oversized = clientFrame(0x82, std::string(2000, 'x')).substr(0, 14);
+   objects::WebSocketParser small(1024);
+   EXPECT_THROW(small.parse(oversized.data(), oversized.size(), messages), std::runtime_error);
+   EXPECT_EQ(objects::WebSocket::MESSAGE_TOO_BIG, small.getCloseCode());
+
+   const std::string invalid = clientFrame(0x81, "caf\xc3");
+   const std::string valid = clientFrame(0x81, "caf\xc3\xa9 na\xc3\xafve \xe2\x82\xac \xf0\x9f\x98\x80 long enough ascii");
+   objects::WebSocketParser text;
+   messages.clear();
+   text.parse(valid.data(), valid.size(), messages);
+   ASSERT_EQ(1u, messages.size());
+   EXPECT_THROW(text.parse(invalid.data(), invalid.size(), messages), std::runtime_error);
+   EXPECT_EQ(objects::WebSocket::INVALID_DATA, text.getCloseCode());
+}
+
+TEST(WEBSOCKET_TEST, TEST_UNMASK)
+{
+   //every length around the vector widths, from every position in the key
+   std::string payload;
+   for(int i = 0; i < 100; ++i) payload.push_back(static_cast<char>(i * 7 + 3));
+   for(size_t offset = 0; offset < 4; ++offset) {
+      for(size_t length = 0; length <= payload.size(); ++length) {
+         std::string masked(payload.substr(0, length));
+         objects::WebSocket::unmask(&masked[0], length, KEY, offset);
+         bool matches = true;
+         for(size_t i = 0; i < length; ++i) {
+            matches = matches && masked[i] == static_cast<char>(payload[i] ^ KEY[(offset + i) % 4]);
+         }
+         EXPECT_TRUE(matches) << "length " << length << " offset " << offset;
+         objects::WebSocket::unmask(&masked[0], length, KEY, offset);
+         EXPECT_EQ(payload.substr(0, length), masked);
+      }
+   }
+}
+
+TEST(WEBSOCKET_TEST, TEST_SERVER_ECHO_AND_BROADCAST)
+{
+   tcp::Server server(8097);
+   server.serveWebSockets("/live", [&server](const std::string& identifier, const std::string& message,
+         const bool binary) {
+      server.sendWebSocket(identifier, std::string(binary ? "binary " : "text ") + message, binary);
+   }, 64 * 1024);
+   server.registerHandler([](const objects::HttpRequest& req) {
+      return objects::HttpResponse(200, "plain " + req.getTarget());
+   }, tcp::Server::DISPATCH_INLINE);
+   std::thread serverThread(&tcp::Server::waitForEvents, &server);
+   std::this_thread::sleep_for(std::chrono::milliseconds(25));
+
+   {
+      std::vector<std::unique_ptr<WebSocketTestClient> > clients;
+      for(int i = 0; i < 3; ++i) {
+         clients.push_back(std::unique_ptr<WebSocketTestClient>(
+               new WebSocketTestClient(8097, "Subscriber" + std::to_string(i))));
+         ASSERT_TRUE(clients.back()->isConnected());
+         const std::string head = clients.back()->upgrade("/live/feed");
+         EXPECT_EQ(0u, head.find("HTTP/1.1 101 Switching Protocols"));
+         EXPECT_NE(std::string::npos, head.find("sec-websocket-accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo="));
+      }
+
+      //messages are echoed through the handler, pings answered without it
+      unsigned char opcode = 0;
+      std::string payload;
+      clients[0]->write(clientFrame(0x81, "hello") + clientFrame(0x89, "are you there"));
+      ASSERT_TRUE(clients[0]->readFrame(opcode, payload));
+      EXPECT_EQ(objects::WebSocket::TEXT, opcode);
+      EXPECT_EQ(std::string("text hello"), payload);
+      ASSERT_TRUE(clients[0]->readFrame(opcode, payload));
+      EXPECT_EQ(objects::WebSocket::PONG, opcode);
+      EXPECT_EQ(std::string("are you there"), payload);
+
+      const std::string large(100000, 'b');
+      clients[1]->write(clientFrame(0x02, large.substr(0, 40000)) + clientFrame(0x80, large.substr(40000, 20000)));
+      ASSERT_TRUE(clients[1]->readFrame(opcode, payload));
+      EXPECT_EQ(objects::WebSocket::BINARY, opcode);
+      EXPECT_EQ("binary " + large.substr(0, 60000), payload);
+
+      //one frame for everyone
+      server.broadcastWebSocket("news");
+      for(size_t i = 0; i < clients.size(); ++i) {
+         ASSERT_TRUE(clients[i]->readFrame(opcode, payload));
+         EXPECT_EQ(objects::WebSocket::TEXT, opcode);
+         EXPECT_EQ(std::string("news"), payload);
+      }
+
+      //a message past the limit is refused with a close, as is anything after it
+      clients[1]->write(clientFrame(0x82, large));
+      ASSERT_TRUE(clients[1]->readFrame(opcode, payload));
+      EXPECT_EQ(objects::WebSocket::CLOSE, opcode);
+      EXPECT_EQ(std::string("\x03\xf1", 2), payload.substr(0, 2));
+
+      clients[2]->write(clientFrame(0x88, std::string("\x03\xe8", 2) + "bye"));
+      ASSERT_TRUE(clients[2]->readFrame(opcode, payload));
+      EXPECT_EQ(objects::WebSocket::CLOSE, opcode);
+      EXPECT_EQ(std::string("\x03\xe8", 2), payload);
+
+      server.broadcastWebSocket("later");
+      ASSERT_TRUE(clients[0]->readFrame(opcode, payload));
+      EXPECT_EQ(std::string("later"), payload);
+
+      //topics carry frames to their subscribers alone
+      server.subscribe("Subscriber0", "scores");
+      server.publishWebSocket("scores", "3-1");
+      server.publishWebSocket("other", "0-0");
+      ASSERT_TRUE(clients[0]->readFrame(opcode, payload));
+      EXPECT_EQ(objects::WebSocket::TEXT, opcode);
+      EXPECT_EQ(std::string("3-1"), payload);
+   }
+
+   {
+      //other targets and plain requests are answered as before
+      WebSocketTestClient client(8097, "PlainClient");
+      const std::string head = client.upgrade("/elsewhere");
+      EXPECT_EQ(0u, head.find("HTTP/1.1 200 OK"));
+   }
+
+   server.shutdown();
+   serverThread.join();
+}
+#endif
@@ -0,0 +1,204 @@
+#include <chrono>
+#include <future>
+#include <thread>
+#include <atomic>
+
+#include "objects/HttpRequest.h"
+#include "objects/HttpResponse.h"
+#include "workers/HdrHistogram.h"
+#include "workers/LoadShedder.h"
+#include "workers/TimerWheel.h"
+#include "workers/WorkerPool.h"
+
+#pragma warning(disable:4251)
+#include <gtest/gtest.h>
+
+using namespace c11http::workers;
+
+TEST(WORKERS_TEST, TEST_TIMER_WHEEL)
+{
+   TimerWheel wheel(10, 8);
+   TimerWheel::Clock::time_point start = TimerWheel::Clock::now();
+   int fired = 0;
+
+   wheel.schedule(20, [&fired]() { fired += 1; });
+   wheel.schedule(200, [&fired]() { fired += 10; }); //more than one turn of the wheel
+   TimerWheel::TimerId cancelled = wheel.schedule(30, [&fired]() { fired += 100; });
+   EXPECT_EQ(3u, wheel.size());
+   EXPECT_TRUE(wheel.cancel(cancelled));
+   EXPECT_FALSE(wheel.cancel(cancelled));
+
+   wheel.advance(start);
+   EXPECT_EQ(0, fired);
+   wheel.advance(start + std::chrono::milliseconds(50));
+   EXPECT_EQ(1, fired);
+   EXPECT_LE(0, wheel.nextTimeout(start + std::chrono::milliseconds(50)));
+   wheel.advance(start + std::chrono::milliseconds(250));
+   EXPECT_EQ(11, fired);
+   EXPECT_EQ(0u, wheel.size());
+   EXPECT_EQ(-1, wheel.nextTimeout(start + std::chrono::milliseconds(250)));
+}
+
+TEST(WORKERS_TEST, TEST_RESPONSE_COMPLETION)
+{
+   using namespace c11http::objects;
+
+   WorkerPool pool(2);
+   HttpRequestToResponse echo = [](HttpRequest req) -> HttpResponse {
+      return HttpResponse(req.getBody());
+   };
+
+   //every response must come back through its responder, none are dropped
+   std::promise<std::string> first;
+   std::promise<std::string> second;
+   pool.addWork(Worker::Work(HttpRequest(HttpRequest::POST, "one"), echo, [&first](const HttpResponse& resp) {
+      first.set_value(resp.getBody());
+   }));
+   pool.addWork(Worker::Work(HttpRequest(HttpRequest::POST, "two"), echo, [&second](const HttpResponse& resp) {
+      second.set_value(resp.getBody());
+   }));
+
+   EXPECT_EQ(std::string("one"), first.get_future().get());
+   EXPECT_EQ(std::string("two"), second.get_future().get());
+}
+
+TEST(WORKERS_TEST, TEST_SCHEDULING_STATS)
+{
+   using namespace c11http::objects;
+
+   WorkerPool pool(2);
+   HttpRequestToResponse sleepy = [](HttpRequest) -> HttpResponse {
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+      return HttpResponse();
+   };
+   HttpRequestToResponse slow = [](HttpRequest) -> HttpResponse {
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      return HttpResponse();
+   };
+   //let both workers park before there is anything to do
+   std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+   //work is handed out in turn, so the first worker's share queues behind the slow item, for the other to steal
+   const int nbWork = 20;
+   std::atomic<int> remaining(nbWork);
+   std::promise<void> done;
+   for(int i = 0; i < nbWork; ++i) {
+      pool.addWork(Worker::Work(HttpRequest(), 0 == i ? slow : sleepy, [&remaining, &done](const HttpResponse&) {
+         if(0 == --remaining) done.set_value();
+      }));
+   }
+   done.get_future().wait();
+
+   WorkerStats::Snapshot total = pool.snapshotTotalStats();
+   EXPECT_EQ(nbWork, (int)total.enqueued);
+   EXPECT_EQ(nbWork, (int)total.completed);
+   EXPECT_EQ(nbWork, (int)total.serviceTime.total);
+   EXPECT_LE(2000u, total.serviceTime.percentile(50)); //at least the 2ms sleep
+   EXPECT_LE(1u, total.maxQueueDepth);
+   EXPECT_EQ(2u, pool.snapshotStats().size());
+   EXPECT_LT(0u, total.steals);
+   EXPECT_LE(2u, total.parks);
+   EXPECT_LE(1u, total.wakeups);
+   EXPECT_EQ(nbWork, (int)total.queueDelay.total);
+   EXPECT_LE(2000u, total.queueDelay.maxMicroseconds); //queued behind at least one sleep
+   //stolen work leaves its queue as surely as work its own worker takes
+   EXPECT_EQ(0u, total.queueDepth);
+
+   pool.resetStats();
+   total = pool.snapshotTotalStats();
+   EXPECT_EQ(0u, total.completed);
+   EXPECT_EQ(0u, total.queueDelay.total);
+}
+
+TEST(WORKERS_TEST, TEST_LATENCY_HISTOGRAM)
+{
+   LatencyHistogram histogram;
+   for(int i = 0; i < 99; ++i) histogram.record(10);
+   histogram.record(5000);
+
+   LatencyHistogram::Snapshot snapshot = histogram.snapshot();
+   EXPECT_EQ(100u, snapshot.total);
+   EXPECT_EQ(15u, snapshot.percentile(50)); //10us falls in the [8, 16) bucket
+   EXPECT_EQ(8191u, snapshot.percentile(100));
+   EXPECT_EQ(5000u, snapshot.maxMicroseconds);
+}
+
+TEST(WORKERS_TEST, TEST_HDR_HISTOGRAM)
+{
+   HdrHistogram histogram(3600ULL * 1000 * 1000, 3);
+   for(unsigned long long value = 1; value <= 10000; ++value) histogram.record(value);
+
+   EXPECT_EQ(10000u, histogram.getTotalCount());
+   EXPECT_EQ(1u, histogram.getMin());
+   EXPECT_EQ(10000u, histogram.getMax());
+   //values are kept to 3 significant digits
+   EXPECT_NEAR(5000.0, (double)histogram.valueAtPercentile(50), 5.0);
+   EXPECT_NEAR(9900.0, (double)histogram.valueAtPercentile(99), 10.0);
+   EXPECT_EQ(10000u, histogram.valueAtPercentile(100));
+
+   //a stall of 100 intervals hides the 99 requests that would have been sent during it
+   HdrHistogram corrected;
+   corrected.recordCorrected(100000, 1000);
+   EXPECT_EQ(100u, corrected.getTotalCount());
+   EXPECT_EQ(1000u, corrected.getMin());
+
+   histogram.add(corrected);
+   EXPECT_EQ(10100u, histogram.getTotalCount());
+   EXPECT_EQ(100000u, histogram.getMax());
+}
+
+TEST(WORKERS_TEST, TEST_LOAD_SHEDDER)
+{
+   LoadShedder shedder(5000, 100000);
+   const LoadShedder::Clock::time_point start = LoadShedder::Clock::now();
+   const std::chrono::milliseconds ms(1);
+   auto take = [&shedder, start, ms](const unsigned long long microseconds, const int at) {
+      shedder.recordSojourn(microseconds, start + at * ms);
+   };
+
+   //a burst that drains within the interval is absorbed
+   shedder.recordEnqueue();
+   shedder.recordEnqueue();
+   take(20000, 0);
+   take(1000, 10);
+   EXPECT_FALSE(shedder.isOverloaded(start + 110 * ms));
+
+   //a queue that never drains below the target over a whole interval is standing
+   shedder.recordEnqueue();
+   shedder.recordEnqueue();
+   take(8000, 120);
+   take(12000, 150);
+   EXPECT_FALSE(shedder.isOverloaded(start + 200 * ms));
+   EXPECT_TRUE(shedder.isOverloaded(start + 220 * ms));
+   EXPECT_TRUE(shedder.isOverloaded(start + 250 * ms));
+
+   //work taken within the target ends the overload at once
+   shedder.recordEnqueue();
+   take(4000, 260);
+   EXPECT_FALSE(shedder.isOverloaded(start + 261 * ms));
+
+   //as does an interval with nothing taken and nothing queued
+   shedder.recordEnqueue();
+   take(9000, 330);
+   EXPECT_TRUE(shedder.isOverloaded(start + 430 * ms));
+   EXPECT_FALSE(shedder.isOverloaded(start + 540 * ms));
+
+   //and a standing interval only judged once later ones have gone by with nothing taken is long over
+   shedder.recordEnqueue();
+   take(9000, 600);
+   EXPECT_FALSE(shedder.isOverloaded(start + 850 * ms));
+
+   //workers held by handlers for longer than the interval take nothing, but the queue still stands
+   for(int i = 0; i < 3; ++i) shedder.recordEnqueue();
+   take(9000, 860);
+   EXPECT_TRUE(shedder.isOverloaded(start + 960 * ms));
+   EXPECT_TRUE(shedder.isOverloaded(start + 1070 * ms));
+   EXPECT_TRUE(shedder.isOverloaded(start + 1300 * ms));
+   take(200000, 1310);
+   take(210000, 1320);
+   EXPECT_TRUE(shedder.isOverloaded(start + 1420 * ms));
+   EXPECT_FALSE(shedder.isOverloaded(start + 1530 * ms));
+
+   shedder.recordShed();
+   EXPECT_EQ(1u, shedder.getShedCount());
+}
@@ -0,0 +1,128 @@
+#include "workers/HdrHistogram.h"
+
+#include <cmath>
+
+namespace c11http {
+namespace workers {
+
+namespace {
+   /**
+    * Number of bits needed to hold value, i.e. the position of its highest set bit plus one.
+    */
+   int bitLength(const unsigned long long value) {
+#ifdef __GNUC__
+      return (0 == value) ? 0 : 64 - __builtin_clzll(value);
+#else
+      int bits = 0;
+      for(unsigned long long remaining = value; remaining > 0; remaining >>= 1) ++bits;
+      return bits;
+#endif
+   }
+}
+
+HdrHistogram::HdrHistogram(const unsigned long long highestTrackable, const int significantDigits)
+      : mHighestTrackable(highestTrackable < 2 ? 2 : highestTrackable), mTotalCount(0), mMax(0), mMin(0), mSum(0) {
+   const int digits = significantDigits < 1 ? 1 : (significantDigits > 5 ? 5 : significantDigits);
+   //sub buckets must be fine enough to resolve 1 part in 10^digits across each power of two range
+   const unsigned long long largestSingleUnitResolution = 2 * (unsigned long long)std::pow(10.0, digits);
+   const int subBucketCountMagnitude = bitLength(largestSingleUnitResolution - 1);
+   mSubBucketHalfCountMagnitude = (subBucketCountMagnitude > 1 ? subBucketCountMagnitude : 1) - 1;
+   mSubBucketHalfCount = 1ULL << mSubBucketHalfCountMagnitude;
+   const unsigned long long subBucketCount = mSubBucketHalfCount * 2;
+   mSubBucketMask = subBucketCount - 1;
+
+   size_t bucketCount = 1;
+   for(unsigned long long smallestUntrackable = subBucketCount; smallestUntrackable <= mHighestTrackable;
+         smallestUntrackable <<= 1) {
+      ++bucketCount;
+      if(smallestUntrackable >> 63) break;
+   }
+   mCounts.assign((bucketCount + 1) * mSubBucketHalfCount, 0);
+}
+
+size_t HdrHistogram::indexFor(const unsigned long long value) const {
+   const int bucketIndex = bitLength(value | mSubBucketMask) - (mSubBucketHalfCountMagnitude + 1);
+   const unsigned long long subBucketIndex = value >> bucketIndex;
+   return ((size_t)(bucketIndex + 1) << mSubBucketHalfCountMagnitude) + (size_t)(subBucketIndex - mSubBucketHalfCount);
+}
+
+unsigned long long HdrHistogram::highestEquivalent(const size_t index) const {
+   int bucketIndex = (int)(index >> mSubBucketHalfCountMagnitude) - 1;
+   unsigned long long subBucketIndex = (index & (mSubBucketHalfCount - 1)) + mSubBucketHalfCount;
+   if(bucketIndex < 0) {
+      subBucketIndex -= mSubBucketHalfCount;
+      bucketIndex = 0;
+   }
+   const unsigned long long lowest = subBucketIndex << bucketIndex;
+   return lowest + (1ULL << bucketIndex) - 1;
+}
+
+void HdrHistogram::record(const unsigned long long value) {
+   const unsigned long long clamped = value > mHighestTrackable ? mHighestTrackable : value;
+   ++mCounts[indexFor(clamped)];
+   if(0 == mTotalCount || clamped < mMin) mMin = clamped;
+   if(clamped > mMax) mMax = clamped;
+   ++mTotalCount;
+   mSum += clamped;
+}
+
+void HdrHistogram::recordCorrected(const unsigned long long value, const unsigned long long expectedInterval) {
+   record(value);
+   if(0 == expectedInterval || value <= expectedInterval) return;
+   for(unsigned long long missing = value - expectedInterval; missing >= expectedInterval; missing -= expectedInterval) {
+      record(missing);
+   }
+}
+
+void HdrHistogram::add(const HdrHistogram& other) {
+   if(0 == other.mTotalCount) return;
+   for(size_t i = 0; i < mCounts.size() && i < other.mCounts.size(); ++i) mCounts[i] += other.mCounts[i];
+   if(0 == mTotalCount || other.mMin < mMin) mMin = other.mMin;
+   if(other.mMax > mMax) mMax = other.mMax;
+   mTotalCount += other.mTotalCount;
+   mSum += other.mSum;
+}
+
+void HdrHistogram::reset() {
+   mCounts.assign(mCounts.size(), 0);
+   mTotalCount = 0;
+   mMax = 0;
+   mMin = 0;
+   mSum = 0;
+}
+
+unsigned long long HdrHistogram::valueAtPercentile(const double percent) const {
+   if(0 == mTotalCount) return 0;
+   const double bounded = percent < 0 ? 0 : (percent > 100 ? 100 : percent);
+   unsigned long long target = (unsigned long long)((bounded / 100.0) * mTotalCount + 0.5);
+   if(target < 1) target = 1;
+
+   unsigned long long seen = 0;
+   for(size_t i = 0; i < mCounts.size(); ++i) {
+      seen += mCounts[i];
+      if(seen >= target) {
+         const unsigned long long value = highestEquivalent(i);
+         return value > mMax ? mMax : value;
+      }
+   }
+   return mMax;
+}
+
+unsigned long long HdrHistogram::getTotalCount() const {
+   return mTotalCount;
+}
+
+unsigned long long HdrHistogram::getMax() const {
+   return mMax;
+}
+
+unsigned long long HdrHistogram::getMin() const {
+   return mMin;
+}
+
+double HdrHistogram::getMean() const {
+   return (0 == mTotalCount) ? 0 : mSum / mTotalCount;
+}
+
+}
+}
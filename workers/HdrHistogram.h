@@ -0,0 +1,64 @@
+#pragma once
+
+#include "workers/Platform.h"
+
+#include <vector>
+
+namespace c11http {
+namespace workers {
+
+/**
+ * High dynamic range histogram of values, e.g. latencies in microseconds. Values from 1 to highestTrackable are
+ * recorded to the given number of significant decimal digits, using a fixed array of counts: each power of two
+ * range gets the same number of linear sub buckets. Not thread safe, so record into one histogram per thread and
+ * add them together.
+ */
+class WORKERS_API HdrHistogram {
+public:
+   /**
+    * significantDigits is from 1 to 5. Values above highestTrackable are recorded as highestTrackable.
+    */
+   HdrHistogram(const unsigned long long highestTrackable = 3600ULL * 1000 * 1000, const int significantDigits = 3);
+
+   void record(const unsigned long long value);
+   /**
+    * Record a value measured by a closed loop that waits expectedInterval between requests. A stall longer than
+    * the interval hid the requests that would have been sent during it, so their latencies are recorded as well,
+    * correcting for coordinated omission.
+    */
+   void recordCorrected(const unsigned long long value, const unsigned long long expectedInterval);
+   /**
+    * Add another histogram's counts. Both must have been created with the same arguments.
+    */
+   void add(const HdrHistogram& other);
+   void reset();
+
+   /**
+    * Value at the given percentile (0-100), accurate to the histogram's significant digits.
+    */
+   unsigned long long valueAtPercentile(const double percent) const;
+   unsigned long long getTotalCount() const;
+   unsigned long long getMax() const;
+   unsigned long long getMin() const;
+   double getMean() const;
+
+private:
+   size_t indexFor(const unsigned long long value) const;
+   /**
+    * Highest value that records into the same count as the value at index.
+    */
+   unsigned long long highestEquivalent(const size_t index) const;
+
+   unsigned long long mHighestTrackable;
+   int mSubBucketHalfCountMagnitude;
+   unsigned long long mSubBucketHalfCount;
+   unsigned long long mSubBucketMask;
+   std::vector<unsigned long long> mCounts;
+   unsigned long long mTotalCount;
+   unsigned long long mMax;
+   unsigned long long mMin;
+   double mSum;
+};
+
+}
+}
@@ -0,0 +1,82 @@
+#include "workers/LoadShedder.h"
+
+#include <limits>
+
+namespace c11http {
+namespace workers {
+
+namespace {
+   const unsigned long long NO_SOJOURN = std::numeric_limits<unsigned long long>::max();
+
+   long long microsecondsOf(const LoadShedder::Clock::time_point& time) {
+      return std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch()).count();
+   }
+
+   void storeMin(std::atomic<unsigned long long>& min, const unsigned long long value) {
+      unsigned long long current = min.load(std::memory_order_relaxed);
+      while(value < current && !min.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+      }
+   }
+}
+
+LoadShedder::LoadShedder(const unsigned long long targetMicroseconds,
+      const unsigned long long intervalMicroseconds) : mTarget(targetMicroseconds),
+   mInterval(intervalMicroseconds), mIntervalStart(microsecondsOf(Clock::now())), mMinimum(NO_SOJOURN),
+   mOverloaded(false), mQueued(0), mShed(0) {
+
+}
+
+void LoadShedder::configure(const unsigned long long targetMicroseconds,
+      const unsigned long long intervalMicroseconds) {
+   mTarget.store(targetMicroseconds, std::memory_order_relaxed);
+   mInterval.store(intervalMicroseconds, std::memory_order_relaxed);
+}
+
+void LoadShedder::recordEnqueue() {
+   mQueued.fetch_add(1, std::memory_order_relaxed);
+}
+
+void LoadShedder::recordSojourn(const unsigned long long microseconds, const Clock::time_point& now) {
+   mQueued.fetch_sub(1, std::memory_order_relaxed);
+   endIntervalIfOver(microsecondsOf(now));
+   storeMin(mMinimum, microseconds);
+   //the queue has drained, so the standing queue is gone without waiting out the interval
+   if(microseconds <= mTarget.load(std::memory_order_relaxed) && mOverloaded.load(std::memory_order_relaxed)) {
+      mOverloaded.store(false, std::memory_order_relaxed);
+   }
+}
+
+bool LoadShedder::isOverloaded(const Clock::time_point& now) {
+   endIntervalIfOver(microsecondsOf(now));
+   return mOverloaded.load(std::memory_order_relaxed);
+}
+
+void LoadShedder::recordShed() {
+   mShed.fetch_add(1, std::memory_order_relaxed);
+}
+
+unsigned long long LoadShedder::getShedCount() const {
+   return mShed.load(std::memory_order_relaxed);
+}
+
+void LoadShedder::endIntervalIfOver(const long long now) {
+   long long start = mIntervalStart.load(std::memory_order_relaxed);
+   const long long interval = mInterval.load(std::memory_order_relaxed);
+   if(now - start < interval) return;
+   //whoever moves the interval on judges the one that ended
+   if(!mIntervalStart.compare_exchange_strong(start, now, std::memory_order_relaxed)) return;
+   const unsigned long long minimum = mMinimum.exchange(NO_SOJOURN, std::memory_order_relaxed);
+   //intervals end when next looked at, so any after the one judged had nothing taken
+   const bool idle = NO_SOJOURN == minimum || now - start >= 2 * interval;
+   if(idle && mQueued.load(std::memory_order_relaxed) <= 0) {
+      //the queue has emptied, refused work would otherwise never be let in again
+      mOverloaded.store(false, std::memory_order_relaxed);
+   }
+   else if(NO_SOJOURN != minimum) {
+      //taken work judges the interval, later ones with nothing taken but work queued do not change the verdict
+      mOverloaded.store(minimum > mTarget.load(std::memory_order_relaxed), std::memory_order_relaxed);
+   }
+}
+
+}
+}
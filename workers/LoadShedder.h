@@ -0,0 +1,62 @@
+#pragma once
+
+#include "workers/Platform.h"
+
+#include <atomic>
+#include <chrono>
+
+namespace c11http {
+namespace workers {
+
+/**
+ * Admission control on the time work waits in the queues, after CoDel. Workers record each item's sojourn as they
+ * take it. Once every item taken during an interval waited longer than the target, a queue is standing rather than
+ * absorbing a burst, and the pool is overloaded until an item is taken within the target or an interval passes with
+ * nothing taken and nothing queued. An interval with nothing taken while work is queued, every worker being held by
+ * a handler for longer than it, keeps the verdict it had. Recording and checking are a few relaxed atomics, so both
+ * are cheap enough to do for every request.
+ */
+class WORKERS_API LoadShedder {
+public:
+   typedef std::chrono::steady_clock Clock;
+
+   /**
+    * CoDel's defaults: a 5ms target over 100ms intervals.
+    */
+   LoadShedder(const unsigned long long targetMicroseconds = 5000,
+         const unsigned long long intervalMicroseconds = 100000);
+
+   void configure(const unsigned long long targetMicroseconds, const unsigned long long intervalMicroseconds);
+   /**
+    * An item was queued. Counted here rather than read from WorkerStats, whose depths are only refreshed by the
+    * worker owning each queue and so miss items its siblings steal.
+    */
+   void recordEnqueue();
+   /**
+    * An item that waited microseconds in a queue was taken at now.
+    */
+   void recordSojourn(const unsigned long long microseconds, const Clock::time_point& now);
+   /**
+    * True if new work should be refused at now, ending the interval if it is over.
+    */
+   bool isOverloaded(const Clock::time_point& now);
+   /**
+    * Count work refused because of overload.
+    */
+   void recordShed();
+   unsigned long long getShedCount() const;
+
+private:
+   void endIntervalIfOver(const long long now);
+
+   std::atomic<unsigned long long> mTarget;
+   std::atomic<long long> mInterval;
+   std::atomic<long long> mIntervalStart; //microseconds since the clock's epoch
+   std::atomic<unsigned long long> mMinimum; //sojourn of the quickest item taken this interval
+   std::atomic<bool> mOverloaded;
+   std::atomic<long long> mQueued; //items recorded as queued and not yet taken
+   std::atomic<unsigned long long> mShed;
+};
+
+}
+}
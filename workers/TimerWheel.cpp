@@ -0,0 +1,87 @@
+#include "workers/TimerWheel.h"
+
+namespace c11http {
+namespace workers {
+
+TimerWheel::TimerWheel(const unsigned int tickMilliseconds, const unsigned int slots) :
+   mTickMilliseconds(tickMilliseconds), mSlots(slots), mStart(Clock::now()), mCurrentTick(0), mNextId(1) {
+   if(0 == tickMilliseconds || 0 == slots) throw(std::runtime_error("Timer wheel tick and slots must be greater than 0"));
+}
+
+TimerWheel::~TimerWheel() {
+
+}
+
+TimerWheel::TimerId TimerWheel::schedule(const unsigned int milliseconds, const Task& task) {
+   unsigned long long ticks = (milliseconds + mTickMilliseconds - 1) / mTickMilliseconds;
+   if(0 == ticks) ticks = 1;
+   //count from the current time rather than the last advance, so a wheel that is behind does not fire early
+   const unsigned long long nowTick = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - mStart).count()
+         / mTickMilliseconds;
+   if(nowTick > mCurrentTick) ticks += nowTick - mCurrentTick;
+
+   const size_t slot = (mCurrentTick + ticks) % mSlots.size();
+   Entry entry;
+   entry.id = mNextId++;
+   entry.rounds = static_cast<unsigned int>((ticks - 1) / mSlots.size());
+   entry.task = task;
+
+   Slot::iterator iter = mSlots[slot].insert(mSlots[slot].end(), entry);
+   mIndex[entry.id] = std::make_pair(slot, iter);
+   return entry.id;
+}
+
+bool TimerWheel::cancel(const TimerId id) {
+   std::map<TimerId, std::pair<size_t, Slot::iterator> >::iterator iter = mIndex.find(id);
+   if(iter == mIndex.end()) return false;
+   mSlots[iter->second.first].erase(iter->second.second);
+   mIndex.erase(iter);
+   return true;
+}
+
+void TimerWheel::advance(const Clock::time_point& now) {
+   const unsigned long long targetTick = std::chrono::duration_cast<std::chrono::milliseconds>(now - mStart).count()
+         / mTickMilliseconds;
+
+   while(mCurrentTick < targetTick) {
+      ++mCurrentTick;
+      if(mIndex.empty()) {
+         //nothing pending, skip straight to the target
+         mCurrentTick = targetTick;
+         break;
+      }
+
+      Slot& slot = mSlots[mCurrentTick % mSlots.size()];
+      std::vector<Task> due;
+      for(Slot::iterator iter = slot.begin(); iter != slot.end(); ) {
+         if(0 == iter->rounds) {
+            due.push_back(iter->task);
+            mIndex.erase(iter->id);
+            iter = slot.erase(iter);
+         }
+         else {
+            --(iter->rounds);
+            ++iter;
+         }
+      }
+
+      //run after the slot is updated, so tasks are free to schedule/cancel
+      for(std::vector<Task>::iterator iter = due.begin(); iter != due.end(); ++iter) {
+         (*iter)();
+      }
+   }
+}
+
+int TimerWheel::nextTimeout(const Clock::time_point& now) const {
+   if(mIndex.empty()) return -1;
+   const long long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - mStart).count();
+   const long long nextTick = static_cast<long long>(mCurrentTick + 1) * mTickMilliseconds;
+   return (nextTick > elapsed) ? static_cast<int>(nextTick - elapsed) : 0;
+}
+
+size_t TimerWheel::size() const {
+   return mIndex.size();
+}
+
+}
+}
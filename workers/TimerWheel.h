@@ -0,0 +1,63 @@
+#pragma once
+
+#include "workers/Platform.h"
+
+#include <chrono>
+#include <functional>
+#include <list>
+#include <map>
+#include <vector>
+
+namespace c11http {
+namespace workers {
+
+/**
+ * Hashed timing wheel. Timers are placed in one of a fixed number of slots, each covering one tick, so
+ * scheduling and cancelling are constant time regardless of how many timers are pending. Not thread safe,
+ * a wheel is owned and advanced by a single event loop.
+ */
+class WORKERS_API TimerWheel {
+public:
+   typedef std::function<void()> Task;
+   typedef unsigned long long TimerId;
+   typedef std::chrono::steady_clock Clock;
+
+   TimerWheel(const unsigned int tickMilliseconds = 10, const unsigned int slots = 512);
+   ~TimerWheel();
+
+   /**
+    * Run task once milliseconds have elapsed. The timer fires on the first tick at or after its deadline.
+    */
+   TimerId schedule(const unsigned int milliseconds, const Task& task);
+   /**
+    * Cancel a pending timer, returning false if it has already fired or been cancelled.
+    */
+   bool cancel(const TimerId id);
+   /**
+    * Run every timer that is due by now. Tasks may schedule or cancel timers.
+    */
+   void advance(const Clock::time_point& now);
+   /**
+    * Milliseconds until the next tick, or -1 when no timers are pending. Suitable as a poll/select timeout.
+    */
+   int nextTimeout(const Clock::time_point& now) const;
+   size_t size() const;
+
+private:
+   struct Entry {
+      TimerId id;
+      unsigned int rounds; //full turns of the wheel remaining before this entry fires
+      Task task;
+   };
+   typedef std::list<Entry> Slot;
+
+   const unsigned int mTickMilliseconds;
+   std::vector<Slot> mSlots;
+   std::map<TimerId, std::pair<size_t, Slot::iterator> > mIndex;
+   Clock::time_point mStart;
+   unsigned long long mCurrentTick;
+   TimerId mNextId;
+};
+
+}
+}
@@ -1,37 +1,149 @@
 #include "workers/Worker.h"
 
-#include "objects/HttpRequest.h"
-#include "objects/HttpResponse.h"
-
 namespace c11http {
 namespace workers {
 
-Worker::Worker() {
+namespace {
+   unsigned long long microsecondsBetween(const Worker::Clock::time_point& start, const Worker::Clock::time_point& end) {
+      return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+   }
+}
+
+Worker::Worker() : mShutdown(false), mParked(false), mWakeRequested(false), mSiblings(0),
+   mLoadShedder(0) {
 
 }
 
 Worker::~Worker() {
-   auto reqToResp = [this](objects::HttpRequest) -> objects::HttpResponse {
-      mShutdown = true;
-      return objects::HttpResponse();
-   };
-   Work work = std::tuple<objects::HttpRequest, objects::HttpRequestToResponse>(objects::HttpRequest(), reqToResp);
-   mPromiseToWork.set_value(work);
+
 }
 
 void Worker::threadEntryPoint() {
-   while(!mShutdown) {
-      std::future<Work> futureWork = mPromiseToWork.get_future();
-      futureWork.wait();
-      Work work = futureWork.get();
-      objects::HttpRequestToResponse reqToResp = std::get<1>(work);
-      reqToResp(std::get<0>(work));
+   while(true) {
+      QueuedWork queued;
+      size_t depth = 0;
+      {
+         std::unique_lock<std::mutex> lock(mMutex);
+         while(true) {
+            if(!mWork.empty()) {
+               queued = mWork.front();
+               mWork.pop_front();
+               depth = mWork.size();
+               break;
+            }
+            if(mShutdown) return;
+
+            //own queue is empty, help out a sibling before going idle
+            lock.unlock();
+            const bool stolen = stealFromSiblings(queued);
+            lock.lock();
+            if(stolen) {
+               mStats.recordSteal();
+               depth = mWork.size();
+               break;
+            }
+            if(!mWork.empty() || mShutdown) continue;
+
+            mParked = true;
+            mStats.recordPark();
+            while(mWork.empty() && !mShutdown && !mWakeRequested) {
+               mWorkAvailable.wait(lock);
+            }
+            mParked = false;
+            mWakeRequested = false;
+            mStats.recordWakeup();
+         }
+      }
+
+      const Clock::time_point start = Clock::now();
+      const unsigned long long sojourn = microsecondsBetween(queued.enqueued, start);
+      mStats.recordStart(sojourn, depth);
+      if(0 != mLoadShedder) mLoadShedder->recordSojourn(sojourn, start);
+
+      Work& work = queued.work;
+      objects::HttpResponse resp;
+      try {
+         resp = std::get<1>(work)(std::get<0>(work));
+      }
+      catch(std::exception&) {
+         resp = objects::HttpResponse(500, "");
+      }
+      mStats.recordComplete(microsecondsBetween(start, Clock::now()));
+
+      //hand the response back to whoever is waiting on it, rather than dropping it
+      const objects::HttpResponder& responder = std::get<2>(work);
+      if(responder) responder(resp);
+   }
+}
+
+bool Worker::provideWork(const Worker::Work& work) {
+   size_t depth = 0;
+   bool parked = false;
+   //counted before it can be taken
+   if(0 != mLoadShedder) mLoadShedder->recordEnqueue();
+   {
+      std::lock_guard<std::mutex> lock(mMutex);
+      QueuedWork queued;
+      queued.work = work;
+      queued.enqueued = Clock::now();
+      mWork.push_back(queued);
+      depth = mWork.size();
+      parked = mParked && 1 == depth;
    }
+   mStats.recordEnqueue(depth);
+   mWorkAvailable.notify_one();
+   return parked;
 }
 
-void Worker::provideWork(const Worker::Work& work) {
-   mPromiseToWork.set_value(work);
+void Worker::shutdown() {
+   {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mShutdown = true;
+   }
+   mWorkAvailable.notify_one();
 }
 
+void Worker::setSiblings(const std::vector<Worker*>* siblings) {
+   mSiblings = siblings;
+}
+
+void Worker::setLoadShedder(LoadShedder* shedder) {
+   mLoadShedder = shedder;
+}
+
+bool Worker::isParked() {
+   std::lock_guard<std::mutex> lock(mMutex);
+   return mParked;
+}
+
+void Worker::wakeUp() {
+   {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mWakeRequested = true;
+   }
+   mWorkAvailable.notify_one();
+}
+
+WorkerStats& Worker::getStats() {
+   return mStats;
+}
+
+bool Worker::trySteal(QueuedWork& work) {
+   std::lock_guard<std::mutex> lock(mMutex);
+   if(mWork.empty()) return false;
+   work = mWork.front();
+   mWork.pop_front();
+   mStats.recordStolen(mWork.size());
+   return true;
+}
+
+bool Worker::stealFromSiblings(QueuedWork& work) {
+   if(0 == mSiblings) return false;
+   for(std::vector<Worker*>::const_iterator iter = mSiblings->begin(); iter != mSiblings->end(); ++iter) {
+      if(*iter != this && (*iter)->trySteal(work)) return true;
+   }
+   return false;
+}
+
+}
 }
-}
\ No newline at end of file
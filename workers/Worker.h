@@ -1,29 +1,85 @@
 #pragma once
 
 #include "workers/Platform.h"
+#include "workers/LoadShedder.h"
+#include "workers/WorkerStats.h"
 
+#include "objects/HttpRequest.h"
+#include "objects/HttpResponse.h"
 #include "objects/HttpRequestToResponse.h"
 
-#include <future>
-#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <tuple>
+#include <vector>
 
 namespace c11http {
 namespace workers {
 
 class WORKERS_API Worker {
 public :
-   typedef std::tuple<objects::HttpRequest, objects::HttpRequestToResponse> Work;
+   /**
+    * A request, the handler to run on it, and where to deliver the handler's response. The responder may be
+    * empty when the caller does not need the response.
+    */
+   typedef std::tuple<objects::HttpRequest, objects::HttpRequestToResponse, objects::HttpResponder> Work;
+   typedef std::chrono::steady_clock Clock;
+
    Worker();
    ~Worker();
 
    void threadEntryPoint();
 
-   void provideWork(const Work& work);
+   /**
+    * Queue work for this worker, returning true if the worker was parked and will start on it right away.
+    */
+   bool provideWork(const Work& work);
+   /**
+    * Stop threadEntryPoint once the work already provided has been run.
+    */
+   void shutdown();
+   /**
+    * Workers whose queues this worker may steal from once its own queue is empty.
+    */
+   void setSiblings(const std::vector<Worker*>* siblings);
+   /**
+    * Where to record how long each item waited in a queue before this worker took it.
+    */
+   void setLoadShedder(LoadShedder* shedder);
+   /**
+    * True while this worker is waiting with nothing to do.
+    */
+   bool isParked();
+   /**
+    * Wake a parked worker so it looks for work to steal.
+    */
+   void wakeUp();
+
+   WorkerStats& getStats();
 
 private:
-   std::promise<Work> mPromiseToWork;
-   std::atomic<bool> mShutdown;
+   struct QueuedWork {
+      Work work;
+      Clock::time_point enqueued;
+   };
+   /**
+    * Take the oldest item from this worker's queue, on behalf of another worker.
+    */
+   bool trySteal(QueuedWork& work);
+   bool stealFromSiblings(QueuedWork& work);
+
+   std::deque<QueuedWork> mWork;
+   std::mutex mMutex;
+   std::condition_variable mWorkAvailable;
+   bool mShutdown;
+   bool mParked;
+   bool mWakeRequested;
+   const std::vector<Worker*>* mSiblings;
+   LoadShedder* mLoadShedder;
+   WorkerStats mStats;
 };
 
 }
-}
\ No newline at end of file
+}
@@ -1,6 +1,8 @@
 #include "workers/WorkerPool.h"
 #include "workers/Worker.h"
 
+#include <algorithm>
+
 namespace c11http {
 namespace workers {
 
@@ -10,6 +12,10 @@ WorkerPool::WorkerPool(const int nbWorkers) {
    for(int i = 0; i < nbWorkers; ++i) {
       mWorkers.push_back(new Worker());
    }
+   std::for_each(mWorkers.begin(), mWorkers.end(), [this](Worker* worker) {
+      worker->setSiblings(&mWorkers);
+      worker->setLoadShedder(&mLoadShedder);
+   });
    mThreads.reserve(nbWorkers);
    std::for_each(mWorkers.begin(), mWorkers.end(), [this](Worker* worker) {
       mThreads.push_back(std::thread(&Worker::threadEntryPoint, worker));
@@ -20,11 +26,14 @@ WorkerPool::WorkerPool(const int nbWorkers) {
 
 WorkerPool::~WorkerPool() {
    std::for_each(mWorkers.begin(), mWorkers.end(), [this](Worker* worker) {
-      delete worker;
+      worker->shutdown();
    });
    std::for_each(mThreads.begin(), mThreads.end(), [this](std::thread& thread) {
       thread.join();
    });
+   std::for_each(mWorkers.begin(), mWorkers.end(), [this](Worker* worker) {
+      delete worker;
+   });
 }
 
 void WorkerPool::addWork(const Worker::Work& work) {
@@ -34,8 +43,49 @@ void WorkerPool::addWork(const Worker::Work& work) {
       worker = mCurrentWorker++;
       if(mCurrentWorker >= mWorkers.size()) mCurrentWorker = 0;
    }
-   mWorkers[worker]->provideWork(work);
+   const bool started = mWorkers[worker]->provideWork(work);
+
+   //the chosen worker is busy, let an idle one steal the work instead of waiting behind it
+   if(!started) {
+      for(size_t i = 1; i < mWorkers.size(); ++i) {
+         Worker* sibling = mWorkers[(worker + i) % mWorkers.size()];
+         if(sibling->isParked()) {
+            sibling->wakeUp();
+            break;
+         }
+      }
+   }
+}
+
+std::vector<WorkerStats::Snapshot> WorkerPool::snapshotStats() {
+   std::vector<WorkerStats::Snapshot> result;
+   result.reserve(mWorkers.size());
+   std::for_each(mWorkers.begin(), mWorkers.end(), [&result](Worker* worker) {
+      result.push_back(worker->getStats().snapshot());
+   });
+   return result;
+}
+
+WorkerStats::Snapshot WorkerPool::snapshotTotalStats() {
+   WorkerStats::Snapshot total;
+   std::for_each(mWorkers.begin(), mWorkers.end(), [&total](Worker* worker) {
+      total.merge(worker->getStats().snapshot());
+   });
+   return total;
+}
+
+void WorkerPool::resetStats() {
+   std::for_each(mWorkers.begin(), mWorkers.end(), [](Worker* worker) {
+      worker->getStats().reset();
+   });
+}
+
+size_t WorkerPool::size() const {
+   return mWorkers.size();
+}
 
+LoadShedder& WorkerPool::getLoadShedder() {
+   return mLoadShedder;
 }
 
 }
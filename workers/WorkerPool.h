@@ -1,13 +1,16 @@
 #pragma once
 
 #include "workers/Platform.h"
+#include "workers/LoadShedder.h"
 #include "workers/Worker.h"
+#include "workers/WorkerStats.h"
 
 #include "objects/HttpRequestToResponse.h"
 
 #include <vector>
 #include <thread>
 #include <atomic>
+#include <mutex>
 
 namespace c11http {
 namespace workers {
@@ -18,13 +21,28 @@ public:
    ~WorkerPool();
 
    void addWork(const Worker::Work& work);
+
+   /**
+    * Scheduling statistics for each worker (and its queue), in worker order.
+    */
+   std::vector<WorkerStats::Snapshot> snapshotStats();
+   /**
+    * Scheduling statistics summed over every worker.
+    */
+   WorkerStats::Snapshot snapshotTotalStats();
+   void resetStats();
+   size_t size() const;
+   /**
+    * Fed the queueing delay of all work the pool runs, for callers deciding whether to give it more.
+    */
+   LoadShedder& getLoadShedder();
 private:
    std::vector<Worker*> mWorkers;
    std::vector<std::thread> mThreads;
    size_t mCurrentWorker;
    std::mutex mMutex;
+   LoadShedder mLoadShedder;
 };
 
 }
 }
-
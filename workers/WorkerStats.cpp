@@ -0,0 +1,156 @@
+#include "workers/WorkerStats.h"
+
+namespace c11http {
+namespace workers {
+
+namespace {
+   size_t bucketFor(unsigned long long microseconds) {
+      size_t bucket = 0;
+      while(microseconds > 0 && bucket < LatencyHistogram::BUCKETS - 1) {
+         microseconds >>= 1;
+         ++bucket;
+      }
+      return bucket;
+   }
+
+   void storeMax(std::atomic<unsigned long long>& max, const unsigned long long value) {
+      unsigned long long current = max.load(std::memory_order_relaxed);
+      while(value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+      }
+   }
+}
+
+LatencyHistogram::Snapshot::Snapshot() : total(0), sumMicroseconds(0), maxMicroseconds(0) {
+   for(size_t i = 0; i < BUCKETS; ++i) counts[i] = 0;
+}
+
+void LatencyHistogram::Snapshot::merge(const Snapshot& other) {
+   for(size_t i = 0; i < BUCKETS; ++i) counts[i] += other.counts[i];
+   total += other.total;
+   sumMicroseconds += other.sumMicroseconds;
+   if(other.maxMicroseconds > maxMicroseconds) maxMicroseconds = other.maxMicroseconds;
+}
+
+unsigned long long LatencyHistogram::Snapshot::percentile(const double percent) const {
+   if(0 == total) return 0;
+   const double target = (percent / 100.0) * total;
+   unsigned long long seen = 0;
+   for(size_t i = 0; i < BUCKETS; ++i) {
+      seen += counts[i];
+      if(seen >= target && counts[i] > 0) return (0 == i) ? 0 : (1ULL << i) - 1;
+   }
+   return maxMicroseconds;
+}
+
+unsigned long long LatencyHistogram::Snapshot::mean() const {
+   return (0 == total) ? 0 : sumMicroseconds / total;
+}
+
+LatencyHistogram::LatencyHistogram() : mSum(0), mMax(0) {
+   for(size_t i = 0; i < BUCKETS; ++i) mCounts[i] = 0;
+}
+
+void LatencyHistogram::record(const unsigned long long microseconds) {
+   mCounts[bucketFor(microseconds)].fetch_add(1, std::memory_order_relaxed);
+   mSum.fetch_add(microseconds, std::memory_order_relaxed);
+   storeMax(mMax, microseconds);
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const {
+   Snapshot result;
+   for(size_t i = 0; i < BUCKETS; ++i) {
+      result.counts[i] = mCounts[i].load(std::memory_order_relaxed);
+      result.total += result.counts[i];
+   }
+   result.sumMicroseconds = mSum.load(std::memory_order_relaxed);
+   result.maxMicroseconds = mMax.load(std::memory_order_relaxed);
+   return result;
+}
+
+void LatencyHistogram::reset() {
+   for(size_t i = 0; i < BUCKETS; ++i) mCounts[i].store(0, std::memory_order_relaxed);
+   mSum.store(0, std::memory_order_relaxed);
+   mMax.store(0, std::memory_order_relaxed);
+}
+
+WorkerStats::Snapshot::Snapshot() : enqueued(0), completed(0), steals(0), parks(0), wakeups(0), queueDepth(0),
+   maxQueueDepth(0) {
+
+}
+
+void WorkerStats::Snapshot::merge(const Snapshot& other) {
+   enqueued += other.enqueued;
+   completed += other.completed;
+   steals += other.steals;
+   parks += other.parks;
+   wakeups += other.wakeups;
+   queueDepth += other.queueDepth;
+   if(other.maxQueueDepth > maxQueueDepth) maxQueueDepth = other.maxQueueDepth;
+   queueDelay.merge(other.queueDelay);
+   serviceTime.merge(other.serviceTime);
+}
+
+WorkerStats::WorkerStats() : mEnqueued(0), mCompleted(0), mSteals(0), mParks(0), mWakeups(0), mQueueDepth(0),
+   mMaxQueueDepth(0) {
+
+}
+
+void WorkerStats::recordEnqueue(const size_t depth) {
+   mEnqueued.fetch_add(1, std::memory_order_relaxed);
+   mQueueDepth.store(depth, std::memory_order_relaxed);
+   storeMax(mMaxQueueDepth, depth);
+}
+
+void WorkerStats::recordStart(const unsigned long long queueDelayMicroseconds, const size_t depth) {
+   mQueueDepth.store(depth, std::memory_order_relaxed);
+   mQueueDelay.record(queueDelayMicroseconds);
+}
+
+void WorkerStats::recordComplete(const unsigned long long serviceMicroseconds) {
+   mCompleted.fetch_add(1, std::memory_order_relaxed);
+   mServiceTime.record(serviceMicroseconds);
+}
+
+void WorkerStats::recordSteal() {
+   mSteals.fetch_add(1, std::memory_order_relaxed);
+}
+
+void WorkerStats::recordStolen(const size_t depth) {
+   mQueueDepth.store(depth, std::memory_order_relaxed);
+}
+
+void WorkerStats::recordPark() {
+   mParks.fetch_add(1, std::memory_order_relaxed);
+}
+
+void WorkerStats::recordWakeup() {
+   mWakeups.fetch_add(1, std::memory_order_relaxed);
+}
+
+WorkerStats::Snapshot WorkerStats::snapshot() const {
+   Snapshot result;
+   result.enqueued = mEnqueued.load(std::memory_order_relaxed);
+   result.completed = mCompleted.load(std::memory_order_relaxed);
+   result.steals = mSteals.load(std::memory_order_relaxed);
+   result.parks = mParks.load(std::memory_order_relaxed);
+   result.wakeups = mWakeups.load(std::memory_order_relaxed);
+   result.queueDepth = mQueueDepth.load(std::memory_order_relaxed);
+   result.maxQueueDepth = mMaxQueueDepth.load(std::memory_order_relaxed);
+   result.queueDelay = mQueueDelay.snapshot();
+   result.serviceTime = mServiceTime.snapshot();
+   return result;
+}
+
+void WorkerStats::reset() {
+   mEnqueued.store(0, std::memory_order_relaxed);
+   mCompleted.store(0, std::memory_order_relaxed);
+   mSteals.store(0, std::memory_order_relaxed);
+   mParks.store(0, std::memory_order_relaxed);
+   mWakeups.store(0, std::memory_order_relaxed);
+   mMaxQueueDepth.store(mQueueDepth.load(std::memory_order_relaxed), std::memory_order_relaxed);
+   mQueueDelay.reset();
+   mServiceTime.reset();
+}
+
+}
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "workers/Platform.h"
+
+#include <atomic>
+#include <vector>
+
+namespace c11http {
+namespace workers {
+
+/**
+ * Histogram of durations in microseconds, using power of two buckets. Recording is a single relaxed atomic
+ * increment, so it is cheap enough to do for every piece of work.
+ */
+class WORKERS_API LatencyHistogram {
+public:
+   static const size_t BUCKETS = 32;
+
+   /**
+    * Point in time copy of a histogram. Bucket i counts durations in [2^(i-1), 2^i) microseconds, with
+    * bucket 0 counting durations under 1 microsecond.
+    */
+   struct Snapshot {
+      Snapshot();
+      unsigned long long counts[BUCKETS];
+      unsigned long long total;
+      unsigned long long sumMicroseconds;
+      unsigned long long maxMicroseconds;
+
+      void merge(const Snapshot& other);
+      /**
+       * Upper bound, in microseconds, of the bucket holding the given percentile (0-100).
+       */
+      unsigned long long percentile(const double percent) const;
+      unsigned long long mean() const;
+   };
+
+   LatencyHistogram();
+
+   void record(const unsigned long long microseconds);
+   Snapshot snapshot() const;
+   void reset();
+
+private:
+   std::atomic<unsigned long long> mCounts[BUCKETS];
+   std::atomic<unsigned long long> mSum;
+   std::atomic<unsigned long long> mMax;
+};
+
+/**
+ * Scheduling counters for a single worker and its queue.
+ */
+class WORKERS_API WorkerStats {
+public:
+   struct Snapshot {
+      Snapshot();
+      unsigned long long enqueued; //work given to this worker's queue
+      unsigned long long completed; //work run by this worker, including stolen work
+      unsigned long long steals; //work this worker took from another worker's queue
+      unsigned long long parks; //times this worker waited with nothing to do
+      unsigned long long wakeups; //times this worker was signalled while parked
+      unsigned long long queueDepth; //work waiting in the queue when the snapshot was taken
+      unsigned long long maxQueueDepth;
+      LatencyHistogram::Snapshot queueDelay; //time from enqueue to a worker starting the work
+      LatencyHistogram::Snapshot serviceTime; //time spent running the handler
+
+      void merge(const Snapshot& other);
+   };
+
+   WorkerStats();
+
+   void recordEnqueue(const size_t depth);
+   void recordStart(const unsigned long long queueDelayMicroseconds, const size_t depth);
+   void recordComplete(const unsigned long long serviceMicroseconds);
+   void recordSteal();
+   /**
+    * A sibling took work from this worker's queue, leaving depth behind.
+    */
+   void recordStolen(const size_t depth);
+   void recordPark();
+   void recordWakeup();
+
+   Snapshot snapshot() const;
+   /**
+    * Clear counters and histograms. The current queue depth is left as is.
+    */
+   void reset();
+
+private:
+   std::atomic<unsigned long long> mEnqueued;
+   std::atomic<unsigned long long> mCompleted;
+   std::atomic<unsigned long long> mSteals;
+   std::atomic<unsigned long long> mParks;
+   std::atomic<unsigned long long> mWakeups;
+   std::atomic<unsigned long long> mQueueDepth;
+   std::atomic<unsigned long long> mMaxQueueDepth;
+   LatencyHistogram mQueueDelay;
+   LatencyHistogram mServiceTime;
+};
+
+}
+}